@@ -0,0 +1,622 @@
+/**
+ * The render benchmark. It measures the cost of the wrappers themselves; creating buffers and textures, compiling and
+ * linking programs and issuing draws. Every case is repeated for a number of frames into an offscreen framebuffer
+ * (of a hidden window, see: gl_window::create_headless) with vsync off, hence nothing waits for the display.
+ *
+ * For every frame of a case both the CPU time spent submitting the calls and the GPU time they took (a
+ * GL_TIME_ELAPSED query around them) are recorded. The queries are read back frames_in_flight frames later so that
+ * reading them doesn't stall the submission. The report also has the calls that the state cache (see:
+ * state_cache.hpp) issued and elided per frame, so that a change to any of them can be compared with a baseline.
+ *  buffer_create      : buffer_object::create of --buffers buffers of --buffer-size bytes.
+ *  texture_create     : texture_object::create of --textures RGBA textures of --texture-size pixels squared.
+ *  shader_compile     : shader_program::compile_shader and link_shader of --shaders programs. Every program is a
+ *                       little different so that the driver can't hand out the one it compiled before.
+ *  draw_elements      : --draws calls of vertex_array_object::draw_elements, every one binding its program and
+ *                       vertex array again (those binds are elided by the state cache) and setting its offset.
+ *  draw_instanced     : The same cubes as a single draw_elements_instanced, their offsets in a static buffer.
+ *  draw_streamed      : The same as draw_instanced, but the offsets are written into a streaming_buffer_object
+ *                       (see: vbo.hpp) every frame.
+ *
+ * The profiler (see: profiler.hpp) is not used, its GPU scopes are issued by the wrappers themselves and a pair of
+ * timestamp queries per draw would be most of what is measured.
+ *
+ * Usage;
+ *  render_bench [--case name]... [--frames 300] [--warmup 30] [--draws 1000] [--buffers 16] [--buffer-size 65536]
+ *               [--textures 4] [--texture-size 512] [--shaders 1] [--width 1280] [--height 720] [--output report.json]
+ *
+ * Needs an OpenGL 4.3 context. It is built separately. (see: bench/compilation-script)
+*/
+
+#include "../glfw/math.hpp"
+#include "../glfw/glwindow.hpp"
+#include "../glfw/state_cache.hpp"
+#include "../glfw/vbo.hpp"
+#include "../glfw/vao.hpp"
+#include "../glfw/texture.hpp"
+#include "../glfw/shader.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+/** @brief The number of frames that the timer queries are read back after. */
+constexpr size_t frames_in_flight = 3;
+
+/** @brief How much of everything every case does. */
+struct settings
+{
+    uint64_t frames = 300, warmup = 30;
+    size_t draws = 1000;
+    size_t buffers = 16, buffer_size = 65536;
+    size_t textures = 4, texture_size = 512;
+    size_t shaders = 1;
+    int width = 1280, height = 720;
+};
+
+namespace sources
+{
+    constexpr const char* vertex = R"(
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 offset;
+out vec3 color;
+
+void main()
+{
+    vec3 p = position * 0.02 + offset.xyz;
+    color = position * 0.5 + 0.5;
+    gl_Position = vec4(p, 1.0);
+}
+)";
+
+    constexpr const char* fragment = R"(
+in vec3 color;
+out vec4 fragment_color;
+
+void main() { fragment_color = vec4(color, 1.0); }
+)";
+}; // namespace sources
+
+/** @brief Compiles and links a program, without going through the binary cache. (see: shader::cache) */
+void compile_program(glfw::shader::shader_program& program, std::string& vertex, std::string& fragment)
+{
+    program.set_content(vertex.data(), fragment.data());
+    program.compile_shader();
+    program.link_shader();
+}
+
+/** @brief A case of the benchmark. */
+class bench_case
+{
+public:
+    virtual ~bench_case() = default;
+
+    virtual const char* name() const = 0;
+    /** @brief Creates everything that the frames use. Not measured. */
+    virtual void setup(const settings& s) = 0;
+    /** @brief Issues the calls of a single frame. This is what is measured. */
+    virtual void frame() = 0;
+    /** @brief The number of calls of the measured wrapper per frame. */
+    virtual size_t calls() const = 0;
+};
+
+class buffer_create : public bench_case
+{
+private:
+    std::vector<std::unique_ptr<glfw::buffer_object>> _buffers;
+    std::vector<uint8_t> _data;
+
+public:
+    const char* name() const override { return "buffer_create"; }
+
+    void setup(const settings& s) override
+    {
+        _data.assign(s.buffer_size, 0x5A);
+        _buffers.resize(s.buffers);
+        for(std::unique_ptr<glfw::buffer_object>& buffer : _buffers)
+        {
+            buffer = std::make_unique<glfw::buffer_object>();
+            buffer->set_type(GL_ARRAY_BUFFER);
+            buffer->find_free_id();
+        }
+    }
+
+    void frame() override
+    {
+        for(std::unique_ptr<glfw::buffer_object>& buffer : _buffers)
+        {
+            buffer->bind();
+            buffer->create<uint8_t>(_data.data(), _data.size(), GL_STATIC_DRAW);
+        }
+    }
+
+    size_t calls() const override { return _buffers.size(); }
+};
+
+class texture_create : public bench_case
+{
+private:
+    std::vector<std::unique_ptr<glfw::texture::texture_object>> _textures;
+    std::vector<uint8_t> _pixels;
+    glfw::texture::image_data _image;
+
+public:
+    const char* name() const override { return "texture_create"; }
+
+    void setup(const settings& s) override
+    {
+        _pixels.resize(s.texture_size * s.texture_size * 4);
+        for(size_t i = 0; i < _pixels.size(); i++) _pixels[i] = static_cast<uint8_t>(i * 31);
+        _image = glfw::texture::image_data { nullptr, static_cast<int>(s.texture_size), static_cast<int>(s.texture_size), 4, _pixels.data() };
+
+        _textures.resize(s.textures);
+        for(std::unique_ptr<glfw::texture::texture_object>& texture : _textures)
+        {
+            texture = std::make_unique<glfw::texture::texture_object>();
+            texture->find_free_id();
+        }
+    }
+
+    void frame() override
+    {
+        for(std::unique_ptr<glfw::texture::texture_object>& texture : _textures)
+        {
+            texture->bind();
+            texture->create(_image, GL_RGBA);
+        }
+    }
+
+    size_t calls() const override { return _textures.size(); }
+};
+
+class shader_compile : public bench_case
+{
+private:
+    size_t _count = 0;
+    uint64_t _generation = 0;
+    std::string _vertex, _fragment;
+
+public:
+    const char* name() const override { return "shader_compile"; }
+
+    void setup(const settings& s) override { _count = s.shaders; }
+
+    void frame() override
+    {
+        for(size_t i = 0; i < _count; i++)
+        {
+            // The number makes every program a new one for the driver, its own caches would be measured otherwise.
+            std::string header = "#version 430 core\n#define GENERATION " + std::to_string(_generation++) + "\n";
+            _vertex = header + sources::vertex;
+            _fragment = header + sources::fragment;
+
+            glfw::shader::shader_program program;
+            compile_program(program, _vertex, _fragment);
+        }
+    }
+
+    size_t calls() const override { return _count; }
+};
+
+/** @brief The cubes that the draw cases draw. One per draw (or instance), spread over the screen. */
+class draw_case : public bench_case
+{
+protected:
+    std::string _vertex, _fragment;
+    glfw::shader::shader_program _program;
+    glfw::vertex_array_object _vao;
+    glfw::buffer_object _vertices, _indices, _offsets;
+    std::vector<glm::vec4> _offset_data;
+    size_t _draws = 0;
+
+    /**
+     * @brief Creates the cube and the program.
+     * @param offsets The buffer that attribute 1 (the offset, one per instance) is read from.
+    */
+    void create_cube(glfw::buffer_object& offsets, size_t offsets_offset=0)
+    {
+        static const float vertices[] = {
+            -1, -1, -1,  1, -1, -1,  1,  1, -1, -1,  1, -1,
+            -1, -1,  1,  1, -1,  1,  1,  1,  1, -1,  1,  1
+        };
+        static const GLuint indices[] = {
+            0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 1, 5, 0, 5, 4,
+            3, 6, 2, 3, 7, 6,  0, 4, 7, 0, 7, 3,  1, 2, 6, 1, 6, 5
+        };
+
+        _vertex = std::string("#version 430 core\n") + sources::vertex;
+        _fragment = std::string("#version 430 core\n") + sources::fragment;
+        compile_program(_program, _vertex, _fragment);
+
+        _vao.find_free_id();
+        _vao.bind();
+        _vertices.set_type(GL_ARRAY_BUFFER);
+        _vertices.find_free_id();
+        _vertices.bind();
+        _vertices.create<float>(vertices, sizeof(vertices) / sizeof(float), GL_STATIC_DRAW);
+        _vao.create_attribute(0, 3, GL_FLOAT, false, sizeof(float) * 3, 0);
+        _vao.enable_attribute(0);
+
+        offsets.bind();
+        _vao.create_attribute(1, 4, GL_FLOAT, false, sizeof(glm::vec4), reinterpret_cast<const void*>(offsets_offset));
+        _vao.enable_attribute(1);
+        _vao.set_attribute_divisor(1, 1);
+
+        _indices.set_type(GL_ELEMENT_ARRAY_BUFFER);
+        _indices.find_free_id();
+        _indices.bind();
+        _indices.create<GLuint>(indices, sizeof(indices) / sizeof(GLuint), GL_STATIC_DRAW);
+    }
+
+    void create_offsets(size_t draws)
+    {
+        _draws = draws;
+        _offset_data.resize(draws);
+        size_t columns = 1;
+        while(columns * columns < draws) columns++;
+        for(size_t i = 0; i < draws; i++)
+        {
+            float x = (i % columns + 0.5f) / columns * 2.0f - 1.0f, y = (i / columns + 0.5f) / columns * 2.0f - 1.0f;
+            _offset_data[i] = glm::vec4(x, y, 0.0f, 0.0f);
+        }
+    }
+
+    void create_static_offsets()
+    {
+        _offsets.set_type(GL_ARRAY_BUFFER);
+        _offsets.find_free_id();
+        _offsets.bind();
+        _offsets.create<glm::vec4>(_offset_data.data(), _offset_data.size(), GL_STATIC_DRAW);
+    }
+};
+
+class draw_elements : public draw_case
+{
+public:
+    const char* name() const override { return "draw_elements"; }
+
+    void setup(const settings& s) override
+    {
+        create_offsets(s.draws);
+        create_static_offsets();
+        create_cube(_offsets);
+        // The offset of every cube is set as the constant value of the attribute instead.
+        _vao.disable_attribute(1);
+    }
+
+    void frame() override
+    {
+        for(size_t i = 0; i < _draws; i++)
+        {
+            _program.use_shader();
+            _vao.bind();
+            glVertexAttrib4fv(1, &_offset_data[i].x);
+            _vao.draw_elements(GL_TRIANGLES, 36, GL_UNSIGNED_INT);
+        }
+    }
+
+    size_t calls() const override { return _draws; }
+};
+
+class draw_instanced : public draw_case
+{
+public:
+    const char* name() const override { return "draw_instanced"; }
+
+    void setup(const settings& s) override
+    {
+        create_offsets(s.draws);
+        create_static_offsets();
+        create_cube(_offsets);
+    }
+
+    void frame() override
+    {
+        _program.use_shader();
+        _vao.bind();
+        _vao.draw_elements_instanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, static_cast<GLsizei>(_draws));
+    }
+
+    size_t calls() const override { return 1; }
+};
+
+class draw_streamed : public draw_case
+{
+private:
+    glfw::streaming_buffer_object _stream;
+    uint64_t _frame = 0;
+
+public:
+    const char* name() const override { return "draw_streamed"; }
+
+    void setup(const settings& s) override
+    {
+        create_offsets(s.draws);
+        _stream.set_type(GL_ARRAY_BUFFER);
+        _stream.find_free_id();
+        _stream.bind();
+        _stream.create<glm::vec4>(_draws, sizeof(glm::vec4));
+        create_cube(_stream);
+    }
+
+    void frame() override
+    {
+        if(!_stream.is_mapped()) return;
+        // The offsets move a little every frame, so that they really have to be written again.
+        glm::vec4* offsets = _stream.map_region<glm::vec4>();
+        float shift = (_frame++ % 64) * 0.0005f;
+        for(size_t i = 0; i < _draws; i++) offsets[i] = _offset_data[i] + glm::vec4(shift, 0.0f, 0.0f, 0.0f);
+
+        _program.use_shader();
+        _vao.bind();
+        _vao.draw_elements_instanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, static_cast<GLsizei>(_draws), 0,
+            static_cast<GLuint>(_stream.region_offset() / sizeof(glm::vec4)));
+        _stream.fence_region();
+    }
+
+    size_t calls() const override { return 1; }
+};
+
+/** @brief The mean, the median and the max of a set of times. */
+struct summary
+{
+    double mean = 0.0, median = 0.0, max = 0.0;
+
+    static summary of(std::vector<double> times)
+    {
+        summary result;
+        if(times.empty()) return result;
+        std::sort(times.begin(), times.end());
+        for(double t : times) result.mean += t;
+        result.mean /= times.size();
+        result.median = times[times.size() / 2];
+        result.max = times.back();
+        return result;
+    }
+};
+
+/** @brief What a case measured. */
+struct case_result
+{
+    std::string name;
+    uint64_t frames = 0;
+    size_t calls = 0;
+    summary cpu_ms, gpu_ms;
+    /** @brief The calls issued and elided by the state cache, per frame. */
+    double issued = 0.0, elided = 0.0;
+};
+
+/** @brief An offscreen framebuffer; a color texture and a depth renderbuffer. */
+class offscreen_target
+{
+private:
+    GLuint _framebuffer = 0, _depth = 0;
+    glfw::texture::texture_object _color;
+
+public:
+    bool create(int width, int height)
+    {
+        _color.find_free_id();
+        _color.bind();
+        _color.create_storage(1, GL_RGBA8, width, height);
+
+        glGenRenderbuffers(1, &_depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, _depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+        glGenFramebuffers(1, &_framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _color.texture_id, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depth);
+        glViewport(0, 0, width, height);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    ~offscreen_target() noexcept(true)
+    {
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteRenderbuffers(1, &_depth);
+    }
+};
+
+case_result run_case(bench_case& c, const settings& s)
+{
+    case_result result;
+    result.name = c.name();
+    c.setup(s);
+    glFinish();
+
+    GLuint queries[frames_in_flight];
+    glGenQueries(frames_in_flight, queries);
+    std::vector<double> cpu_times, gpu_times;
+    cpu_times.reserve(s.frames);
+    gpu_times.reserve(s.frames);
+    uint64_t issued = 0, elided = 0;
+
+    uint64_t total = s.warmup + s.frames;
+    for(uint64_t f = 0; f < total + frames_in_flight; f++)
+    {
+        GLuint query = queries[f % frames_in_flight];
+        // The query of this slot was issued frames_in_flight frames ago, it is read back before being reused.
+        if(f >= frames_in_flight && f - frames_in_flight >= s.warmup)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            gpu_times.push_back(elapsed / 1e6);
+        }
+        if(f >= total) continue;
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        auto start = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        c.frame();
+        glEndQuery(GL_TIME_ELAPSED);
+        auto end = std::chrono::steady_clock::now();
+        glFlush();
+
+        const glfw::state::call_counters& counters = glfw::state::current().this_frame();
+        if(f >= s.warmup)
+        {
+            cpu_times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            issued += counters.total_issued();
+            elided += counters.total_elided();
+        }
+        glfw::state::current().end_frame();
+    }
+    glDeleteQueries(frames_in_flight, queries);
+
+    result.frames = s.frames;
+    result.calls = c.calls();
+    result.cpu_ms = summary::of(cpu_times);
+    result.gpu_ms = summary::of(gpu_times);
+    if(s.frames)
+    {
+        result.issued = static_cast<double>(issued) / s.frames;
+        result.elided = static_cast<double>(elided) / s.frames;
+    }
+    return result;
+}
+
+void write_summary(std::ostream& out, const char* name, const summary& s)
+{
+    out << "\"" << name << "\": { \"mean\": " << s.mean << ", \"median\": " << s.median << ", \"max\": " << s.max << " }";
+}
+
+void write_report(std::ostream& out, const std::vector<case_result>& results, const settings& s)
+{
+    auto string = [](GLenum name) { const GLubyte* value = glGetString(name); return value ? reinterpret_cast<const char*>(value) : ""; };
+    out << "{\n  \"renderer\": \"" << string(GL_RENDERER) << "\",\n  \"version\": \"" << string(GL_VERSION) << "\""
+        << ",\n  \"settings\": { \"frames\": " << s.frames << ", \"warmup\": " << s.warmup << ", \"draws\": " << s.draws
+        << ", \"buffers\": " << s.buffers << ", \"buffer_size\": " << s.buffer_size
+        << ", \"textures\": " << s.textures << ", \"texture_size\": " << s.texture_size
+        << ", \"shaders\": " << s.shaders << ", \"width\": " << s.width << ", \"height\": " << s.height << " }"
+        << ",\n  \"cases\": [";
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const case_result& r = results[i];
+        out << (i ? "," : "") << "\n    {\n      \"name\": \"" << r.name << "\""
+            << ",\n      \"frames\": " << r.frames
+            << ",\n      \"calls_per_frame\": " << r.calls
+            << ",\n      "; write_summary(out, "cpu_ms", r.cpu_ms);
+        out << ",\n      "; write_summary(out, "gpu_ms", r.gpu_ms);
+        out << ",\n      \"cpu_us_per_call\": " << (r.calls ? r.cpu_ms.mean * 1000.0 / r.calls : 0.0)
+            << ",\n      \"state_cache\": { \"issued\": " << r.issued << ", \"elided\": " << r.elided << " }"
+            << "\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+    settings s;
+    std::vector<std::string> names;
+    const char* output = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        auto number = [&]() { return std::strtoull(argv[++i], nullptr, 10); };
+        if(!std::strcmp(argv[i], "--case") && has_value) names.push_back(argv[++i]);
+        else if(!std::strcmp(argv[i], "--frames") && has_value) s.frames = number();
+        else if(!std::strcmp(argv[i], "--warmup") && has_value) s.warmup = number();
+        else if(!std::strcmp(argv[i], "--draws") && has_value) s.draws = std::max<size_t>(number(), 1);
+        else if(!std::strcmp(argv[i], "--buffers") && has_value) s.buffers = number();
+        else if(!std::strcmp(argv[i], "--buffer-size") && has_value) s.buffer_size = number();
+        else if(!std::strcmp(argv[i], "--textures") && has_value) s.textures = number();
+        else if(!std::strcmp(argv[i], "--texture-size") && has_value) s.texture_size = std::max<size_t>(number(), 1);
+        else if(!std::strcmp(argv[i], "--shaders") && has_value) s.shaders = number();
+        else if(!std::strcmp(argv[i], "--width") && has_value) s.width = static_cast<int>(std::max<size_t>(number(), 1));
+        else if(!std::strcmp(argv[i], "--height") && has_value) s.height = static_cast<int>(std::max<size_t>(number(), 1));
+        else if(!std::strcmp(argv[i], "--output") && has_value) output = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--case name]... [--frames n] [--warmup n] [--draws n] [--buffers n] [--buffer-size bytes] "
+                "[--textures n] [--texture-size pixels] [--shaders n] [--width pixels] [--height pixels] [--output path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    glfw::init();
+    glfw::gl_window::set_hint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfw::gl_window::set_hint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfw::gl_window::set_hint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    std::unique_ptr<glfw::gl_window> window = std::make_unique<glfw::gl_window>();
+    if(!window->create_headless())
+    {
+        std::fprintf(stderr, "Error creating an OpenGL 4.3 context\n");
+        glfw::terminate();
+        return 1;
+    }
+    window->make_context_current();
+    glfw::init_glad();
+    // Nothing is presented, but a driver may still throttle a window that swaps with vsync on.
+    glfwSwapInterval(0);
+    // The programs are compiled every time, the cache would skip exactly what is measured.
+    glfw::shader::cache::set_directory("");
+
+    int exit_code = 0;
+    {
+        offscreen_target target;
+        if(!target.create(s.width, s.height))
+        {
+            std::fprintf(stderr, "Error creating the offscreen framebuffer\n");
+            exit_code = 1;
+        }
+
+        std::vector<std::unique_ptr<bench_case>> cases;
+        cases.push_back(std::make_unique<buffer_create>());
+        cases.push_back(std::make_unique<texture_create>());
+        cases.push_back(std::make_unique<shader_compile>());
+        cases.push_back(std::make_unique<draw_elements>());
+        cases.push_back(std::make_unique<draw_instanced>());
+        cases.push_back(std::make_unique<draw_streamed>());
+        for(const std::string& name : names)
+        {
+            if(std::none_of(cases.begin(), cases.end(), [&](const std::unique_ptr<bench_case>& c) { return name == c->name(); }))
+            {
+                std::fprintf(stderr, "Error unknown case \"%s\"\n", name.c_str());
+                exit_code = 1;
+            }
+        }
+
+        std::vector<case_result> results;
+        for(std::unique_ptr<bench_case>& c : cases)
+        {
+            if(exit_code) break;
+            if(!names.empty() && std::find(names.begin(), names.end(), c->name()) == names.end()) continue;
+
+            std::fprintf(stderr, "Running %s...\n", c->name());
+            results.push_back(run_case(*c, s));
+            // The objects of a case are deleted before the next one, so that the driver doesn't carry them along.
+            c.reset();
+            glFinish();
+        }
+
+        if(!exit_code)
+        {
+            if(output)
+            {
+                std::ofstream file(output);
+                if(file) write_report(file, results, s);
+                else
+                {
+                    std::fprintf(stderr, "Error creating report at \"%s\"\n", output);
+                    exit_code = 1;
+                }
+            }
+            else write_report(std::cout, results, s);
+        }
+    }
+
+    window.reset();
+    glfw::terminate();
+    return exit_code;
+}
\ No newline at end of file
@@ -0,0 +1,580 @@
+/**
+ * The simulation benchmark. It runs a set of canonical scenes headless (see: glfw::fixed_step_loop::run_headless)
+ * and writes how fast they ran as JSON, so that it can be run on a build server and compared from one commit to the
+ * next.
+ *
+ * The scenes are built the same way on every run; there are no random numbers other than a fixed seed, the step is
+ * constant and the final positions of the bodies are hashed into a checksum. A different checksum with the same
+ * settings means the behaviour of the simulation changed, not only its speed.
+ *  box_pyramid       : A pyramid of 210 boxes. Tall stacks, the solver converging is what is measured.
+ *  sphere_pile       : 10000 spheres dropped into a box. The broadphase and the narrowphase.
+ *  ragdoll_crowd     : 100 ragdolls of 11 capsules and 10 ball joints each, falling onto each other. The joints.
+ *  particle_fountain : The GPU particle system (see: glfw/particles.hpp) fed by a fountain. Needs an OpenGL 4.3
+ *                      context, hence a hidden window; it is skipped when there is none. (ex; no display) It
+ *                      isn't built at all with _GLFW_WITHOUT_OPENGL_, then neither glad nor GLFW are needed.
+ *
+ * For every scene the report has; the steps per second, the time of every step (mean, median and max), the time
+ * of every profiled scope (see: glfw/profiler.hpp) and the allocations (see: glfw/memory.hpp) made while building the
+ * scene and during the steps. The warm up steps aren't measured, the first steps grow the pools and arenas. After
+ * them a step of a world must not allocate at all; the bench fails (returns 1, after writing the report) if one did.
+ *
+ * Usage;
+ *  simulation_bench [--scene name]... [--steps 600] [--warmup 60] [--threads n] [--output report.json]
+ *
+ * The report is written to the console unless an output is given. It is built separately. (see: bench/compilation-script)
+*/
+
+#define _GLFW_USE_PROFILER_
+#define _GLFW_COUNT_ALLOCATIONS_
+
+#include "../physics/world.hpp"
+#include "../glfw/frame_loop.hpp"
+#ifndef _GLFW_WITHOUT_OPENGL_
+    #include "../glfw/glwindow.hpp"
+    #include "../glfw/particles.hpp"
+#endif
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+#include <chrono>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+/** @brief The size of a step, the same for every scene. */
+constexpr float step_size = 1.0f / 60.0f;
+/** @brief The seed of every scene. */
+constexpr uint32_t seed = 0x9E3779B9u;
+
+/** @brief A random number generator that gives the same numbers on every platform. (xorshift32) */
+struct random_numbers
+{
+    uint32_t state = seed;
+
+    uint32_t next() noexcept(true)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    /** @brief Returns a number in the range [min,max). */
+    float range(float min, float max) noexcept(true) { return min + (max - min) * static_cast<float>(next() >> 8) / 16777216.0f; }
+};
+
+/** @brief Hashes bytes into a checksum. (FNV-1a) */
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash=0xCBF29CE484222325ull)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for(size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    return hash;
+}
+
+/** @brief A scene of the benchmark. */
+class scene
+{
+public:
+    virtual ~scene() = default;
+
+    virtual const char* name() const = 0;
+    /** @brief Whether or not the scene needs an OpenGL context. */
+    virtual bool needs_context() const { return false; }
+    /** @brief Creates everything. Not measured, other than its allocations. */
+    virtual void build(glfw::jobs::thread_pool* pool) = 0;
+    virtual void step(float dt) = 0;
+
+    /** @brief The number of bodies (or particles) that are simulated. */
+    virtual size_t size() const = 0;
+    /** @brief The heap allocations of the last step. */
+    virtual uint64_t step_allocations() const { return 0; }
+    /** @brief A hash of the state after the last step, 0 if it can't be read back. */
+    virtual uint64_t checksum() const { return 0; }
+};
+
+/** @brief A scene that is a physics::world. */
+class world_scene : public scene
+{
+protected:
+    std::unique_ptr<physics::world> _world;
+
+    /**
+     * @param expected_pairs The most pairs that the scene ever has, roughly. Otherwise the pairs (and the contacts)
+     * of a scene that is still piling up when the warm up ends would grow during the measured steps.
+    */
+    void create_world(glfw::jobs::thread_pool* pool, size_t expected_bodies, size_t expected_pairs)
+    {
+        physics::world_settings settings;
+        settings.expected_bodies = expected_bodies;
+        settings.expected_pairs = expected_pairs;
+        settings.pool = pool;
+        settings.solver.multithreaded = pool != nullptr;
+        _world = std::make_unique<physics::world>(settings);
+    }
+
+    void create_static_box(const glm::vec3& position, const glm::vec3& half_extents)
+    {
+        physics::body_desc desc;
+        desc.mass = 0.0f;
+        desc.shape = physics::shape::box(half_extents);
+        desc.position = position;
+        _world->create_body(desc);
+    }
+
+public:
+    void step(float dt) override { _world->step(dt); }
+
+    size_t size() const override { return _world->bodies().size(); }
+    uint64_t step_allocations() const override { return _world->step_allocations(); }
+
+    uint64_t checksum() const override
+    {
+        const physics::body_store& bodies = _world->bodies();
+        uint64_t hash = fnv1a(bodies.position.x.data(), sizeof(float) * bodies.size());
+        hash = fnv1a(bodies.position.y.data(), sizeof(float) * bodies.size(), hash);
+        return fnv1a(bodies.position.z.data(), sizeof(float) * bodies.size(), hash);
+    }
+};
+
+class box_pyramid : public world_scene
+{
+public:
+    static constexpr int base = 20;
+
+    const char* name() const override { return "box_pyramid"; }
+
+    void build(glfw::jobs::thread_pool* pool) override
+    {
+        create_world(pool, base * (base + 1) / 2 + 1, base * base * 2);
+        create_static_box(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(50.0f, 1.0f, 50.0f));
+
+        physics::body_desc desc;
+        desc.shape = physics::shape::box(glm::vec3(0.5f));
+        for(int row = 0; row < base; row++)
+        {
+            int count = base - row;
+            for(int i = 0; i < count; i++)
+            {
+                desc.position = glm::vec3((i - (count - 1) * 0.5f) * 1.05f, 0.5f + row * 1.0f, 0.0f);
+                _world->create_body(desc);
+            }
+        }
+    }
+};
+
+class sphere_pile : public world_scene
+{
+public:
+    static constexpr int width = 25, height = 16;
+
+    const char* name() const override { return "sphere_pile"; }
+
+    void build(glfw::jobs::thread_pool* pool) override
+    {
+        create_world(pool, width * width * height + 5, width * width * height * 5);
+        create_static_box(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(50.0f, 1.0f, 50.0f));
+        // The walls around the grid, so that the spheres pile up instead of rolling away.
+        float half = width * 0.5f;
+        create_static_box(glm::vec3(-half - 0.5f, 10.0f, 0.0f), glm::vec3(0.5f, 10.0f, half + 1.0f));
+        create_static_box(glm::vec3( half + 0.5f, 10.0f, 0.0f), glm::vec3(0.5f, 10.0f, half + 1.0f));
+        create_static_box(glm::vec3(0.0f, 10.0f, -half - 0.5f), glm::vec3(half + 1.0f, 10.0f, 0.5f));
+        create_static_box(glm::vec3(0.0f, 10.0f,  half + 0.5f), glm::vec3(half + 1.0f, 10.0f, 0.5f));
+
+        random_numbers random;
+        physics::body_desc desc;
+        for(int y = 0; y < height; y++) for(int x = 0; x < width; x++) for(int z = 0; z < width; z++)
+        {
+            desc.shape = physics::shape::sphere(random.range(0.35f, 0.5f));
+            desc.position = glm::vec3(x - half + 0.5f + random.range(-0.05f, 0.05f), 0.5f + y * 1.05f, z - half + 0.5f + random.range(-0.05f, 0.05f));
+            _world->create_body(desc);
+        }
+    }
+};
+
+class ragdoll_crowd : public world_scene
+{
+private:
+    /** @brief Creates a capsule between two points. */
+    physics::body_handle create_limb(const glm::vec3& from, const glm::vec3& to, float radius)
+    {
+        physics::body_desc desc;
+        glm::vec3 axis = to - from;
+        float length = glm::length(axis);
+        desc.shape = physics::shape::capsule(radius, std::max(length * 0.5f - radius, 0.01f));
+        desc.position = (from + to) * 0.5f;
+        // The capsules are along their local y axis. The limbs only point up, down or sideways.
+        if(std::fabs(axis.x) > std::fabs(axis.y)) desc.orientation = glm::angleAxis(1.5707963f, glm::vec3(0.0f, 0.0f, 1.0f));
+        return _world->create_body(desc);
+    }
+
+    void join(physics::body_handle a, physics::body_handle b, const glm::vec3& anchor)
+    {
+        physics::ball_joint_desc desc;
+        desc.a = a;
+        desc.b = b;
+        desc.anchor = anchor;
+        _world->create_ball_joint(desc);
+    }
+
+    void create_ragdoll(const glm::vec3& o)
+    {
+        glm::vec3 neck = o + glm::vec3(0.0f, 1.5f, 0.0f), hips = o + glm::vec3(0.0f, 0.9f, 0.0f);
+        glm::vec3 waist = o + glm::vec3(0.0f, 1.15f, 0.0f);
+
+        physics::body_desc desc;
+        desc.shape = physics::shape::sphere(0.12f);
+        desc.position = neck + glm::vec3(0.0f, 0.14f, 0.0f);
+        physics::body_handle head = _world->create_body(desc);
+
+        physics::body_handle chest = create_limb(waist, neck, 0.14f);
+        physics::body_handle pelvis = create_limb(hips, waist, 0.13f);
+        join(head, chest, neck);
+        join(chest, pelvis, waist);
+
+        for(float side : { -1.0f, 1.0f })
+        {
+            glm::vec3 shoulder = neck + glm::vec3(side * 0.18f, -0.05f, 0.0f);
+            glm::vec3 elbow = shoulder + glm::vec3(side * 0.3f, 0.0f, 0.0f);
+            glm::vec3 hand = elbow + glm::vec3(side * 0.28f, 0.0f, 0.0f);
+            physics::body_handle upper_arm = create_limb(shoulder, elbow, 0.05f);
+            physics::body_handle lower_arm = create_limb(elbow, hand, 0.045f);
+            join(upper_arm, chest, shoulder);
+            join(lower_arm, upper_arm, elbow);
+
+            glm::vec3 hip = hips + glm::vec3(side * 0.1f, 0.0f, 0.0f);
+            glm::vec3 knee = hip - glm::vec3(0.0f, 0.42f, 0.0f);
+            glm::vec3 foot = knee - glm::vec3(0.0f, 0.42f, 0.0f);
+            physics::body_handle thigh = create_limb(knee, hip, 0.07f);
+            physics::body_handle shin = create_limb(foot, knee, 0.06f);
+            join(thigh, pelvis, hip);
+            join(shin, thigh, knee);
+        }
+    }
+
+public:
+    static constexpr int rows = 10;
+
+    const char* name() const override { return "ragdoll_crowd"; }
+
+    void build(glfw::jobs::thread_pool* pool) override
+    {
+        create_world(pool, rows * rows * 11 + 1, rows * rows * 11 * 4);
+        create_static_box(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(50.0f, 1.0f, 50.0f));
+
+        // Three layers, every one shifted so that the ragdolls land on each other.
+        random_numbers random;
+        for(int i = 0; i < rows * rows; i++)
+        {
+            int layer = i % 3, x = (i / 3) % rows, z = (i / 3) / rows;
+            create_ragdoll(glm::vec3(x * 0.9f - 4.0f + layer * 0.3f, 0.1f + layer * 2.0f + random.range(0.0f, 0.2f), z * 0.9f - 2.0f));
+        }
+    }
+};
+
+#ifndef _GLFW_WITHOUT_OPENGL_
+class particle_fountain : public scene
+{
+private:
+    /** @brief Only created once there is a context, its destructor deletes the buffers. */
+    std::unique_ptr<glfw::particles::particle_system> _particles;
+    std::vector<glfw::particles::particle> _emitted;
+    random_numbers _random;
+
+public:
+    static constexpr size_t capacity = 1 << 18;
+    /** @brief The number of particles that are emitted every step. */
+    static constexpr size_t rate = 1024;
+
+    const char* name() const override { return "particle_fountain"; }
+    bool needs_context() const override { return true; }
+
+    void build(glfw::jobs::thread_pool*) override
+    {
+        glfw::particles::simulation_settings settings;
+        settings.cell_size = 0.05f;
+        _particles = std::make_unique<glfw::particles::particle_system>();
+        _particles->create(capacity, settings);
+        _particles->add_plane(glm::vec3(0.0f, 1.0f, 0.0f), 0.0f);
+        _emitted.resize(rate);
+    }
+
+    void step(float dt) override
+    {
+        for(glfw::particles::particle& p : _emitted)
+        {
+            p.position = glm::vec4(_random.range(-0.05f, 0.05f), 0.1f, _random.range(-0.05f, 0.05f), 0.02f);
+            p.velocity = glm::vec4(_random.range(-1.0f, 1.0f), _random.range(6.0f, 8.0f), _random.range(-1.0f, 1.0f), 0.0f);
+        }
+        _particles->emit(_emitted.data(), _emitted.size());
+        _particles->update(dt);
+        // The time of a step is the time until the GPU finished it.
+        glFinish();
+    }
+
+    size_t size() const override { return _particles ? _particles->size() : 0; }
+};
+#endif
+
+/** @brief The time spent in a profiled scope. */
+struct phase
+{
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+};
+
+/** @brief What a scene measured. */
+struct scene_result
+{
+    std::string name;
+    std::string skipped;
+    size_t size = 0;
+    uint64_t steps = 0;
+    double seconds = 0.0;
+    double mean_step_ms = 0.0, median_step_ms = 0.0, max_step_ms = 0.0;
+    uint64_t setup_allocations = 0, step_allocations = 0, max_step_allocations = 0;
+    /** @brief The measured steps that allocated. (see: physics::world::step_allocations) */
+    uint64_t allocating_steps = 0;
+    uint64_t checksum = 0;
+    /** @brief By the name of the scope and whether or not it is the GPU time. */
+    std::map<std::pair<std::string, bool>, phase> phases;
+};
+
+scene_result run_scene(scene& s, glfw::jobs::thread_pool* pool, uint64_t warmup, uint64_t steps)
+{
+    scene_result result;
+    result.name = s.name();
+
+    uint64_t allocations = glfw::memory::allocation_count();
+    s.build(pool);
+    result.setup_allocations = glfw::memory::allocation_count() - allocations;
+
+    std::vector<double> step_times;
+    uint64_t max_step_allocations = 0, allocating_steps = 0;
+
+    glfw::fixed_step_loop loop;
+    loop.set_step_rate(1.0L / step_size);
+    loop.set_simulation([&](long double dt)
+    {
+        auto start = std::chrono::steady_clock::now();
+        s.step(static_cast<float>(dt));
+        step_times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        max_step_allocations = std::max(max_step_allocations, s.step_allocations());
+        if(s.step_allocations()) allocating_steps++;
+    });
+    step_times.reserve(std::max(warmup, steps));
+
+    step_times.clear();
+    loop.run_headless(warmup);
+
+    // Everything before the measured steps is forgotten, including the GPU results of the warm up that come in late.
+    glfw::profiler::recorder.clear();
+    uint64_t first_frame = glfw::profiler::recorder.frame();
+    step_times.clear();
+    max_step_allocations = 0;
+    allocating_steps = 0;
+
+    allocations = glfw::memory::allocation_count();
+    auto start = std::chrono::steady_clock::now();
+    loop.run_headless(steps);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.step_allocations = glfw::memory::allocation_count() - allocations;
+    result.max_step_allocations = max_step_allocations;
+    result.allocating_steps = allocating_steps;
+
+    // The GPU results of the last steps are read back frames_in_flight - 1 frames later.
+    for(size_t i = 0; i < glfw::profiler::frames_in_flight; i++) GLFW_PROFILE_FRAME();
+    glfw::profiler::recorder.for_each_event([&](const glfw::profiler::trace_event& event)
+    {
+        if(event.frame < first_frame || event.frame >= first_frame + steps) return;
+        phase& p = result.phases[{ event.name, event.gpu }];
+        p.calls++;
+        p.total_ns += event.duration_ns;
+        p.max_ns = std::max(p.max_ns, event.duration_ns);
+    });
+
+    result.steps = steps;
+    result.size = s.size();
+    result.checksum = s.checksum();
+    if(!step_times.empty())
+    {
+        std::vector<double> sorted = step_times;
+        std::sort(sorted.begin(), sorted.end());
+        for(double t : sorted) result.mean_step_ms += t;
+        result.mean_step_ms /= sorted.size();
+        result.median_step_ms = sorted[sorted.size() / 2];
+        result.max_step_ms = sorted.back();
+    }
+    return result;
+}
+
+void write_report(std::ostream& out, const std::vector<scene_result>& results, size_t threads, uint64_t warmup)
+{
+    out << "{\n  \"step\": " << step_size << ",\n  \"threads\": " << threads << ",\n  \"warmup\": " << warmup
+        << ",\n  \"counts_heap_allocations\": " << (glfw::memory::counts_heap_allocations ? "true" : "false")
+        << ",\n  \"scenes\": [";
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const scene_result& r = results[i];
+        out << (i ? "," : "") << "\n    {\n      \"name\": \"" << r.name << "\"";
+        if(!r.skipped.empty())
+        {
+            out << ",\n      \"skipped\": \"" << r.skipped << "\"\n    }";
+            continue;
+        }
+
+        char checksum[32];
+        std::snprintf(checksum, sizeof(checksum), "%016llx", static_cast<unsigned long long>(r.checksum));
+        out << ",\n      \"size\": " << r.size
+            << ",\n      \"steps\": " << r.steps
+            << ",\n      \"seconds\": " << r.seconds
+            << ",\n      \"steps_per_second\": " << (r.seconds > 0.0 ? r.steps / r.seconds : 0.0)
+            << ",\n      \"step_ms\": { \"mean\": " << r.mean_step_ms << ", \"median\": " << r.median_step_ms << ", \"max\": " << r.max_step_ms << " }"
+            << ",\n      \"allocations\": { \"setup\": " << r.setup_allocations << ", \"steps\": " << r.step_allocations
+            << ", \"max_per_step\": " << r.max_step_allocations << ", \"allocating_steps\": " << r.allocating_steps << " }"
+            << ",\n      \"checksum\": " << (r.checksum ? "\"" + std::string(checksum) + "\"" : std::string("null"))
+            << ",\n      \"phases\": [";
+
+        size_t k = 0;
+        for(const auto& [key, p] : r.phases)
+        {
+            out << (k++ ? "," : "") << "\n        { \"name\": \"" << key.first << "\", \"gpu\": " << (key.second ? "true" : "false")
+                << ", \"calls\": " << p.calls
+                << ", \"total_ms\": " << p.total_ns / 1e6
+                << ", \"mean_ms\": " << p.total_ns / 1e6 / p.calls
+                << ", \"max_ms\": " << p.max_ns / 1e6 << " }";
+        }
+        out << "\n      ]\n    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+#ifndef _GLFW_WITHOUT_OPENGL_
+/** @brief Creates a hidden window with an OpenGL 4.3 context and makes it current. GLFW must have been initialized. */
+bool create_context(glfw::gl_window& window)
+{
+    glfw::gl_window::set_hint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfw::gl_window::set_hint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfw::gl_window::set_hint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if(!window.create_headless()) return false;
+
+    window.make_context_current();
+    glfw::init_glad();
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> names;
+    uint64_t steps = 600, warmup = 60;
+    size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1;
+    const char* output = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--scene") && has_value) names.push_back(argv[++i]);
+        else if(!std::strcmp(argv[i], "--steps") && has_value) steps = std::strtoull(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--warmup") && has_value) warmup = std::strtoull(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--threads") && has_value) threads = std::strtoull(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--output") && has_value) output = argv[++i];
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [--scene name]... [--steps n] [--warmup n] [--threads n] [--output path]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::unique_ptr<scene>> scenes;
+    scenes.push_back(std::make_unique<box_pyramid>());
+    scenes.push_back(std::make_unique<sphere_pile>());
+    scenes.push_back(std::make_unique<ragdoll_crowd>());
+#ifndef _GLFW_WITHOUT_OPENGL_
+    scenes.push_back(std::make_unique<particle_fountain>());
+#endif
+    for(const std::string& name : names)
+    {
+        if(std::none_of(scenes.begin(), scenes.end(), [&](const std::unique_ptr<scene>& s) { return name == s->name(); }))
+        {
+            std::fprintf(stderr, "Error unknown scene \"%s\"\n", name.c_str());
+            return 1;
+        }
+    }
+
+    // 0 threads runs everything on this thread.
+    std::unique_ptr<glfw::jobs::thread_pool> pool;
+    if(threads) pool = std::make_unique<glfw::jobs::thread_pool>(threads);
+    glfw::profiler::recorder.set_max_events(SIZE_MAX);
+
+#ifndef _GLFW_WITHOUT_OPENGL_
+    std::unique_ptr<glfw::gl_window> window;
+#endif
+    bool has_context = false;
+
+    std::vector<scene_result> results;
+    for(std::unique_ptr<scene>& s : scenes)
+    {
+        if(!names.empty() && std::find(names.begin(), names.end(), s->name()) == names.end()) continue;
+
+#ifndef _GLFW_WITHOUT_OPENGL_
+        if(s->needs_context() && !window)
+        {
+            glfw::init();
+            window = std::make_unique<glfw::gl_window>();
+            has_context = create_context(*window);
+        }
+#endif
+        if(s->needs_context() && !has_context)
+        {
+            scene_result skipped;
+            skipped.name = s->name();
+            skipped.skipped = "no OpenGL 4.3 context";
+            results.push_back(skipped);
+            continue;
+        }
+
+        std::fprintf(stderr, "Running %s...\n", s->name());
+        results.push_back(run_scene(*s, pool.get(), warmup, steps));
+        // The memory of a scene is given back before the next one is built.
+        s.reset();
+    }
+
+    if(output)
+    {
+        std::ofstream file(output);
+        if(!file)
+        {
+            std::fprintf(stderr, "Error creating report at \"%s\"\n", output);
+            return 1;
+        }
+        write_report(file, results, threads, warmup);
+    }
+    else write_report(std::cout, results, threads, warmup);
+
+#ifndef _GLFW_WITHOUT_OPENGL_
+    // The window is only created (and GLFW initialized) for the scenes that need a context.
+    if(window)
+    {
+        window.reset();
+        glfw::terminate();
+    }
+#endif
+
+    // A step that allocates after the warm up is a regression, even if it isn't any slower here.
+    int status = 0;
+    for(const scene_result& r : results)
+    {
+        if(!r.allocating_steps) continue;
+        std::fprintf(stderr, "Error %s allocated in %llu of the measured steps (up to %llu allocations in a step)\n", r.name.c_str(),
+            static_cast<unsigned long long>(r.allocating_steps), static_cast<unsigned long long>(r.max_step_allocations));
+        status = 1;
+    }
+    return status;
+}
\ No newline at end of file
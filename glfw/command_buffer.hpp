@@ -0,0 +1,627 @@
+/**
+ * This header contains the command buffers and the render thread. OpenGL can only be called from the thread whose
+ * context is current, the command buffers let every other thread take part in building a frame anyway; they record
+ * lightweight commands (binds, uniforms, buffer updates, draws, etc.) that the render thread replays later on.
+ *
+ * A command is a small header followed by its parameters, packed one after the other into a single byte buffer. The
+ * data of the buffer updates and the uniforms is copied into the buffer as well, hence it can be changed right after
+ * it was recorded. The storage of the buffers is kept between frames, so that recording doesn't allocate once the
+ * buffers have grown to the size of a frame.
+ *
+ * frame_commands holds one command buffer per worker of a thread pool, plus one that is shared by all the other
+ * threads. (Like memory::thread_arenas) Only the order of the commands within a single buffer is kept, the buffers
+ * are replayed one after the other. Draws whose order matters across the buffers should be pushed as draw packets,
+ * the render thread sorts all of them together. (see: render_queue.hpp)
+ *
+ * The render thread owns the context. There are two frames, the main thread records the next frame while the render
+ * thread is still replaying the last one. i.e. The simulation of frame N+1 runs while frame N is being submitted.
+ *
+ * Usage;
+ *  render::render_thread renderer(window, pool);
+ *  renderer.start();                        // The context must be current on the calling thread, it is moved over.
+ *  ... every frame ...
+ *  render::frame_commands& frame = renderer.begin_frame();
+ *  pool.parallel_for(0, n, 0, [&](size_t begin, size_t end) { for(size_t i = begin; i < end; i++) frame.local().push(packets[i]); });
+ *  renderer.submit();
+ *  ...
+ *  renderer.stop();                         // The context is released, it can be made current again.
+ *
+ * fixed_step_loop::run(render_thread&) does the above every frame. (see: frame_loop.hpp)
+*/
+
+#include "./glfw.hpp"
+#include "./glwindow.hpp"
+#include "./profiler.hpp"
+#include "./state_cache.hpp"
+#include "./thread_pool.hpp"
+#include "./render_queue.hpp"
+
+#ifndef _GLFW_COMMAND_BUFFER_DEFINITION_HPP_
+    #define _GLFW_COMMAND_BUFFER_DEFINITION_HPP_
+
+    #include <vector>
+    #include <memory>
+    #include <thread>
+    #include <mutex>
+    #include <condition_variable>
+    #include <exception>
+    #include <optional>
+    #include <cstdint>
+    #include <cstring>
+    #include <cstddef>
+    #include <type_traits>
+
+    _GLFW_START_
+
+    namespace render
+    {
+        /** @brief The commands that can be recorded. */
+        enum class command_type : uint8_t
+        {
+            USE_PROGRAM         = 0,
+            BIND_VERTEX_ARRAY   = 1,
+            BIND_TEXTURE        = 2,
+            BIND_BUFFER         = 3,
+            BIND_BUFFER_RANGE   = 4,
+            UPDATE_BUFFER       = 5,
+            UNIFORM             = 6,
+            DRAW_ELEMENTS       = 7,
+            MULTI_DRAW_INDIRECT = 8,
+            DRAW_PACKET         = 9,
+            FLUSH_QUEUE         = 10,
+            DISPATCH            = 11,
+            MEMORY_BARRIER      = 12,
+            VIEWPORT            = 13,
+            CLEAR               = 14,
+            CALL                = 15
+        };
+
+        /** @brief The types of the uniforms that can be recorded. */
+        enum class uniform_type : uint8_t
+        {
+            INT     = 0,
+            FLOAT   = 1,
+            VEC2    = 2,
+            VEC3    = 3,
+            VEC4    = 4,
+            MAT3    = 5,
+            MAT4    = 6
+        };
+
+        /** @brief Records commands to be replayed on the thread whose context is current. (see: the top of this file) */
+        class command_buffer
+        {
+            /** @brief Every command (and its data) starts at a multiple of this. */
+            static constexpr size_t alignment = 8;
+
+            struct command_header
+            {
+                command_type type;
+                /** @brief The size of the command (in bytes) including this header and its data. */
+                uint32_t size;
+            };
+
+            struct bind_texture_command { GLenum unit; GLenum target; GLuint texture; };
+            struct bind_buffer_command { GLenum target; GLuint buffer; };
+            struct bind_buffer_range_command { GLenum target; GLuint binding; GLuint buffer; GLintptr offset; GLsizeiptr size; };
+            struct update_buffer_command { GLenum target; GLuint buffer; GLintptr offset; GLsizeiptr size; };
+            struct uniform_command { GLint location; uniform_type type; GLsizei count; };
+            struct draw_elements_command { GLenum mode; GLenum index_type; draw_elements_indirect_command draw; };
+            struct multi_draw_indirect_command { GLenum mode; GLenum index_type; GLintptr offset; GLsizei count; GLsizei stride; };
+            struct dispatch_command { GLuint x, y, z; };
+            struct viewport_command { GLint x, y; GLsizei width, height; };
+            struct clear_command { GLbitfield mask; GLfloat r, g, b, a; };
+            struct callback_command { void(*fn)(const void* data); };
+
+            std::vector<unsigned char> _bytes;
+            size_t _commands = 0;
+
+            static size_t aligned(size_t size) noexcept(true) { return (size + alignment - 1) / alignment * alignment; }
+
+            static size_t uniform_size(uniform_type type) noexcept(true)
+            {
+                switch(type)
+                {
+                case uniform_type::INT:     return sizeof(GLint);
+                case uniform_type::FLOAT:   return sizeof(GLfloat);
+                case uniform_type::VEC2:    return sizeof(GLfloat) * 2;
+                case uniform_type::VEC3:    return sizeof(GLfloat) * 3;
+                case uniform_type::VEC4:    return sizeof(GLfloat) * 4;
+                case uniform_type::MAT3:    return sizeof(GLfloat) * 9;
+                case uniform_type::MAT4:    return sizeof(GLfloat) * 16;
+                }
+                return 0;
+            }
+
+            /** @brief Appends a command, its parameters and (optionally) its data. */
+            template <typename T>
+            void write(command_type type, const T& parameters, const void* data=nullptr, size_t data_size=0)
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "The parameters are copied into the buffer as they are.");
+                static_assert(alignof(T) <= alignment, "The parameters are only aligned to command_buffer::alignment.");
+
+                size_t parameters_offset = aligned(sizeof(command_header));
+                size_t data_offset = parameters_offset + aligned(sizeof(T));
+                size_t size = data_offset + aligned(data_size);
+
+                size_t start = _bytes.size();
+                _bytes.resize(start + size);
+                unsigned char* command = _bytes.data() + start;
+
+                command_header header { type, static_cast<uint32_t>(size) };
+                std::memcpy(command, &header, sizeof(command_header));
+                std::memcpy(command + parameters_offset, &parameters, sizeof(T));
+                if(data_size) std::memcpy(command + data_offset, data, data_size);
+                _commands++;
+            }
+
+            template <typename T>
+            static const T& parameters_of(const unsigned char* command) noexcept(true)
+            {
+                return *reinterpret_cast<const T*>(command + aligned(sizeof(command_header)));
+            }
+            template <typename T>
+            static const void* data_of(const unsigned char* command) noexcept(true)
+            {
+                return command + aligned(sizeof(command_header)) + aligned(sizeof(T));
+            }
+
+            static void replay_uniform(const uniform_command& uniform, const void* data)
+            {
+                const GLfloat* f = static_cast<const GLfloat*>(data);
+                switch(uniform.type)
+                {
+                case uniform_type::INT:     glUniform1iv(uniform.location, uniform.count, static_cast<const GLint*>(data)); break;
+                case uniform_type::FLOAT:   glUniform1fv(uniform.location, uniform.count, f); break;
+                case uniform_type::VEC2:    glUniform2fv(uniform.location, uniform.count, f); break;
+                case uniform_type::VEC3:    glUniform3fv(uniform.location, uniform.count, f); break;
+                case uniform_type::VEC4:    glUniform4fv(uniform.location, uniform.count, f); break;
+                case uniform_type::MAT3:    glUniformMatrix3fv(uniform.location, uniform.count, GL_FALSE, f); break;
+                case uniform_type::MAT4:    glUniformMatrix4fv(uniform.location, uniform.count, GL_FALSE, f); break;
+                }
+            }
+
+        public:
+            /** @brief Forgets the commands, but keeps the storage. */
+            void clear() noexcept(true)
+            {
+                _bytes.clear();
+                _commands = 0;
+            }
+
+            /** @brief Returns the number of recorded commands. */
+            size_t size() const noexcept(true) { return _commands; }
+            /** @brief Returns the number of bytes that the recorded commands take up. */
+            size_t bytes() const noexcept(true) { return _bytes.size(); }
+            bool empty() const noexcept(true) { return _commands == 0; }
+
+            // ============================= RECORDING =============================
+
+            /** @brief glUseProgram */
+            void use_program(GLuint program) { write(command_type::USE_PROGRAM, program); }
+            /** @brief glBindVertexArray */
+            void bind_vertex_array(GLuint vertex_array) { write(command_type::BIND_VERTEX_ARRAY, vertex_array); }
+            /** @brief Makes the unit active and binds the texture to it. @param unit ex; GL_TEXTURE0 */
+            void bind_texture(GLenum unit, GLenum target, GLuint texture)
+            {
+                write(command_type::BIND_TEXTURE, bind_texture_command { unit, target, texture });
+            }
+            /** @brief glBindBuffer */
+            void bind_buffer(GLenum target, GLuint buffer) { write(command_type::BIND_BUFFER, bind_buffer_command { target, buffer }); }
+            /** @brief glBindBufferRange. A size of -1 binds the whole buffer. (i.e. glBindBufferBase) */
+            void bind_buffer_range(GLenum target, GLuint binding, GLuint buffer, GLintptr offset=0, GLsizeiptr size=-1)
+            {
+                write(command_type::BIND_BUFFER_RANGE, bind_buffer_range_command { target, binding, buffer, offset, size });
+            }
+
+            /**
+             * @brief glBufferSubData. The data is copied into the command buffer.
+             * @param target The target that the buffer is bound to while it is updated. ex; GL_ARRAY_BUFFER
+             * @param buffer The id of the buffer.
+             * @param offset The offset(in bytes) into the buffer.
+             * @param data The data.
+             * @param size The size(in bytes) of the data.
+            */
+            void update_buffer(GLenum target, GLuint buffer, GLintptr offset, const void* data, size_t size)
+            {
+                write(command_type::UPDATE_BUFFER, update_buffer_command { target, buffer, offset, static_cast<GLsizeiptr>(size) }, data, size);
+            }
+
+            /** @brief Sets @c count uniforms of the program in use, starting from the location. The values are copied. */
+            void uniform(GLint location, uniform_type type, const void* values, GLsizei count=1)
+            {
+                write(command_type::UNIFORM, uniform_command { location, type, count }, values, uniform_size(type) * count);
+            }
+            void uniform(GLint location, GLint value) { uniform(location, uniform_type::INT, &value); }
+            void uniform(GLint location, GLfloat value) { uniform(location, uniform_type::FLOAT, &value); }
+
+            /** @brief Draws with the state that was recorded before it. (see: vertex_array_object::draw_elements_instanced) */
+            void draw_elements(GLenum mode, GLenum index_type, const draw_elements_indirect_command& draw)
+            {
+                write(command_type::DRAW_ELEMENTS, draw_elements_command { mode, index_type, draw });
+            }
+            /** @brief glMultiDrawElementsIndirect, from the buffer bound to GL_DRAW_INDIRECT_BUFFER. */
+            void multi_draw_indirect(GLenum mode, GLenum index_type, GLintptr offset, GLsizei count, GLsizei stride=0)
+            {
+                write(command_type::MULTI_DRAW_INDIRECT, multi_draw_indirect_command { mode, index_type, offset, count, stride });
+            }
+
+            /** @brief Pushes the packet into the render queue of the render thread. They are sorted and drawn together. */
+            void push(const draw_packet& packet) { write(command_type::DRAW_PACKET, packet); }
+            /** @brief Draws the packets that have been pushed so far. The render thread also does this at the end of every frame. */
+            void flush_queue() { write(command_type::FLUSH_QUEUE, uint32_t(0)); }
+
+            /** @brief glDispatchCompute, with the program in use. */
+            void dispatch(GLuint x, GLuint y=1, GLuint z=1) { write(command_type::DISPATCH, dispatch_command { x, y, z }); }
+            /** @brief glMemoryBarrier */
+            void memory_barrier(GLbitfield barriers) { write(command_type::MEMORY_BARRIER, barriers); }
+            /** @brief glViewport */
+            void viewport(GLint x, GLint y, GLsizei width, GLsizei height) { write(command_type::VIEWPORT, viewport_command { x, y, width, height }); }
+            /** @brief glClearColor and glClear */
+            void clear(GLbitfield mask, GLfloat r=0.0f, GLfloat g=0.0f, GLfloat b=0.0f, GLfloat a=1.0f)
+            {
+                write(command_type::CLEAR, clear_command { mask, r, g, b, a });
+            }
+
+            /**
+             * @brief Calls the function on the render thread, for anything that doesn't have a command of its own. The data
+             * is copied and a pointer to the copy is passed to the function.
+            */
+            template <typename T>
+            void call(void(*fn)(const void* data), const T& data)
+            {
+                static_assert(std::is_trivially_copyable_v<T>, "The data is copied into the buffer as it is.");
+                write(command_type::CALL, callback_command { fn }, &data, sizeof(T));
+            }
+            void call(void(*fn)(const void* data)) { write(command_type::CALL, callback_command { fn }); }
+
+            // ============================= REPLAYING =============================
+
+            /**
+             * @brief Replays the commands. Must be called on the thread whose context is current. The binds go through the
+             * state cache. (see: state::state_cache)
+             * @param queue The queue that the packets are pushed into.
+            */
+            void execute(render_queue& queue) const
+            {
+                state::state_cache& cache = state::current();
+                for(size_t offset = 0; offset < _bytes.size();)
+                {
+                    const unsigned char* command = _bytes.data() + offset;
+                    command_header header;
+                    std::memcpy(&header, command, sizeof(command_header));
+                    offset += header.size;
+
+                    switch(header.type)
+                    {
+                    case command_type::USE_PROGRAM:
+                        cache.use_program(parameters_of<GLuint>(command));
+                        break;
+                    case command_type::BIND_VERTEX_ARRAY:
+                        cache.bind_vertex_array(parameters_of<GLuint>(command));
+                        break;
+                    case command_type::BIND_TEXTURE:
+                    {
+                        const bind_texture_command& bind = parameters_of<bind_texture_command>(command);
+                        cache.bind_texture_unit(bind.unit, bind.target, bind.texture);
+                        break;
+                    }
+                    case command_type::BIND_BUFFER:
+                    {
+                        const bind_buffer_command& bind = parameters_of<bind_buffer_command>(command);
+                        cache.bind_buffer(bind.target, bind.buffer);
+                        break;
+                    }
+                    case command_type::BIND_BUFFER_RANGE:
+                    {
+                        const bind_buffer_range_command& bind = parameters_of<bind_buffer_range_command>(command);
+                        cache.bind_buffer_range(bind.target, bind.binding, bind.buffer, bind.offset, bind.size);
+                        break;
+                    }
+                    case command_type::UPDATE_BUFFER:
+                    {
+                        const update_buffer_command& update = parameters_of<update_buffer_command>(command);
+                        cache.bind_buffer(update.target, update.buffer);
+                        glBufferSubData(update.target, update.offset, update.size, data_of<update_buffer_command>(command));
+                        break;
+                    }
+                    case command_type::UNIFORM:
+                        replay_uniform(parameters_of<uniform_command>(command), data_of<uniform_command>(command));
+                        break;
+                    case command_type::DRAW_ELEMENTS:
+                    {
+                        const draw_elements_command& draw = parameters_of<draw_elements_command>(command);
+                        size_t index_size = draw.index_type == GL_UNSIGNED_BYTE ? 1 : draw.index_type == GL_UNSIGNED_SHORT ? 2 : 4;
+                        glDrawElementsInstancedBaseVertexBaseInstance(draw.mode, draw.draw.count, draw.index_type,
+                            reinterpret_cast<const void*>(draw.draw.first_index * index_size), draw.draw.instance_count,
+                            draw.draw.base_vertex, draw.draw.base_instance);
+                        break;
+                    }
+                    case command_type::MULTI_DRAW_INDIRECT:
+                    {
+                        const multi_draw_indirect_command& draw = parameters_of<multi_draw_indirect_command>(command);
+                        glMultiDrawElementsIndirect(draw.mode, draw.index_type, reinterpret_cast<const void*>(draw.offset), draw.count, draw.stride);
+                        break;
+                    }
+                    case command_type::DRAW_PACKET:
+                        queue.push(parameters_of<draw_packet>(command));
+                        break;
+                    case command_type::FLUSH_QUEUE:
+                        queue.flush();
+                        break;
+                    case command_type::DISPATCH:
+                    {
+                        const dispatch_command& dispatch = parameters_of<dispatch_command>(command);
+                        glDispatchCompute(dispatch.x, dispatch.y, dispatch.z);
+                        break;
+                    }
+                    case command_type::MEMORY_BARRIER:
+                        glMemoryBarrier(parameters_of<GLbitfield>(command));
+                        break;
+                    case command_type::VIEWPORT:
+                    {
+                        const viewport_command& viewport = parameters_of<viewport_command>(command);
+                        glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+                        break;
+                    }
+                    case command_type::CLEAR:
+                    {
+                        const clear_command& clear = parameters_of<clear_command>(command);
+                        glClearColor(clear.r, clear.g, clear.b, clear.a);
+                        glClear(clear.mask);
+                        break;
+                    }
+                    case command_type::CALL:
+                        parameters_of<callback_command>(command).fn(data_of<callback_command>(command));
+                        break;
+                    }
+                }
+            }
+        };
+
+        /** @brief The command buffers of a single frame, one per thread. (see: the top of this file) */
+        class frame_commands
+        {
+            jobs::thread_pool* _pool;
+            std::vector<std::unique_ptr<command_buffer>> _buffers;
+
+        public:
+            /** @param pool The pool whose workers will record the commands. */
+            explicit frame_commands(jobs::thread_pool& pool) : _pool(&pool)
+            {
+                _buffers.reserve(pool.size() + 1);
+                for(size_t i = 0; i <= pool.size(); i++) _buffers.push_back(std::make_unique<command_buffer>());
+            }
+
+            /**
+             * @brief Returns the command buffer of the calling thread. Every thread that isn't a worker of the pool shares
+             * the last buffer, hence only one of them (the one that drives the pool) may record into it.
+            */
+            command_buffer& local() { return *_buffers[_pool->worker_index()]; }
+
+            /** @brief Clears every buffer. */
+            void clear()
+            {
+                for(std::unique_ptr<command_buffer>& buffer : _buffers) buffer->clear();
+            }
+
+            /**
+             * @brief Replays the buffer that is shared by the other threads first (it usually sets up the frame, ex; clear)
+             * and then the buffers of the workers, in order.
+            */
+            void execute(render_queue& queue) const
+            {
+                _buffers.back()->execute(queue);
+                for(size_t i = 0; i + 1 < _buffers.size(); i++) _buffers[i]->execute(queue);
+            }
+
+            /** @brief Returns the number of commands in all the buffers. */
+            size_t commands() const
+            {
+                size_t total = 0;
+                for(const std::unique_ptr<command_buffer>& buffer : _buffers) total += buffer->size();
+                return total;
+            }
+
+            size_t size() const noexcept(true) { return _buffers.size(); }
+            command_buffer& operator[](size_t index) { return *_buffers[index]; }
+        };
+
+        /**
+         * @brief Owns the context of a window and replays the frames that are submitted to it. Every frame is followed by
+         * a flush of the render queue, a swap of the buffers and the end of the frame of the state cache and the profiler.
+        */
+        class render_thread
+        {
+        public:
+            /** @brief The number of frames. One is being recorded while the other one is being replayed. */
+            static constexpr size_t frame_count = 2;
+
+        private:
+            gl_window* _window;
+            std::unique_ptr<frame_commands> _frames[frame_count];
+            bool _submitted[frame_count] = {};
+            size_t _recording = 0;
+            size_t _replaying = 0;
+
+            size_t _queue_capacity;
+            render_queue _queue;
+
+            std::thread _thread;
+            std::mutex _lock;
+            std::condition_variable _changed;
+            bool _running = false;
+            uint64_t _completed_frames = 0;
+            std::exception_ptr _error;
+            /** @brief Only applied by the render thread, the swap interval belongs to the context. */
+            std::optional<int> _swap_interval;
+
+            void thread_func()
+            {
+                _window->make_context_current();
+                if(_swap_interval) glfwSwapInterval(*_swap_interval);
+                _queue.create(_queue_capacity);
+
+                for(;;)
+                {
+                    {
+                        std::unique_lock<std::mutex> guard(_lock);
+                        _changed.wait(guard, [this] { return _submitted[_replaying] || !_running; });
+                        if(!_submitted[_replaying]) break;
+                    }
+
+                    try
+                    {
+                        GLFW_PROFILE_SCOPE("render_thread::replay");
+                        _frames[_replaying]->execute(_queue);
+                        _queue.flush();
+                    }
+                    catch(...)
+                    {
+                        std::lock_guard<std::mutex> guard(_lock);
+                        if(!_error) _error = std::current_exception();
+                    }
+                    _window->swap_buffers();
+                    state::current().end_frame();
+                    GLFW_PROFILE_FRAME();
+
+                    {
+                        std::lock_guard<std::mutex> guard(_lock);
+                        _submitted[_replaying] = false;
+                        _completed_frames++;
+                    }
+                    _changed.notify_all();
+                    _replaying = (_replaying + 1) % frame_count;
+                }
+
+                // The queue owns GL objects, they must be deleted while the context is still current.
+                _queue = render_queue();
+                glfwMakeContextCurrent(nullptr);
+            }
+
+        public:
+            /**
+             * @param window The window whose context will be owned by the render thread.
+             * @param pool The pool whose workers will record the commands.
+             * @param queue_capacity? The number of packets that fit without growing the render queue.
+            */
+            render_thread(gl_window& window, jobs::thread_pool& pool, size_t queue_capacity=1024)
+                : _window(&window), _queue_capacity(queue_capacity)
+            {
+                for(std::unique_ptr<frame_commands>& frame : _frames) frame = std::make_unique<frame_commands>(pool);
+            }
+            render_thread(const render_thread&) = delete;
+            render_thread& operator=(const render_thread&) = delete;
+
+            /** @brief Moves the context of the window over to the render thread. It must be current on the calling thread. */
+            void start()
+            {
+                if(_running) return;
+
+                glfwMakeContextCurrent(nullptr);
+                _running = true;
+                _thread = std::thread(&render_thread::thread_func, this);
+            }
+
+            /** @brief Replays the frames that have been submitted and stops the render thread. The context is left released. */
+            void stop()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    if(!_running) return;
+                    _running = false;
+                }
+                _changed.notify_all();
+                if(_thread.joinable()) _thread.join();
+            }
+
+            /** @brief Whether or not the render thread is running. */
+            bool running() const noexcept(true) { return _running; }
+
+            /**
+             * @brief Sets the number of screen updates that a swap waits for. (0 turns vsync off) Only as the thread
+             * starts, it is ignored while running. The default is whatever the driver uses.
+            */
+            void set_swap_interval(int interval) noexcept(true) { _swap_interval = interval; }
+
+            /**
+             * @brief Returns the frame to record into. Waits until the render thread has finished replaying it, which is two
+             * frames ago. Rethrows the first exception that was thrown while replaying.
+            */
+            frame_commands& begin_frame()
+            {
+                GLFW_PROFILE_SCOPE("render_thread::begin_frame");
+                std::unique_lock<std::mutex> guard(_lock);
+                _changed.wait(guard, [this] { return !_submitted[_recording]; });
+                if(_error)
+                {
+                    std::exception_ptr error = _error;
+                    _error = nullptr;
+                    std::rethrow_exception(error);
+                }
+
+                _frames[_recording]->clear();
+                return *_frames[_recording];
+            }
+
+            /**
+             * @brief Same as begin_frame, but returns nullptr instead of waiting if the render thread hasn't finished
+             * replaying the frame yet. i.e. The frame is dropped rather than slowing down the caller.
+            */
+            frame_commands* try_begin_frame()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                if(_error)
+                {
+                    std::exception_ptr error = _error;
+                    _error = nullptr;
+                    std::rethrow_exception(error);
+                }
+                if(_submitted[_recording]) return nullptr;
+
+                _frames[_recording]->clear();
+                return _frames[_recording].get();
+            }
+
+            /** @brief Returns the frame that is being recorded. Only valid between begin_frame and submit. */
+            frame_commands& recording() noexcept(true) { return *_frames[_recording]; }
+
+            /** @brief Hands the frame that is being recorded over to the render thread, and moves on to the next frame. */
+            void submit()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    _submitted[_recording] = true;
+                }
+                _changed.notify_all();
+                _recording = (_recording + 1) % frame_count;
+            }
+
+            /** @brief Waits until every frame that has been submitted has been replayed. */
+            void wait_idle()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                _changed.wait(guard, [this]
+                {
+                    for(bool submitted : _submitted) if(submitted) return false;
+                    return true;
+                });
+            }
+
+            /** @brief Returns the number of frames that have been replayed. */
+            uint64_t completed_frames()
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                return _completed_frames;
+            }
+
+            gl_window& window() noexcept(true) { return *_window; }
+
+            /** @brief Stops the render thread if it is still running. */
+            ~render_thread() noexcept(true) { stop(); }
+        };
+    }; // namespace render
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
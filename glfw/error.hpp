@@ -1,98 +1,330 @@
-#ifndef _GLFW_ERRORS_DEFINTION_HPP_
-    #define _GLFW_ERRORS_DEFINTION_HPP_
-
-    #include <string>
-
-    #include "./glfw.hpp"
-
-    #include "stdio.h"
-
-    _GLFW_START_
-
-    /** @brief The namespace that contains the standard error class and other error related stuff. */
-    namespace error
-    { 
-        /** @brief A list of all the error messages. Range:[0,9) */
-        constexpr const char* errors[] = 
-        {
-            "GL_NO_ERROR",
-            "GL_INVALID_ENUM",
-            "GL_INVALID_VALUE",
-            "GL_INVALID_OPERATION",
-            "GL_STACK_OVERFLOW",
-            "GL_STACK_UNDERFLOW",
-            "GL_OUT_OF_MEMORY",
-            "GL_INVALID_FRAMEBUFFER_OPERATION",
-            "GL_CONTEXT_LOST"
-        };
-
-        /** @brief Converts an OpenGL error code into a readable string. */
-        #define CONVERT_GL_ERRCODE_TO_STRING(errcode) (errors[errcode==0?0:errcode-(GL_INVALID_ENUM-1)])
-
-        /** @brief The base error class. Other error classes can derive from this class. */
-        struct error_base 
-        { 
-        private:
-            GLenum _code = 0; 
-            std::string _msg; 
-
-        public:
-            error_base()=default;
-            error_base(const char* msg, GLenum code)
-                : _msg(msg), _code(code) {}
-
-            /** @brief The contents of the error. */
-            const char* what() const { return _msg.c_str(); } 
-            /** @brief The error code associated with the error. */
-            const GLenum code() const { return _code; }
-
-            /** 
-             * @brief Allows you to reuse this class to display another error. 
-             * @param msg The new error message to set.
-             * @param code The new error code to set.
-            */
-            void reuse(const char* msg, GLenum code)
-            {
-                _msg=msg;
-                _code=code; 
-            }
-
-            /** @brief Prints the error message to stdout (The standard console). */
-            void print() const { printf("errmsg:%s,\nerrcode:%u\n",_msg.c_str(),_code); }
-        };
-
-        using gl_error = error_base;
-
-        /** @brief Gets the last error on opengl's error stack. Side effects: It will pop the error off the stack so 
-         * that it wont be accessible after calling this function. */
-        gl_error get_last_error()
-        {
-            GLenum errcode = glGetError();
-            return gl_error {
-                CONVERT_GL_ERRCODE_TO_STRING(errcode),
-                errcode
-            };
-        }
-
-        using ERROR_READING_FUNCTION = void(*)(const gl_error&);
-
-        /** 
-         * @brief Executes the specified callback function for every error on the error stack. 
-         * @param func The callback function to execute. The function is: void (const gl_error&).
-        */
-        void read_error_stack(ERROR_READING_FUNCTION func)
-        {
-            GLenum errcode;
-            gl_error err;
-            while((errcode = glGetError()) != GL_NO_ERROR)
-            {
-                err.reuse(CONVERT_GL_ERRCODE_TO_STRING(errcode),errcode);
-                func(err);
-            }
-        }
-
-    }; // namespace error
-
-    _GLFW_END_
-
+#ifndef _GLFW_ERRORS_DEFINTION_HPP_
+    #define _GLFW_ERRORS_DEFINTION_HPP_
+
+    #include <string>
+    #include <atomic>
+    #include <cstring>
+
+    #include "./glfw.hpp"
+
+    #include "stdio.h"
+
+    /**
+     * Error checks (GLFW_CHECK_GL, which the wrappers issue their uploads and draws through, and the glGetError of
+     * get_last_error and read_error_stack) are compiled out in release builds (when NDEBUG is defined) unless 
+     * _GLFW_ENABLE_ERROR_CHECKS_ is defined. Define _GLFW_DISABLE_ERROR_CHECKS_ to compile them out in every build.
+    */
+    #if defined(NDEBUG) && !defined(_GLFW_ENABLE_ERROR_CHECKS_) && !defined(_GLFW_DISABLE_ERROR_CHECKS_)
+        #define _GLFW_DISABLE_ERROR_CHECKS_
+    #endif
+
+    _GLFW_START_
+
+    /** @brief The namespace that contains the standard error class and other error related stuff. */
+    namespace error
+    { 
+        /** @brief A list of all the error messages. Range:[0,9) */
+        constexpr const char* errors[] = 
+        {
+            "GL_NO_ERROR",
+            "GL_INVALID_ENUM",
+            "GL_INVALID_VALUE",
+            "GL_INVALID_OPERATION",
+            "GL_STACK_OVERFLOW",
+            "GL_STACK_UNDERFLOW",
+            "GL_OUT_OF_MEMORY",
+            "GL_INVALID_FRAMEBUFFER_OPERATION",
+            "GL_CONTEXT_LOST"
+        };
+
+        /** @brief Converts an OpenGL error code into a readable string. */
+        #define CONVERT_GL_ERRCODE_TO_STRING(errcode) (errors[errcode==0?0:errcode-(GL_INVALID_ENUM-1)])
+
+        /** @brief The base error class. Other error classes can derive from this class. */
+        struct error_base 
+        { 
+        private:
+            GLenum _code = 0; 
+            std::string _msg; 
+
+        public:
+            error_base()=default;
+            error_base(const char* msg, GLenum code)
+                : _msg(msg), _code(code) {}
+
+            /** @brief The contents of the error. */
+            const char* what() const { return _msg.c_str(); } 
+            /** @brief The error code associated with the error. */
+            const GLenum code() const { return _code; }
+
+            /** 
+             * @brief Allows you to reuse this class to display another error. 
+             * @param msg The new error message to set.
+             * @param code The new error code to set.
+            */
+            void reuse(const char* msg, GLenum code)
+            {
+                _msg=msg;
+                _code=code; 
+            }
+
+            /** @brief Prints the error message to stdout (The standard console). */
+            void print() const { printf("errmsg:%s,\nerrcode:%u\n",_msg.c_str(),_code); }
+        };
+
+        using gl_error = error_base;
+
+        /** @brief Gets the last error on opengl's error stack. Side effects: It will pop the error off the stack so 
+         * that it wont be accessible after calling this function. Always GL_NO_ERROR when the error checks are 
+         * compiled out, glGetError isn't called. */
+        gl_error get_last_error()
+        {
+        #ifdef _GLFW_DISABLE_ERROR_CHECKS_
+            GLenum errcode = GL_NO_ERROR;
+        #else
+            GLenum errcode = glGetError();
+        #endif
+            return gl_error {
+                CONVERT_GL_ERRCODE_TO_STRING(errcode),
+                errcode
+            };
+        }
+
+        using ERROR_READING_FUNCTION = void(*)(const gl_error&);
+
+        /** 
+         * @brief Executes the specified callback function for every error on the error stack. 
+         * @param func The callback function to execute. The function is: void (const gl_error&). It is never executed
+         * when the error checks are compiled out.
+        */
+        void read_error_stack(ERROR_READING_FUNCTION func)
+        {
+        #ifdef _GLFW_DISABLE_ERROR_CHECKS_
+            (void)func;
+        #else
+            GLenum errcode;
+            gl_error err;
+            while((errcode = glGetError()) != GL_NO_ERROR)
+            {
+                err.reuse(CONVERT_GL_ERRCODE_TO_STRING(errcode),errcode);
+                func(err);
+            }
+        #endif
+        }
+
+        /** @brief A message that was sent by the driver through the debug output. (GL_KHR_debug) */
+        struct debug_message
+        {
+            /** @brief The maximum length of the text of a message. Longer messages are cut off. */
+            static constexpr size_t max_length = 256;
+
+            GLenum source;
+            GLenum type;
+            GLuint id;
+            GLenum severity;
+            char text[max_length];
+
+            /** @brief Whether or not the message is an error. (The rest are warnings, performance hints, etc.) */
+            bool is_error() const { return type == GL_DEBUG_TYPE_ERROR; }
+
+            /** @brief Prints the message to stdout (The standard console). */
+            void print() const { printf("debugmsg:%s,\nid:%u,type:0x%X,severity:0x%X\n", text, id, type, severity); }
+        };
+
+        /**
+         * @brief A bounded queue of debug messages that can be pushed to from any thread without locking, as the driver
+         * may call the debug callback from its own threads. Once it is full, new messages are dropped and counted. 
+         * Refer to this site for a detailed explanation; @link https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+         * @tparam N The number of messages it can hold. Must be a power of two.
+        */
+        template <size_t N>
+        class debug_message_ring
+        {
+            static_assert(N && (N & (N - 1)) == 0, "The size of the ring must be a power of two.");
+
+        private:
+            struct slot
+            {
+                std::atomic<size_t> sequence;
+                debug_message message;
+            };
+
+            slot _slots[N];
+            alignas(64) std::atomic<size_t> _head = 0;
+            alignas(64) std::atomic<size_t> _tail = 0;
+            alignas(64) std::atomic<size_t> _dropped = 0;
+
+        public:
+            debug_message_ring() 
+            { 
+                for(size_t i = 0; i < N; i++) _slots[i].sequence.store(i, std::memory_order_relaxed); 
+            }
+
+            /** @brief Adds a message to the ring. Returns false (and drops the message) if the ring is full. */
+            bool push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text)
+            {
+                size_t position = _tail.load(std::memory_order_relaxed);
+                slot* current;
+                for(;;)
+                {
+                    current = &_slots[position & (N - 1)];
+                    size_t sequence = current->sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+                    if(difference == 0)
+                    {
+                        if(_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                    }
+                    else if(difference < 0)
+                    {
+                        _dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                    else position = _tail.load(std::memory_order_relaxed);
+                }
+
+                debug_message& message = current->message;
+                message.source = source;
+                message.type = type;
+                message.id = id;
+                message.severity = severity;
+
+                size_t text_length = length < 0 ? strlen(text) : static_cast<size_t>(length);
+                text_length = text_length < debug_message::max_length ? text_length : debug_message::max_length - 1;
+                memcpy(message.text, text, text_length);
+                message.text[text_length] = '\0';
+
+                current->sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+
+            /** @brief Removes the oldest message from the ring. Returns false if the ring is empty. */
+            bool pop(debug_message& message)
+            {
+                size_t position = _head.load(std::memory_order_relaxed);
+                slot* current;
+                for(;;)
+                {
+                    current = &_slots[position & (N - 1)];
+                    size_t sequence = current->sequence.load(std::memory_order_acquire);
+                    intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+                    if(difference == 0)
+                    {
+                        if(_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                    }
+                    else if(difference < 0) return false;
+                    else position = _head.load(std::memory_order_relaxed);
+                }
+
+                message = current->message;
+                current->sequence.store(position + N, std::memory_order_release);
+                return true;
+            }
+
+            /** @brief Returns the number of messages that were dropped because the ring was full. */
+            size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+        };
+
+        /** @brief The ring that the debug callback writes to. */
+        debug_message_ring<1024> debug_messages;
+
+        /** @brief Whether or not the debug output has been installed. (see: install_debug_output) */
+        bool debug_output_installed = false;
+
+        /** @brief The callback that is called by the driver, it only copies the message into the ring. */
+        void APIENTRY __debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void*)
+        {
+            debug_messages.push(source, type, id, severity, length, message);
+        }
+
+        /**
+         * @brief Starts recording the errors (and other messages) through the debug output, so that glGetError doesn't 
+         * have to be polled. Requires OpenGL 4.3 or GL_KHR_debug, some drivers only send messages if the window was 
+         * created with the GLFW_OPENGL_DEBUG_CONTEXT hint. Should be called after glfw::init_glad.
+         * @param min_severity? Messages less severe than this are not sent. i.e. GL_DEBUG_SEVERITY_HIGH, 
+         * GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW or GL_DEBUG_SEVERITY_NOTIFICATION.
+         * @returns Whether or not the debug output is supported by the current context.
+        */
+        bool install_debug_output(GLenum min_severity=GL_DEBUG_SEVERITY_LOW)
+        {
+            GLint major = 0, minor = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            if(major < 4 || (major == 4 && minor < 3)) if(!glfwExtensionSupported("GL_KHR_debug")) return false;
+
+            glEnable(GL_DEBUG_OUTPUT);
+            // Not synchronous on purpose, that would make the driver check every call on the calling thread. 
+            glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(__debug_message_callback, nullptr);
+
+            constexpr GLenum severities[] = { GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION };
+            bool enabled = true;
+            for(GLenum severity : severities)
+            {
+                glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, enabled ? GL_TRUE : GL_FALSE);
+                if(severity == min_severity) enabled = false;
+            }
+
+            return debug_output_installed = true;
+        }
+
+        /** @brief Stops recording messages through the debug output. */
+        void uninstall_debug_output()
+        {
+            if(!debug_output_installed) return;
+            glDebugMessageCallback(nullptr, nullptr);
+            glDisable(GL_DEBUG_OUTPUT);
+            debug_output_installed = false;
+        }
+
+        using DEBUG_MESSAGE_READING_FUNCTION = void(*)(const debug_message&);
+
+        /**
+         * @brief Executes the specified callback function for every message that was recorded by the debug output. The 
+         * messages are removed from the ring. Cheap enough to be called once per frame.
+         * @param func The callback function to execute. The function is: void (const debug_message&).
+         * @returns The number of messages that were read.
+        */
+        size_t read_debug_messages(DEBUG_MESSAGE_READING_FUNCTION func)
+        {
+            size_t count = 0;
+            debug_message message;
+            while(debug_messages.pop(message))
+            {
+                func(message);
+                count++;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Checks for errors after an OpenGL call. Only polls glGetError if the debug output isn't installed, 
+         * otherwise the errors will be in the debug ring. Use GLFW_CHECK_GL instead of calling this function.
+         * @param call The call that was checked.
+         * @param file The file where the call is.
+         * @param line The line where the call is.
+        */
+        void check_call(const char* call, const char* file, int line)
+        {
+            if(debug_output_installed) return;
+
+            GLenum errcode;
+            while((errcode = glGetError()) != GL_NO_ERROR)
+            {
+                fprintf(stderr, "%s:%d: %s (%s)\n", file, line, CONVERT_GL_ERRCODE_TO_STRING(errcode), call);
+            }
+        }
+
+    }; // namespace error
+
+    _GLFW_END_
+
+    /** @brief Executes the OpenGL call and checks for errors in debug builds. In release builds it only executes the call. */
+    #ifdef _GLFW_DISABLE_ERROR_CHECKS_
+        #define GLFW_CHECK_GL(call) call
+    #else
+        #define GLFW_CHECK_GL(call) do { call; ::glfw::error::check_call(#call, __FILE__, __LINE__); } while(0)
+    #endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,330 @@
+/**
+ * This header contains the fixed step frame loop that drives the simulation and the window.
+ *
+ * The simulation is advanced in steps of a constant size (ex; 1/60th of a second) no matter how long a
+ * frame takes to render. The time left over after the last step is passed to the renderer as an interpolation
+ * factor(alpha) so that it can blend the previous and the current state of the simulation.
+ *
+ * The simulation can also be run on a separate thread. In that case the renderer must read the state of the
+ * simulation from a copy (ex; double buffered) as the simulation thread will keep on writing to it.
+ *
+ * Alternatively the rendering can be moved to a render thread (see: command_buffer.hpp), the loop then only records
+ * the frames and the render thread submits them. The same goes for several windows, one render thread each.
+ * (see: window_group.hpp)
+ *
+ * Without a window (ex; on a build server, or to run simulations in batches) the loop runs the steps back to back,
+ * see: fixed_step_loop::run_headless. That is all that is left of the loop without OpenGL. (see: glfw.hpp)
+ *
+ * Refer to this site for a detailed explanation; @link https://gafferongames.com/post/fix_your_timestep/
+*/
+
+#ifndef _GLFW_FRAME_LOOP_DEFINITION_HPP_
+    #define _GLFW_FRAME_LOOP_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+    #include "./profiler.hpp"
+    #ifndef _GLFW_WITHOUT_OPENGL_
+        #include "./glwindow.hpp"
+        #include "./state_cache.hpp"
+        #include "./command_buffer.hpp"
+        #include "./window_group.hpp"
+    #endif
+
+    #include <atomic>
+    #include <functional>
+    #include <chrono>
+    #include <thread>
+    #include <cmath>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    /// @brief Advances the simulation in fixed steps and renders the window in between them.
+    class fixed_step_loop
+    {
+    public:
+        /// @brief The function that advances the simulation by @c step seconds. Any callable, ex; a lambda that captures the world.
+        using simulation_function_type = std::function<void(long double step)>;
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        simulation_function_type _simulation;
+
+        long double _step = 1.0L/60.0L;
+        unsigned _max_substeps = 8;
+
+        long double _accumulator = .0L;
+        long double _dropped_time = .0L;
+        unsigned _last_substeps = 0;
+
+        clock::time_point _last_frame;
+        bool _started = false;
+
+        std::thread _simulation_thread;
+        std::atomic<bool> _running = false;
+        std::atomic<uint64_t> _completed_steps = 0;
+        std::atomic<clock::rep> _last_step_time = 0;
+        /// @brief The time dropped by the simulation thread, it is read from the other threads.
+        std::atomic<uint64_t> _dropped_ns = 0;
+
+        static long double seconds_between(clock::time_point a, clock::time_point b)
+        {
+            return std::chrono::duration<long double>(b - a).count();
+        }
+
+        /// @brief The function that is executed by the simulation thread.
+        void simulation_thread_func()
+        {
+            clock::time_point last = clock::now();
+            long double accumulator = .0L;
+
+            while(_running.load(std::memory_order_relaxed))
+            {
+                clock::time_point current = clock::now();
+                long double frame_time = seconds_between(last, current), max_frame_time = _step*_max_substeps;
+                if(frame_time > max_frame_time)
+                {
+                    _dropped_ns.fetch_add(static_cast<uint64_t>((frame_time - max_frame_time) * std::chrono::nanoseconds::period::den),
+                        std::memory_order_relaxed);
+                    frame_time = max_frame_time;
+                }
+                accumulator += frame_time;
+                last = current;
+
+                while(accumulator >= _step)
+                {
+                    _simulation(_step);
+                    accumulator -= _step;
+
+                    _last_step_time.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                    _completed_steps.fetch_add(1, std::memory_order_release);
+                }
+
+                std::this_thread::sleep_for(std::chrono::duration<long double>(_step - accumulator));
+            }
+        }
+
+        /// @brief Measures the time since the last frame and advances the simulation (unless it runs on its own thread).
+        void begin_frame()
+        {
+            clock::time_point current = clock::now();
+            if(!_started)
+            {
+                _last_frame = current;
+                _started = true;
+            }
+
+            long double frame_time = seconds_between(_last_frame, current);
+            _last_frame = current;
+
+            glfw::time::frame_times.add(frame_time);
+            if(!_running.load(std::memory_order_relaxed)) advance(frame_time);
+        }
+
+    public:
+        fixed_step_loop() = default;
+        fixed_step_loop(const fixed_step_loop&) = delete;
+        fixed_step_loop& operator=(const fixed_step_loop&) = delete;
+
+        /// @brief Sets the function that advances the simulation. Should not be called while the simulation thread is running.
+        void set_simulation(simulation_function_type fn) { _simulation = std::move(fn); }
+
+        /// @brief Sets how many simulation steps are run per second (Hz). Should not be called while the simulation thread is running.
+        void set_step_rate(long double hz) noexcept(true) { _step = 1.0L/hz; }
+        /// @brief Returns the size of a single simulation step in seconds.
+        long double get_step() const noexcept(true) { return _step; }
+
+        /**
+         * @brief Sets the maximum number of steps that can be run in a single frame. Any time beyond that is dropped so
+         * that a slow frame can't cause an even slower next frame. (i.e. the spiral of death)
+        */
+        void set_max_substeps(unsigned n) noexcept(true) { _max_substeps = n ? n : 1; }
+        /// @brief Returns the maximum number of steps that can be run in a single frame.
+        unsigned get_max_substeps() const noexcept(true) { return _max_substeps; }
+
+        /**
+         * @brief Adds the time to the accumulator and runs as many simulation steps as fit into it.
+         * @param frame_time The time(in seconds) that has passed since the last call.
+         * @returns The number of steps that were run.
+        */
+        unsigned advance(long double frame_time)
+        {
+            long double max_frame_time = _step*_max_substeps;
+            if(frame_time > max_frame_time)
+            {
+                _dropped_time += frame_time - max_frame_time;
+                frame_time = max_frame_time;
+            }
+            _accumulator += frame_time;
+
+            unsigned substeps = 0;
+            while(_accumulator >= _step && substeps < _max_substeps)
+            {
+                if(_simulation) _simulation(_step);
+                _accumulator -= _step;
+                substeps++;
+
+                _completed_steps.fetch_add(1, std::memory_order_relaxed);
+            }
+            // Only happens due to rounding, a whole step must never be carried over to the next frame.
+            if(_accumulator >= _step)
+            {
+                _dropped_time += _accumulator - std::fmod(_accumulator, _step);
+                _accumulator = std::fmod(_accumulator, _step);
+            }
+
+            return _last_substeps = substeps;
+        }
+
+        /**
+         * @brief The interpolation factor between the previous and the current simulation step. Range:[0,1]
+         * It is 0 right after a step and it approaches 1 as the next step comes closer.
+        */
+        long double alpha() const noexcept(true)
+        {
+            if(!_running.load(std::memory_order_relaxed)) return _accumulator/_step;
+
+            long double since_last_step = seconds_between(
+                clock::time_point(clock::duration(_last_step_time.load(std::memory_order_relaxed))), clock::now());
+            return std::clamp(since_last_step/_step, .0L, 1.0L);
+        }
+
+        /// @brief The number of steps that were run during the last frame.
+        unsigned last_substeps() const noexcept(true) { return _last_substeps; }
+        /// @brief The total amount of time(in seconds) that was dropped to avoid the spiral of death. Includes the time dropped by the simulation thread.
+        long double dropped_time() const noexcept(true)
+        {
+            return _dropped_time + static_cast<long double>(_dropped_ns.load(std::memory_order_relaxed)) / std::chrono::nanoseconds::period::den;
+        }
+        /// @brief The total number of steps that have been completed. It can be read from any thread.
+        uint64_t completed_steps() const noexcept(true) { return _completed_steps.load(std::memory_order_acquire); }
+
+    #ifndef _GLFW_WITHOUT_OPENGL_
+        /**
+         * @brief Runs a single frame. i.e. advances the simulation (unless it is running on the simulation thread),
+         * renders the window using the interpolation factor, swaps the buffers and processes the events. The duration of
+         * the frame is recorded in glfw::time::frame_times.
+         * @param window A reference to the window. Its context must be current on the calling thread.
+        */
+        void frame(gl_window& window)
+        {
+            begin_frame();
+
+            {
+                GLFW_PROFILE_SCOPE("gl_window::render");
+                window.render(alpha());
+            }
+            window.swap_buffers();
+            window.handle_events();
+
+            state::current().end_frame();
+            GLFW_PROFILE_FRAME();
+        }
+
+        /// @brief Runs frames until the window recieves a close event.
+        /// @param window A reference to the window. Its context must be current on the calling thread.
+        void run(gl_window& window)
+        {
+            while(!window.event_listener.should_close()) frame(window);
+        }
+
+        /**
+         * @brief Runs a single frame whose commands are replayed by the render thread. i.e. advances the simulation, 
+         * records the frame by calling the renderer of the window (it should record into renderer.recording()) and 
+         * submits it. The render thread swaps the buffers, hence the simulation of the next frame runs while this one 
+         * is being submitted. (see: command_buffer.hpp)
+         * @param renderer The render thread. It must have been started.
+        */
+        void frame(render::render_thread& renderer)
+        {
+            begin_frame();
+
+            renderer.begin_frame();
+            {
+                GLFW_PROFILE_SCOPE("gl_window::render");
+                renderer.window().render(alpha());
+            }
+            renderer.submit();
+            renderer.window().handle_events();
+        }
+
+        /// @brief Runs frames on the render thread until its window recieves a close event. Waits for the last frame.
+        void run(render::render_thread& renderer)
+        {
+            while(!renderer.window().event_listener.should_close()) frame(renderer);
+            renderer.wait_idle();
+        }
+
+        /**
+         * @brief Runs a single frame of every window of the group. i.e. advances the simulation once, then records the
+         * frame of every window (by calling its renderer, it should record into group.renderer(i).recording()) with the
+         * same interpolation factor and submits them. The windows that are behind and drop their late frames are
+         * skipped, their renderers aren't called. (see: window_group::begin_frame)
+         * @param group The windows. It must have been started.
+        */
+        void frame(render::window_group& group)
+        {
+            begin_frame();
+
+            long double a = alpha();
+            group.begin_frame();
+            {
+                GLFW_PROFILE_SCOPE("gl_window::render");
+                for(size_t i = 0; i < group.view_count(); i++) if(group.is_recording(i)) group.window(i).render(a);
+            }
+            group.submit();
+            if(group.view_count()) group.window(0).handle_events();
+        }
+
+        /// @brief Runs frames until the main view of the group recieves a close event. Waits for the last frames.
+        void run(render::window_group& group)
+        {
+            while(!group.should_close()) frame(group);
+            group.wait_idle();
+        }
+    #endif
+
+        /**
+         * @brief Runs the simulation without a window, as fast as it can. i.e. the steps are run back to back instead of
+         * waiting for their time to come. Neither a window nor a context is needed, unless the simulation function
+         * itself calls OpenGL functions. (see: gl_window::create_headless) Every step is a frame of the profiler.
+         * @param steps The number of steps to run.
+        */
+        void run_headless(uint64_t steps)
+        {
+            if(!_simulation) return;
+            for(uint64_t i = 0; i < steps; i++)
+            {
+                _simulation(_step);
+                _completed_steps.fetch_add(1, std::memory_order_relaxed);
+                GLFW_PROFILE_FRAME();
+            }
+        }
+
+        /**
+         * @brief Moves the simulation to a separate thread. The simulation function will only ever be called from that
+         * thread until stop_simulation_thread is called. The simulation function must not call any OpenGL functions.
+        */
+        void start_simulation_thread()
+        {
+            if(!_simulation || _running.exchange(true)) return;
+
+            _last_step_time.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            _simulation_thread = std::thread(&fixed_step_loop::simulation_thread_func, this);
+        }
+
+        /// @brief Stops the simulation thread and waits for the step that it is running to finish.
+        void stop_simulation_thread()
+        {
+            if(!_running.exchange(false)) return;
+            if(_simulation_thread.joinable()) _simulation_thread.join();
+        }
+
+        /// @brief Stops the simulation thread if it is still running.
+        ~fixed_step_loop() noexcept(true) { stop_simulation_thread(); }
+    };
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
@@ -1,33 +1,41 @@
-/**
- * The default header that every file will have to include.
- * 
- * This for making it easier to refactor later on.
-*/
-
-#ifndef _GLFW_DEFINITION_HPP_
-    #define _GLFW_DEFINITION_HPP_
-
-    #define GLEW_STATIC
-        #include <glad/glad.h>
-    #include <GLFW/glfw3.h>
-
-    /// @brief The namespace that will contain all the abstractions and simplications for the opengl functions.
-    namespace glfw 
-    {
-        /// @brief Initialize GLFW library so that we can use all of it's functions.
-        void init() { glfwInit(); }
-        /// @brief Terminate GLFW library to free resources.
-        void terminate() { glfwTerminate(); }
-
-        /** 
-         * @brief Initialize GLAD library to use all of it's functions. Should be called after the window
-         * has been created and it's context has been made current. i.e. after a call of
-         * @c glfw::gl_window::make_context_current
-        */
-        void init_glad() { gladLoadGL(); }
-    };
-
-    #define _GLFW_START_ namespace glfw {
-    #define _GLFW_END_ };
-
+/**
+ * The default header that every file will have to include.
+ * 
+ * This for making it easier to refactor later on.
+ *
+ * Define _GLFW_WITHOUT_OPENGL_ before including any of the headers to leave glad and GLFW out. Only the CPU side
+ * (time, profiler scopes, thread pool, memory, mapped files) can be used then, none of the window or GL headers. The
+ * physics engine only needs that much. (ex; to benchmark it on a build server, see: bench/simulation_bench.cpp)
+*/
+
+#ifndef _GLFW_DEFINITION_HPP_
+    #define _GLFW_DEFINITION_HPP_
+
+    #ifndef _GLFW_WITHOUT_OPENGL_
+        #define GLEW_STATIC
+            #include <glad/glad.h>
+        #include <GLFW/glfw3.h>
+    #endif
+
+    /// @brief The namespace that will contain all the abstractions and simplications for the opengl functions.
+    namespace glfw 
+    {
+    #ifndef _GLFW_WITHOUT_OPENGL_
+        /// @brief Initialize GLFW library so that we can use all of it's functions.
+        void init() { glfwInit(); }
+        /// @brief Terminate GLFW library to free resources.
+        void terminate() { glfwTerminate(); }
+
+        /** 
+         * @brief Initialize GLAD library to use all of it's functions. Should be called after the window
+         * has been created and it's context has been made current. i.e. after a call of
+         * @c glfw::gl_window::make_context_current
+        */
+        void init_glad() { gladLoadGL(); }
+    #endif
+    };
+
+    #define _GLFW_START_ namespace glfw {
+    #define _GLFW_END_ };
+
 #endif
\ No newline at end of file
@@ -1,14 +1,14 @@
-/**
- * This header will contain functions to listen for and get user input.
- * 
- * Refer to this site for a detailed documentation;
- * @link https://www.glfw.org/docs/3.3/group__input.html
-*/
-
-#include "./glfw.hpp"
-
-#ifndef _GLFW_INPUT_DEFINITION_HPP_
-    #define _GLFW_INPUT_DEFINITION_HPP_
-    
-    
+/**
+ * This header will contain functions to listen for and get user input.
+ * 
+ * Refer to this site for a detailed documentation;
+ * @link https://www.glfw.org/docs/3.3/group__input.html
+*/
+
+#include "./glfw.hpp"
+
+#ifndef _GLFW_INPUT_DEFINITION_HPP_
+    #define _GLFW_INPUT_DEFINITION_HPP_
+    
+    
 #endif
\ No newline at end of file
@@ -0,0 +1,383 @@
+/**
+ * This header contains the loader context. It is an invisible window whose context shares its objects with the main
+ * window, and a background thread that keeps it current. Everything that is submitted to it (texture, buffer and
+ * shader uploads) runs on that thread, hence loading a new scene never takes time from the frames of the main context.
+ *
+ * Every upload is followed by a fence. The main context uses it to know when the GPU is done with the upload, either
+ * by polling it (see: upload::ready) or by making its own GPU wait for it (see: upload::get) which never blocks the CPU.
+ *
+ * Only the objects that hold data are shared between the contexts. i.e. Textures, buffers, programs, shaders, etc.
+ * Container objects such as vertex arrays and framebuffers are not, they must be created on the context that uses them.
+ * Binds aren't shared either, every context has its own state cache. (see: state_cache.hpp)
+ *
+ * The loader window is created (and destroyed) like any other window, on the main thread.
+ *
+ * Usage;
+ *  loading::loader_context loader;
+ *  loader.create(window);
+ *  loading::upload<GLuint> texture = loader.load_texture("./image.png");
+ *  ... later, on the main thread ...
+ *  if(texture.ready()) use(texture.get());
+*/
+
+#include "./glfw.hpp"
+#include "./glwindow.hpp"
+#include "./state_cache.hpp"
+#include "./shader.hpp"
+#include "./texture.hpp"
+#include "./texture_compressed.hpp"
+
+#ifdef _USE_STB_IMAGE_LOADER_
+    #include "./texture_streaming.hpp"
+#endif
+
+#ifndef _GLFW_LOADER_CONTEXT_DEFINITION_HPP_
+    #define _GLFW_LOADER_CONTEXT_DEFINITION_HPP_
+
+    #include <deque>
+    #include <vector>
+    #include <memory>
+    #include <thread>
+    #include <mutex>
+    #include <future>
+    #include <chrono>
+    #include <functional>
+    #include <condition_variable>
+    #include <type_traits>
+    #include <cstring>
+    #include <cstdio>
+
+    _GLFW_START_
+
+    namespace loading
+    {
+        class loader_context; // Opaque definition
+
+        /**
+         * @brief The result of something that was submitted to a loader context.
+         * @tparam T What the submitted function returned. ex; the id of a texture.
+        */
+        template <typename T>
+        class upload
+        {
+            struct record
+            {
+                std::promise<void> promise;
+                std::shared_future<void> done = promise.get_future().share();
+                /** @brief Written by the loader thread before the promise is fulfilled, only accessed by the owner after that. */
+                GLsync fence = nullptr;
+                T value{};
+
+                /** @brief The last reference can be dropped on either thread, both have a context that shares the fence. */
+                ~record() noexcept(true) { if(fence && glfwGetCurrentContext()) glDeleteSync(fence); }
+            };
+
+            std::shared_ptr<record> _record;
+
+            friend class loader_context;
+
+        public:
+            upload() = default;
+
+            /** @brief Whether or not this refers to an upload. */
+            bool valid() const noexcept(true) { return static_cast<bool>(_record); }
+
+            /** @brief Whether or not the loader thread has finished with the upload. The GPU may still be working on it. */
+            bool finished() const
+            {
+                return _record->done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            }
+
+            /**
+             * @brief Whether or not the GPU has finished the upload as well. Never waits. Must be called on a thread whose
+             * context shares with the loader context.
+            */
+            bool ready()
+            {
+                if(!finished()) return false;
+                if(!_record->fence) return true;
+                if(glClientWaitSync(_record->fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+
+                glDeleteSync(_record->fence);
+                _record->fence = nullptr;
+                return true;
+            }
+
+            /**
+             * @brief Waits for the loader thread to finish the upload and then makes the GPU of the calling context wait for
+             * it. (glWaitSync) The CPU doesn't wait for the GPU. Rethrows the exception if the submitted function threw one.
+             * @returns The value that the submitted function returned.
+            */
+            T& get()
+            {
+                _record->done.get();
+                if(_record->fence)
+                {
+                    glWaitSync(_record->fence, 0, GL_TIMEOUT_IGNORED);
+                    glDeleteSync(_record->fence);
+                    _record->fence = nullptr;
+                }
+                return _record->value;
+            }
+        };
+
+        /** @brief Owns the hidden loader window and the thread that its context is current on. (see: the top of this file) */
+        class loader_context
+        {
+        private:
+            std::unique_ptr<gl_window> _window;
+            std::thread _thread;
+
+            std::mutex _lock;
+            std::condition_variable _changed;
+            std::deque<std::function<void()>> _jobs;
+            size_t _busy = 0;
+            bool _running = false;
+
+            void thread_func()
+            {
+                _window->make_context_current();
+
+                for(;;)
+                {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> guard(_lock);
+                        _changed.wait(guard, [this] { return !_jobs.empty() || !_running; });
+                        if(_jobs.empty()) break;
+
+                        job = std::move(_jobs.front());
+                        _jobs.pop_front();
+                        _busy++;
+                    }
+
+                    job();
+
+                    {
+                        std::lock_guard<std::mutex> guard(_lock);
+                        _busy--;
+                    }
+                    _changed.notify_all();
+                }
+
+                glfwMakeContextCurrent(nullptr);
+            }
+
+            #ifdef _USE_STB_IMAGE_LOADER_
+                /** @brief Uploads every level of a KTX2 or DDS file into an immutable texture. Runs on the loader thread. */
+                static GLuint load_compressed_texture(const std::string& path, const texture::streaming::stream_options& options)
+                {
+                    texture::compressed::compressed_image image;
+                    if(!image.open(path.c_str())) return GLuint(0);
+                    if(!image.is_supported())
+                    {
+                        fprintf(stderr, "Unsupported compressed format in \"%s\"\n", path.c_str());
+                        return GLuint(0);
+                    }
+
+                    GLenum internal_format = image.format().internal_format;
+                    GLuint id = 0;
+                    glGenTextures(1, &id);
+                    state::current().bind_texture(GL_TEXTURE_2D, id);
+                    glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(image.level_count()), internal_format, image.width(), image.height());
+                    // The levels of the file are used as they are, none are generated.
+                    texture::texture_object::set_min_filter(image.level_count() > 1 ? options.min_filter : options.mag_filter);
+                    texture::texture_object::set_mag_filter(options.mag_filter);
+                    texture::texture_object::set_mapping_for_x_axis(options.wrap);
+                    texture::texture_object::set_mapping_for_y_axis(options.wrap);
+
+                    for(size_t i = 0; i < image.level_count(); i++)
+                    {
+                        const texture::compressed::compressed_level& level = image.level(i);
+                        texture::texture_object::update_compressed(static_cast<GLint>(i), 0, 0, level.width, level.height,
+                            internal_format, level.size, level.data);
+                    }
+                    state::current().bind_texture(GL_TEXTURE_2D, 0);
+                    return id;
+                }
+            #endif
+
+        public:
+            loader_context() = default;
+            loader_context(const loader_context&) = delete;
+            loader_context& operator=(const loader_context&) = delete;
+
+            /**
+             * @brief Creates the hidden window and starts the loader thread. Must be called on the main thread, like any other
+             * window. The hints that have been set (ex; the context version) are used for the loader context as well.
+             * @param main The window whose context will share its objects with the loader context.
+            */
+            void create(gl_window& main)
+            {
+                if(_running) return;
+
+                gl_window::set_hint(GLFW_VISIBLE, GLFW_FALSE);
+                _window = std::make_unique<gl_window>();
+                _window->create(1, 1, "", nullptr, main.context);
+                gl_window::set_hint(GLFW_VISIBLE, GLFW_TRUE);
+
+                _running = true;
+                _thread = std::thread(&loader_context::thread_func, this);
+            }
+
+            /**
+             * @brief Runs the function on the loader thread, with the loader context current. A fence is placed (and flushed)
+             * after it so that the other contexts can wait for whatever it uploaded.
+             * @param fn The function. It must return something, ex; the id of the object that it created.
+            */
+            template <typename Fn>
+            upload<std::invoke_result_t<Fn>> submit(Fn&& fn)
+            {
+                using result_type = std::invoke_result_t<Fn>;
+                static_assert(!std::is_void_v<result_type>, "The function must return something. ex; the id of the object.");
+
+                upload<result_type> result;
+                result._record = std::make_shared<typename upload<result_type>::record>();
+
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    _jobs.emplace_back([record = result._record, fn = std::forward<Fn>(fn)]() mutable
+                    {
+                        try
+                        {
+                            record->value = fn();
+                            record->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                            // The fence must reach the GPU, or the other contexts could wait for it forever.
+                            glFlush();
+                            record->promise.set_value();
+                        }
+                        catch(...) { record->promise.set_exception(std::current_exception()); }
+                    });
+                }
+                _changed.notify_all();
+                return result;
+            }
+
+            /**
+             * @brief Creates a buffer and uploads the data into it. The data is copied before this returns.
+             * @param target The target that the buffer is created with. ex; GL_ARRAY_BUFFER
+             * @param data The data.
+             * @param size The size(in bytes) of the data.
+             * @param usage? How and How much it will be used.
+             * @returns The id of the buffer.
+            */
+            upload<GLuint> upload_buffer(GLenum target, const void* data, size_t size, GLenum usage=GL_STATIC_DRAW)
+            {
+                std::vector<unsigned char> bytes(size);
+                if(size) std::memcpy(bytes.data(), data, size);
+
+                return submit([target, usage, bytes = std::move(bytes)]
+                {
+                    GLuint buffer = 0;
+                    glGenBuffers(1, &buffer);
+                    state::current().bind_buffer(target, buffer);
+                    glBufferData(target, bytes.size(), bytes.data(), usage);
+                    state::current().bind_buffer(target, 0);
+                    return buffer;
+                });
+            }
+
+            /**
+             * @brief Loads, compiles and links the shader program. The binary cache is used like in shader::loader::full_load_shader.
+             * @param paths The paths of the shaders.
+             * @returns The program.
+            */
+            upload<std::unique_ptr<shader::shader_program>> load_shader(const shader::shader_paths& paths)
+            {
+                return submit([paths]
+                {
+                    std::unique_ptr<shader::shader_program> program = shader::loader::get_shader(paths);
+                    shader::loader::full_load_shader(*program);
+                    return program;
+                });
+            }
+
+            #ifdef _USE_STB_IMAGE_LOADER_
+                /**
+                 * @brief Decodes the image and uploads it into an immutable texture, on the loader thread. KTX2 and DDS
+                 * files aren't decoded, their levels are uploaded straight from the mapped file. (see: texture_compressed.hpp)
+                 * @param path The path to the image.
+                 * @param options? How the texture should be created.
+                 * @returns The id of the texture, 0 if the image couldn't be decoded.
+                */
+                upload<GLuint> load_texture(const char* path, const texture::streaming::stream_options& options = {})
+                {
+                    return submit([path = std::string(path), options]
+                    {
+                        if(texture::compressed::is_compressed_container(path.c_str())) return load_compressed_texture(path, options);
+
+                        int width = 0, height = 0, channels = 0;
+                        ubyte_t* pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+                        if(!pixels)
+                        {
+                            fprintf(stderr, "Error loading image at \"%s\"\n", path.c_str());
+                            return GLuint(0);
+                        }
+
+                        GLenum internal_format, format;
+                        switch(channels)
+                        {
+                        case 1:  internal_format = GL_R8;    format = GL_RED;  break;
+                        case 2:  internal_format = GL_RG8;   format = GL_RG;   break;
+                        case 3:  internal_format = GL_RGB8;  format = GL_RGB;  break;
+                        default: internal_format = GL_RGBA8; format = GL_RGBA; break;
+                        }
+
+                        GLuint id = 0;
+                        glGenTextures(1, &id);
+                        state::current().bind_texture(GL_TEXTURE_2D, id);
+                        glTexStorage2D(GL_TEXTURE_2D, options.mipmaps ? texture::texture_object::mipmap_levels(width, height) : 1,
+                            internal_format, width, height);
+                        texture::texture_object::set_min_filter(options.mipmaps ? options.min_filter : options.mag_filter);
+                        texture::texture_object::set_mag_filter(options.mag_filter);
+                        texture::texture_object::set_mapping_for_x_axis(options.wrap);
+                        texture::texture_object::set_mapping_for_y_axis(options.wrap);
+
+                        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                        texture::texture_object::update(0, 0, 0, width, height, format, pixels);
+                        if(options.mipmaps) texture::texture_object::generate_mipmaps();
+                        state::current().bind_texture(GL_TEXTURE_2D, 0);
+
+                        stbi_image_free(pixels);
+                        return id;
+                    });
+                }
+            #endif
+
+            /** @brief Returns the number of jobs that haven't finished yet. */
+            size_t pending()
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                return _jobs.size() + _busy;
+            }
+
+            /** @brief Waits until every job that has been submitted has finished. (On the CPU) */
+            void wait_idle()
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                _changed.wait(guard, [this] { return _jobs.empty() && !_busy; });
+            }
+
+            /** @brief Finishes the jobs that have been submitted, stops the loader thread and destroys the hidden window. Must be called on the main thread. */
+            void destroy()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    if(!_running) return;
+                    _running = false;
+                }
+                _changed.notify_all();
+                if(_thread.joinable()) _thread.join();
+                _window.reset();
+            }
+
+            /** @brief Returns the hidden window. */
+            gl_window& window() noexcept(true) { return *_window; }
+
+            ~loader_context() noexcept(true) { destroy(); }
+        };
+    }; // namespace loading
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
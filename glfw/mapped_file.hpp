@@ -0,0 +1,152 @@
+/**
+ * This header contains the mapped_file class. It maps a whole file into the address space (read-only) so that its
+ * contents can be read, or handed to OpenGL, straight from the page cache without being read into a buffer first.
+ * The pages are only loaded from the disk when they are touched.
+ *
+ * Uses CreateFileMapping/MapViewOfFile on Windows and mmap everywhere else.
+*/
+
+#include "./glfw.hpp"
+
+#ifndef _GLFW_MAPPED_FILE_DEFINITION_HPP_
+    #define _GLFW_MAPPED_FILE_DEFINITION_HPP_
+
+    #include <cstdint>
+    #include <cstddef>
+    #include <cstdio>
+    #include <utility>
+
+    #ifdef _WIN32
+        #ifndef WIN32_LEAN_AND_MEAN
+            #define WIN32_LEAN_AND_MEAN
+        #endif
+        #ifndef NOMINMAX
+            #define NOMINMAX
+        #endif
+        #include <windows.h>
+    #else
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <fcntl.h>
+        #include <unistd.h>
+    #endif
+
+    _GLFW_START_
+
+    /** @brief A read-only view of a whole file. (see: the top of this file) The view stays valid until the file is closed. */
+    class mapped_file
+    {
+    private:
+        const unsigned char* _data = nullptr;
+        size_t _size = 0;
+
+    public:
+        mapped_file() = default;
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& other) noexcept(true)
+            : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)) {}
+        mapped_file& operator=(mapped_file&& other) noexcept(true)
+        {
+            if(this != &other)
+            {
+                close();
+                _data = std::exchange(other._data, nullptr);
+                _size = std::exchange(other._size, 0);
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Maps the file. A file that is already open is closed first.
+         * @param path The path to the file.
+         * @returns Whether or not the file could be mapped. An empty file can't be.
+        */
+        bool open(const char* path)
+        {
+            close();
+
+            #ifdef _WIN32
+                HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if(file == INVALID_HANDLE_VALUE)
+                {
+                    fprintf(stderr, "Error mapping file at \"%s\"\n", path);
+                    return false;
+                }
+
+                LARGE_INTEGER size;
+                HANDLE mapping = nullptr;
+                if(GetFileSizeEx(file, &size) && size.QuadPart > 0)
+                    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                // The view keeps the mapping (and the mapping keeps the file) open, the handles aren't needed anymore.
+                CloseHandle(file);
+                if(!mapping)
+                {
+                    fprintf(stderr, "Error mapping file at \"%s\"\n", path);
+                    return false;
+                }
+
+                _data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+                if(!_data)
+                {
+                    fprintf(stderr, "Error mapping file at \"%s\"\n", path);
+                    return false;
+                }
+                _size = static_cast<size_t>(size.QuadPart);
+            #else
+                int file = ::open(path, O_RDONLY);
+                struct stat info;
+                if(file < 0 || fstat(file, &info) != 0 || info.st_size <= 0)
+                {
+                    if(file >= 0) ::close(file);
+                    fprintf(stderr, "Error mapping file at \"%s\"\n", path);
+                    return false;
+                }
+
+                void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+                // The mapping keeps the file open.
+                ::close(file);
+                if(data == MAP_FAILED)
+                {
+                    fprintf(stderr, "Error mapping file at \"%s\"\n", path);
+                    return false;
+                }
+
+                _data = static_cast<const unsigned char*>(data);
+                _size = static_cast<size_t>(info.st_size);
+                // It is about to be read from start to end. (ex; uploaded)
+                madvise(data, _size, MADV_SEQUENTIAL);
+            #endif
+
+            return true;
+        }
+
+        /** @brief Unmaps the file. Every pointer into it becomes invalid. */
+        void close() noexcept(true)
+        {
+            if(!_data) return;
+
+            #ifdef _WIN32
+                UnmapViewOfFile(_data);
+            #else
+                munmap(const_cast<unsigned char*>(_data), _size);
+            #endif
+            _data = nullptr;
+            _size = 0;
+        }
+
+        bool is_open() const noexcept(true) { return _data != nullptr; }
+
+        /** @brief Returns the first byte of the file. The mapping starts at a page boundary, hence it is aligned to at least 4096 bytes. */
+        const unsigned char* data() const noexcept(true) { return _data; }
+        /** @brief Returns the size(in bytes) of the file. */
+        size_t size() const noexcept(true) { return _size; }
+
+        ~mapped_file() noexcept(true) { close(); }
+    };
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
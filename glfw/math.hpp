@@ -1,20 +1,23 @@
-/**
- * This header is not complete.
- * 
- * The file where all the definitions are; C:\MinGW\include\glm\glm.hpp
-*/
-
-#ifndef _GL_MATH_DEFINITION_HPP_
-    #define _GL_MATH_DEFINITION_HPP_
-
-    #include "./glfw.hpp"
-
-    #include "C:\MinGW\include\glm\glm.hpp"   
-    #include "C:\MinGW\include\glm\gtc\matrix_transform.hpp"
-    #include "C:\MinGW\include\glm\gtc\type_ptr.hpp"
-
-    /**
-     * This header just includes all the necessary headers for "math".
-    */
-
+/**
+ * This header is not complete.
+ * 
+ * The file where all the definitions are; C:\MinGW\include\glm\glm.hpp
+ * The headers are included through the include path (C:\MinGW\include is on it by default) so that they can 
+ * also be found on other platforms.
+*/
+
+#ifndef _GL_MATH_DEFINITION_HPP_
+    #define _GL_MATH_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+
+    #include <glm/glm.hpp>
+    #include <glm/gtc/matrix_transform.hpp>
+    #include <glm/gtc/type_ptr.hpp>
+    #include <glm/gtc/quaternion.hpp>
+
+    /**
+     * This header just includes all the necessary headers for "math".
+    */
+
 #endif
\ No newline at end of file
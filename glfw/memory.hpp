@@ -0,0 +1,410 @@
+/**
+ * This header contains the allocators of the engine. They are meant for the data that is rebuilt every step (or
+ * frame) and for small objects that are created and destroyed all the time, so that once the engine has warmed up
+ * its hot paths don't go to the heap anymore.
+ *
+ *  frame_arena   : A bump allocator. An allocation only moves a pointer forwards and everything is freed at once by
+ *                  reset(). If a step needed more than one block, the blocks are merged into a single one by the next
+ *                  reset, hence after the first few steps it never allocates again.
+ *  fixed_pool    : Hands out blocks of a single size from a free list. The blocks are only given back to the heap
+ *                  once the pool is destroyed.
+ *  thread_arenas : One frame_arena per worker of a thread pool, plus one for the thread that drives it.
+ *
+ * The counters (see: get_counters) count the blocks that these allocators take from the heap. Defining
+ * _GLFW_COUNT_ALLOCATIONS_ also replaces the global operator new and delete so that every allocation of the program
+ * is counted, that is what proves that a step doesn't allocate. (see: physics::world::step_allocations) Like the rest
+ * of the headers, it must only be included by a single translation unit then.
+*/
+
+#include "./glfw.hpp"
+#include "./thread_pool.hpp"
+
+#ifndef _GLFW_MEMORY_DEFINITION_HPP_
+    #define _GLFW_MEMORY_DEFINITION_HPP_
+
+    #include <new>
+    #include <atomic>
+    #include <memory>
+    #include <vector>
+    #include <cstdlib>
+    #include <cstdint>
+    #include <cstddef>
+    #include <algorithm>
+    #include <type_traits>
+
+    _GLFW_START_
+
+    namespace memory
+    {
+        /** @brief A snapshot of the allocation counters. */
+        struct allocation_counters
+        {
+            /** @brief The blocks that the arenas have taken from the heap. */
+            uint64_t arena_blocks = 0;
+            /** @brief The chunks that the pools have taken from the heap. */
+            uint64_t pool_chunks = 0;
+            /** @brief Every allocation of the program. Always 0 unless _GLFW_COUNT_ALLOCATIONS_ is defined. */
+            uint64_t heap_allocations = 0;
+            /** @brief The bytes of every allocation of the program. Always 0 unless _GLFW_COUNT_ALLOCATIONS_ is defined. */
+            uint64_t heap_bytes = 0;
+        };
+
+        namespace __counters
+        {
+            inline std::atomic<uint64_t> arena_blocks { 0 };
+            inline std::atomic<uint64_t> pool_chunks { 0 };
+            inline std::atomic<uint64_t> heap_allocations { 0 };
+            inline std::atomic<uint64_t> heap_bytes { 0 };
+        };
+
+        /** @brief Whether or not every allocation of the program is counted. (see: _GLFW_COUNT_ALLOCATIONS_) */
+        #ifdef _GLFW_COUNT_ALLOCATIONS_
+            constexpr bool counts_heap_allocations = true;
+        #else
+            constexpr bool counts_heap_allocations = false;
+        #endif
+
+        /** @brief Returns the counters. They only ever go up, subtract two snapshots to see what happened in between. */
+        allocation_counters get_counters()
+        {
+            allocation_counters counters;
+            counters.arena_blocks = __counters::arena_blocks.load(std::memory_order_relaxed);
+            counters.pool_chunks = __counters::pool_chunks.load(std::memory_order_relaxed);
+            counters.heap_allocations = __counters::heap_allocations.load(std::memory_order_relaxed);
+            counters.heap_bytes = __counters::heap_bytes.load(std::memory_order_relaxed);
+            return counters;
+        }
+
+        /** @brief Returns the number of allocations the engine (or with _GLFW_COUNT_ALLOCATIONS_, the program) has made so far. */
+        uint64_t allocation_count()
+        {
+            allocation_counters counters = get_counters();
+            return counts_heap_allocations ? counters.heap_allocations : counters.arena_blocks + counters.pool_chunks;
+        }
+
+        /** @brief A bump allocator that is reset as a whole. (see: the top of this file) Not thread safe. */
+        class frame_arena
+        {
+        private:
+            struct block
+            {
+                block* next;
+                size_t size;
+            };
+            /** @brief The data of a block starts right after its header, aligned like any fundamental type. */
+            static constexpr size_t header_size = (sizeof(block) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+            /** @brief The block that is being allocated from. The older blocks of this step follow it. */
+            block* _head = nullptr;
+            unsigned char* _cursor = nullptr;
+            unsigned char* _end = nullptr;
+            size_t _block_count = 0;
+
+            /** @brief The bytes that were used from the older blocks of this step. */
+            size_t _used_before = 0;
+            size_t _high_water = 0;
+            size_t _block_size;
+
+            static unsigned char* __data(block* b) { return reinterpret_cast<unsigned char*>(b) + header_size; }
+
+            void push_block(size_t size)
+            {
+                block* b = static_cast<block*>(::operator new(header_size + size));
+                b->next = _head;
+                b->size = size;
+                _head = b;
+                _cursor = __data(b);
+                _end = _cursor + size;
+                _block_count++;
+                __counters::arena_blocks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void free_blocks()
+            {
+                while(_head)
+                {
+                    block* next = _head->next;
+                    ::operator delete(_head);
+                    _head = next;
+                }
+                _cursor = _end = nullptr;
+                _block_count = 0;
+            }
+
+        public:
+            /// @param block_size? The size(in bytes) of the first block, and the smallest size of the blocks after it.
+            explicit frame_arena(size_t block_size = 64 * 1024) : _block_size(std::max<size_t>(block_size, 256)) {}
+
+            frame_arena(const frame_arena&) = delete;
+            frame_arena& operator=(const frame_arena&) = delete;
+
+            ~frame_arena() noexcept(true) { free_blocks(); }
+
+            /**
+             * @brief Allocates uninitialized memory that stays valid until the next reset.
+             * @param bytes The size(in bytes).
+             * @param alignment? A power of 2.
+            */
+            void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+            {
+                uintptr_t aligned = (reinterpret_cast<uintptr_t>(_cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+                if(!_head || aligned + bytes > reinterpret_cast<uintptr_t>(_end))
+                {
+                    if(_head) _used_before += static_cast<size_t>(_cursor - __data(_head));
+                    push_block(std::max(_block_size, bytes + alignment));
+                    aligned = (reinterpret_cast<uintptr_t>(_cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+                }
+                _cursor = reinterpret_cast<unsigned char*>(aligned + bytes);
+                return reinterpret_cast<void*>(aligned);
+            }
+
+            /**
+             * @brief Allocates an uninitialized array that stays valid until the next reset. Nothing is ever destroyed,
+             * hence T must be trivially destructible.
+             * @param count The number of elements.
+            */
+            template <typename T>
+            T* allocate(size_t count)
+            {
+                static_assert(std::is_trivially_destructible_v<T>, "The arena never destroys anything.");
+                return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+            }
+
+            /** @brief Same as allocate<T> but every element is value initialized. */
+            template <typename T>
+            T* allocate_zeroed(size_t count)
+            {
+                T* data = allocate<T>(count);
+                std::uninitialized_value_construct_n(data, count);
+                return data;
+            }
+
+            /**
+             * @brief Frees everything that has been allocated. If more than one block was used, they are replaced by a
+             * single block that is large enough for all of it, so that the next step fits without allocating.
+            */
+            void reset()
+            {
+                _high_water = std::max(_high_water, used());
+                _used_before = 0;
+                if(_block_count > 1 || (_head && _head->size < _high_water))
+                {
+                    free_blocks();
+                    _block_size = std::max(_block_size, _high_water + _high_water / 8);
+                    push_block(_block_size);
+                }
+                else if(_head) _cursor = __data(_head);
+            }
+
+            /**
+             * @brief Makes sure that @p bytes fit in a single block from the next reset on, so that the steps that
+             * need that much don't allocate. ex; the scratch memory of the solver for the most constraints so far.
+             * @param bytes The size(in bytes), including the padding of every allocation.
+            */
+            void reserve(size_t bytes) noexcept(true) { _high_water = std::max(_high_water, bytes); }
+
+            /** @brief The bytes that have been allocated since the last reset, including the padding. */
+            size_t used() const noexcept(true) { return _head ? _used_before + static_cast<size_t>(_cursor - __data(_head)) : 0; }
+            /** @brief The most bytes that were ever allocated between two resets. */
+            size_t high_water() const noexcept(true) { return std::max(_high_water, used()); }
+            /** @brief The number of blocks that are being used. 1 once the arena has warmed up. */
+            size_t block_count() const noexcept(true) { return _block_count; }
+        };
+
+        /**
+         * @brief Lets the standard containers allocate from a frame_arena. Deallocating does nothing, the memory is freed
+         * by reset, hence a container must not be used after its arena has been reset.
+        */
+        template <typename T>
+        class arena_allocator
+        {
+        public:
+            using value_type = T;
+
+            frame_arena* arena;
+
+            explicit arena_allocator(frame_arena& a) noexcept(true) : arena(&a) {}
+            template <typename U>
+            arena_allocator(const arena_allocator<U>& other) noexcept(true) : arena(other.arena) {}
+
+            T* allocate(size_t count) { return static_cast<T*>(arena->allocate(sizeof(T) * count, alignof(T))); }
+            void deallocate(T*, size_t) noexcept(true) {}
+
+            template <typename U>
+            bool operator==(const arena_allocator<U>& other) const noexcept(true) { return arena == other.arena; }
+            template <typename U>
+            bool operator!=(const arena_allocator<U>& other) const noexcept(true) { return arena != other.arena; }
+        };
+
+        /** @brief A vector that lives in a frame_arena. */
+        template <typename T>
+        using arena_vector = std::vector<T, arena_allocator<T>>;
+
+        /**
+         * @brief Hands out blocks that fit a T from a free list. The blocks are taken from the heap in chunks and are
+         * reused until the pool is destroyed. Not thread safe.
+         * @tparam T The type of the objects.
+        */
+        template <typename T>
+        class fixed_pool
+        {
+        private:
+            union slot
+            {
+                slot* next;
+                alignas(T) unsigned char storage[sizeof(T)];
+            };
+
+            std::vector<std::unique_ptr<slot[]>> _chunks;
+            slot* _free = nullptr;
+            size_t _chunk_size;
+            size_t _live = 0;
+
+            void grow()
+            {
+                slot* chunk = new slot[_chunk_size];
+                _chunks.emplace_back(chunk);
+                for(size_t i = _chunk_size; i > 0; i--)
+                {
+                    chunk[i - 1].next = _free;
+                    _free = &chunk[i - 1];
+                }
+                __counters::pool_chunks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+        public:
+            /// @param chunk_size? The number of objects that are taken from the heap at once.
+            explicit fixed_pool(size_t chunk_size = 64) : _chunk_size(std::max<size_t>(chunk_size, 1)) {}
+
+            fixed_pool(const fixed_pool&) = delete;
+            fixed_pool& operator=(const fixed_pool&) = delete;
+
+            /** @brief Takes a block that fits a T. It is uninitialized. */
+            void* allocate()
+            {
+                if(!_free) grow();
+                slot* s = _free;
+                _free = s->next;
+                _live++;
+                return s->storage;
+            }
+
+            /** @brief Puts a block back into the free list. */
+            void deallocate(void* pointer) noexcept(true)
+            {
+                slot* s = reinterpret_cast<slot*>(pointer);
+                s->next = _free;
+                _free = s;
+                _live--;
+            }
+
+            /** @brief Constructs a T in a block from the pool. */
+            template <typename... Args>
+            T* create(Args&&... args) { return new(allocate()) T(std::forward<Args>(args)...); }
+
+            /** @brief Destroys an object that was created by create and puts its block back. */
+            void destroy(T* object) noexcept(true)
+            {
+                object->~T();
+                deallocate(object);
+            }
+
+            /** @brief Makes sure that at least @c count objects can be created without going to the heap. */
+            void reserve(size_t count)
+            {
+                while(_chunks.size() * _chunk_size < count) grow();
+            }
+
+            /** @brief The number of objects that are currently allocated. */
+            size_t live() const noexcept(true) { return _live; }
+            /** @brief The number of objects that fit without going to the heap again. */
+            size_t capacity() const noexcept(true) { return _chunks.size() * _chunk_size; }
+        };
+
+        /**
+         * @brief One arena for every worker of a thread pool and one for the thread that drives it. A job can take the
+         * arena of the worker it is running on without any synchronization. (see: local)
+        */
+        class thread_arenas
+        {
+        private:
+            jobs::thread_pool* _pool;
+            std::vector<std::unique_ptr<frame_arena>> _arenas;
+
+        public:
+            /// @param pool The pool whose workers will use the arenas.
+            /// @param block_size? The size(in bytes) of the first block of every arena.
+            explicit thread_arenas(jobs::thread_pool& pool, size_t block_size = 64 * 1024) : _pool(&pool)
+            {
+                _arenas.reserve(pool.size() + 1);
+                for(size_t i = 0; i <= pool.size(); i++) _arenas.push_back(std::make_unique<frame_arena>(block_size));
+            }
+
+            /**
+             * @brief Returns the arena of the calling thread. Every thread that isn't a worker of the pool shares the last
+             * arena, hence only one of them (the one that drives the pool) may use it.
+            */
+            frame_arena& local() { return *_arenas[_pool->worker_index()]; }
+
+            /** @brief Resets every arena. Must only be called while none of them is being used. ex; between two steps */
+            void reset()
+            {
+                for(std::unique_ptr<frame_arena>& arena : _arenas) arena->reset();
+            }
+
+            /** @brief The bytes that have been allocated from all the arenas since the last reset. */
+            size_t used() const
+            {
+                size_t total = 0;
+                for(const std::unique_ptr<frame_arena>& arena : _arenas) total += arena->used();
+                return total;
+            }
+
+            size_t size() const noexcept(true) { return _arenas.size(); }
+            frame_arena& operator[](size_t index) { return *_arenas[index]; }
+        };
+    }; // namespace memory
+
+    _GLFW_END_
+
+    #ifdef _GLFW_COUNT_ALLOCATIONS_
+        /**
+         * The replacements of the global operator new and delete that count every allocation. The aligned versions
+         * keep the pointer that malloc returned right before the aligned block.
+        */
+        void* __glfw_counted_alloc(size_t size)
+        {
+            glfw::memory::__counters::heap_allocations.fetch_add(1, std::memory_order_relaxed);
+            glfw::memory::__counters::heap_bytes.fetch_add(size, std::memory_order_relaxed);
+            if(void* pointer = std::malloc(size ? size : 1)) return pointer;
+            throw std::bad_alloc();
+        }
+        void* __glfw_counted_aligned_alloc(size_t size, std::align_val_t alignment)
+        {
+            size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+            unsigned char* raw = static_cast<unsigned char*>(__glfw_counted_alloc(size + align + sizeof(void*)));
+            uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + align - 1) & ~(uintptr_t(align) - 1);
+            reinterpret_cast<void**>(aligned)[-1] = raw;
+            return reinterpret_cast<void*>(aligned);
+        }
+        void __glfw_counted_aligned_free(void* pointer) noexcept(true)
+        {
+            if(pointer) std::free(reinterpret_cast<void**>(pointer)[-1]);
+        }
+
+        void* operator new(size_t size) { return __glfw_counted_alloc(size); }
+        void* operator new[](size_t size) { return __glfw_counted_alloc(size); }
+        void* operator new(size_t size, std::align_val_t alignment) { return __glfw_counted_aligned_alloc(size, alignment); }
+        void* operator new[](size_t size, std::align_val_t alignment) { return __glfw_counted_aligned_alloc(size, alignment); }
+
+        void operator delete(void* pointer) noexcept(true) { std::free(pointer); }
+        void operator delete[](void* pointer) noexcept(true) { std::free(pointer); }
+        void operator delete(void* pointer, size_t) noexcept(true) { std::free(pointer); }
+        void operator delete[](void* pointer, size_t) noexcept(true) { std::free(pointer); }
+        void operator delete(void* pointer, std::align_val_t) noexcept(true) { __glfw_counted_aligned_free(pointer); }
+        void operator delete[](void* pointer, std::align_val_t) noexcept(true) { __glfw_counted_aligned_free(pointer); }
+        void operator delete(void* pointer, size_t, std::align_val_t) noexcept(true) { __glfw_counted_aligned_free(pointer); }
+        void operator delete[](void* pointer, size_t, std::align_val_t) noexcept(true) { __glfw_counted_aligned_free(pointer); }
+    #endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,307 @@
+/**
+ * This header contains the binary mesh asset format and its loader. An asset file holds everything that a group of
+ * meshes needs at runtime, already in the layout that it is used in;
+ *  - The vertices, interleaved exactly like the vertex buffer, and the layout of their attributes.
+ *  - The indices, grouped by mesh. A mesh is drawn with its first_index and base_vertex (see: draw_command) hence all
+ *    the meshes of a file share one vertex and one index buffer.
+ *  - The points of a convex hull per mesh, for physics::shape::convex. (see: physics::convex_hull)
+ *  - A bounding volume hierarchy over the triangles of every mesh, for ray casts against the render geometry.
+ *
+ * The file is memory-mapped (see: mapped_file.hpp) and is never parsed; the header is validated once and every
+ * section is then used in place. The buffers are uploaded straight from the mapping and hull_points can be handed to
+ * physics::convex_hull as they are. Nothing is copied on the CPU.
+ *
+ * The layout of a file (every section starts at a multiple of section_alignment, see: mesh_format.hpp);
+ *  file_header | vertices | indices | mesh_record[mesh_count] | glm::vec3 hull points | bvh_node[]
+ *
+ * Files are written by the converter in tools/ (see: tools/mesh_converter.cpp) and are little-endian. A file whose
+ * version isn't mesh_file_version is refused, it has to be converted again.
+ *
+ * Usage;
+ *  assets::mesh_file file;
+ *  if(!file.open("./level.mesh")) ...
+ *  file.upload(vbo, ibo);                  // Or; assets::load_mesh_file(loader, file) on the loader context,
+ *                                          // when loader_context.hpp is included before this header.
+ *  vao.bind(); vbo.bind(); ibo.bind();
+ *  file.create_attributes(vao);
+ *  ... queue.push with file.draw_command(i, instances, base_instance) ...
+ *  physics::convex_hull hull(file.hull_points(i), file.mesh(i).hull_count);
+ *  world.hulls().set(i, hull);             // The index of the mesh is a stable id for the snapshots.
+ *  desc.shape = physics::shape::convex(world.hulls(), i);
+*/
+
+#include "./glfw.hpp"
+#include "./math.hpp"
+#include "./mapped_file.hpp"
+#include "./mesh_format.hpp"
+#include "./vbo.hpp"
+#include "./vao.hpp"
+
+#ifndef _GLFW_MESH_ASSET_DEFINITION_HPP_
+    #define _GLFW_MESH_ASSET_DEFINITION_HPP_
+
+    #include <memory>
+    #include <cstdint>
+    #include <cstddef>
+    #include <cstdio>
+    #include <cstring>
+    #include <cmath>
+    #include <limits>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace assets
+    {
+        static_assert(type_float == GL_FLOAT && type_int_2_10_10_10_rev == GL_INT_2_10_10_10_REV
+            && type_unsigned_short == GL_UNSIGNED_SHORT && type_unsigned_int == GL_UNSIGNED_INT, "The enums of the format are the enums of OpenGL.");
+
+        /** @brief Where a ray hit a mesh. */
+        struct mesh_hit
+        {
+            /** @brief The distance along the (normalized) direction. */
+            float distance;
+            /** @brief The triangle of the mesh that was hit. The indices are [first_index + 3*triangle, +3) */
+            uint32_t triangle;
+            /** @brief The barycentric coordinates of the point on the triangle, for the 2nd and the 3rd vertex. */
+            float u, v;
+        };
+
+        /** @brief A mapped mesh asset. (see: the top of this file) */
+        class mesh_file
+        {
+        private:
+            mapped_file _file;
+            const file_header* _header = nullptr;
+
+            template <typename T>
+            const T* section(const file_section& s) const noexcept(true) { return reinterpret_cast<const T*>(_file.data() + s.offset); }
+
+            size_t index_size() const noexcept(true) { return _header->index_type == GL_UNSIGNED_SHORT ? 2 : 4; }
+
+            /** @brief Returns the position of a vertex of the mesh. */
+            glm::vec3 position(const mesh_record& m, uint32_t index) const noexcept(true)
+            {
+                const unsigned char* vertex = vertex_data() + size_t(uint32_t(m.base_vertex) + index) * _header->vertex_stride
+                    + _header->attributes[0].offset;
+                glm::vec3 p;
+                std::memcpy(&p, vertex, sizeof(p));
+                return p;
+            }
+
+            uint32_t index(uint32_t i) const noexcept(true)
+            {
+                if(_header->index_type == GL_UNSIGNED_SHORT) return reinterpret_cast<const uint16_t*>(index_data())[i];
+                return reinterpret_cast<const uint32_t*>(index_data())[i];
+            }
+
+        public:
+            mesh_file() = default;
+            mesh_file(const mesh_file&) = delete;
+            mesh_file& operator=(const mesh_file&) = delete;
+
+            /**
+             * @brief Maps and validates the file. A file that is already open is closed first.
+             * @param path The path to the file.
+             * @returns Whether or not the file could be mapped and is a valid mesh file of the current version.
+            */
+            bool open(const char* path)
+            {
+                close();
+                if(!_file.open(path)) return false;
+
+                _header = reinterpret_cast<const file_header*>(_file.data());
+                if(!validate_mesh_file(_file.data(), _file.size()))
+                {
+                    fprintf(stderr, "Error loading mesh asset at \"%s\"\n", path);
+                    close();
+                    return false;
+                }
+                return true;
+            }
+
+            /** @brief Unmaps the file. Buffers that were uploaded from it stay valid, the hulls that use its points don't. */
+            void close() noexcept(true)
+            {
+                _file.close();
+                _header = nullptr;
+            }
+
+            bool is_open() const noexcept(true) { return _header != nullptr; }
+
+            const file_header& header() const noexcept(true) { return *_header; }
+            size_t mesh_count() const noexcept(true) { return _header->mesh_count; }
+            const mesh_record& mesh(size_t i) const noexcept(true) { return section<mesh_record>(_header->meshes)[i]; }
+
+            /** @brief Returns the vertices, in the layout of the vertex buffer. */
+            const unsigned char* vertex_data() const noexcept(true) { return section<unsigned char>(_header->vertices); }
+            size_t vertex_data_size() const noexcept(true) { return static_cast<size_t>(_header->vertices.size); }
+            /** @brief Returns the indices, of header().index_type. */
+            const unsigned char* index_data() const noexcept(true) { return section<unsigned char>(_header->indices); }
+            size_t index_data_size() const noexcept(true) { return static_cast<size_t>(_header->indices.size); }
+
+            /** @brief Returns the points of the convex hull of the mesh. (mesh(i).hull_count of them) */
+            const glm::vec3* hull_points(size_t i) const noexcept(true) { return section<glm::vec3>(_header->hull_points) + mesh(i).hull_first; }
+            /** @brief Returns the nodes of the hierarchy of the mesh. (mesh(i).bvh_count of them) The first one is the root. */
+            const bvh_node* bvh(size_t i) const noexcept(true) { return section<bvh_node>(_header->bvh_nodes) + mesh(i).bvh_first; }
+
+            /**
+             * @brief Creates the vertex and the index buffer straight from the mapping. The buffers are bound while they
+             * are created.
+             * @param vertices The vertex buffer. (GL_ARRAY_BUFFER)
+             * @param indices The index buffer. (GL_ELEMENT_ARRAY_BUFFER) The vertex array that it is used with must be bound.
+             * @param usage? How and How much they will be used.
+            */
+            void upload(buffer_object& vertices, buffer_object& indices, GLenum usage=GL_STATIC_DRAW) const
+            {
+                vertices.bind();
+                vertices.create<unsigned char>(vertex_data(), vertex_data_size(), usage);
+                indices.bind();
+                indices.create<unsigned char>(index_data(), index_data_size(), usage);
+            }
+
+            /**
+             * @brief Creates and enables the attributes of the vertices. The vertex array and the vertex buffer must be bound.
+             * @param vao The vertex array.
+            */
+            void create_attributes(vertex_array_object& vao) const
+            {
+                for(uint32_t i = 0; i < _header->attribute_count; i++)
+                {
+                    const vertex_attribute& a = _header->attributes[i];
+                    vao.create_attribute(a.location, a.count, a.type, a.normalized != 0, _header->vertex_stride,
+                        reinterpret_cast<const void*>(static_cast<uintptr_t>(a.offset)));
+                    vao.enable_attribute(a.location);
+                }
+            }
+
+            /** @brief Returns the indirect command that draws the mesh from the buffers of upload. */
+            draw_elements_indirect_command draw_command(size_t i, GLuint instance_count=1, GLuint base_instance=0) const noexcept(true)
+            {
+                const mesh_record& m = mesh(i);
+                return draw_elements_indirect_command { m.index_count, instance_count, m.first_index, m.base_vertex, base_instance };
+            }
+
+            /**
+             * @brief Casts a ray against the triangles of the mesh, using its hierarchy. Both sides of the triangles are hit.
+             * @param i The mesh.
+             * @param origin The origin of the ray, in the space of the mesh.
+             * @param direction The direction of the ray. Should be normalized.
+             * @param max_distance The length of the ray.
+             * @param hit Where the ray hit the mesh, only written if it did.
+             * @returns Whether or not the ray hit the mesh.
+            */
+            bool raycast(size_t i, const glm::vec3& origin, const glm::vec3& direction, float max_distance, mesh_hit& hit) const
+            {
+                const mesh_record& m = mesh(i);
+                if(!m.bvh_count) return false;
+
+                const bvh_node* nodes = bvh(i);
+                glm::vec3 inverse;
+                for(int k = 0; k < 3; k++) inverse[k] = direction[k] != 0.0f ? 1.0f / direction[k] : std::numeric_limits<float>::infinity();
+
+                // A ray against a box. (the slab test)
+                auto enter = [&](const bvh_node& n)
+                {
+                    glm::vec3 t0 = (n.min - origin) * inverse, t1 = (n.max - origin) * inverse;
+                    glm::vec3 entry = glm::min(t0, t1), exit = glm::max(t0, t1);
+                    float t_near = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.0f));
+                    float t_far = std::min(std::min(exit.x, exit.y), std::min(exit.z, max_distance));
+                    // NaNs (0 * infinity) fail the comparison, hence a ray on the plane of a slab is treated as inside.
+                    return !(t_near > t_far);
+                };
+
+                bool found = false;
+                uint32_t stack[64];
+                size_t size = 0;
+                stack[size++] = 0;
+                while(size)
+                {
+                    uint32_t node = stack[--size];
+                    const bvh_node& n = nodes[node];
+                    if(!enter(n)) continue;
+
+                    if(!n.is_leaf())
+                    {
+                        // The hierarchy is built by the converter, it is never deeper than the stack.
+                        if(size + 2 > 64) continue;
+                        stack[size++] = n.first;
+                        stack[size++] = node + 1;
+                        continue;
+                    }
+
+                    for(uint32_t t = n.first; t < n.first + n.count; t++)
+                    {
+                        uint32_t first = m.first_index + 3 * t;
+                        glm::vec3 a = position(m, index(first)), b = position(m, index(first + 1)), c = position(m, index(first + 2));
+
+                        // Möller–Trumbore
+                        glm::vec3 ab = b - a, ac = c - a;
+                        glm::vec3 p = glm::cross(direction, ac);
+                        float determinant = glm::dot(ab, p);
+                        if(std::abs(determinant) < 1e-12f) continue;
+
+                        float inverse_determinant = 1.0f / determinant;
+                        glm::vec3 s = origin - a;
+                        float u = glm::dot(s, p) * inverse_determinant;
+                        if(u < 0.0f || u > 1.0f) continue;
+                        glm::vec3 q = glm::cross(s, ab);
+                        float v = glm::dot(direction, q) * inverse_determinant;
+                        if(v < 0.0f || u + v > 1.0f) continue;
+
+                        float distance = glm::dot(ac, q) * inverse_determinant;
+                        if(distance < 0.0f || distance > max_distance) continue;
+
+                        // The rest of the ray is shortened, the boxes behind the hit are skipped.
+                        max_distance = distance;
+                        hit = mesh_hit { distance, t, u, v };
+                        found = true;
+                    }
+                }
+                return found;
+            }
+        };
+
+        /** @brief The buffers of a mesh file that was uploaded on a loader context. */
+        struct mesh_buffers
+        {
+            GLuint vertices = 0;
+            GLuint indices = 0;
+        };
+
+        #ifdef _GLFW_LOADER_CONTEXT_DEFINITION_HPP_
+            /**
+             * @brief Creates the vertex and the index buffer of the file on the loader thread, straight from the mapping.
+             * The file is kept open until the upload has finished. (see: loading::loader_context)
+             * @param loader The loader context.
+             * @param file The file. It must be open.
+             * @param usage? How and How much they will be used.
+             * @returns The ids of the buffers.
+            */
+            loading::upload<mesh_buffers> load_mesh_file(loading::loader_context& loader, std::shared_ptr<const mesh_file> file,
+                GLenum usage=GL_STATIC_DRAW)
+            {
+                return loader.submit([file = std::move(file), usage]
+                {
+                    mesh_buffers buffers;
+                    GLuint ids[2];
+                    glGenBuffers(2, ids);
+                    buffers.vertices = ids[0];
+                    buffers.indices = ids[1];
+
+                    // The element array binding belongs to the vertex array, which isn't shared. Both are uploaded
+                    // through GL_ARRAY_BUFFER, the target doesn't matter to the buffer itself.
+                    state::current().bind_buffer(GL_ARRAY_BUFFER, buffers.vertices);
+                    glBufferData(GL_ARRAY_BUFFER, file->vertex_data_size(), file->vertex_data(), usage);
+                    state::current().bind_buffer(GL_ARRAY_BUFFER, buffers.indices);
+                    glBufferData(GL_ARRAY_BUFFER, file->index_data_size(), file->index_data(), usage);
+                    state::current().bind_buffer(GL_ARRAY_BUFFER, 0);
+                    return buffers;
+                });
+            }
+        #endif
+    }; // namespace assets
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
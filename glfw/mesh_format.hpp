@@ -0,0 +1,197 @@
+/**
+ * This header contains the layout of the mesh asset format (see: mesh_asset.hpp); the structs that are read from the
+ * file as they are. It doesn't include OpenGL, so that the offline converter (see: tools/mesh_converter.cpp) can be
+ * built without it. The enums that the file stores are the values of their OpenGL counterparts.
+*/
+
+#ifndef _GLFW_MESH_FORMAT_DEFINITION_HPP_
+    #define _GLFW_MESH_FORMAT_DEFINITION_HPP_
+
+    #include <glm/glm.hpp>
+
+    #include <cstdint>
+    #include <cstddef>
+
+    // Not _GLFW_START_, that is defined along with the OpenGL headers. (see: glfw.hpp)
+    namespace glfw
+    {
+    namespace assets
+    {
+        /** @brief GL_FLOAT */
+        constexpr uint32_t type_float = 0x1406;
+        /** @brief GL_INT_2_10_10_10_REV */
+        constexpr uint32_t type_int_2_10_10_10_rev = 0x8D9F;
+        /** @brief GL_UNSIGNED_SHORT */
+        constexpr uint32_t type_unsigned_short = 0x1403;
+        /** @brief GL_UNSIGNED_INT */
+        constexpr uint32_t type_unsigned_int = 0x1405;
+
+        /** @brief The first 4 bytes of every mesh file. ("GLMA") */
+        constexpr uint32_t mesh_file_magic = 0x414D4C47u;
+        /** @brief The version of the layout. Changing any of the structs below requires a new version. */
+        constexpr uint32_t mesh_file_version = 1;
+        /** @brief The alignment(in bytes) of every section from the start of the file. */
+        constexpr size_t section_alignment = 16;
+        /** @brief The maximum number of vertex attributes. */
+        constexpr size_t max_vertex_attributes = 8;
+
+        static_assert(sizeof(glm::vec3) == 12, "The hull points and the bounds are stored as 3 tightly packed floats.");
+
+        /** @brief A part of the file. (in bytes) */
+        struct file_section
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        /** @brief An attribute of the vertices. (see: vertex_array_object::create_attribute) */
+        struct vertex_attribute
+        {
+            uint32_t location;
+            /** @brief The number of components. [1<=count<=4] */
+            uint32_t count;
+            /** @brief The type of the components. ex; type_float, type_int_2_10_10_10_rev */
+            uint32_t type;
+            uint32_t normalized;
+            /** @brief The offset(in bytes) of the attribute from the start of a vertex. */
+            uint32_t offset;
+        };
+
+        struct file_header
+        {
+            uint32_t magic;
+            uint32_t version;
+            /** @brief The size of the whole file, a file that was cut short is refused. */
+            uint64_t file_size;
+
+            /** @brief The size(in bytes) of a vertex. */
+            uint32_t vertex_stride;
+            /** @brief The number of attributes. The first one is always the position, as 3 floats. */
+            uint32_t attribute_count;
+            vertex_attribute attributes[max_vertex_attributes];
+            /** @brief type_unsigned_short or type_unsigned_int. */
+            uint32_t index_type;
+            uint32_t mesh_count;
+
+            file_section vertices;
+            file_section indices;
+            file_section meshes;
+            file_section hull_points;
+            file_section bvh_nodes;
+        };
+
+        /** @brief A mesh of a file. The ranges are in elements (not in bytes) from the start of their sections. */
+        struct mesh_record
+        {
+            uint32_t first_index;
+            /** @brief The number of indices. Always a multiple of 3, every mesh is a list of triangles. */
+            uint32_t index_count;
+            /** @brief The indices of the mesh are relative to this vertex. */
+            int32_t base_vertex;
+            uint32_t vertex_count;
+            /** @brief The box around the vertices, in the space of the mesh. */
+            glm::vec3 bounds_min;
+            glm::vec3 bounds_max;
+            uint32_t hull_first;
+            uint32_t hull_count;
+            uint32_t bvh_first;
+            uint32_t bvh_count;
+        };
+
+        /**
+         * @brief A node of the hierarchy of a mesh. The nodes are stored depth first, the left child of a node is the
+         * node right after it. The triangles of a mesh are sorted so that every leaf refers to a range of them.
+        */
+        struct bvh_node
+        {
+            glm::vec3 min;
+            /** @brief The first triangle (of the mesh) for a leaf, the right child (relative to mesh_record::bvh_first) otherwise. */
+            uint32_t first;
+            glm::vec3 max;
+            /** @brief The number of triangles of a leaf, 0 for any other node. */
+            uint32_t count;
+
+            bool is_leaf() const noexcept(true) { return count != 0; }
+        };
+
+        static_assert(sizeof(bvh_node) == 32, "A node is read from the file as it is.");
+        static_assert(sizeof(mesh_record) == 56, "A mesh is read from the file as it is.");
+        static_assert(sizeof(file_header) == 272, "The header is read from the file as it is.");
+
+        namespace detail
+        {
+            inline bool valid_section(const file_section& s, size_t element_size, size_t file_size) noexcept(true)
+            {
+                return s.offset % section_alignment == 0 && s.offset <= file_size && s.size <= file_size - s.offset
+                    && s.size % element_size == 0;
+            }
+
+            /** @brief Whether or not every index of the mesh refers to one of its vertices. */
+            template <typename T>
+            bool valid_indices(const uint8_t* data, const file_header& h, const mesh_record& m) noexcept(true)
+            {
+                const T* indices = reinterpret_cast<const T*>(data + h.indices.offset) + m.first_index;
+                for(uint32_t i = 0; i < m.index_count; i++) if(indices[i] >= m.vertex_count) return false;
+                return true;
+            }
+
+            /**
+             * @brief Whether or not the hierarchy of the mesh can be walked without leaving it. Every leaf must refer
+             * to triangles of the mesh, and the right child of a node must come after its left child; hence a walk
+             * always moves forward and ends.
+            */
+            inline bool valid_bvh(const bvh_node* nodes, const mesh_record& m) noexcept(true)
+            {
+                uint64_t triangle_count = m.index_count / 3;
+                for(uint32_t k = 0; k < m.bvh_count; k++)
+                {
+                    const bvh_node& n = nodes[k];
+                    if(n.is_leaf() && uint64_t(n.first) + n.count > triangle_count) return false;
+                    if(!n.is_leaf() && (uint64_t(k) + 1 >= m.bvh_count || n.first <= k + 1 || n.first >= m.bvh_count)) return false;
+                }
+                return true;
+            }
+        }; // namespace detail
+
+        /**
+         * @brief Checks the header, the ranges of every section and mesh, the indices and the hierarchies. i.e. Every
+         * read of mesh_file stays inside of the file. The values of the vertices aren't checked.
+         * @param data The whole file.
+         * @param size The size(in bytes) of the file.
+         * @returns Whether or not it is a mesh file of the current version, that every range of is inside of it.
+        */
+        inline bool validate_mesh_file(const uint8_t* data, size_t size)
+        {
+            if(size < sizeof(file_header)) return false;
+            const file_header& h = *reinterpret_cast<const file_header*>(data);
+            if(h.magic != mesh_file_magic || h.file_size != size || h.version != mesh_file_version) return false;
+            if(h.index_type != type_unsigned_short && h.index_type != type_unsigned_int) return false;
+            if(!h.vertex_stride || !h.attribute_count || h.attribute_count > max_vertex_attributes) return false;
+            if(h.attributes[0].count != 3 || h.attributes[0].type != type_float || h.attributes[0].offset + 12 > h.vertex_stride) return false;
+
+            size_t index_size = h.index_type == type_unsigned_short ? 2 : 4;
+            if(!detail::valid_section(h.vertices, h.vertex_stride, size) || !detail::valid_section(h.indices, index_size, size) ||
+                !detail::valid_section(h.meshes, sizeof(mesh_record), size) || !detail::valid_section(h.hull_points, sizeof(glm::vec3), size) ||
+                !detail::valid_section(h.bvh_nodes, sizeof(bvh_node), size)) return false;
+            if(h.meshes.size / sizeof(mesh_record) != h.mesh_count) return false;
+
+            uint64_t vertex_count = h.vertices.size / h.vertex_stride, index_count = h.indices.size / index_size;
+            uint64_t point_count = h.hull_points.size / sizeof(glm::vec3), node_count = h.bvh_nodes.size / sizeof(bvh_node);
+            const mesh_record* records = reinterpret_cast<const mesh_record*>(data + h.meshes.offset);
+            for(uint32_t i = 0; i < h.mesh_count; i++)
+            {
+                const mesh_record& m = records[i];
+                if(m.index_count % 3 || uint64_t(m.first_index) + m.index_count > index_count) return false;
+                if(m.base_vertex < 0 || uint64_t(m.base_vertex) + m.vertex_count > vertex_count) return false;
+                if(uint64_t(m.hull_first) + m.hull_count > point_count) return false;
+                if(uint64_t(m.bvh_first) + m.bvh_count > node_count) return false;
+
+                bool indices = h.index_type == type_unsigned_short ? detail::valid_indices<uint16_t>(data, h, m) : detail::valid_indices<uint32_t>(data, h, m);
+                if(!indices || !detail::valid_bvh(reinterpret_cast<const bvh_node*>(data + h.bvh_nodes.offset) + m.bvh_first, m)) return false;
+            }
+            return true;
+        }
+    }; // namespace assets
+    };
+
+#endif
\ No newline at end of file
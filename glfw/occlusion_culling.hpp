@@ -0,0 +1,438 @@
+/**
+ * This header contains the GPU culling pass. A compute shader tests the bounding box of every instance against the
+ * view frustum and (optionally) against a hierarchical depth buffer of the last frame, and copies the transforms of
+ * the instances that passed next to each other into a buffer, while counting them into the indirect draw commands.
+ * Hence, the instances that are off screen or hidden behind other geometry cost no vertex work, and nothing is read
+ * back to the CPU.
+ *
+ * The hierarchical depth buffer (Hi-Z) is a mipmap chain of the depth buffer in which every texel holds the farthest
+ * depth of the four texels below it. A box is hidden if the nearest point of the box is farther than the farthest
+ * depth in the (at most 2x2) texels of the level at which its rectangle on the screen is about a texel in size.
+ *
+ * The depth is the one of the last frame, a box that comes out from behind something (or that the camera turns
+ * towards) is drawn one frame late. The depth must be a texture (i.e. the depth attachment of a framebuffer, the
+ * default framebuffer can be blitted into one) in the usual convention; 0 near, 1 far, GL_LESS.
+ *
+ * Usage;
+ *  culling::hiz_pyramid pyramid;
+ *  culling::gpu_culler culler;
+ *  pyramid.create(width, height);
+ *  culler.create(max_instances);
+ *  culler.set_commands(meshes, mesh_count);      // One command per mesh, instance_count = its number of instances.
+ *  culler.attach(vao, 3);                        // Once. The mat4 of the visible instances is read from [3, 7).
+ *  ... every frame ...
+ *  culler.cull(view_projection, bounds, count, transforms.buffer_id, 0, &pyramid);
+ *  culler.draw(vao, GL_TRIANGLES, GL_UNSIGNED_INT);
+ *  pyramid.build(depth_texture);                 // After the geometry, for the next frame.
+ *
+ * For the culling on the CPU, with the bounding volume tree of the physics engine, see: physics/culling.hpp
+ * Requires OpenGL 4.3. (Compute shaders, shader storage buffers and indirect draws)
+*/
+
+#include "./glfw.hpp"
+#include "./math.hpp"
+#include "./profiler.hpp"
+#include "./state_cache.hpp"
+#include "./shader.hpp"
+#include "./texture.hpp"
+#include "./vbo.hpp"
+#include "./vao.hpp"
+
+#ifndef _GLFW_OCCLUSION_CULLING_DEFINITION_HPP_
+    #define _GLFW_OCCLUSION_CULLING_DEFINITION_HPP_
+
+    #include <string>
+    #include <vector>
+    #include <memory>
+    #include <cstddef>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace culling
+    {
+        /// @brief The number of invocations in a work group of the culling pass.
+        constexpr GLuint work_group_size = 256;
+
+        /** @brief The world space bounding box of an instance. It is read by the GPU (std430) hence, the order and the size of the members must not be changed. */
+        struct instance_bounds
+        {
+            glm::vec3 min;
+            /// @brief The index of the draw command (i.e. of the mesh) that the instance is drawn with. (see: gpu_culler::set_commands)
+            GLuint command;
+            glm::vec3 max;
+            GLuint padding;
+        };
+        static_assert(sizeof(instance_bounds) == 32, "The bounds are read by the GPU as a vec3, a uint, a vec3 and a uint.");
+
+        /** @brief The uniform block of the culling pass. It follows the std140 layout. */
+        struct culling_parameters
+        {
+            glm::mat4 view_projection;
+            /// @brief xy: The size of the level 0 of the pyramid, z: The number of levels, w: 1 to test against the pyramid, 0 not to.
+            glm::vec4 pyramid;
+            /// @brief x: The instances, y: The draw commands.
+            GLuint counts[4];
+        };
+
+        /** @brief The GLSL sources of the passes. */
+        namespace sources
+        {
+            /// @brief Copies the depth buffer into the level 0 of the pyramid.
+            constexpr const char* copy_depth = R"(#version 430 core
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(binding = 0) uniform sampler2D depth;
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if(any(greaterThanEqual(p, imageSize(destination)))) return;
+    imageStore(destination, p, vec4(texelFetch(depth, p, 0).r));
+}
+)";
+
+            /// @brief Writes the farthest depth of the 2x2 (3x3 at the odd edges) texels of the level above.
+            constexpr const char* downsample = R"(#version 430 core
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(r32f, binding = 0) readonly uniform image2D source;
+layout(r32f, binding = 1) writeonly uniform image2D destination;
+void main()
+{
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy), size = imageSize(destination), source_size = imageSize(source);
+    if(any(greaterThanEqual(p, size))) return;
+
+    // An odd level has a texel more than twice the next one, the last texels of the next one cover it too.
+    ivec2 last = min(2 * p + 1 + ivec2(equal(p, size - 1)) * (source_size & 1), source_size - 1);
+    float depth = 0.0;
+    for(int y = 2 * p.y; y <= last.y; y++)
+        for(int x = 2 * p.x; x <= last.x; x++) depth = max(depth, imageLoad(source, ivec2(x, y)).r);
+    imageStore(destination, p, vec4(depth));
+}
+)";
+
+            /// @brief Tests every instance and appends the visible ones to the range of their command. It is preceded by the #version and the limits.
+            constexpr const char* cull = R"(
+layout(local_size_x = WORK_GROUP_SIZE) in;
+
+struct instance_bounds { vec3 min; uint command; vec3 max; uint padding; };
+struct draw_command { uint count; uint instance_count; uint first_index; int base_vertex; uint base_instance; };
+
+layout(std140, binding = 0) uniform culling_parameters
+{
+    mat4 view_projection;
+    vec4 pyramid;
+    uvec4 counts;
+};
+
+layout(std430, binding = 0) readonly buffer bounds_block { instance_bounds bounds[]; };
+layout(std430, binding = 1) readonly buffer transform_block { mat4 transforms[]; };
+layout(std430, binding = 2) writeonly buffer visible_block { mat4 visible[]; };
+layout(std430, binding = 3) buffer command_block { draw_command commands[]; };
+layout(binding = 0) uniform sampler2D hiz;
+
+bool inside_frustum(vec3 lo, vec3 hi)
+{
+    mat4 m = transpose(view_projection);
+    vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]);
+    vec3 center = (lo + hi) * 0.5, extent = (hi - lo) * 0.5;
+    for(int i = 0; i < 6; i++)
+    {
+        if(dot(planes[i].xyz, center) + planes[i].w < -dot(abs(planes[i].xyz), extent)) return false;
+    }
+    return true;
+}
+
+bool hidden(vec3 lo, vec3 hi)
+{
+    vec2 screen_min = vec2(1.0), screen_max = vec2(0.0);
+    float nearest = 1.0;
+    for(int i = 0; i < 8; i++)
+    {
+        vec4 p = view_projection * vec4(mix(lo, hi, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1)), 1.0);
+        // A corner behind the camera, the rectangle on the screen isn't bounded.
+        if(p.w <= 0.0) return false;
+        vec3 ndc = p.xyz / p.w;
+        screen_min = min(screen_min, ndc.xy * 0.5 + 0.5);
+        screen_max = max(screen_max, ndc.xy * 0.5 + 0.5);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+    screen_min = clamp(screen_min, 0.0, 1.0);
+    screen_max = clamp(screen_max, 0.0, 1.0);
+
+    // The level at which the rectangle is at most a texel in size, hence covers at most 2x2 texels.
+    vec2 size = (screen_max - screen_min) * pyramid.xy;
+    int level = int(min(ceil(log2(max(max(size.x, size.y), 1.0))), pyramid.z - 1.0));
+    ivec2 texels = textureSize(hiz, level);
+    ivec2 a = clamp(ivec2(screen_min * vec2(texels)), ivec2(0), texels - 1);
+    ivec2 b = clamp(ivec2(screen_max * vec2(texels)), ivec2(0), texels - 1);
+
+    float farthest = max(max(texelFetch(hiz, a, level).r, texelFetch(hiz, ivec2(b.x, a.y), level).r),
+                         max(texelFetch(hiz, ivec2(a.x, b.y), level).r, texelFetch(hiz, b, level).r));
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= counts.x) return;
+
+    instance_bounds box = bounds[i];
+    if(box.command >= counts.y || !inside_frustum(box.min, box.max)) return;
+    if(pyramid.w != 0.0 && hidden(box.min, box.max)) return;
+
+    uint slot = atomicAdd(commands[box.command].instance_count, 1u);
+    visible[commands[box.command].base_instance + slot] = transforms[i];
+}
+)";
+        }; // namespace sources
+
+        /** @brief The hierarchical depth buffer. (see: the top of this file) */
+        class hiz_pyramid
+        {
+        private:
+            std::unique_ptr<texture::texture_object> _texture;
+            shader::shader_program _copy;
+            shader::shader_program _downsample;
+            std::string _sources[2];
+
+            int _width = 0;
+            int _height = 0;
+            GLsizei _levels = 0;
+
+        public:
+            /**
+             * @brief Allocates the pyramid and compiles the passes. Called again (ex; when the window is resized) it only
+             * reallocates the pyramid. Should be called after glfw::init_glad.
+             * @param width The width of the depth buffer.
+             * @param height The height of the depth buffer.
+            */
+            void create(int width, int height)
+            {
+                if(_sources[0].empty())
+                {
+                    _sources[0] = sources::copy_depth;
+                    _sources[1] = sources::downsample;
+                    _copy.set_compute_content(_sources[0].data());
+                    _downsample.set_compute_content(_sources[1].data());
+                    shader::loader::full_load_shader(_copy);
+                    shader::loader::full_load_shader(_downsample);
+                }
+
+                _width = width;
+                _height = height;
+                _levels = texture::texture_object::mipmap_levels(width, height);
+
+                // The storage is immutable, a new size is a new texture.
+                _texture = std::make_unique<texture::texture_object>();
+                _texture->find_free_id();
+                _texture->bind();
+                _texture->create_storage(_levels, GL_R32F, width, height);
+                texture::texture_object::set_min_filter(GL_NEAREST_MIPMAP_NEAREST);
+                texture::texture_object::set_mag_filter(GL_NEAREST);
+                texture::texture_object::set_mapping_for_x_axis(GL_CLAMP_TO_EDGE);
+                texture::texture_object::set_mapping_for_y_axis(GL_CLAMP_TO_EDGE);
+            }
+
+            /**
+             * @brief Builds the pyramid out of the depth buffer. Should be called after the frame has been drawn.
+             * @param depth_texture The depth attachment of the framebuffer that the frame was drawn into. Its size must
+             * be the one that the pyramid was created with.
+            */
+            void build(GLuint depth_texture)
+            {
+                GLFW_PROFILE_GPU_SCOPE("hiz_pyramid::build");
+                if(!_texture) return;
+                GLuint id = _texture->texture_id;
+
+                state::current().bind_texture_unit(GL_TEXTURE0, GL_TEXTURE_2D, depth_texture);
+                glBindImageTexture(0, id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+                _copy.use_shader();
+                _copy.dispatch((_width + 7) / 8, (_height + 7) / 8);
+
+                _downsample.use_shader();
+                for(GLsizei level = 1; level < _levels; level++)
+                {
+                    shader::shader_program::memory_barrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+                    int w = std::max(_width >> level, 1), h = std::max(_height >> level, 1);
+                    glBindImageTexture(0, id, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+                    glBindImageTexture(1, id, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+                    _downsample.dispatch((w + 7) / 8, (h + 7) / 8);
+                }
+                shader::shader_program::memory_barrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+            }
+
+            GLuint get_id() const noexcept(true) { return _texture ? _texture->texture_id : 0; }
+            int width() const noexcept(true) { return _width; }
+            int height() const noexcept(true) { return _height; }
+            GLsizei levels() const noexcept(true) { return _levels; }
+        };
+
+        /** @brief Culls the instances on the GPU and draws the visible ones. (see: the top of this file) */
+        class gpu_culler
+        {
+        private:
+            shader::shader_program _program;
+            /// @brief The program only points to its contents, hence this has to outlive it.
+            std::string _source;
+
+            buffer_object _bounds;
+            /// @brief The transforms of the visible instances, the range of every command after one another.
+            buffer_object _visible;
+            buffer_object _commands;
+            uniform_buffer_object<culling_parameters> _parameters;
+
+            /// @brief The commands as they were set, with instance_count = 0. They are uploaded before every pass.
+            std::vector<draw_elements_indirect_command> _reset;
+            size_t _capacity = 0;
+            size_t _bounds_capacity = 0;
+
+            static void __create_storage(buffer_object& buffer, GLenum type, size_t size, GLenum usage)
+            {
+                buffer.set_type(type);
+                buffer.find_free_id();
+                buffer.bind();
+                buffer.create<GLubyte>(nullptr, size, usage);
+            }
+
+        public:
+            /**
+             * @brief Creates the buffers and compiles the pass. Should be called once, after glfw::init_glad.
+             * @param capacity The maximum number of instances, of every command together.
+            */
+            void create(size_t capacity)
+            {
+                _capacity = capacity;
+                __create_storage(_bounds, GL_SHADER_STORAGE_BUFFER, 0, GL_STREAM_DRAW);
+                __create_storage(_visible, GL_ARRAY_BUFFER, sizeof(glm::mat4)*capacity, GL_DYNAMIC_COPY);
+                __create_storage(_commands, GL_DRAW_INDIRECT_BUFFER, 0, GL_DYNAMIC_COPY);
+
+                _parameters.find_free_id();
+                _parameters.bind();
+                _parameters.create();
+
+                _source = "#version 430 core\n"
+                    "#define WORK_GROUP_SIZE " + std::to_string(work_group_size) + "\n";
+                _source += sources::cull;
+                _program.set_compute_content(_source.data());
+                shader::loader::full_load_shader(_program);
+            }
+
+            /**
+             * @brief Sets the meshes that the instances are drawn with.
+             * @param commands One command per mesh. The instance_count is the number of instances that use the mesh
+             * (i.e. the most that can be visible), the base_instance is ignored; every command gets the range after
+             * the ones before it.
+             * @param count The number of commands.
+             * @returns false if the instances don't fit into the capacity, nothing is changed then.
+            */
+            bool set_commands(const draw_elements_indirect_command* commands, size_t count)
+            {
+                size_t total = 0;
+                for(size_t i = 0; i < count; i++) total += commands[i].instance_count;
+                if(total > _capacity) return false;
+
+                _reset.assign(commands, commands + count);
+                GLuint first = 0;
+                for(draw_elements_indirect_command& command : _reset)
+                {
+                    command.base_instance = first;
+                    first += command.instance_count;
+                    command.instance_count = 0;
+                }
+
+                _commands.bind();
+                _commands.create<draw_elements_indirect_command>(_reset.data(), _reset.size(), GL_DYNAMIC_COPY);
+                return true;
+            }
+
+            /**
+             * @brief Culls the instances. Nothing is read back, it is safe to draw right after.
+             * @param view_projection The projection matrix times the view matrix.
+             * @param bounds The bounding box of every instance.
+             * @param count The number of instances.
+             * @param transforms The buffer that holds the mat4 of every instance, in the same order as the boxes.
+             * ex; what physics::world::write_instance_transforms wrote.
+             * @param transforms_offset? The offset(in bytes) of the first transform in the buffer. ex; the region of a streaming buffer.
+             * @param pyramid? The depth of the last frame, nullptr to only test the frustum.
+            */
+            void cull(const glm::mat4& view_projection, const instance_bounds* bounds, size_t count, GLuint transforms,
+                GLintptr transforms_offset=0, const hiz_pyramid* pyramid=nullptr)
+            {
+                GLFW_PROFILE_GPU_SCOPE("gpu_culler::cull");
+                GLFW_PROFILE_COUNTER("culling::instances", static_cast<double>(count));
+                if(_reset.empty()) return;
+
+                _commands.bind();
+                _commands.update<draw_elements_indirect_command>(_reset.data(), _reset.size());
+                if(!count) return;
+
+                _bounds.bind();
+                if(count > _bounds_capacity)
+                {
+                    _bounds_capacity = std::max(count, _bounds_capacity * 2);
+                    _bounds.create<instance_bounds>(nullptr, _bounds_capacity, GL_STREAM_DRAW);
+                }
+                _bounds.update<instance_bounds>(bounds, count);
+
+                bool occlusion = pyramid && pyramid->get_id();
+                culling_parameters* parameters = _parameters.map();
+                parameters->view_projection = view_projection;
+                parameters->pyramid = occlusion
+                    ? glm::vec4(static_cast<float>(pyramid->width()), static_cast<float>(pyramid->height()), static_cast<float>(pyramid->levels()), 1.0f)
+                    : glm::vec4(0.0f);
+                parameters->counts[0] = static_cast<GLuint>(count);
+                parameters->counts[1] = static_cast<GLuint>(_reset.size());
+                parameters->counts[2] = parameters->counts[3] = 0;
+                _parameters.bind_base(0);
+
+                _bounds.bind_base(0);
+                state::current().bind_buffer_range(GL_SHADER_STORAGE_BUFFER, 1, transforms, transforms_offset, static_cast<GLsizeiptr>(sizeof(glm::mat4)*count));
+                _visible.bind_base(2);
+                _commands.bind_base(3);
+                if(occlusion) state::current().bind_texture_unit(GL_TEXTURE0, GL_TEXTURE_2D, pyramid->get_id());
+
+                _program.use_shader();
+                _program.dispatch_for(static_cast<GLuint>(count));
+                shader::shader_program::memory_barrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+                _parameters.fence_region();
+            }
+
+            /**
+             * @brief Makes the vertex array object read the transforms of the visible instances as a per-instance mat4.
+             * This only has to be called once per vertex array object.
+             * @param vao A reference to the vertex array object. (State will be modified)
+             * @param index The first of the four attributes of the matrix. (see: vertex_array_object::create_instance_transform_attribute)
+            */
+            void attach(vertex_array_object& vao, GLuint index)
+            {
+                vao.bind();
+                _visible.bind();
+                vao.create_instance_transform_attribute(index, sizeof(glm::mat4));
+            }
+
+            /**
+             * @brief Draws the visible instances of every command, with a single multi-draw call. (see: attach)
+             * @param vao A reference to the vertex array object. Its element array buffer holds the indices of every mesh.
+             * @param type The type of figure to draw. ex; GL_TRIANGLES
+             * @param type_of_indices The type of the indices. ex; GL_UNSIGNED_INT
+            */
+            void draw(vertex_array_object& vao, GLenum type, GLenum type_of_indices)
+            {
+                if(_reset.empty()) return;
+                vao.bind();
+                _commands.bind();
+                vao.multi_draw_elements_indirect(type, type_of_indices, static_cast<GLsizei>(_reset.size()));
+            }
+
+            size_t capacity() const noexcept(true) { return _capacity; }
+            size_t command_count() const noexcept(true) { return _reset.size(); }
+            /// @brief The buffer of the commands. It is a GL_DRAW_INDIRECT_BUFFER that is also bound to the storage block 3.
+            buffer_object& command_buffer() noexcept(true) { return _commands; }
+            /// @brief The buffer of the transforms of the visible instances. It is a GL_ARRAY_BUFFER that is also bound to the storage block 2.
+            buffer_object& visible_buffer() noexcept(true) { return _visible; }
+        };
+    }; // namespace culling
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
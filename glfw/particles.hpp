@@ -0,0 +1,547 @@
+/**
+ * This header contains the GPU particle system. The particles live in a single buffer on the GPU, they are simulated
+ * by compute shaders and drawn straight out of that same buffer as per-instance attributes. Hence, once they have
+ * been emitted, the particles never go back to the CPU.
+ *
+ * Every update runs these passes, one dispatch each;
+ *  - hash      : Finds the cell of the spatial hash that every particle is in and counts the particles of every cell.
+ *  - scan      : A prefix sum over the counts. This gives the range of every cell in the sorted indices.
+ *  - scatter   : Writes the index of every particle into the range of its cell.
+ *  - forces    : Every particle looks at the particles in the 27 cells around it and is pushed away from the ones
+ *                that it overlaps.
+ *  - integrate : Applies the gravity and the forces, moves the particles and pushes them out of the planes and the
+ *                signed distance fields (SDF) of the colliders.
+ *
+ * Usage;
+ *  particles.create(1 << 20);
+ *  particles.add_plane(glm::vec3(0.0f, 1.0f, 0.0f), 0.0f);
+ *  particles.emit(data, count);
+ *  particles.attach(vao, 3);           // Once. The position is read from attribute 3 and the velocity from 4.
+ *  ... every frame ...
+ *  particles.update(dt);
+ *  particles.draw(vao, GL_TRIANGLES, index_count, GL_UNSIGNED_INT);
+ *
+ * Requires OpenGL 4.3. (Compute shaders and shader storage buffers)
+*/
+
+#include "./glfw.hpp"
+#include "./math.hpp"
+#include "./profiler.hpp"
+#include "./shader.hpp"
+#include "./vbo.hpp"
+#include "./vao.hpp"
+
+#ifndef _GLFW_PARTICLES_DEFINITION_HPP_
+    #define _GLFW_PARTICLES_DEFINITION_HPP_
+
+    #include <string>
+    #include <cstddef>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace particles
+    {
+        /// @brief The maximum number of planes that the particles collide with.
+        constexpr size_t max_planes = 8;
+        /// @brief The maximum number of colliders that the particles collide with.
+        constexpr size_t max_colliders = 16;
+        /// @brief The number of invocations in a work group of every pass, except for the scan.
+        constexpr GLuint work_group_size = 256;
+
+        /** @brief A single particle. It is read by the GPU (std430) hence, the order and the size of the members must not be changed. */
+        struct particle
+        {
+            /// @brief xyz: The position, w: The radius.
+            glm::vec4 position;
+            /// @brief xyz: The velocity, w: Left untouched by the simulation. (ex; the color or the age, for the vertex shader)
+            glm::vec4 velocity;
+        };
+        static_assert(sizeof(particle) == 32, "The particle is read by the GPU as two vec4s.");
+
+        /** @brief The shape of the signed distance field of a collider. */
+        enum class collider_type : uint32_t
+        {
+            SPHERE  = 0,
+            /** @brief An axis aligned box with rounded edges. */
+            BOX     = 1
+        };
+
+        /** @brief A collider. It is read by the GPU (std140). */
+        struct sdf_collider
+        {
+            /// @brief xyz: The center, w: The type. (see: collider_type)
+            glm::vec4 center;
+            /// @brief The sphere - x: The radius. The box - xyz: The half extents, w: The radius of the edges.
+            glm::vec4 size;
+
+            static sdf_collider sphere(const glm::vec3& center, float radius)
+            {
+                return sdf_collider { glm::vec4(center, static_cast<float>(collider_type::SPHERE)), glm::vec4(radius, 0.0f, 0.0f, 0.0f) };
+            }
+            static sdf_collider box(const glm::vec3& center, const glm::vec3& half_extents, float rounding=0.0f)
+            {
+                return sdf_collider { glm::vec4(center, static_cast<float>(collider_type::BOX)), glm::vec4(half_extents, rounding) };
+            }
+        };
+
+        /** @brief How the particles behave. */
+        struct simulation_settings
+        {
+            glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+            /// @brief How much of the normal velocity is kept after hitting a plane or a collider. [0,1]
+            float restitution = 0.3f;
+            /// @brief How much of the tangential velocity is lost after hitting a plane or a collider. [0,1]
+            float friction = 0.1f;
+            /// @brief How strongly two overlapping particles are pushed apart.
+            float stiffness = 2000.0f;
+            /// @brief How strongly the relative velocity of two overlapping particles is damped.
+            float damping = 10.0f;
+            /// @brief The size of a cell of the spatial hash. Must be at least twice the radius of the largest particle.
+            float cell_size = 0.1f;
+            /// @brief The number of cells in the spatial hash. Rounded up to a power of 2.
+            uint32_t hash_table_size = 1u << 18;
+        };
+
+        /** @brief The uniform block of the passes. It follows the std140 layout. */
+        struct simulation_parameters
+        {
+            /// @brief xyz: The gravity, w: The time step.
+            glm::vec4 gravity;
+            /// @brief x: The restitution, y: The friction, z: The stiffness, w: The damping.
+            glm::vec4 material;
+            /// @brief x: The cell size, y: 1 / the cell size.
+            glm::vec4 grid;
+            /// @brief x: The particles, y: The cells in the hash table, z: The planes, w: The colliders.
+            GLuint counts[4];
+            /// @brief xyz: The normal, w: The distance of the plane from the origin along the normal.
+            glm::vec4 planes[max_planes];
+            sdf_collider colliders[max_colliders];
+        };
+
+        /** @brief The GLSL sources of the passes. */
+        namespace sources
+        {
+            /// @brief The declarations that every pass shares. It is preceded by the #version and the limits.
+            constexpr const char* common = R"(
+struct particle { vec4 position; vec4 velocity; };
+struct sdf_collider { vec4 center; vec4 size; };
+
+layout(std140, binding = 0) uniform simulation_parameters
+{
+    vec4 gravity;
+    vec4 material;
+    vec4 grid;
+    uvec4 counts;
+    vec4 planes[MAX_PLANES];
+    sdf_collider colliders[MAX_COLLIDERS];
+};
+
+layout(std430, binding = 0) buffer particle_block { particle particles[]; };
+layout(std430, binding = 1) buffer force_block { vec4 forces[]; };
+layout(std430, binding = 2) buffer particle_cell_block { uint particle_cells[]; };
+layout(std430, binding = 3) buffer cell_start_block { uint cell_start[]; };
+layout(std430, binding = 4) buffer cell_end_block { uint cell_end[]; };
+layout(std430, binding = 5) buffer sorted_block { uint sorted_particles[]; };
+
+ivec3 cell_of(vec3 p) { return ivec3(floor(p * grid.y)); }
+uint hash_cell(ivec3 c) { return ((uint(c.x) * 73856093u) ^ (uint(c.y) * 19349663u) ^ (uint(c.z) * 83492791u)) & (counts.y - 1u); }
+)";
+
+            constexpr const char* hash = R"(
+layout(local_size_x = WORK_GROUP_SIZE) in;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= counts.x) return;
+
+    uint cell = hash_cell(cell_of(particles[i].position.xyz));
+    particle_cells[i] = cell;
+    atomicAdd(cell_end[cell], 1u);
+}
+)";
+
+            /// @brief A single work group. Every invocation sums a contiguous run of cells, the sums are scanned in shared memory.
+            constexpr const char* scan = R"(
+layout(local_size_x = 1024) in;
+shared uint sums[1024];
+void main()
+{
+    uint t = gl_LocalInvocationID.x;
+    uint per_invocation = (counts.y + 1023u) / 1024u;
+    uint begin = t * per_invocation, end = min(begin + per_invocation, counts.y);
+
+    uint sum = 0u;
+    for(uint c = begin; c < end; c++) sum += cell_end[c];
+    sums[t] = sum;
+    barrier();
+
+    for(uint offset = 1u; offset < 1024u; offset <<= 1)
+    {
+        uint value = t >= offset ? sums[t - offset] : 0u;
+        barrier();
+        sums[t] += value;
+        barrier();
+    }
+
+    // The end of every cell starts at its start, scatter moves it forwards while it fills the cell.
+    uint running = sums[t] - sum;
+    for(uint c = begin; c < end; c++)
+    {
+        uint count = cell_end[c];
+        cell_start[c] = running;
+        cell_end[c] = running;
+        running += count;
+    }
+}
+)";
+
+            constexpr const char* scatter = R"(
+layout(local_size_x = WORK_GROUP_SIZE) in;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= counts.x) return;
+
+    sorted_particles[atomicAdd(cell_end[particle_cells[i]], 1u)] = i;
+}
+)";
+
+            constexpr const char* forces = R"(
+layout(local_size_x = WORK_GROUP_SIZE) in;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= counts.x) return;
+
+    vec3 p = particles[i].position.xyz;
+    vec3 v = particles[i].velocity.xyz;
+    float r = particles[i].position.w;
+    ivec3 base = cell_of(p);
+
+    vec3 force = vec3(0.0);
+    for(int z = -1; z <= 1; z++)
+    for(int y = -1; y <= 1; y++)
+    for(int x = -1; x <= 1; x++)
+    {
+        ivec3 cell = base + ivec3(x, y, z);
+        uint h = hash_cell(cell);
+        for(uint s = cell_start[h]; s < cell_end[h]; s++)
+        {
+            uint j = sorted_particles[s];
+            vec3 q = particles[j].position.xyz;
+            // Different cells can share a slot of the hash table, only the particles that are actually in the cell count.
+            if(j == i || cell_of(q) != cell) continue;
+
+            vec3 d = p - q;
+            float radii = r + particles[j].position.w;
+            float distance_sq = dot(d, d);
+            if(distance_sq >= radii * radii || distance_sq < 1e-12) continue;
+
+            float separation = sqrt(distance_sq);
+            vec3 n = d / separation;
+            float approach = dot(v - particles[j].velocity.xyz, n);
+            force += n * ((radii - separation) * material.z - approach * material.w);
+        }
+    }
+    forces[i] = vec4(force, 0.0);
+}
+)";
+
+            constexpr const char* integrate = R"(
+layout(local_size_x = WORK_GROUP_SIZE) in;
+
+float distance_to(sdf_collider c, vec3 p)
+{
+    vec3 q = p - c.center.xyz;
+    if(c.center.w < 0.5) return length(q) - c.size.x;
+
+    vec3 d = abs(q) - c.size.xyz;
+    return length(max(d, 0.0)) + min(max(d.x, max(d.y, d.z)), 0.0) - c.size.w;
+}
+
+vec3 normal_of(sdf_collider c, vec3 p)
+{
+    const vec2 e = vec2(1e-3, 0.0);
+    vec3 n = vec3(
+        distance_to(c, p + e.xyy) - distance_to(c, p - e.xyy),
+        distance_to(c, p + e.yxy) - distance_to(c, p - e.yxy),
+        distance_to(c, p + e.yyx) - distance_to(c, p - e.yyx));
+    float length_sq = dot(n, n);
+    return length_sq > 1e-12 ? n * inversesqrt(length_sq) : vec3(0.0, 1.0, 0.0);
+}
+
+void resolve(inout vec3 p, inout vec3 v, vec3 n, float penetration)
+{
+    p += n * penetration;
+    float vn = dot(v, n);
+    if(vn < 0.0) v = (v - n * vn) * max(1.0 - material.y, 0.0) - n * (vn * material.x);
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if(i >= counts.x) return;
+
+    float dt = gravity.w;
+    float r = particles[i].position.w;
+    vec3 v = particles[i].velocity.xyz + (gravity.xyz + forces[i].xyz) * dt;
+    vec3 p = particles[i].position.xyz + v * dt;
+
+    for(uint k = 0u; k < counts.z; k++)
+    {
+        float d = dot(planes[k].xyz, p) - planes[k].w - r;
+        if(d < 0.0) resolve(p, v, planes[k].xyz, -d);
+    }
+    for(uint k = 0u; k < counts.w; k++)
+    {
+        float d = distance_to(colliders[k], p) - r;
+        if(d < 0.0) resolve(p, v, normal_of(colliders[k], p), -d);
+    }
+
+    particles[i].position.xyz = p;
+    particles[i].velocity.xyz = v;
+}
+)";
+        }; // namespace sources
+
+        /** @brief Simulates and draws particles entirely on the GPU. */
+        class particle_system
+        {
+        private:
+            enum pass { HASH = 0, SCAN = 1, SCATTER = 2, FORCES = 3, INTEGRATE = 4, PASS_COUNT = 5 };
+
+            shader::shader_program _programs[PASS_COUNT];
+            /// @brief The programs only point to their contents, hence these have to outlive them.
+            std::string _sources[PASS_COUNT];
+
+            buffer_object _particles;
+            buffer_object _forces;
+            buffer_object _particle_cells;
+            buffer_object _cell_start;
+            buffer_object _cell_end;
+            buffer_object _sorted;
+            uniform_buffer_object<simulation_parameters> _parameters;
+
+            simulation_settings _settings;
+            glm::vec4 _planes[max_planes];
+            sdf_collider _colliders[max_colliders];
+            size_t _plane_count = 0;
+            size_t _collider_count = 0;
+
+            size_t _capacity = 0;
+            size_t _size = 0;
+            /// @brief Where the next emitted particle is written. Once the buffer is full the oldest particles are overwritten.
+            size_t _next = 0;
+            uint32_t _hash_table_size = 0;
+
+            static uint32_t __next_power_of_two(uint32_t value)
+            {
+                uint32_t result = 1;
+                while(result < value) result <<= 1;
+                return result;
+            }
+
+            static void __create_storage(buffer_object& buffer, GLenum type, size_t size, GLenum usage)
+            {
+                buffer.set_type(type);
+                buffer.find_free_id();
+                buffer.bind();
+                buffer.create<GLubyte>(nullptr, size, usage);
+            }
+
+            void create_hash_table()
+            {
+                _hash_table_size = __next_power_of_two(std::max<uint32_t>(_settings.hash_table_size, 1));
+                for(buffer_object* buffer : { &_cell_start, &_cell_end })
+                {
+                    buffer->bind();
+                    buffer->create<GLuint>(nullptr, _hash_table_size, GL_DYNAMIC_COPY);
+                }
+            }
+
+        public:
+            /**
+             * @brief Creates the buffers and compiles the passes. (The programs go through the binary cache, see: shader::cache)
+             * Should be called once, after glfw::init_glad.
+             * @param capacity The maximum number of particles.
+             * @param settings? How the particles behave.
+            */
+            void create(size_t capacity, const simulation_settings& settings={})
+            {
+                _capacity = capacity;
+                _settings = settings;
+
+                __create_storage(_particles, GL_ARRAY_BUFFER, sizeof(particle)*capacity, GL_DYNAMIC_DRAW);
+                __create_storage(_forces, GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4)*capacity, GL_DYNAMIC_COPY);
+                __create_storage(_particle_cells, GL_SHADER_STORAGE_BUFFER, sizeof(GLuint)*capacity, GL_DYNAMIC_COPY);
+                __create_storage(_sorted, GL_SHADER_STORAGE_BUFFER, sizeof(GLuint)*capacity, GL_DYNAMIC_COPY);
+                __create_storage(_cell_start, GL_SHADER_STORAGE_BUFFER, 0, GL_DYNAMIC_COPY);
+                __create_storage(_cell_end, GL_SHADER_STORAGE_BUFFER, 0, GL_DYNAMIC_COPY);
+                create_hash_table();
+
+                _parameters.find_free_id();
+                _parameters.bind();
+                _parameters.create();
+
+                std::string header = "#version 430 core\n"
+                    "#define MAX_PLANES " + std::to_string(max_planes) + "\n"
+                    "#define MAX_COLLIDERS " + std::to_string(max_colliders) + "\n"
+                    "#define WORK_GROUP_SIZE " + std::to_string(work_group_size) + "\n";
+                header += sources::common;
+
+                const char* bodies[PASS_COUNT] = { sources::hash, sources::scan, sources::scatter, sources::forces, sources::integrate };
+                for(int i = 0; i < PASS_COUNT; i++)
+                {
+                    _sources[i] = header + bodies[i];
+                    _programs[i].set_compute_content(_sources[i].data());
+                    shader::loader::full_load_shader(_programs[i]);
+                }
+            }
+
+            /// @brief Changes how the particles behave. The hash table is reallocated if its size changed.
+            void set_settings(const simulation_settings& settings)
+            {
+                bool resize = settings.hash_table_size != _settings.hash_table_size;
+                _settings = settings;
+                if(resize && _capacity) create_hash_table();
+            }
+            const simulation_settings& get_settings() const noexcept(true) { return _settings; }
+
+            /// @brief Adds a plane. The particles stay on the side that the normal points towards.
+            /// @param normal The normalized normal of the plane.
+            /// @param distance The distance of the plane from the origin along the normal.
+            /// @return Whether or not the plane was added. (see: max_planes)
+            bool add_plane(const glm::vec3& normal, float distance)
+            {
+                if(_plane_count == max_planes) return false;
+                _planes[_plane_count++] = glm::vec4(normal, distance);
+                return true;
+            }
+            void clear_planes() noexcept(true) { _plane_count = 0; }
+
+            /// @brief Adds a collider. (see: sdf_collider::sphere, sdf_collider::box)
+            /// @return Whether or not the collider was added. (see: max_colliders)
+            bool add_collider(const sdf_collider& collider)
+            {
+                if(_collider_count == max_colliders) return false;
+                _colliders[_collider_count++] = collider;
+                return true;
+            }
+            void clear_colliders() noexcept(true) { _collider_count = 0; }
+
+            /**
+             * @brief Uploads new particles. This is the only time the particle data crosses the bus. Once the buffer is
+             * full the oldest particles are overwritten.
+             * @param data The particles.
+             * @param count The number of particles. Only the last @c capacity() of them are kept if there are more.
+            */
+            void emit(const particle* data, size_t count)
+            {
+                if(!_capacity || !count) return;
+                if(count > _capacity)
+                {
+                    data += count - _capacity;
+                    count = _capacity;
+                }
+
+                _particles.bind();
+                size_t first = std::min(count, _capacity - _next);
+                _particles.update<particle>(data, first, _next);
+                if(first < count) _particles.update<particle>(data + first, count - first, 0);
+
+                _next = (_next + count) % _capacity;
+                _size = std::min(_size + count, _capacity);
+            }
+
+            /// @brief Removes all the particles. Nothing is uploaded.
+            void clear() noexcept(true) { _size = _next = 0; }
+
+            /// @brief Advances the simulation by @c dt seconds. Nothing is read back, it is safe to draw right after.
+            void update(float dt)
+            {
+                GLFW_PROFILE_GPU_SCOPE("particle_system::update");
+                GLFW_PROFILE_COUNTER("particles::count", static_cast<double>(_size));
+                if(!_size) return;
+
+                simulation_parameters* parameters = _parameters.map();
+                parameters->gravity = glm::vec4(_settings.gravity, dt);
+                parameters->material = glm::vec4(_settings.restitution, _settings.friction, _settings.stiffness, _settings.damping);
+                parameters->grid = glm::vec4(_settings.cell_size, 1.0f / _settings.cell_size, 0.0f, 0.0f);
+                parameters->counts[0] = static_cast<GLuint>(_size);
+                parameters->counts[1] = _hash_table_size;
+                parameters->counts[2] = static_cast<GLuint>(_plane_count);
+                parameters->counts[3] = static_cast<GLuint>(_collider_count);
+                std::copy(_planes, _planes + _plane_count, parameters->planes);
+                std::copy(_colliders, _colliders + _collider_count, parameters->colliders);
+                _parameters.bind_base(0);
+
+                _particles.bind_base(0);
+                _forces.bind_base(1);
+                _particle_cells.bind_base(2);
+                _cell_start.bind_base(3);
+                _cell_end.bind_base(4);
+                _sorted.bind_base(5);
+
+                _cell_end.bind();
+                glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+                GLuint count = static_cast<GLuint>(_size);
+                for(int i = 0; i < PASS_COUNT; i++)
+                {
+                    _programs[i].use_shader();
+                    if(i == SCAN) _programs[i].dispatch(1);
+                    else _programs[i].dispatch_for(count);
+
+                    shader::shader_program::memory_barrier(i == INTEGRATE
+                        ? GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT
+                        : GL_SHADER_STORAGE_BARRIER_BIT);
+                }
+                _parameters.fence_region();
+            }
+
+            /**
+             * @brief Makes the vertex array object read the particle buffer as per-instance attributes. This only has to
+             * be called once per vertex array object.
+             * @param vao A reference to the vertex array object. (State will be modified)
+             * @param index The attribute of the position (and the radius). The velocity is at index+1.
+            */
+            void attach(vertex_array_object& vao, GLuint index)
+            {
+                vao.bind();
+                _particles.bind();
+                vao.create_attribute(index, 4, GL_FLOAT, false, sizeof(particle), reinterpret_cast<const void*>(offsetof(particle, position)));
+                vao.create_attribute(index+1, 4, GL_FLOAT, false, sizeof(particle), reinterpret_cast<const void*>(offsetof(particle, velocity)));
+                for(GLuint attribute : { index, index+1 })
+                {
+                    vao.enable_attribute(attribute);
+                    vao.set_attribute_divisor(attribute, 1);
+                }
+            }
+
+            /**
+             * @brief Draws every particle as an instance of the mesh of the vertex array object. (see: attach)
+             * @param vao A reference to the vertex array object.
+             * @param type The type of figure to draw. ex; point, line, triangle, etc.
+             * @param number_of_elements The number of indices of the mesh.
+             * @param type_of_indices The type of the data in the indices array. i.e. uint, int, ubyte, etc.
+            */
+            void draw(vertex_array_object& vao, GLenum type, GLsizei number_of_elements, GLenum type_of_indices)
+            {
+                if(!_size) return;
+                vao.bind();
+                vao.draw_elements_instanced(type, number_of_elements, type_of_indices, static_cast<GLsizei>(_size));
+            }
+
+            size_t size() const noexcept(true) { return _size; }
+            size_t capacity() const noexcept(true) { return _capacity; }
+            /// @brief The buffer that the particles live in. It is a GL_ARRAY_BUFFER that is also bound to the storage block 0.
+            buffer_object& particle_buffer() noexcept(true) { return _particles; }
+            /// @brief The compute program of the specified pass. [0<=pass<5]
+            const shader::shader_program& program(int pass) const { return _programs[pass]; }
+        };
+    }; // namespace particles
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
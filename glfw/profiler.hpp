@@ -0,0 +1,422 @@
+/**
+ * This header contains the profiler. It records how long the CPU and the GPU spend inside of named scopes
+ * and it can export all of that into the Chrome trace format. (Open chrome://tracing or https://ui.perfetto.dev and
+ * load the file)
+ *
+ * The profiler is compiled out unless _GLFW_USE_PROFILER_ is defined before including any of the headers. When it
+ * is compiled out, the GLFW_PROFILE_* macros expand to nothing and cost nothing.
+ *
+ *  GLFW_PROFILE_SCOPE(name)      : Records the CPU time of the enclosing scope. Can be used on any thread.
+ *  GLFW_PROFILE_GPU_SCOPE(name)  : Records the CPU and the GPU time of the enclosing scope. Only on the thread
+ *                                  whose context is current.
+ *  GLFW_PROFILE_FRAME()          : Marks the end of a frame. Should be called once per frame after swapping the buffers.
+ *  GLFW_PROFILE_COUNTER(name, v) : Records the value of a counter (ex; the number of pairs found by the broadphase).
+ *                                  It is shown as a graph in the trace. Can be used on any thread.
+ *
+ * The name must be a string literal (or any other string that lives forever) as only the pointer is stored.
+ *
+ * GPU times are measured with GL_TIMESTAMP queries, rather than a single GL_TIME_ELAPSED query, as only one
+ * GL_TIME_ELAPSED query can be active at a time which would make it impossible to nest the scopes. The results
+ * are read back at the end of the frame @c frames_in_flight - 1 frames later, so that reading them never stalls. If
+ * they still aren't available by then, the events of that frame are dropped rather than waiting for them. Without
+ * OpenGL (see: glfw.hpp) there are no GPU times, GLFW_PROFILE_GPU_SCOPE only records the CPU time.
+*/
+
+#include "./glfw.hpp"
+#include "./time.hpp"
+
+#ifndef _GLFW_PROFILER_DEFINITION_HPP_
+    #define _GLFW_PROFILER_DEFINITION_HPP_
+
+    #include <vector>
+    #include <memory>
+    #include <mutex>
+    #include <ostream>
+    #include <fstream>
+
+    _GLFW_START_
+
+    namespace profiler
+    {
+        /** @brief A single recorded scope. */
+        struct trace_event
+        {
+            /** @brief The name of the scope. */
+            const char* name;
+            /** @brief When the scope started, on the timeline of glfw::time::now_ns(). */
+            uint64_t start_ns;
+            /** @brief How long the scope took. */
+            uint64_t duration_ns;
+            /** @brief The id of the thread that recorded the scope. */
+            uint32_t thread;
+            /** @brief How deep the scope is nested. 0 means it is a top-level scope. */
+            uint32_t depth;
+            /** @brief The frame during which the scope was recorded. */
+            uint64_t frame;
+            /** @brief Whether this is the time spent by the GPU (true) or the CPU (false). */
+            bool gpu;
+        };
+
+        /** @brief A single recorded value of a counter. */
+        struct counter_event
+        {
+            /** @brief The name of the counter. */
+            const char* name;
+            /** @brief When the value was recorded, on the timeline of glfw::time::now_ns(). */
+            uint64_t time_ns;
+            double value;
+            /** @brief The id of the thread that recorded the value. */
+            uint32_t thread;
+            /** @brief The frame during which the value was recorded. */
+            uint64_t frame;
+        };
+
+        /** @brief The number of frames whose GPU queries are kept, the results are read back frames_in_flight - 1 frames later. */
+        constexpr size_t frames_in_flight = 3;
+
+        /** @brief Records the events of all the threads and resolves the GPU queries. Use the free functions below instead of this class. */
+        class trace_recorder
+        {
+        private:
+            /** @brief The events recorded by a single thread since the last frame. */
+            struct thread_buffer
+            {
+                std::mutex lock;
+                std::vector<trace_event> events;
+                std::vector<counter_event> counters;
+                uint32_t depth = 0;
+                uint32_t id = 0;
+            };
+
+            /** @brief A GPU scope whose queries haven't been read back yet. */
+            struct pending_gpu_event
+            {
+                const char* name;
+                uint32_t depth;
+                size_t begin_query;
+                size_t end_query;
+            };
+
+            /** @brief The queries issued during a single frame. */
+            struct gpu_frame
+            {
+                /** @brief GLuint, which isn't declared without OpenGL. */
+                std::vector<unsigned int> queries;
+                size_t used = 0;
+                std::vector<pending_gpu_event> events;
+                uint64_t frame = 0;
+
+                /** @brief Used to move the GPU timestamps onto the CPU timeline. */
+                int64_t gpu_to_cpu_offset = 0;
+                bool calibrated = false;
+            };
+
+            std::mutex _lock;
+            std::vector<std::shared_ptr<thread_buffer>> _threads;
+            std::vector<trace_event> _trace;
+            std::vector<counter_event> _counters;
+            size_t _max_events = 1 << 20;
+            uint64_t _frame = 0;
+            uint64_t _dropped_gpu_frames = 0;
+
+            gpu_frame _gpu_frames[frames_in_flight];
+            uint32_t _gpu_depth = 0;
+
+            gpu_frame& current_gpu_frame() { return _gpu_frames[_frame % frames_in_flight]; }
+
+            /** @brief Reads back the queries of a frame if they are available. */
+            void resolve_gpu_frame(gpu_frame& frame)
+            {
+                if(frame.events.empty()) return;
+
+            #ifndef _GLFW_WITHOUT_OPENGL_
+                GLuint available = GL_FALSE;
+                glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if(available)
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    for(const pending_gpu_event& event : frame.events)
+                    {
+                        GLuint64 begin = 0, end = 0;
+                        glGetQueryObjectui64v(frame.queries[event.begin_query], GL_QUERY_RESULT, &begin);
+                        glGetQueryObjectui64v(frame.queries[event.end_query], GL_QUERY_RESULT, &end);
+
+                        if(_trace.size() < _max_events) _trace.push_back(trace_event {
+                            event.name,
+                            static_cast<uint64_t>(static_cast<int64_t>(begin) + frame.gpu_to_cpu_offset),
+                            end - begin,
+                            0, event.depth, frame.frame, true
+                        });
+                    }
+                }
+                else _dropped_gpu_frames++;
+            #endif
+
+                frame.events.clear();
+                frame.used = 0;
+                frame.calibrated = false;
+            }
+
+        public:
+            /** @brief Returns the buffer of the calling thread. */
+            thread_buffer& local_buffer()
+            {
+                thread_local std::shared_ptr<thread_buffer> buffer = [this]
+                {
+                    std::shared_ptr<thread_buffer> created = std::make_shared<thread_buffer>();
+
+                    std::lock_guard<std::mutex> guard(_lock);
+                    created->id = static_cast<uint32_t>(_threads.size());
+                    _threads.push_back(created);
+                    return created;
+                }();
+                return *buffer;
+            }
+
+        #ifndef _GLFW_WITHOUT_OPENGL_
+            /** @brief Issues a timestamp query and returns its index in the current frame. */
+            size_t issue_gpu_timestamp()
+            {
+                gpu_frame& frame = current_gpu_frame();
+                if(!frame.calibrated)
+                {
+                    GLint64 gpu_now = 0;
+                    glGetInteger64v(GL_TIMESTAMP, &gpu_now);
+                    frame.gpu_to_cpu_offset = static_cast<int64_t>(glfw::time::now_ns()) - gpu_now;
+                    frame.calibrated = true;
+                }
+
+                if(frame.used == frame.queries.size())
+                {
+                    size_t grow = std::max<size_t>(frame.queries.size(), 64);
+                    frame.queries.resize(frame.queries.size() + grow);
+                    glGenQueries(static_cast<GLsizei>(grow), frame.queries.data() + frame.used);
+                }
+
+                glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+                return frame.used++;
+            }
+
+            uint32_t push_gpu_scope() { return _gpu_depth++; }
+
+            void pop_gpu_scope(const char* name, uint32_t depth, size_t begin_query)
+            {
+                size_t end_query = issue_gpu_timestamp();
+                current_gpu_frame().events.push_back(pending_gpu_event { name, depth, begin_query, end_query });
+                _gpu_depth--;
+            }
+        #endif
+
+            uint64_t frame() const { return _frame; }
+
+            /** @brief Collects the CPU events of all the threads and reads back the GPU results of an older frame. */
+            void end_frame()
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    for(std::shared_ptr<thread_buffer>& thread : _threads)
+                    {
+                        std::lock_guard<std::mutex> thread_guard(thread->lock);
+                        for(const trace_event& event : thread->events)
+                        {
+                            if(_trace.size() < _max_events) _trace.push_back(event);
+                        }
+                        thread->events.clear();
+
+                        for(const counter_event& counter : thread->counters)
+                        {
+                            if(_counters.size() < _max_events) _counters.push_back(counter);
+                        }
+                        thread->counters.clear();
+                    }
+                }
+
+                _frame++;
+                // The slot that the next frame will use was last written by the frame frames_in_flight - 1 frames before
+                // the one that just ended.
+                resolve_gpu_frame(current_gpu_frame());
+                current_gpu_frame().frame = _frame;
+            }
+
+            /** @brief Sets the maximum number of events that are kept, any event beyond that is dropped. */
+            void set_max_events(size_t count)
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _max_events = count;
+            }
+
+            /** @brief Forgets all the recorded events. */
+            void clear()
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _trace.clear();
+                _counters.clear();
+            }
+
+            /** @brief Returns the number of frames whose GPU results weren't ready in time and were dropped. */
+            uint64_t dropped_gpu_frames() const { return _dropped_gpu_frames; }
+
+            /** @brief Calls the function for every recorded event. */
+            template <typename Fn>
+            void for_each_event(Fn&& fn)
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                for(const trace_event& event : _trace) fn(event);
+            }
+
+            /** @brief Calls the function for every recorded value of every counter. */
+            template <typename Fn>
+            void for_each_counter(Fn&& fn)
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                for(const counter_event& counter : _counters) fn(counter);
+            }
+
+            /** @brief Deletes the query objects. The context must still be current. */
+            void destroy_queries()
+            {
+                for(gpu_frame& frame : _gpu_frames)
+                {
+                #ifndef _GLFW_WITHOUT_OPENGL_
+                    if(!frame.queries.empty()) glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+                #endif
+                    frame.queries.clear();
+                    frame.events.clear();
+                    frame.used = 0;
+                }
+            }
+        };
+
+        /** @brief The recorder that all the scopes write to. */
+        trace_recorder recorder;
+
+        /** @brief Records the CPU time spent from its creation to its destruction. */
+        class cpu_scope
+        {
+        private:
+            const char* _name;
+            uint32_t _depth;
+            uint64_t _start;
+
+        public:
+            explicit cpu_scope(const char* name) noexcept(true)
+                : _name(name), _depth(recorder.local_buffer().depth++), _start(glfw::time::now_ns()) {}
+
+            cpu_scope(const cpu_scope&) = delete;
+            cpu_scope& operator=(const cpu_scope&) = delete;
+
+            ~cpu_scope() noexcept(true)
+            {
+                uint64_t end = glfw::time::now_ns();
+
+                auto& buffer = recorder.local_buffer();
+                buffer.depth--;
+
+                std::lock_guard<std::mutex> guard(buffer.lock);
+                buffer.events.push_back(trace_event { _name, _start, end - _start, buffer.id, _depth, recorder.frame(), false });
+            }
+        };
+
+    #ifndef _GLFW_WITHOUT_OPENGL_
+        /** @brief Records both the CPU and the GPU time spent from its creation to its destruction. */
+        class gpu_scope
+        {
+        private:
+            cpu_scope _cpu;
+            const char* _name;
+            uint32_t _depth;
+            size_t _begin_query;
+
+        public:
+            explicit gpu_scope(const char* name)
+                : _cpu(name), _name(name), _depth(recorder.push_gpu_scope()), _begin_query(recorder.issue_gpu_timestamp()) {}
+
+            gpu_scope(const gpu_scope&) = delete;
+            gpu_scope& operator=(const gpu_scope&) = delete;
+
+            ~gpu_scope() { recorder.pop_gpu_scope(_name, _depth, _begin_query); }
+        };
+    #else
+        /** @brief There is no GPU to time without OpenGL, only the CPU time is recorded. */
+        using gpu_scope = cpu_scope;
+    #endif
+
+        /** @brief Records the current value of a counter. */
+        void record_counter(const char* name, double value)
+        {
+            uint64_t now = glfw::time::now_ns();
+
+            auto& buffer = recorder.local_buffer();
+            std::lock_guard<std::mutex> guard(buffer.lock);
+            buffer.counters.push_back(counter_event { name, now, value, buffer.id, recorder.frame() });
+        }
+
+        /** @brief Marks the end of a frame. */
+        void end_frame() { recorder.end_frame(); }
+
+        /**
+         * @brief Writes all the recorded events in the Chrome trace (JSON) format. CPU events are grouped by thread,
+         * GPU events are put into a separate process named "GPU". Counters are put into the "CPU" process.
+         * @param file_or_console Where to write the trace to.
+        */
+        void export_chrome_trace(std::ostream& file_or_console)
+        {
+            file_or_console << "{\"traceEvents\":[\n";
+            file_or_console << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+            file_or_console << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+            recorder.for_each_event([&](const trace_event& event)
+            {
+                // Chrome traces are in microseconds.
+                file_or_console << ",\n{\"name\":\"" << event.name
+                    << "\",\"cat\":\"" << (event.gpu ? "gpu" : "cpu")
+                    << "\",\"ph\":\"X\",\"ts\":" << event.start_ns / 1000 << '.' << event.start_ns % 1000 / 100
+                    << ",\"dur\":" << event.duration_ns / 1000 << '.' << event.duration_ns % 1000 / 100
+                    << ",\"pid\":" << (event.gpu ? 1 : 0)
+                    << ",\"tid\":" << event.thread
+                    << ",\"args\":{\"frame\":" << event.frame << ",\"depth\":" << event.depth << "}}";
+            });
+
+            recorder.for_each_counter([&](const counter_event& counter)
+            {
+                file_or_console << ",\n{\"name\":\"" << counter.name
+                    << "\",\"ph\":\"C\",\"ts\":" << counter.time_ns / 1000 << '.' << counter.time_ns % 1000 / 100
+                    << ",\"pid\":0,\"tid\":" << counter.thread
+                    << ",\"args\":{\"value\":" << counter.value << "}}";
+            });
+
+            file_or_console << "\n]}\n";
+        }
+
+        /**
+         * @brief Writes all the recorded events in the Chrome trace (JSON) format to the specified file.
+         * @param path The path of the file. It will be overwritten.
+         * @returns Whether or not the file could be opened.
+        */
+        bool export_chrome_trace(const char* path)
+        {
+            std::ofstream file(path);
+            if(!file) return false;
+            export_chrome_trace(file);
+            return true;
+        }
+    }; // namespace profiler
+
+    _GLFW_END_
+
+    #define __GLFW_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define __GLFW_PROFILE_CONCAT(a, b) __GLFW_PROFILE_CONCAT_IMPL(a, b)
+
+    #ifdef _GLFW_USE_PROFILER_
+        #define GLFW_PROFILE_SCOPE(name) ::glfw::profiler::cpu_scope __GLFW_PROFILE_CONCAT(__glfw_profile_scope_, __LINE__)(name)
+        #define GLFW_PROFILE_GPU_SCOPE(name) ::glfw::profiler::gpu_scope __GLFW_PROFILE_CONCAT(__glfw_profile_scope_, __LINE__)(name)
+        #define GLFW_PROFILE_FRAME() ::glfw::profiler::end_frame()
+        #define GLFW_PROFILE_COUNTER(name, value) ::glfw::profiler::record_counter(name, static_cast<double>(value))
+    #else
+        #define GLFW_PROFILE_SCOPE(name)
+        #define GLFW_PROFILE_GPU_SCOPE(name)
+        #define GLFW_PROFILE_FRAME()
+        #define GLFW_PROFILE_COUNTER(name, value)
+    #endif
+
+#endif
\ No newline at end of file
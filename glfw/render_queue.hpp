@@ -0,0 +1,345 @@
+/**
+ * This header contains the render queue. Instead of drawing while the scene is walked, the renderer pushes a draw
+ * packet for everything that it wants to draw. When the queue is flushed the packets are sorted by a 64-bit key, so
+ * that the ones that use the same program, vertex array and texture end up next to each other, and are then drawn
+ * with as few state changes as possible. A run of packets that share all of their state is drawn with a single
+ * glMultiDrawElementsIndirect call.
+ *
+ * The layout of the key (from the most significant bit);
+ *  sort_mode::BY_STATE      : program(12) | vertex array(12) | texture(16) | depth(24)   i.e. by state, then front to back.
+ *  sort_mode::BACK_TO_FRONT : depth(24) | program(12) | vertex array(12) | texture(16)   i.e. back to front, then by state.
+ *
+ * Only the low bits of the ids go into the key. Two different objects whose ids share those bits are only sorted
+ * next to each other, the packets are still compared by their full ids before being merged.
+ *
+ * The packets of a batch can't set uniforms of their own. Per-draw data should be read from a per-instance attribute
+ * (or a storage buffer) at the base_instance of the packet, which is what makes the packets mergeable in the first place.
+ *
+ * Usage;
+ *  queue.create();
+ *  ... every frame, inside the renderer ...
+ *  queue.push(packet);               // For everything that is visible.
+ *  queue.flush();                    // Sorts, draws and clears the queue.
+ *
+ * Requires OpenGL 4.4. (Multi-draw-indirect with a persistently mapped indirect buffer)
+*/
+
+#include "./glfw.hpp"
+#include "./error.hpp"
+#include "./profiler.hpp"
+#include "./state_cache.hpp"
+#include "./vbo.hpp"
+#include "./vao.hpp"
+
+#ifndef _GLFW_RENDER_QUEUE_DEFINITION_HPP_
+    #define _GLFW_RENDER_QUEUE_DEFINITION_HPP_
+
+    #include <vector>
+    #include <memory>
+    #include <cstdint>
+    #include <cstring>
+    #include <cstddef>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace render
+    {
+        /** @brief A single draw. It is drawn like draw_elements_indirect_command, with the state that it needs. */
+        struct draw_packet
+        {
+            /** @brief The id of the shader program. (see: shader_program::get_shader_id) */
+            GLuint program = 0;
+            /** @brief The id of the vertex array. Its element array buffer holds the indices. */
+            GLuint vertex_array = 0;
+            /** @brief The id of the texture that is bound to GL_TEXTURE0. 0 leaves the unit untouched. */
+            GLuint texture = 0;
+            /**
+             * @brief The target of the texture. ex; GL_TEXTURE_2D_ARRAY for a texture atlas (see: texture_array.hpp),
+             * every packet that samples the same atlas can then be drawn by the same multi-draw call.
+            */
+            GLenum texture_target = GL_TEXTURE_2D;
+
+            /** @brief The type of figure to draw. ex; GL_TRIANGLES */
+            GLenum mode = GL_TRIANGLES;
+            /** @brief The type of the indices. ex; GL_UNSIGNED_INT */
+            GLenum index_type = GL_UNSIGNED_INT;
+
+            /** @brief The number of indices to draw. */
+            GLuint count = 0;
+            /** @brief The index of the first index (not in bytes) in the index buffer. */
+            GLuint first_index = 0;
+            /** @brief A constant that is added to every index. */
+            GLint base_vertex = 0;
+            /** @brief The number of instances to draw. */
+            GLuint instance_count = 1;
+            /** @brief The instance from where the per-instance attributes start. */
+            GLuint base_instance = 0;
+
+            /** @brief The distance from the camera. Must not be negative. */
+            float depth = 0.0f;
+        };
+
+        /** @brief What the packets are sorted by first. */
+        enum class sort_mode : uint8_t
+        {
+            /** @brief By state, then front to back. i.e. The least state changes, with some early depth rejection. */
+            BY_STATE        = 0,
+            /** @brief Back to front, then by state. The order that blending needs. */
+            BACK_TO_FRONT   = 1
+        };
+
+        /** @brief How many packets of the last flush were drawn with how many calls. */
+        struct queue_statistics
+        {
+            size_t packets = 0;
+            /** @brief The number of draw calls, including the multi-draw calls. */
+            size_t draw_calls = 0;
+            /** @brief The number of draw calls that were multi-draw calls. */
+            size_t multi_draw_calls = 0;
+            /** @brief The number of times that the program, the vertex array or the texture changed. */
+            size_t state_changes = 0;
+        };
+
+        class render_queue
+        {
+            struct sort_entry
+            {
+                uint64_t key;
+                uint32_t index;
+            };
+
+            std::vector<draw_packet> _packets;
+            std::vector<sort_entry> _entries;
+            std::vector<sort_entry> _scratch;
+
+            std::unique_ptr<streaming_buffer_object> _indirect;
+            size_t _capacity = 0;
+
+            sort_mode _mode = sort_mode::BY_STATE;
+            queue_statistics _statistics;
+
+            static size_t index_size(GLenum index_type) noexcept(true)
+            {
+                switch(index_type)
+                {
+                case GL_UNSIGNED_BYTE:  return 1;
+                case GL_UNSIGNED_SHORT: return 2;
+                default:                return 4;
+                }
+            }
+
+            /** @brief Whether or not the two packets can be drawn with the same multi-draw call. */
+            static bool compatible(const draw_packet& a, const draw_packet& b) noexcept(true)
+            {
+                return a.program == b.program && a.vertex_array == b.vertex_array && a.texture == b.texture
+                    && a.texture_target == b.texture_target
+                    && a.mode == b.mode && a.index_type == b.index_type;
+            }
+
+            /** @brief (Re)creates the indirect buffer, so that a region fits @c capacity commands. */
+            void allocate(size_t capacity)
+            {
+                _capacity = capacity;
+                _indirect = std::make_unique<streaming_buffer_object>();
+                _indirect->set_type(GL_DRAW_INDIRECT_BUFFER);
+                _indirect->find_free_id();
+                _indirect->bind();
+                _indirect->create<draw_elements_indirect_command>(capacity);
+            }
+
+            /**
+             * @brief A least significant digit radix sort of the entries, 8 bits per pass. The histograms of all the
+             * passes are built in a single read of the keys. The passes whose digit is the same for every key are
+             * skipped. (ex; the depth when everything was pushed at the same depth)
+            */
+            void radix_sort()
+            {
+                size_t n = _entries.size();
+                _scratch.resize(n);
+
+                uint32_t histograms[8][256] = {};
+                for(const sort_entry& entry : _entries)
+                    for(int pass = 0; pass < 8; pass++) histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+
+                sort_entry* source = _entries.data();
+                sort_entry* destination = _scratch.data();
+                for(int pass = 0; pass < 8; pass++)
+                {
+                    uint32_t* histogram = histograms[pass];
+                    if(histogram[(source[0].key >> (pass * 8)) & 0xFF] == n) continue;
+
+                    uint32_t offset = 0;
+                    for(int digit = 0; digit < 256; digit++)
+                    {
+                        uint32_t count = histogram[digit];
+                        histogram[digit] = offset;
+                        offset += count;
+                    }
+                    for(size_t i = 0; i < n; i++) destination[histogram[(source[i].key >> (pass * 8)) & 0xFF]++] = source[i];
+                    std::swap(source, destination);
+                }
+                if(source != _entries.data()) std::memcpy(_entries.data(), source, n * sizeof(sort_entry));
+            }
+
+            /** @brief Binds the state of the packet. Only what changed is issued. (see: state::state_cache) */
+            void bind(const draw_packet& packet, const draw_packet* previous)
+            {
+                state::state_cache& cache = state::current();
+                _statistics.state_changes += !previous || previous->program != packet.program
+                    || previous->vertex_array != packet.vertex_array || previous->texture != packet.texture;
+
+                cache.use_program(packet.program);
+                cache.bind_vertex_array(packet.vertex_array);
+                if(packet.texture) cache.bind_texture_unit(GL_TEXTURE0, packet.texture_target, packet.texture);
+            }
+
+        public:
+            /**
+             * @brief Creates the indirect buffer. The context must be current.
+             * @param capacity? The number of packets that fit without growing the buffer.
+            */
+            void create(size_t capacity=1024)
+            {
+                allocate(std::max<size_t>(capacity, 1));
+                _packets.reserve(capacity);
+                _entries.reserve(capacity);
+                _scratch.reserve(capacity);
+            }
+
+            /** @brief Sets what the packets are sorted by first. (see: sort_mode) */
+            void set_sort_mode(sort_mode mode) noexcept(true) { _mode = mode; }
+            sort_mode get_sort_mode() const noexcept(true) { return _mode; }
+
+            /** @brief Returns the sort key of the packet. (see: the top of this file for the layout) */
+            static uint64_t make_key(const draw_packet& packet, sort_mode mode) noexcept(true)
+            {
+                // The bits of a non-negative float are ordered like the float itself. The top 24 (after the sign) are kept.
+                uint32_t depth_bits;
+                float depth = std::max(packet.depth, 0.0f);
+                std::memcpy(&depth_bits, &depth, sizeof(float));
+                uint64_t depth_key = (depth_bits >> 7) & 0xFFFFFF;
+
+                uint64_t state_key = (static_cast<uint64_t>(packet.program & 0xFFF) << 28)
+                    | (static_cast<uint64_t>(packet.vertex_array & 0xFFF) << 16)
+                    | static_cast<uint64_t>(packet.texture & 0xFFFF);
+
+                if(mode == sort_mode::BACK_TO_FRONT) return ((0xFFFFFF - depth_key) << 40) | state_key;
+                return (state_key << 24) | depth_key;
+            }
+
+            /** @brief Adds the packet to the queue. */
+            void push(const draw_packet& packet)
+            {
+                _entries.push_back(sort_entry { make_key(packet, _mode), static_cast<uint32_t>(_packets.size()) });
+                _packets.push_back(packet);
+            }
+
+            /** @brief Drops the packets without drawing them. */
+            void clear() noexcept(true)
+            {
+                _packets.clear();
+                _entries.clear();
+            }
+
+            /** @brief Sorts the packets by their keys. flush does this by itself. */
+            void sort()
+            {
+                GLFW_PROFILE_SCOPE("render_queue::sort");
+                if(_entries.size() > 1) radix_sort();
+            }
+
+            /**
+             * @brief Sorts and draws the packets, then clears the queue. The commands of the packets are written into the
+             * current region of the indirect buffer, which is fenced after the draws.
+            */
+            void flush()
+            {
+                GLFW_PROFILE_SCOPE("render_queue::flush");
+                _statistics = queue_statistics();
+                _statistics.packets = _packets.size();
+                if(_packets.empty()) return;
+
+                sort();
+
+                // The buffer grows by reallocating it. GL keeps the old one alive until the GPU is done with it.
+                if(_packets.size() > _capacity)
+                {
+                    size_t capacity = _capacity;
+                    while(capacity < _packets.size()) capacity *= 2;
+                    allocate(capacity);
+                }
+                // The packets are dropped if the indirect buffer couldn't be mapped. (see: streaming_buffer_object::create)
+                if(!_indirect->is_mapped())
+                {
+                    clear();
+                    return;
+                }
+
+                draw_elements_indirect_command* commands = _indirect->map_region<draw_elements_indirect_command>();
+                for(size_t i = 0; i < _entries.size(); i++)
+                {
+                    const draw_packet& packet = _packets[_entries[i].index];
+                    commands[i] = draw_elements_indirect_command {
+                        packet.count, packet.instance_count, packet.first_index, packet.base_vertex, packet.base_instance
+                    };
+                }
+
+                {
+                    GLFW_PROFILE_GPU_SCOPE("render_queue::draw");
+                    state::current().bind_buffer(GL_DRAW_INDIRECT_BUFFER, _indirect->get_id());
+
+                    const draw_packet* previous = nullptr;
+                    for(size_t first = 0; first < _entries.size();)
+                    {
+                        const draw_packet& packet = _packets[_entries[first].index];
+                        size_t last = first + 1;
+                        while(last < _entries.size() && compatible(packet, _packets[_entries[last].index])) last++;
+
+                        bind(packet, previous);
+                        previous = &packet;
+
+                        if(last - first == 1)
+                        {
+                            const void* offset = reinterpret_cast<const void*>(packet.first_index * index_size(packet.index_type));
+                            GLFW_CHECK_GL(glDrawElementsInstancedBaseVertexBaseInstance(packet.mode, packet.count, packet.index_type,
+                                offset, packet.instance_count, packet.base_vertex, packet.base_instance));
+                        }
+                        else
+                        {
+                            const void* offset = reinterpret_cast<const void*>(_indirect->region_offset() + first * sizeof(draw_elements_indirect_command));
+                            GLFW_CHECK_GL(glMultiDrawElementsIndirect(packet.mode, packet.index_type, offset,
+                                static_cast<GLsizei>(last - first), 0));
+                            _statistics.multi_draw_calls++;
+                        }
+                        _statistics.draw_calls++;
+                        first = last;
+                    }
+                }
+
+                _indirect->fence_region();
+                clear();
+
+                GLFW_PROFILE_COUNTER("render_queue::packets", _statistics.packets);
+                GLFW_PROFILE_COUNTER("render_queue::draw_calls", _statistics.draw_calls);
+            }
+
+            /** @brief Returns the number of packets in the queue. */
+            size_t size() const noexcept(true) { return _packets.size(); }
+            /** @brief Returns the number of packets that fit without growing the indirect buffer. */
+            size_t capacity() const noexcept(true) { return _capacity; }
+            /** @brief Returns the statistics of the last flush. */
+            const queue_statistics& statistics() const noexcept(true) { return _statistics; }
+
+            /** @brief Returns the packets in the order that they will be drawn in, after sort. */
+            template <typename F>
+            void for_each_sorted(F&& fn) const
+            {
+                for(const sort_entry& entry : _entries) fn(_packets[entry.index]);
+            }
+        };
+    }; // namespace render
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
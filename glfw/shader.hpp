@@ -1,379 +1,947 @@
-#ifndef _GLFW_SHADER_DEFINITION_HPP_
-    #define _GLFW_SHADER_DEFINITION_HPP_
-
-    #include "./glfw.hpp"
-
-    #include <fstream>
-    #include <filesystem>
-
-    #include <thread>
-
-    _GLFW_START_
-
-    namespace shader
-    {
-
-    /// @brief A struct which represents the paths(filenames) of the vertex and fragment shaders.
-    struct shader_paths 
-    { 
-        const char *vertex_shader = nullptr;
-        const char *fragment_shader = nullptr; 
-    };
-    /// @brief A struct which contains the contents of the vertex and fragment shaders. i.e. the actual stuff that will get compiled into a shader.
-    struct shader_contents 
-    { 
-        char *vertex_shader_content = nullptr; 
-        char *fragment_shader_content = nullptr; 
-    };
-
-    /// @brief Represents a null path or in other words, a path to nothing.
-    constexpr shader_paths null_shader_path = {};
-    #define NULL_SHADER_PATH null_shader_path
-    
-    /// @brief Pointer comparison
-    constexpr bool operator==(const shader_paths& left, const shader_paths& right)
-    { 
-        return left.vertex_shader == right.vertex_shader && left.fragment_shader == right.fragment_shader; 
-    }
-
-
-    class shader_program
-    {
-    private:
-        shader_paths paths;
-        shader_contents contents;
-
-        /// @brief Loades the file contents of the shaders into memeory.
-        /// @param vsc A reference to the variable where the content of the vertex shader will be set.
-        /// @param fsc A reference to the variable where the content of the fragment shader will be set.
-        /// @param vpth The path to the file where the vertex shader is present.
-        /// @param fpth The path to the file where the fragment shader is present.
-        static void __loader_func(char *&vsc, char*&fsc, const char* vpth, const char* fpth)
-        {
-            std::fstream vertfile(vpth);
-            size_t vertsz = std::filesystem::file_size(vpth);
-            vsc = new char[vertsz];
-            vertfile.get(vsc, vertsz,'\0'/* delim only works if the file read is a text file (not binary serialized). */);
-
-            std::fstream fragfile(fpth);
-            size_t fragsz = std::filesystem::file_size(fpth);
-            fsc = new char[fragsz];
-            fragfile.get(fsc, fragsz,'\0');
-        }
-
-        uint8_t _shader_state = static_cast<uint8_t>(shader_state::EMPTY);
-
-    public:
-        /// @brief Sets the filenames where the vertex and fragment shader will be found.
-        /// @param paths The filenames (preferrably the full path). If the passed in value is NULL_SHADER_PATH then call the set_content nethod to set your won content for the vertex and fragment shaders.
-        void set_path(const shader_paths& paths) noexcept(true)
-        { 
-            this->paths = paths; // copy
-            _shader_state = static_cast<uint8_t>(shader_state::FOUND_PATH); 
-        }
-
-        template <bool async=false>
-        void load_file()
-        {
-            if constexpr (async) // Loades the file in a different thread, concurrently.
-            {
-                std::thread thread_loader = 
-                    std::thread(
-                        __loader_func,                                  // Function
-                            std::ref(contents.vertex_shader_content),   // Params
-                            std::ref(contents.fragment_shader_content), // Params
-                            paths.vertex_shader,                        // Params
-                            paths.fragment_shader                       // Params
-                    );
-                thread_loader.detach(); // Is this safe?
-            } 
-            else 
-            {
-                __loader_func(                                  // Syncronous
-                    std::ref(contents.vertex_shader_content),   // Params
-                    std::ref(contents.fragment_shader_content), // Params
-                    paths.vertex_shader,                        // Params
-                    paths.fragment_shader                       // Params
-                );                     
-                return;
-            }
-        }
-
-        /// @brief This function should only be called when no file has been provided for getting the vertex and fragment shaders from.
-        /// @param vertex_shader_content The content to set for the vertex shader.
-        /// @param fragment_shader_content The content to set for the fragment shader.
-        void set_content(char* vertex_shader_content, char* fragment_shader_content) noexcept(true)
-        {
-            this->contents.vertex_shader_content = vertex_shader_content;
-            this->contents.fragment_shader_content = fragment_shader_content;
-
-            _shader_state = static_cast<uint8_t>(shader_state::CONTENT);
-        }
-
-    private:
-        GLuint vertex_shader_id;
-        GLuint fragment_shader_id;
-        
-    public:
-        /// @brief The id of the shader program.
-        GLuint shader_id = 0;
-
-        /// @brief Returns the id of the shader program.
-        const GLuint get_id() const noexcept(true) { return shader_id; }
-        
-        /// @brief Loads the actual compiled shader into memory.
-        void compile_shader()
-        {
-            vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-            glShaderSource(vertex_shader_id, 1, &contents.vertex_shader_content, NULL);
-            glCompileShader(vertex_shader_id);
-
-            fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
-            glShaderSource(fragment_shader_id, 1, &contents.fragment_shader_content, NULL);
-            glCompileShader(fragment_shader_id);
-
-            _shader_state = static_cast<uint8_t>(shader_state::COMPILED);
-        }
-
-        /// @brief Returns the id of the vertex shader. The vertex shader will be deleted after the shader program has been linked i.e. after link_shader( ) has been called. 
-        const GLuint get_vertex_shader_id() const noexcept(true) { return vertex_shader_id; }
-        /// @brief Returns the id of the fragment shader. The fragment shader will be deleted after the shader program has been linked i.e. after link_shader( ) has been called. 
-        const GLuint get_fragment_shader_id() const noexcept(true) { return fragment_shader_id; }
-
-        /// @brief Finally links the shaders to opengl so that they can be used later.
-        void link_shader()
-        {
-            shader_id = glCreateProgram();
-            glAttachShader(shader_id, vertex_shader_id);
-            glAttachShader(shader_id, fragment_shader_id);
-
-            glLinkProgram(shader_id);
-
-            // We dont need these shaders anymore as they have already been linked.
-                glDeleteShader(vertex_shader_id); 
-                glDeleteShader(fragment_shader_id);
-
-            _shader_state = static_cast<uint8_t>(shader_state::LINKED);
-        }
-        
-        /// @brief Uses the shader program while rendering. i.e. makes this the current active shader program.
-        void use_shader() noexcept(true) { glUseProgram(shader_id); }
-        
-        /**
-         * @brief Automatically deletes the shader program after any instance of this class is deleted or goes out 
-            of scope. Hence, it is beteer to heap allocate any instances of this class. Call this function manually 
-            to destroy the shader.
-        */ 
-        ~shader_program() noexcept(true) 
-        { 
-            glDeleteProgram(shader_id); 
-            _shader_state = static_cast<uint8_t>(shader_state::DESTROYED);
-        }
-
-        /// @brief The various states a shader can be in.
-        enum class shader_state : uint8_t
-        {
-            /// @brief It has no path and has no content.
-            EMPTY       = 0,
-            /// @brief A path has been specified for the vertex and fragment shaders. This state however is not necessarily reached all the time.
-            FOUND_PATH  = 1,
-            /// @brief The shader has loaded the content.
-            CONTENT     = 2,
-            /// @brief The contents of the shader have been compiled.
-            COMPILED    = 3,
-            /// @brief The compiled shader has been linked with opengl and can be used for rendering.
-            LINKED      = 4,
-            /// @brief The shader has been destroyed.
-            DESTROYED   = 5
-        };
-        /// @brief Returns the state of the shader.
-        shader_state get_shader_state() const noexcept(true) { return shader_state(_shader_state); }
-        /// @brief Returns the paths of the vertex and fragment shader files.
-        const shader_paths& get_shader_paths() const noexcept(true) { return this->paths; }
-        /// @brief Returns the contents loaded from the vertex and shader files.
-        const shader_contents& get_shader_contents() const noexcept(true) { return this->contents; }
-
-        /**
-         * @brief Returns the address of the uniform variable in the shader. So taht it can be modified in our 
-         * actual program.
-         * @param name The name of the variable to search for.
-        */ 
-        GLuint get_uniform_location(const char* name) const noexcept(true)
-        {
-            return glGetUniformLocation(this->shader_id, name);
-        }
-    };
-
-    /// @brief A namespace that helps with loading shaders quickly and efficiently.
-    namespace loader
-    {
-        /// @brief Creates a shader and sets the paths of the shader to the specified value.
-        /// @param paths The paths of the vertex and fragment shaders.
-        /// @return A unique pointer to the memory where the shader is heap allocated.
-        std::unique_ptr<shader_program> get_shader(const shader_paths& paths)
-        {
-            shader_program* sh = new shader_program();
-            sh->set_path(paths);
-
-            return std::unique_ptr<shader_program>(sh);
-        }
-
-        /// @brief Creates mutiple shaders and sets each and every one of their paths to the specified paths.
-        /// @param paths A vector of paths to set for the shaders.
-        /// @return Returns a vector of these shaders.
-        std::vector<shader_program> get_multiple_shaders(const std::vector<shader_paths>& paths)
-        {
-            std::vector<shader_program> _hRes = std::vector<shader_program>(paths.size());
-            for(int i = 0; i < paths.size(); i++)
-            {
-                _hRes[i].set_path(paths[i]);
-            }
-            return _hRes; // Hoping for move eliding.
-        }
-
-        /// @brief Loads the contents of the shader.
-        /// @param shader A reference to the shader. (The shader will be modified.)
-        void load_shader_contents(shader_program& shader) { shader.load_file<false>(); }
-        /// @brief Loads the contents of the shader asyncronously i.e. in a different thread.
-        /// @param shader A reference to the shader. (The shader will be modified.)
-        void load_shader_contents_async(shader_program& shader) { shader.load_file<true>(); }
-
-        /// @brief Loads multiple shaders at once. The program is paused until all the shaders have been loaded.
-        /// @param shaders A reference to a vector of shaders. 
-        void load_multiple_shader_contents(std::vector<shader_program>& shaders)
-        {
-            for(shader_program& shader : shaders)
-            {
-                shader.load_file<false>();
-            }
-        }
-        /// @brief Loads multiple shaders at once. The program will continue to run even while the shaders are being loaded.
-        /// @param shaders A reference to a vector of shaders. 
-        void load_multiple_shader_contents_async(std::vector<shader_program>& shaders)
-        {
-            for(shader_program& shader : shaders)
-            {
-                shader.load_file<true>();
-            }
-        }
-
-        /**
-         * @brief Attempts to fully load and link the shader program. That is, it does every step such as loading 
-            the file, compiling the shader and finally linking the shader. This function assumes that the paths are 
-            already set and if not uses the specified contents of the vertex and fragment shaders.
-         * @param shader A reference to the shader program.
-         * @param async_load? Whether or not the files should be loaded asynchronously. False by default.
-        */
-        void full_load_shader(shader_program& shader, bool async_load=false)
-        {
-            if(!(shader.get_shader_paths() == NULL_SHADER_PATH))
-            {
-                async_load?shader.load_file<true>():shader.load_file<false>();
-            } 
-            shader.compile_shader();
-            shader.link_shader();
-        }
-    }
-
-    /// @brief A namespace that makes it easier to compile shaders and check any problems that would have occurred during the compilation.
-    namespace compiler
-    {
-        /// @brief Compiles the shader and links it to memory.
-        /// @param shader A reference to the shader.
-        void compile_shader(shader_program& shader) { shader.link_shader(); }
-
-        /// @brief Compiles all the shaders and links them into memory.
-        /// @param shaders A vector of shaders.
-        void compile_shaders(std::vector<shader_program>& shaders) 
-        {
-            for(shader_program& shader : shaders)
-            {
-                shader.link_shader();
-            }
-        }
-
-        /// @brief Prints the compilation status of the vertex and fragment shaders. This should be called before the shader program has been linked as the compiled log exist only until that point.
-        /// @param shader A const reference to the shader program. (Nothing will be modified!)
-        void log_compilation_status(const shader_program& shader)
-        {
-            GLint param;
-
-            // ============================= VERTEX SHADER =============================
-            glGetShaderiv(shader.get_vertex_shader_id(), GL_COMPILE_STATUS, &param);
-            if(param == GL_FALSE)
-            {
-                printf("SHADER_COMPILATION_ERROR for vertex shader%c",'\n'); // Avoid flushing
-
-                glGetShaderiv(shader.get_vertex_shader_id(), GL_INFO_LOG_LENGTH, &param);
-
-                char* infoLog = new char[param];
-                glGetShaderInfoLog(shader.get_vertex_shader_id(), param, NULL, infoLog);
-                printf("INFO_LOG:%c%s\n",'\n',infoLog);
-                delete[] infoLog;
-
-            }else printf("SHADER_STATUS for vertex shader: GOOD\n");
-
-            // ============================= FRAGMENT SHADER =============================
-
-            glGetShaderiv(shader.get_fragment_shader_id(), GL_COMPILE_STATUS, &param);
-            if(param == GL_FALSE)
-            {
-                printf("SHADER_COMPILATION_ERROR for fragment shader%c",'\n'); // Avoid flushing
-
-                glGetShaderiv(shader.get_fragment_shader_id(), GL_INFO_LOG_LENGTH, &param);
-
-                char* infoLog = new char[param];
-                glGetShaderInfoLog(shader.get_fragment_shader_id(), param, NULL, infoLog);
-                printf("INFO_LOG:%c%s\n",'\n',infoLog);
-                delete[] infoLog;
-
-            }else printf("SHADER_STATUS for fragment shader: GOOD\n");
-        }
-
-        /// @brief Logs the compilation status of the vertex and fragment shaders to the specified file. This should be called before the shader program has been linked as the compiled log exist only until that point.
-        /// @param shader A const reference to the shader program. (Nothing will be modified!)
-        /// @param file_or_console The contents of the log will be written to the specified file or console[=stdout,stderr,etc].
-        void log_compilation_status(const shader_program& shader, std::ostream& file_or_console)
-        {
-            GLint param;
-
-            // ============================= VERTEX SHADER =============================
-            glGetShaderiv(shader.get_vertex_shader_id(), GL_COMPILE_STATUS, &param);
-            if(param == GL_FALSE)
-            {
-                file_or_console << "SHADER_COMPILATION_ERROR for vertex shader\n"; // Avoid flushing
-
-                glGetShaderiv(shader.get_vertex_shader_id(), GL_INFO_LOG_LENGTH, &param);
-
-                char* infoLog = new char[param];
-                glGetShaderInfoLog(shader.get_vertex_shader_id(), param, NULL, infoLog);
-                file_or_console << "INFO_LOG:\n" << infoLog << "\n";
-                delete[] infoLog;
-
-            }else file_or_console << "SHADER_STATUS for vertex shader: GOOD\n";
-
-            // ============================= FRAGMENT SHADER =============================
-
-            glGetShaderiv(shader.get_fragment_shader_id(), GL_COMPILE_STATUS, &param);
-            if(param == GL_FALSE)
-            {
-                file_or_console << "SHADER_COMPILATION_ERROR for fragment shader\n"; // Avoid flushing
-
-                glGetShaderiv(shader.get_fragment_shader_id(), GL_INFO_LOG_LENGTH, &param);
-
-                char* infoLog = new char[param];
-                glGetShaderInfoLog(shader.get_fragment_shader_id(), param, NULL, infoLog);
-                file_or_console << "INFO_LOG:\n" << infoLog << std::endl;
-                delete[] infoLog;
-
-            }else file_or_console << "SHADER_STATUS for fragment shader: GOOD" << std::endl;
-        }
-    };
-
-    }; // namespace shader
-
-    _GLFW_END_
-
-    #undef PRIVATE
-
+#ifndef _GLFW_SHADER_DEFINITION_HPP_
+    #define _GLFW_SHADER_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+    #include "./profiler.hpp"
+    #include "./thread_pool.hpp"
+    #include "./state_cache.hpp"
+    #include "./error.hpp"
+
+    #include <fstream>
+    #include <filesystem>
+
+    #include <thread>
+    #include <future>
+    #include <vector>
+    #include <memory>
+    #include <string>
+    #include <unordered_map>
+
+    _GLFW_START_
+
+    namespace shader
+    {
+
+    /**
+     * @brief A struct which represents the paths(filenames) of the vertex and fragment shaders. A compute program only 
+     * sets the path of the compute shader, the vertex and fragment shaders are ignored if it is set.
+    */
+    struct shader_paths 
+    { 
+        const char *vertex_shader = nullptr;
+        const char *fragment_shader = nullptr; 
+        const char *compute_shader = nullptr;
+    };
+    /// @brief A struct which contains the contents of the vertex and fragment shaders. i.e. the actual stuff that will get compiled into a shader.
+    struct shader_contents 
+    { 
+        char *vertex_shader_content = nullptr; 
+        char *fragment_shader_content = nullptr; 
+        char *compute_shader_content = nullptr;
+    };
+
+    /// @brief Represents a null path or in other words, a path to nothing.
+    constexpr shader_paths null_shader_path = {};
+    #define NULL_SHADER_PATH null_shader_path
+    
+    /// @brief Pointer comparison
+    constexpr bool operator==(const shader_paths& left, const shader_paths& right)
+    { 
+        return left.vertex_shader == right.vertex_shader && left.fragment_shader == right.fragment_shader 
+            && left.compute_shader == right.compute_shader; 
+    }
+
+    /// @brief Returns the paths of a compute program.
+    constexpr shader_paths compute_shader_path(const char* compute_shader) { return shader_paths { nullptr, nullptr, compute_shader }; }
+
+
+    class shader_program
+    {
+    private:
+        /// @brief The job that is loading the contents. Copying it (and assigning it) waits for the job, and for the 
+        /// job of the program that is assigned to.
+        struct __pending_load
+        {
+            std::shared_future<void> job;
+
+            /// @brief Waits for the job, if there is one. Returns the future of a job that has finished, i.e. none.
+            std::shared_future<void> finished() const
+            {
+                if(job.valid()) job.wait();
+                return {};
+            }
+
+            __pending_load() = default;
+            __pending_load(const __pending_load& other) : job(other.finished()) {}
+            __pending_load& operator=(const __pending_load& other)
+            {
+                other.finished();
+                job = finished();
+                return *this;
+            }
+        };
+        /**
+         * @brief Only valid while the contents are being loaded asynchronously. The job writes into the contents of 
+         * this program, hence it is declared before them; a program that is copied (ex; by a vector that grows) waits
+         * for the job before its contents are copied.
+        */
+        __pending_load _pending_load;
+
+        shader_paths paths;
+        shader_contents contents;
+
+        /// @brief Reads the whole file with a single read. The contents are null terminated.
+        /// @param pth The path to the file.
+        /// @return The contents (heap allocated) or nullptr if the file couldn't be read.
+        static char* __read_file(const char* pth)
+        {
+            std::ifstream file(pth, std::ios::binary);
+            std::error_code ec;
+            size_t sz = std::filesystem::file_size(pth, ec);
+            if(!file || ec) 
+            {
+                fprintf(stderr, "Error loading shader at \"%s\"\n", pth);
+                return nullptr;
+            }
+
+            char* contents = new char[sz + 1];
+            file.read(contents, sz);
+            contents[file.gcount()] = '\0';
+            return contents;
+        }
+
+        /// @brief Loades the file contents of the shaders into memeory. Only the shaders that have a path are read.
+        /// @param contents A reference to the contents that will be set.
+        /// @param paths The paths to the files where the shaders are present.
+        static void __loader_func(shader_contents& contents, const shader_paths& paths)
+        {
+            if(paths.compute_shader)
+            {
+                contents.compute_shader_content = __read_file(paths.compute_shader);
+                return;
+            }
+            if(paths.vertex_shader) contents.vertex_shader_content = __read_file(paths.vertex_shader);
+            if(paths.fragment_shader) contents.fragment_shader_content = __read_file(paths.fragment_shader);
+        }
+
+        uint8_t _shader_state = static_cast<uint8_t>(shader_state::EMPTY);
+
+        /// @brief The locations of all the active uniforms, by name. Filled once after linking. (see: get_uniform_location)
+        mutable std::unordered_map<std::string, GLint> _uniform_locations;
+        mutable bool _uniforms_introspected = false;
+
+        /// @brief Fills the uniform location cache by querying all the active uniforms of the program at once. Only 
+        /// the names GL reports are stored, the others are still looked up on a miss (see: get_uniform_location).
+        void introspect_uniforms() const
+        {
+            _uniform_locations.clear();
+            _uniforms_introspected = true;
+            if(!GLAD_GL_VERSION_4_3) return; // Program interface queries are GL 4.3.
+
+            GLint count = 0, max_length = 0;
+            glGetProgramInterfaceiv(shader_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+            glGetProgramInterfaceiv(shader_id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+            if(count <= 0) return;
+
+            std::string name(static_cast<size_t>(max_length), '\0');
+            _uniform_locations.reserve(static_cast<size_t>(count) * 2);
+
+            const GLenum properties[] = { GL_LOCATION };
+            for(GLint i = 0; i < count; i++)
+            {
+                GLint location = -1;
+                glGetProgramResourceiv(shader_id, GL_UNIFORM, i, 1, properties, 1, nullptr, &location);
+                if(location < 0) continue; // Uniforms inside of uniform blocks don't have a location.
+
+                GLsizei length = 0;
+                glGetProgramResourceName(shader_id, GL_UNIFORM, i, max_length, &length, name.data());
+                std::string key(name.data(), static_cast<size_t>(length));
+
+                // Arrays are reported as "name[0]", but they can also be looked up as "name".
+                if(key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) 
+                    _uniform_locations.emplace(key.substr(0, key.size() - 3), location);
+                _uniform_locations.emplace(std::move(key), location);
+            }
+        }
+
+    public:
+        /// @brief Sets the filenames where the vertex and fragment shader will be found.
+        /// @param paths The filenames (preferrably the full path). If the passed in value is NULL_SHADER_PATH then call the set_content nethod to set your won content for the vertex and fragment shaders.
+        void set_path(const shader_paths& paths) noexcept(true)
+        { 
+            this->paths = paths; // copy
+            _shader_state = static_cast<uint8_t>(shader_state::FOUND_PATH); 
+        }
+
+        /**
+         * @brief Loads the contents of the vertex and fragment shader files.
+         * @tparam async Whether or not to load the files on the shared thread pool. (see: thread_pool.hpp) The contents 
+         * must not be accessed until the returned future is ready, compile_shader waits for it by itself.
+         * @return A future that becomes ready once the contents have been loaded.
+        */
+        template <bool async=false>
+        std::shared_future<void> load_file()
+        {
+            wait_for_contents();
+
+            if constexpr (async) // Loades the file on the thread pool, concurrently.
+            {
+                shader_contents* destination = &contents;
+                shader_paths source = paths;
+                _pending_load.job = jobs::shared_pool().submit([destination, source]
+                {
+                    __loader_func(*destination, source);
+                }).share();
+                _shader_state = static_cast<uint8_t>(shader_state::CONTENT);
+                return _pending_load.job;
+            } 
+            else 
+            {
+                __loader_func(contents, paths);                 // Syncronous
+                _shader_state = static_cast<uint8_t>(shader_state::CONTENT);
+
+                std::promise<void> loaded;
+                loaded.set_value();
+                return loaded.get_future().share();
+            }
+        }
+
+        /// @brief Whether or not the contents have been loaded. Always true if they aren't being loaded asynchronously.
+        bool is_loaded() const
+        {
+            return !_pending_load.job.valid() || _pending_load.job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        /// @brief Blocks until the contents have been loaded, if they are being loaded asynchronously.
+        void wait_for_contents()
+        {
+            _pending_load.job = _pending_load.finished();
+        }
+
+        /// @brief This function should only be called when no file has been provided for getting the vertex and fragment shaders from.
+        /// @param vertex_shader_content The content to set for the vertex shader.
+        /// @param fragment_shader_content The content to set for the fragment shader.
+        void set_content(char* vertex_shader_content, char* fragment_shader_content) noexcept(true)
+        {
+            this->contents.vertex_shader_content = vertex_shader_content;
+            this->contents.fragment_shader_content = fragment_shader_content;
+
+            _shader_state = static_cast<uint8_t>(shader_state::CONTENT);
+        }
+
+        /// @brief Same as set_content but for a compute program. This should only be called when no file has been provided.
+        /// @param compute_shader_content The content to set for the compute shader.
+        void set_compute_content(char* compute_shader_content) noexcept(true)
+        {
+            this->contents.compute_shader_content = compute_shader_content;
+
+            _shader_state = static_cast<uint8_t>(shader_state::CONTENT);
+        }
+
+        /// @brief Whether or not this is a compute program. i.e. it has a compute shader instead of the vertex and fragment shaders.
+        bool is_compute() const noexcept(true) { return paths.compute_shader || contents.compute_shader_content; }
+
+    private:
+        GLuint vertex_shader_id = 0;
+        GLuint fragment_shader_id = 0;
+        GLuint compute_shader_id = 0;
+        
+    public:
+        /// @brief The id of the shader program.
+        GLuint shader_id = 0;
+
+        /// @brief Returns the id of the shader program.
+        const GLuint get_id() const noexcept(true) { return shader_id; }
+        
+        /// @brief Loads the actual compiled shader into memory. Waits for the contents if they are still being loaded.
+        /// If parallel compilation is enabled (see: compiler::enable_parallel_compile) this doesn't wait for the compilation.
+        void compile_shader()
+        {
+            wait_for_contents();
+
+            if(is_compute())
+            {
+                compute_shader_id = glCreateShader(GL_COMPUTE_SHADER);
+                glShaderSource(compute_shader_id, 1, &contents.compute_shader_content, NULL);
+                glCompileShader(compute_shader_id);
+
+                _shader_state = static_cast<uint8_t>(shader_state::COMPILED);
+                return;
+            }
+
+            vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(vertex_shader_id, 1, &contents.vertex_shader_content, NULL);
+            glCompileShader(vertex_shader_id);
+
+            fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(fragment_shader_id, 1, &contents.fragment_shader_content, NULL);
+            glCompileShader(fragment_shader_id);
+
+            _shader_state = static_cast<uint8_t>(shader_state::COMPILED);
+        }
+
+        /// @brief Returns the id of the vertex shader. The vertex shader will be deleted after the shader program has been linked i.e. after link_shader( ) has been called. 
+        const GLuint get_vertex_shader_id() const noexcept(true) { return vertex_shader_id; }
+        /// @brief Returns the id of the fragment shader. The fragment shader will be deleted after the shader program has been linked i.e. after link_shader( ) has been called. 
+        const GLuint get_fragment_shader_id() const noexcept(true) { return fragment_shader_id; }
+        /// @brief Returns the id of the compute shader. Like the others, it will be deleted after the shader program has been linked.
+        GLuint get_compute_shader_id() const noexcept(true) { return compute_shader_id; }
+
+        /// @brief Finally links the shaders to opengl so that they can be used later.
+        void link_shader()
+        {
+            GLFW_PROFILE_GPU_SCOPE("shader_program::link_shader");
+            shader_id = glCreateProgram();
+            if(is_compute()) glAttachShader(shader_id, compute_shader_id);
+            else
+            {
+                glAttachShader(shader_id, vertex_shader_id);
+                glAttachShader(shader_id, fragment_shader_id);
+            }
+
+            // So that the linked program can be stored in the binary cache. (see: cache)
+            glProgramParameteri(shader_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(shader_id);
+
+            // We dont need these shaders anymore as they have already been linked.
+            if(is_compute()) glDeleteShader(compute_shader_id);
+            else
+            {
+                glDeleteShader(vertex_shader_id); 
+                glDeleteShader(fragment_shader_id);
+            }
+
+            _uniforms_introspected = false;
+            _work_group_size[0] = 0;
+            _shader_state = static_cast<uint8_t>(shader_state::LINKED);
+        }
+        
+        /**
+         * @brief Whether or not the driver has finished linking the program. With parallel compilation linking happens 
+         * in the background, querying anything else about the program before then will block. Always true otherwise.
+        */
+        bool is_link_complete() const
+        {
+            if(!parallel_compile_enabled) return true;
+
+            GLint complete = GL_TRUE;
+            glGetProgramiv(shader_id, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete == GL_TRUE;
+        }
+
+        /// @brief Blocks until the driver has finished linking the program. (Querying the link status waits for it)
+        /// @return Whether or not the program was linked successfully.
+        bool wait_for_link() const
+        {
+            GLint status = GL_FALSE;
+            glGetProgramiv(shader_id, GL_LINK_STATUS, &status);
+            return status == GL_TRUE;
+        }
+
+        /// @brief Whether or not compiler::enable_parallel_compile has succeeded.
+        static inline bool parallel_compile_enabled = false;
+
+        /**
+         * @brief Creates the shader program from a binary that was previously retrieved with glGetProgramBinary, instead 
+         * of compiling and linking it. The driver may reject the binary (ex; after a driver update).
+         * @param format The format of the binary. (Driver specific)
+         * @param binary The binary.
+         * @param length The size(in bytes) of the binary.
+         * @return Whether or not the driver accepted the binary. If it didn't, the shader program is left untouched.
+        */
+        bool link_from_binary(GLenum format, const void* binary, GLsizei length)
+        {
+            GLuint program = glCreateProgram();
+            glProgramBinary(program, format, binary, length);
+
+            GLint status = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+            if(status != GL_TRUE)
+            {
+                glDeleteProgram(program);
+                return false;
+            }
+
+            if(shader_id) 
+            {
+                glDeleteProgram(shader_id);
+                state::current().forget_program(shader_id);
+            }
+            shader_id = program;
+            _uniforms_introspected = false;
+            _work_group_size[0] = 0;
+            _shader_state = static_cast<uint8_t>(shader_state::LINKED);
+            return true;
+        }
+
+        /// @brief Uses the shader program while rendering. i.e. makes this the current active shader program.
+        void use_shader() noexcept(true) { state::current().use_program(shader_id); }
+
+    private:
+        mutable GLint _work_group_size[3] = { 0, 0, 0 };
+
+    public:
+        /// @brief Returns the local size (layout(local_size_x=...) in the shader) of the compute program along the specified axis. [0<=axis<3]
+        GLuint get_work_group_size(int axis) const
+        {
+            if(!_work_group_size[0]) glGetProgramiv(shader_id, GL_COMPUTE_WORK_GROUP_SIZE, _work_group_size);
+            return static_cast<GLuint>(_work_group_size[axis]);
+        }
+
+        /**
+         * @brief Launches the compute program. The program must be in use. (see: use_shader) Requires OpenGL 4.3.
+         * @param x The number of work groups along the x-axis.
+         * @param y? The number of work groups along the y-axis.
+         * @param z? The number of work groups along the z-axis.
+        */
+        void dispatch(GLuint x, GLuint y=1, GLuint z=1)
+        {
+            GLFW_PROFILE_GPU_SCOPE("shader_program::dispatch");
+            GLFW_CHECK_GL(glDispatchCompute(x, y, z));
+        }
+
+        /// @brief Launches enough work groups of the compute program to cover @c count invocations along the x-axis. The shader
+        /// has to skip the invocations past the end by itself. Nothing is launched if the program failed to link.
+        void dispatch_for(GLuint count)
+        {
+            GLuint size = get_work_group_size(0);
+            if(count && size) dispatch((count + size - 1) / size);
+        }
+
+        /// @brief Launches the compute program with the work group counts (3 GLuints) read from the buffer bound to GL_DISPATCH_INDIRECT_BUFFER.
+        /// @param offset? The offset(in bytes) of the counts in the indirect buffer.
+        void dispatch_indirect(GLintptr offset=0)
+        {
+            GLFW_PROFILE_GPU_SCOPE("shader_program::dispatch_indirect");
+            GLFW_CHECK_GL(glDispatchComputeIndirect(offset));
+        }
+
+        /**
+         * @brief Makes the writes of the previous dispatches visible to the commands after it. Compute shaders write 
+         * incoherently, hence this must be called between a dispatch and anything that reads what it wrote.
+         * @param barriers How the data will be read next. ex; GL_SHADER_STORAGE_BARRIER_BIT for another dispatch, 
+         * GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT for a draw call that reads the buffer as vertex attributes.
+        */
+        static void memory_barrier(GLbitfield barriers) { glMemoryBarrier(barriers); }
+        
+        /**
+         * @brief Automatically deletes the shader program after any instance of this class is deleted or goes out 
+            of scope. Hence, it is beteer to heap allocate any instances of this class. Call this function manually 
+            to destroy the shader.
+        */ 
+        ~shader_program() noexcept(true) 
+        { 
+            // The job writes into the contents of this program, it can't outlive it.
+            wait_for_contents();
+            glDeleteProgram(shader_id); 
+            state::current().forget_program(shader_id);
+            _shader_state = static_cast<uint8_t>(shader_state::DESTROYED);
+        }
+
+        /// @brief The various states a shader can be in.
+        enum class shader_state : uint8_t
+        {
+            /// @brief It has no path and has no content.
+            EMPTY       = 0,
+            /// @brief A path has been specified for the vertex and fragment shaders. This state however is not necessarily reached all the time.
+            FOUND_PATH  = 1,
+            /// @brief The shader has loaded the content.
+            CONTENT     = 2,
+            /// @brief The contents of the shader have been compiled.
+            COMPILED    = 3,
+            /// @brief The compiled shader has been linked with opengl and can be used for rendering.
+            LINKED      = 4,
+            /// @brief The shader has been destroyed.
+            DESTROYED   = 5
+        };
+        /// @brief Returns the state of the shader.
+        shader_state get_shader_state() const noexcept(true) { return shader_state(_shader_state); }
+        /// @brief Returns the paths of the vertex and fragment shader files.
+        const shader_paths& get_shader_paths() const noexcept(true) { return this->paths; }
+        /// @brief Returns the contents loaded from the vertex and shader files.
+        const shader_contents& get_shader_contents() const noexcept(true) { return this->contents; }
+
+        /**
+         * @brief Returns the address of the uniform variable in the shader. So taht it can be modified in our 
+         * actual program. On GL 4.3 the locations of all the uniforms are queried at once the first time this is 
+         * called after linking (not inside link_shader so that parallel linking isn't blocked). Names that aren't 
+         * cached yet, like "lights[3]" or "s.member", are asked from GL once and then cached too, -1 included.
+         * @param name The name of the variable to search for.
+         * @return The location, or -1 if there is no active uniform with that name.
+        */ 
+        GLuint get_uniform_location(const char* name) const noexcept(true)
+        {
+            if(!_uniforms_introspected) introspect_uniforms();
+
+            auto found = _uniform_locations.find(name);
+            if(found != _uniform_locations.end()) return found->second;
+
+            GLint location = glGetUniformLocation(shader_id, name);
+            _uniform_locations.emplace(name, location);
+            return location;
+        }
+
+        /**
+         * @brief Connects a uniform block of the shader to a binding point, so that it reads from the uniform buffer 
+         * bound to that point. (see: uniform_buffer_object::bind_base)
+         * @param name The name of the uniform block.
+         * @param binding The binding point.
+         * @return Whether or not the program has an active uniform block with that name.
+        */
+        bool bind_uniform_block(const char* name, GLuint binding) const
+        {
+            GLuint index = glGetUniformBlockIndex(shader_id, name);
+            if(index == GL_INVALID_INDEX) return false;
+
+            glUniformBlockBinding(shader_id, index, binding);
+            return true;
+        }
+
+        /**
+         * @brief Connects a shader storage block of the shader to a binding point, so that it reads from and writes to 
+         * the buffer bound to that point. (see: buffer_object::bind_base) Requires OpenGL 4.3.
+         * @param name The name of the shader storage block.
+         * @param binding The binding point.
+         * @return Whether or not the program has an active shader storage block with that name.
+        */
+        bool bind_storage_block(const char* name, GLuint binding) const
+        {
+            GLuint index = glGetProgramResourceIndex(shader_id, GL_SHADER_STORAGE_BLOCK, name);
+            if(index == GL_INVALID_INDEX) return false;
+
+            glShaderStorageBlockBinding(shader_id, index, binding);
+            return true;
+        }
+    };
+
+    /**
+     * @brief A namespace that stores linked shader programs on the disk (glGetProgramBinary) so that they don't have to be
+     * compiled and linked again the next time. Every program is stored in its own file, named after a hash of its 
+     * sources and the vendor/renderer/version strings of the driver. Hence, editing a shader or updating the driver 
+     * simply misses the cache.
+    */
+    namespace cache
+    {
+        /// @brief The directory where the programs are stored. The cache is disabled if it is empty.
+        std::string directory = "shader_cache";
+
+        /// @brief Identifies the files of the cache, so that other files are never fed to the driver.
+        constexpr uint32_t file_magic = 0x42505347; // "GSPB"
+        /// @brief Should be increased whenever the layout of the files is changed.
+        constexpr uint32_t file_version = 1;
+
+        /// @brief The header at the start of every file in the cache.
+        struct file_header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t key;
+            uint32_t format;
+            uint32_t length;
+        };
+
+        /// @brief Sets the directory where the programs are stored. Pass an empty string to disable the cache.
+        void set_directory(const char* path) { directory = path ? path : ""; }
+
+        /// @brief Whether or not the cache is enabled and the driver can retrieve program binaries.
+        bool is_supported()
+        {
+            if(directory.empty()) return false;
+
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            return formats > 0;
+        }
+
+        /// @brief The FNV-1a hash. @link http://www.isthe.com/chongo/tech/comp/fnv/index.html
+        uint64_t __hash(uint64_t hash, const char* str)
+        {
+            if(!str) return hash;
+            for(; *str; str++) hash = (hash ^ static_cast<uint8_t>(*str)) * 0x100000001B3ull;
+            // Separates the strings, so that ("ab","c") and ("a","bc") don't hash the same.
+            return (hash ^ 0xFF) * 0x100000001B3ull;
+        }
+
+        /// @brief Returns the key of the program in the cache. The contents of the shader must have been loaded.
+        uint64_t get_key(const shader_program& shader)
+        {
+            uint64_t hash = 0xCBF29CE484222325ull;
+            hash = __hash(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+            hash = __hash(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+            hash = __hash(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+            hash = __hash(hash, shader.get_shader_contents().vertex_shader_content);
+            hash = __hash(hash, shader.get_shader_contents().fragment_shader_content);
+            hash = __hash(hash, shader.get_shader_contents().compute_shader_content);
+            return hash;
+        }
+
+        /// @brief Returns the path of the file where the program with the specified key is stored.
+        std::filesystem::path get_path(uint64_t key)
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+            return std::filesystem::path(directory) / name;
+        }
+
+        /**
+         * @brief Tries to create the shader program from the cache. Stale files (ones the driver rejects) are deleted.
+         * @param shader A reference to the shader program. Its contents must have been loaded.
+         * @return Whether or not the program was found and accepted by the driver. If it was, the shader program has
+         * been linked and doesn't have to be compiled.
+        */
+        bool load(shader_program& shader)
+        {
+            if(!is_supported()) return false;
+
+            uint64_t key = get_key(shader);
+            std::filesystem::path path = get_path(key);
+
+            std::ifstream file(path, std::ios::binary);
+            if(!file) return false;
+
+            // The length comes from the file, a damaged one must not make it allocate more than the file holds.
+            std::error_code ec;
+            uintmax_t size = std::filesystem::file_size(path, ec);
+            file_header header;
+            bool valid = !ec && size >= sizeof(header) && file.read(reinterpret_cast<char*>(&header), sizeof(header)) 
+                && header.magic == file_magic && header.version == file_version && header.key == key
+                && header.length > 0 && header.length <= size - sizeof(header);
+
+            std::unique_ptr<char[]> binary;
+            if(valid)
+            {
+                binary.reset(new char[header.length]);
+                valid = file.read(binary.get(), header.length) 
+                    && shader.link_from_binary(header.format, binary.get(), static_cast<GLsizei>(header.length));
+            }
+            file.close();
+
+            if(!valid) std::filesystem::remove(path, ec);
+            return valid;
+        }
+
+        /**
+         * @brief Stores the linked shader program in the cache. Blocks until the driver has finished linking it.
+         * @param shader A const reference to the shader program. (Nothing will be modified!) Its contents must still be loaded.
+         * @return Whether or not the program was stored.
+        */
+        bool store(const shader_program& shader)
+        {
+            if(!is_supported() || shader.get_shader_state() != shader_program::shader_state::LINKED) return false;
+
+            GLint status = GL_FALSE, length = 0;
+            glGetProgramiv(shader.get_id(), GL_LINK_STATUS, &status);
+            glGetProgramiv(shader.get_id(), GL_PROGRAM_BINARY_LENGTH, &length);
+            if(status != GL_TRUE || length <= 0) return false;
+
+            std::unique_ptr<char[]> binary(new char[length]);
+            GLenum format = 0;
+            glGetProgramBinary(shader.get_id(), length, &length, &format, binary.get());
+
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+
+            file_header header { file_magic, file_version, get_key(shader), format, static_cast<uint32_t>(length) };
+            std::ofstream file(get_path(header.key), std::ios::binary | std::ios::trunc);
+            if(!file) return false;
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.get(), length);
+            return static_cast<bool>(file);
+        }
+    }
+
+    /// @brief A namespace that helps with loading shaders quickly and efficiently.
+    namespace loader
+    {
+        /// @brief Creates a shader and sets the paths of the shader to the specified value.
+        /// @param paths The paths of the vertex and fragment shaders.
+        /// @return A unique pointer to the memory where the shader is heap allocated.
+        std::unique_ptr<shader_program> get_shader(const shader_paths& paths)
+        {
+            shader_program* sh = new shader_program();
+            sh->set_path(paths);
+
+            return std::unique_ptr<shader_program>(sh);
+        }
+
+        /// @brief Creates a compute program and sets the path of its compute shader to the specified value.
+        /// @param path The path of the compute shader.
+        /// @return A unique pointer to the memory where the shader is heap allocated.
+        std::unique_ptr<shader_program> get_compute_shader(const char* path) { return get_shader(compute_shader_path(path)); }
+
+        /// @brief Creates mutiple shaders and sets each and every one of their paths to the specified paths.
+        /// @param paths A vector of paths to set for the shaders.
+        /// @return Returns a vector of these shaders.
+        std::vector<shader_program> get_multiple_shaders(const std::vector<shader_paths>& paths)
+        {
+            std::vector<shader_program> _hRes = std::vector<shader_program>(paths.size());
+            for(int i = 0; i < paths.size(); i++)
+            {
+                _hRes[i].set_path(paths[i]);
+            }
+            return _hRes; // Hoping for move eliding.
+        }
+
+        /// @brief Loads the contents of the shader.
+        /// @param shader A reference to the shader. (The shader will be modified.)
+        void load_shader_contents(shader_program& shader) { shader.load_file<false>(); }
+        /// @brief Loads the contents of the shader asyncronously i.e. on the thread pool.
+        /// @param shader A reference to the shader. (The shader will be modified.)
+        /// @return A future that becomes ready once the contents have been loaded.
+        std::shared_future<void> load_shader_contents_async(shader_program& shader) { return shader.load_file<true>(); }
+
+        /// @brief Loads multiple shaders at once. The program is paused until all the shaders have been loaded.
+        /// @param shaders A reference to a vector of shaders. 
+        void load_multiple_shader_contents(std::vector<shader_program>& shaders)
+        {
+            for(shader_program& shader : shaders)
+            {
+                shader.load_file<false>();
+            }
+        }
+        /// @brief Loads multiple shaders at once. The program will continue to run even while the shaders are being loaded.
+        /// @param shaders A reference to a vector of shaders. 
+        /// @return The futures of every shader, in the same order.
+        std::vector<std::shared_future<void>> load_multiple_shader_contents_async(std::vector<shader_program>& shaders)
+        {
+            std::vector<std::shared_future<void>> futures;
+            futures.reserve(shaders.size());
+            for(shader_program& shader : shaders)
+            {
+                futures.push_back(shader.load_file<true>());
+            }
+            return futures;
+        }
+
+        /**
+         * @brief Attempts to fully load and link the shader program. That is, it does every step such as loading 
+            the file, compiling the shader and finally linking the shader. This function assumes that the paths are 
+            already set and if not uses the specified contents of the vertex and fragment shaders. If the program is 
+            found in the binary cache (see: cache) it isn't compiled, otherwise the linked program is stored in it.
+         * @param shader A reference to the shader program.
+         * @param async_load? Whether or not the files should be loaded asynchronously. False by default.
+        */
+        void full_load_shader(shader_program& shader, bool async_load=false)
+        {
+            if(!(shader.get_shader_paths() == NULL_SHADER_PATH))
+            {
+                async_load?shader.load_file<true>():shader.load_file<false>();
+            } 
+            shader.wait_for_contents();
+            if(cache::load(shader)) return;
+
+            shader.compile_shader();
+            shader.link_shader();
+            cache::store(shader);
+        }
+
+        /**
+         * @brief Fully loads and links multiple shader programs. The files of all the shaders are read on the thread 
+         * pool at once, and every program is compiled as soon as its files have been read. With parallel compilation 
+         * (see: compiler::enable_parallel_compile) the compilation also happens in the background, hence the whole 
+         * thing is bounded by the time it takes to read the files. Programs found in the binary cache aren't compiled,
+         * the rest are stored in it once they have been linked (only if @c wait_for_link is true).
+         * @param shaders A reference to a vector of shaders.
+         * @param wait_for_link? Whether or not to wait until the driver has finished linking every program.
+        */
+        void full_load_shaders(std::vector<shader_program>& shaders, bool wait_for_link=true)
+        {
+            for(shader_program& shader : shaders)
+            {
+                if(!(shader.get_shader_paths() == NULL_SHADER_PATH)) shader.load_file<true>();
+            }
+
+            std::vector<bool> linked(shaders.size(), false);
+            std::vector<bool> cached(shaders.size(), false);
+            for(size_t remaining = shaders.size(); remaining;)
+            {
+                bool progressed = false;
+                size_t first_pending = shaders.size();
+                for(size_t i = 0; i < shaders.size(); i++)
+                {
+                    if(linked[i]) continue;
+                    if(!shaders[i].is_loaded())
+                    {
+                        if(first_pending == shaders.size()) first_pending = i;
+                        continue;
+                    }
+
+                    shaders[i].wait_for_contents();
+                    cached[i] = cache::load(shaders[i]);
+                    if(!cached[i])
+                    {
+                        shaders[i].compile_shader();
+                        shaders[i].link_shader();
+                    }
+                    linked[i] = progressed = true;
+                    remaining--;
+                }
+                // Nothing else is ready yet, blocks on the job of a shader that is still loading.
+                if(!progressed) shaders[first_pending].wait_for_contents();
+            }
+
+            if(!wait_for_link) return;
+            for(size_t i = 0; i < shaders.size(); i++)
+            {
+                shaders[i].wait_for_link();
+                if(!cached[i]) cache::store(shaders[i]);
+            }
+        }
+    }
+
+    /// @brief A namespace that makes it easier to compile shaders and check any problems that would have occurred during the compilation.
+    namespace compiler
+    {
+        /**
+         * @brief Lets the driver compile and link shaders on its own threads. (GL_KHR_parallel_shader_compile) After this
+         * glCompileShader and glLinkProgram return immediately. Should be called after glfw::init_glad.
+         * @param threads? The maximum number of threads the driver may use. The default lets the driver decide.
+         * @return Whether or not the extension is supported by the current context.
+        */
+        bool enable_parallel_compile(GLuint threads=0xFFFFFFFF)
+        {
+            if(glfwExtensionSupported("GL_KHR_parallel_shader_compile")) glMaxShaderCompilerThreadsKHR(threads);
+            else if(glfwExtensionSupported("GL_ARB_parallel_shader_compile")) glMaxShaderCompilerThreadsARB(threads);
+            else return false;
+
+            return shader_program::parallel_compile_enabled = true;
+        }
+
+        /// @brief Compiles the shader and links it to memory.
+        /// @param shader A reference to the shader.
+        void compile_shader(shader_program& shader) { shader.link_shader(); }
+
+        /// @brief Compiles all the shaders and links them into memory.
+        /// @param shaders A vector of shaders.
+        void compile_shaders(std::vector<shader_program>& shaders) 
+        {
+            for(shader_program& shader : shaders)
+            {
+                shader.link_shader();
+            }
+        }
+
+        /// @brief Prints the compilation status of the vertex and fragment shaders (or the compute shader). This should be called before the shader program has been linked as the compiled log exist only until that point.
+        /// @param shader A const reference to the shader program. (Nothing will be modified!)
+        void log_compilation_status(const shader_program& shader)
+        {
+            GLint param;
+
+            // ============================= COMPUTE SHADER =============================
+            if(shader.is_compute())
+            {
+                glGetShaderiv(shader.get_compute_shader_id(), GL_COMPILE_STATUS, &param);
+                if(param == GL_FALSE)
+                {
+                    printf("SHADER_COMPILATION_ERROR for compute shader%c",'\n'); // Avoid flushing
+
+                    glGetShaderiv(shader.get_compute_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                    char* infoLog = new char[param];
+                    glGetShaderInfoLog(shader.get_compute_shader_id(), param, NULL, infoLog);
+                    printf("INFO_LOG:%c%s\n",'\n',infoLog);
+                    delete[] infoLog;
+
+                }else printf("SHADER_STATUS for compute shader: GOOD\n");
+                return;
+            }
+
+            // ============================= VERTEX SHADER =============================
+            glGetShaderiv(shader.get_vertex_shader_id(), GL_COMPILE_STATUS, &param);
+            if(param == GL_FALSE)
+            {
+                printf("SHADER_COMPILATION_ERROR for vertex shader%c",'\n'); // Avoid flushing
+
+                glGetShaderiv(shader.get_vertex_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                char* infoLog = new char[param];
+                glGetShaderInfoLog(shader.get_vertex_shader_id(), param, NULL, infoLog);
+                printf("INFO_LOG:%c%s\n",'\n',infoLog);
+                delete[] infoLog;
+
+            }else printf("SHADER_STATUS for vertex shader: GOOD\n");
+
+            // ============================= FRAGMENT SHADER =============================
+
+            glGetShaderiv(shader.get_fragment_shader_id(), GL_COMPILE_STATUS, &param);
+            if(param == GL_FALSE)
+            {
+                printf("SHADER_COMPILATION_ERROR for fragment shader%c",'\n'); // Avoid flushing
+
+                glGetShaderiv(shader.get_fragment_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                char* infoLog = new char[param];
+                glGetShaderInfoLog(shader.get_fragment_shader_id(), param, NULL, infoLog);
+                printf("INFO_LOG:%c%s\n",'\n',infoLog);
+                delete[] infoLog;
+
+            }else printf("SHADER_STATUS for fragment shader: GOOD\n");
+        }
+
+        /// @brief Logs the compilation status of the vertex and fragment shaders (or the compute shader) to the specified file. This should be called before the shader program has been linked as the compiled log exist only until that point.
+        /// @param shader A const reference to the shader program. (Nothing will be modified!)
+        /// @param file_or_console The contents of the log will be written to the specified file or console[=stdout,stderr,etc].
+        void log_compilation_status(const shader_program& shader, std::ostream& file_or_console)
+        {
+            GLint param;
+
+            // ============================= COMPUTE SHADER =============================
+            if(shader.is_compute())
+            {
+                glGetShaderiv(shader.get_compute_shader_id(), GL_COMPILE_STATUS, &param);
+                if(param == GL_FALSE)
+                {
+                    file_or_console << "SHADER_COMPILATION_ERROR for compute shader\n"; // Avoid flushing
+
+                    glGetShaderiv(shader.get_compute_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                    char* infoLog = new char[param];
+                    glGetShaderInfoLog(shader.get_compute_shader_id(), param, NULL, infoLog);
+                    file_or_console << "INFO_LOG:\n" << infoLog << std::endl;
+                    delete[] infoLog;
+
+                }else file_or_console << "SHADER_STATUS for compute shader: GOOD" << std::endl;
+                return;
+            }
+
+            // ============================= VERTEX SHADER =============================
+            glGetShaderiv(shader.get_vertex_shader_id(), GL_COMPILE_STATUS, &param);
+            if(param == GL_FALSE)
+            {
+                file_or_console << "SHADER_COMPILATION_ERROR for vertex shader\n"; // Avoid flushing
+
+                glGetShaderiv(shader.get_vertex_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                char* infoLog = new char[param];
+                glGetShaderInfoLog(shader.get_vertex_shader_id(), param, NULL, infoLog);
+                file_or_console << "INFO_LOG:\n" << infoLog << "\n";
+                delete[] infoLog;
+
+            }else file_or_console << "SHADER_STATUS for vertex shader: GOOD\n";
+
+            // ============================= FRAGMENT SHADER =============================
+
+            glGetShaderiv(shader.get_fragment_shader_id(), GL_COMPILE_STATUS, &param);
+            if(param == GL_FALSE)
+            {
+                file_or_console << "SHADER_COMPILATION_ERROR for fragment shader\n"; // Avoid flushing
+
+                glGetShaderiv(shader.get_fragment_shader_id(), GL_INFO_LOG_LENGTH, &param);
+
+                char* infoLog = new char[param];
+                glGetShaderInfoLog(shader.get_fragment_shader_id(), param, NULL, infoLog);
+                file_or_console << "INFO_LOG:\n" << infoLog << std::endl;
+                delete[] infoLog;
+
+            }else file_or_console << "SHADER_STATUS for fragment shader: GOOD" << std::endl;
+        }
+    };
+
+    }; // namespace shader
+
+    _GLFW_END_
+
+    #undef PRIVATE
+
 #endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+/**
+ * This header contains the state cache. It shadows the parts of the OpenGL state that are changed the most (the
+ * program in use, the bound vertex array, the buffers bound to every target and the textures bound to every unit)
+ * and skips the calls that wouldn't change anything. Every bind of the wrappers (buffer_object::bind,
+ * vertex_array_object::bind, texture_object::bind, shader_program::use_shader, etc.) goes through it.
+ *
+ * The cache belongs to the context that is current on the calling thread. (see: current) It can't see the calls that
+ * are made without going through it, call invalidate after making any (ex; after a third party library has drawn
+ * something) so that the next bind of everything is issued again. gl_window::make_context_current does that by itself.
+ *
+ * Programs, buffers and textures can be shared between contexts, hence one that is deleted on one thread may still be
+ * shadowed by the caches of the other threads, and its name handed out again. Every deletion of them bumps a counter
+ * that all the caches share; a cache that sees it changed on its next bind forgets everything first. (see: forget_buffer)
+ *
+ * The number of calls that were issued and elided is counted per frame. (see: end_frame, last_frame) With the
+ * profiler they are also recorded as the counters "gl::issued" and "gl::elided".
+*/
+
+#include "./glfw.hpp"
+#include "./profiler.hpp"
+
+#ifndef _GLFW_STATE_CACHE_DEFINITION_HPP_
+    #define _GLFW_STATE_CACHE_DEFINITION_HPP_
+
+    #include <cstdint>
+    #include <cstddef>
+    #include <atomic>
+
+    _GLFW_START_
+
+    namespace state
+    {
+        /** @brief The kinds of calls that are counted. */
+        enum class call_type : uint8_t
+        {
+            /** @brief glUseProgram */
+            PROGRAM         = 0,
+            /** @brief glBindVertexArray */
+            VERTEX_ARRAY    = 1,
+            /** @brief glBindBuffer */
+            BUFFER          = 2,
+            /** @brief glBindBufferBase, glBindBufferRange */
+            INDEXED_BUFFER  = 3,
+            /** @brief glActiveTexture */
+            ACTIVE_TEXTURE  = 4,
+            /** @brief glBindTexture */
+            TEXTURE         = 5,
+            COUNT           = 6
+        };
+
+        /** @brief The number of calls of a frame. */
+        struct call_counters
+        {
+            uint64_t issued[static_cast<size_t>(call_type::COUNT)] = {};
+            uint64_t elided[static_cast<size_t>(call_type::COUNT)] = {};
+
+            uint64_t total_issued() const noexcept(true)
+            {
+                uint64_t total = 0;
+                for(uint64_t count : issued) total += count;
+                return total;
+            }
+            uint64_t total_elided() const noexcept(true)
+            {
+                uint64_t total = 0;
+                for(uint64_t count : elided) total += count;
+                return total;
+            }
+        };
+
+        namespace __shared
+        {
+            /** @brief The number of shared objects that were deleted, by any thread. (see: state_cache::forget_buffer) */
+            inline std::atomic<uint64_t> deletions { 0 };
+        };
+
+        /** @brief Shadows the bindings of a single context. (see: the top of this file) */
+        class state_cache
+        {
+        public:
+            /** @brief The number of texture units that are shadowed. Binds to the units past these are always issued. */
+            static constexpr size_t max_texture_units = 32;
+            /** @brief The number of binding points per indexed target that are shadowed. */
+            static constexpr size_t max_indexed_bindings = 16;
+
+        private:
+            /** @brief A binding that has to be issued the next time, whatever it is. */
+            static constexpr GLuint unknown = 0xFFFFFFFF;
+
+            static constexpr size_t buffer_target_count = 10;
+            static constexpr size_t texture_target_count = 5;
+            static constexpr size_t indexed_target_count = 2;
+
+            struct indexed_binding
+            {
+                GLuint buffer;
+                GLintptr offset;
+                GLsizeiptr size;
+            };
+
+            GLuint _program;
+            GLuint _vertex_array;
+            GLuint _buffers[buffer_target_count];
+            GLuint _active_unit;
+            GLuint _textures[max_texture_units][texture_target_count];
+            indexed_binding _indexed[indexed_target_count][max_indexed_bindings];
+
+            call_counters _frame;
+            call_counters _last_frame;
+            /** @brief The deletions of shared objects that the bindings are up to date with. */
+            uint64_t _deletions;
+
+            static int __buffer_target_index(GLenum target) noexcept(true)
+            {
+                switch(target)
+                {
+                case GL_ARRAY_BUFFER:               return 0;
+                case GL_ELEMENT_ARRAY_BUFFER:       return 1;
+                case GL_UNIFORM_BUFFER:             return 2;
+                case GL_SHADER_STORAGE_BUFFER:      return 3;
+                case GL_DRAW_INDIRECT_BUFFER:       return 4;
+                case GL_DISPATCH_INDIRECT_BUFFER:   return 5;
+                case GL_PIXEL_UNPACK_BUFFER:        return 6;
+                case GL_PIXEL_PACK_BUFFER:          return 7;
+                case GL_COPY_READ_BUFFER:           return 8;
+                case GL_COPY_WRITE_BUFFER:          return 9;
+                default:                            return -1;
+                }
+            }
+            static int __texture_target_index(GLenum target) noexcept(true)
+            {
+                switch(target)
+                {
+                case GL_TEXTURE_2D:         return 0;
+                case GL_TEXTURE_2D_ARRAY:   return 1;
+                case GL_TEXTURE_CUBE_MAP:   return 2;
+                case GL_TEXTURE_3D:         return 3;
+                case GL_TEXTURE_BUFFER:     return 4;
+                default:                    return -1;
+                }
+            }
+            static int __indexed_target_index(GLenum target) noexcept(true)
+            {
+                switch(target)
+                {
+                case GL_UNIFORM_BUFFER:         return 0;
+                case GL_SHADER_STORAGE_BUFFER:  return 1;
+                default:                        return -1;
+                }
+            }
+
+            /** @brief Forgets everything if a shared object was deleted by another thread since the last bind. */
+            void sync() noexcept(true)
+            {
+                uint64_t deletions = __shared::deletions.load(std::memory_order_acquire);
+                if(deletions == _deletions) return;
+                invalidate();
+                _deletions = deletions;
+            }
+
+            /** @brief Counts a deletion of a shared object, which was already forgotten by this cache. */
+            void deleted_shared() noexcept(true)
+            {
+                uint64_t previous = __shared::deletions.fetch_add(1, std::memory_order_release);
+                // Unless another thread deleted something in between, this cache is up to date.
+                if(previous == _deletions) _deletions = previous + 1;
+            }
+
+            /** @brief Counts the call and returns whether or not it has to be issued. */
+            bool count(call_type type, bool changed) noexcept(true)
+            {
+                (changed ? _frame.issued : _frame.elided)[static_cast<size_t>(type)]++;
+                return changed;
+            }
+
+        public:
+            state_cache() : _deletions(__shared::deletions.load(std::memory_order_acquire)) { invalidate(); }
+
+            /** @brief Forgets everything, so that the next bind of everything is issued. */
+            void invalidate() noexcept(true)
+            {
+                _program = unknown;
+                _vertex_array = unknown;
+                _active_unit = unknown;
+                for(GLuint& buffer : _buffers) buffer = unknown;
+                for(auto& unit : _textures) for(GLuint& texture : unit) texture = unknown;
+                for(auto& target : _indexed) for(indexed_binding& binding : target) binding = indexed_binding { unknown, 0, 0 };
+            }
+
+            /** @brief glUseProgram */
+            void use_program(GLuint program)
+            {
+                sync();
+                if(!count(call_type::PROGRAM, _program != program)) return;
+                glUseProgram(program);
+                _program = program;
+            }
+
+            /**
+             * @brief glBindVertexArray. The element array buffer is part of the state of the vertex array, hence it is
+             * forgotten whenever the vertex array changes.
+            */
+            void bind_vertex_array(GLuint vertex_array)
+            {
+                sync();
+                if(!count(call_type::VERTEX_ARRAY, _vertex_array != vertex_array)) return;
+                glBindVertexArray(vertex_array);
+                _vertex_array = vertex_array;
+                _buffers[__buffer_target_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+            }
+
+            /** @brief glBindBuffer. The binds to the targets that aren't shadowed are always issued. */
+            void bind_buffer(GLenum target, GLuint buffer)
+            {
+                sync();
+                int index = __buffer_target_index(target);
+                if(!count(call_type::BUFFER, index < 0 || _buffers[index] != buffer)) return;
+                glBindBuffer(target, buffer);
+                if(index >= 0) _buffers[index] = buffer;
+            }
+
+            /** @brief glBindBufferBase. Like GL, it also binds the buffer to the generic binding point of the target. */
+            void bind_buffer_base(GLenum target, GLuint binding, GLuint buffer)
+            {
+                bind_buffer_range(target, binding, buffer, 0, -1);
+            }
+
+            /** @brief glBindBufferRange. A size of -1 means the whole buffer. (i.e. glBindBufferBase) */
+            void bind_buffer_range(GLenum target, GLuint binding, GLuint buffer, GLintptr offset, GLsizeiptr size)
+            {
+                sync();
+                int index = __indexed_target_index(target);
+                indexed_binding* cached = index >= 0 && binding < max_indexed_bindings ? &_indexed[index][binding] : nullptr;
+                bool changed = !cached || cached->buffer != buffer || cached->offset != offset || cached->size != size;
+                if(!count(call_type::INDEXED_BUFFER, changed)) return;
+
+                if(size < 0) glBindBufferBase(target, binding, buffer);
+                else glBindBufferRange(target, binding, buffer, offset, size);
+
+                if(cached) *cached = indexed_binding { buffer, offset, size };
+                int generic = __buffer_target_index(target);
+                if(generic >= 0) _buffers[generic] = buffer;
+            }
+
+            /** @brief glActiveTexture. @param unit The unit. ex; GL_TEXTURE0 */
+            void active_texture(GLenum unit)
+            {
+                GLuint index = unit - GL_TEXTURE0;
+                if(!count(call_type::ACTIVE_TEXTURE, _active_unit != index)) return;
+                glActiveTexture(unit);
+                _active_unit = index;
+            }
+
+            /** @brief glBindTexture, on the active unit. */
+            void bind_texture(GLenum target, GLuint texture)
+            {
+                sync();
+                int index = __texture_target_index(target);
+                bool shadowed = index >= 0 && _active_unit < max_texture_units;
+                if(!count(call_type::TEXTURE, !shadowed || _textures[_active_unit][index] != texture)) return;
+                glBindTexture(target, texture);
+                if(shadowed) _textures[_active_unit][index] = texture;
+            }
+
+            /** @brief Makes the unit active and binds the texture to it. */
+            void bind_texture_unit(GLenum unit, GLenum target, GLuint texture)
+            {
+                sync();
+                GLuint index = unit - GL_TEXTURE0;
+                int target_index = __texture_target_index(target);
+                // Nothing has to change if the texture is already bound to the unit, not even the active unit.
+                if(index < max_texture_units && target_index >= 0 && _textures[index][target_index] == texture)
+                {
+                    count(call_type::TEXTURE, false);
+                    return;
+                }
+                active_texture(unit);
+                bind_texture(target, texture);
+            }
+
+            // ============================= DELETED OBJECTS =============================
+            // GL unbinds the objects that are deleted, and their names can be handed out again afterwards.
+
+            /** @brief Should be called when a program is deleted. A deleted program stays in use, hence its name is forgotten. */
+            void forget_program(GLuint program) noexcept(true)
+            {
+                if(_program == program) _program = unknown;
+                deleted_shared();
+            }
+
+            /** @brief Should be called when a vertex array is deleted. */
+            void forget_vertex_array(GLuint vertex_array) noexcept(true)
+            {
+                if(_vertex_array != vertex_array) return;
+                _vertex_array = 0;
+                _buffers[__buffer_target_index(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+            }
+
+            /**
+             * @brief Should be called when a buffer is deleted. The caches of the other threads forget everything on
+             * their next bind, they may have the buffer bound. The same goes for forget_program and forget_texture.
+            */
+            void forget_buffer(GLuint buffer) noexcept(true)
+            {
+                for(GLuint& cached : _buffers) if(cached == buffer) cached = 0;
+                for(auto& target : _indexed) for(indexed_binding& binding : target) if(binding.buffer == buffer) binding.buffer = unknown;
+                deleted_shared();
+            }
+
+            /** @brief Should be called when a texture is deleted. */
+            void forget_texture(GLuint texture) noexcept(true)
+            {
+                for(auto& unit : _textures) for(GLuint& cached : unit) if(cached == texture) cached = 0;
+                deleted_shared();
+            }
+
+            // ============================= COUNTERS =============================
+
+            /** @brief Ends the frame of the counters. Should be called once per frame, after swapping the buffers. */
+            void end_frame()
+            {
+                GLFW_PROFILE_COUNTER("gl::issued", static_cast<double>(_frame.total_issued()));
+                GLFW_PROFILE_COUNTER("gl::elided", static_cast<double>(_frame.total_elided()));
+                _last_frame = _frame;
+                _frame = call_counters();
+            }
+
+            /** @brief Returns the counters of the frame that is being recorded. */
+            const call_counters& this_frame() const noexcept(true) { return _frame; }
+            /** @brief Returns the counters of the last frame that ended. */
+            const call_counters& last_frame() const noexcept(true) { return _last_frame; }
+
+            GLuint get_program() const noexcept(true) { return _program; }
+            GLuint get_vertex_array() const noexcept(true) { return _vertex_array; }
+        };
+
+        /**
+         * @brief Returns the cache of the context that is current on the calling thread. A thread only ever has one
+         * current context, switching it must invalidate the cache. (see: gl_window::make_context_current)
+        */
+        state_cache& current()
+        {
+            static thread_local state_cache cache;
+            return cache;
+        }
+    }; // namespace state
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
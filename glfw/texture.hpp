@@ -1,173 +1,254 @@
-#ifndef _GLFW_TEXTURE_DEFINITION_HPP_
-    #define _GLFW_TEXTURE_DEFINITION_HPP_
-
-    #include "./glfw.hpp"
-    #include "../stb/stb.h"
-
-    #include <memory>
-    
-    _GLFW_START_
-
-    #ifdef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
-        /** @brief Shorthand name for Texture Buffer Objects. */
-        using __tbo = buffer_object;
-    #endif
-
-    using byte_t    = char;
-    using ubyte_t   = unsigned char;
-    
-    template <typename T> using ptr_t       = T*;
-    template <typename T> using constptr_t  = const T*;
-    
-    namespace texture
-    {
-        /**
-         * @brief Contains information required by opengl for creating textures. All data is required 
-         * unless marked [optional].
-        */
-        struct image_data
-        {
-            /** @brief The path to the image file. [optional] */
-            const char* path;
-
-            /** @brief The width of the image. */
-            int width;
-            /** @brief The height of the image. */
-            int height;
-            /** @brief The number of color channels that the image has. i.e. RGB, RGBA, etc. */
-            int color_channels;
-
-            /** @brief The data retrieved after loading the image. */
-            ptr_t<ubyte_t> data;
-        };
-
-        class texture_object
-        {
-        public:
-            GLuint texture_id;
-
-            void find_free_id() { glGenTextures(1, &texture_id); }
-
-            void bind() { glBindTexture(GL_TEXTURE_2D, texture_id); }
-            static void unbind() { glBindTexture(GL_TEXTURE_2D, 0); }
-
-            static void set_mapping_for_x_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, value); }
-            static void set_mapping_for_y_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, value); } 
-
-            static void set_min_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, value); }
-            static void set_mag_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, value); }
-
-            static void set_active_texture_slot(GLenum slot) { glActiveTexture(slot); }
-
-            void create(const image_data& data, GLuint format)
-            {
-                glTexImage2D(GL_TEXTURE_2D, 0, format, data.width, data.height, 0, format, GL_UNSIGNED_BYTE, data.data);
-            }
-
-            static void generate_mipmaps() { glGenerateMipmap(GL_TEXTURE_2D); }
-
-            ~texture_object() noexcept { glDeleteTextures(1, &texture_id); }
-        };
-        void reset_texture_slot(GLenum slot)
-        {
-            glActiveTexture(slot);
-            glBindTexture(GL_TEXTURE_2D, 0);
-        }
-
-        #ifdef _USE_STB_IMAGE_LOADER_
-            namespace loader
-            {
-                /** @brief Helps in loading images. It supports most image formats. */
-                class image_loader
-                {
-                private:
-                    image_data _data;
-
-                public:
-                    image_loader() = default;
-                    image_loader(const char* path) { _data.path = path; }
-
-                    /**
-                     * @brief Sets the path to the image to load.
-                     * @param path The path to set.
-                    */
-                    void set_path(const char* path) { _data.path = path; }
-
-                    /** @brief Loads the data from the specified image. */
-                    void load_file() 
-                    { 
-                        _data.data = stbi_load(_data.path, &_data.width, &_data.height, &_data.color_channels, 0); 
-                        if(!_data.data) fprintf(stderr, "Error loading image at \"%s\"\n", _data.path);
-                    }
-
-                    /** @brief Returns the data retrieved from the specified image. */
-                    ptr_t<ubyte_t> get_data() const { return _data.data; }
-
-                    /** @brief Returns the path to the specified image. */
-                    const char* get_path() const { return _data.path; }
-
-                    /** @brief Returns the width of the image. */
-                    int get_width() const { return _data.width; }
-                    /** @brief Return the height of the image. */
-                    int get_height() const { return _data.height; }
-                    /** @brief Returns the number of color channels in the image.*/
-                    int get_channels() const { return _data.color_channels; }
-
-                    /** @brief Returns the image data. It will only return the proper data after the image has been loaded. */
-                    const image_data& get_image_data() const { return _data; }
-
-                    /**
-                     * @brief The destructor, it will be called when any instance of this class goes out of scope. Or
-                     * it can be called manually to destroy or free the resources hogged by this class for storing
-                     * the data of the image.
-                    */
-                    ~image_loader() noexcept { stbi_image_free(_data.data); }
-                };
-
-                /**
-                 * @brief Gets an image loader for the specified image.
-                 * @param path The path to the image. 
-                 * @returns The pointer to the loader which has been heap allocated.
-                */
-                std::unique_ptr<image_loader> get_image_loader(const char* path)
-                {
-                    return std::unique_ptr<image_loader>(new image_loader(path));
-                }
-
-                /**
-                 * @brief Loads the image data using the specified image loader.
-                 * @param loader A reference to the image loader to use for loading the image data. 
-                */
-                void load_image(image_loader& loader)
-                {
-                    loader.load_file();
-                }
-
-                /**
-                 * @brief Gets the image data from the specified image loader. It is assumed that the loader has 
-                 * already loaded the image.
-                 * @param loader A const reference to the image loader. (Nothing will be modified)
-                 * @returns The pointer to the image data which has been heap allocated.
-                */
-                std::unique_ptr<image_data> get_image_data_from_loader(const image_loader& loader)
-                {
-                    return std::unique_ptr<image_data>(
-                        new image_data {
-                            loader.get_path(),
-                            loader.get_width(),
-                            loader.get_height(),
-                            loader.get_channels(),
-                            loader.get_data()
-                        }
-                    );
-                }
-            }
-        #endif
-        
-    } // namespace texture
-
-    
-
-    _GLFW_END_
-
+#ifndef _GLFW_TEXTURE_DEFINITION_HPP_
+    #define _GLFW_TEXTURE_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+    #include "./profiler.hpp"
+    #include "./state_cache.hpp"
+    #include "./error.hpp"
+    #include "../stb/stb.h"
+
+    #include <memory>
+    #include <algorithm>
+    
+    _GLFW_START_
+
+    #ifdef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
+        /** @brief Shorthand name for Texture Buffer Objects. */
+        using __tbo = buffer_object;
+    #endif
+
+    using byte_t    = char;
+    using ubyte_t   = unsigned char;
+    
+    template <typename T> using ptr_t       = T*;
+    template <typename T> using constptr_t  = const T*;
+    
+    namespace texture
+    {
+        /**
+         * @brief Contains information required by opengl for creating textures. All data is required 
+         * unless marked [optional].
+        */
+        struct image_data
+        {
+            /** @brief The path to the image file. [optional] */
+            const char* path;
+
+            /** @brief The width of the image. */
+            int width;
+            /** @brief The height of the image. */
+            int height;
+            /** @brief The number of color channels that the image has. i.e. RGB, RGBA, etc. */
+            int color_channels;
+
+            /** @brief The data retrieved after loading the image. */
+            ptr_t<ubyte_t> data;
+        };
+
+        class texture_object
+        {
+        public:
+            GLuint texture_id;
+
+            void find_free_id() { glGenTextures(1, &texture_id); }
+
+            void bind() { state::current().bind_texture(GL_TEXTURE_2D, texture_id); }
+            static void unbind() { state::current().bind_texture(GL_TEXTURE_2D, 0); }
+
+            static void set_mapping_for_x_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, value); }
+            static void set_mapping_for_y_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, value); } 
+
+            static void set_min_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, value); }
+            static void set_mag_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, value); }
+
+            static void set_active_texture_slot(GLenum slot) { state::current().active_texture(slot); }
+
+            void create(const image_data& data, GLuint format)
+            {
+                GLFW_PROFILE_GPU_SCOPE("texture_object::create");
+                GLFW_CHECK_GL(glTexImage2D(GL_TEXTURE_2D, 0, format, data.width, data.height, 0, format, GL_UNSIGNED_BYTE, data.data));
+            }
+
+            /**
+             * @brief Allocates immutable storage for the texture. Its size and format can't be changed afterwards, the data
+             * is uploaded with update. Requires OpenGL 4.2.
+             * @param levels The number of mipmap levels. (see: mipmap_levels)
+             * @param internal_format The format the texture is stored in. Must be a sized format. ex; GL_RGBA8
+             * @param width The width of the texture.
+             * @param height The height of the texture.
+            */
+            void create_storage(GLsizei levels, GLenum internal_format, int width, int height)
+            {
+                GLFW_PROFILE_GPU_SCOPE("texture_object::create_storage");
+                GLFW_CHECK_GL(glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height));
+            }
+
+            /**
+             * @brief Uploads data into a part of the texture. If a buffer is bound to GL_PIXEL_UNPACK_BUFFER, then 
+             * @c pixels is the offset into that buffer instead.
+             * @param level The mipmap level.
+             * @param x The x-coordinate of the part.
+             * @param y The y-coordinate of the part.
+             * @param w The width of the part.
+             * @param h The height of the part.
+             * @param format The format of the data. ex; GL_RGBA
+             * @param pixels The data.
+            */
+            static void update(GLint level, int x, int y, int w, int h, GLenum format, const void* pixels)
+            {
+                GLFW_CHECK_GL(glTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, format, GL_UNSIGNED_BYTE, pixels));
+            }
+
+            /**
+             * @brief Creates a level of the texture from block compressed data. (see: texture_compressed.hpp) The data is
+             * uploaded as it is, it is neither decoded nor converted.
+             * @param level The mipmap level.
+             * @param internal_format The compressed format of the data. ex; GL_COMPRESSED_RGBA_BPTC_UNORM
+             * @param width The width of the level.
+             * @param height The height of the level.
+             * @param size The size(in bytes) of the data.
+             * @param data The data.
+            */
+            void create_compressed(GLint level, GLenum internal_format, int width, int height, size_t size, const void* data)
+            {
+                GLFW_CHECK_GL(glCompressedTexImage2D(GL_TEXTURE_2D, level, internal_format, width, height, 0, static_cast<GLsizei>(size), data));
+            }
+
+            /**
+             * @brief Uploads block compressed data into a part of the texture. The part must be aligned to the blocks of
+             * the format. If a buffer is bound to GL_PIXEL_UNPACK_BUFFER, then @c data is the offset into that buffer instead.
+             * @param level The mipmap level.
+             * @param x The x-coordinate of the part.
+             * @param y The y-coordinate of the part.
+             * @param w The width of the part.
+             * @param h The height of the part.
+             * @param internal_format The compressed format of the texture.
+             * @param size The size(in bytes) of the data.
+             * @param data The data.
+            */
+            static void update_compressed(GLint level, int x, int y, int w, int h, GLenum internal_format, size_t size, const void* data)
+            {
+                GLFW_CHECK_GL(glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, w, h, internal_format, static_cast<GLsizei>(size), data));
+            }
+
+            /** @brief Sets the last mipmap level that will be sampled from. For a chain that doesn't go down to 1x1. */
+            static void set_max_level(GLint level) { glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level); }
+
+            /** @brief Returns the number of mipmap levels of a full mipmap chain for a texture of the specified size. */
+            static GLsizei mipmap_levels(int width, int height)
+            {
+                GLsizei levels = 1;
+                for(int size = std::max(width, height); size > 1; size >>= 1) levels++;
+                return levels;
+            }
+
+            static void generate_mipmaps() { glGenerateMipmap(GL_TEXTURE_2D); }
+
+            ~texture_object() noexcept 
+            { 
+                glDeleteTextures(1, &texture_id); 
+                state::current().forget_texture(texture_id);
+            }
+        };
+        void reset_texture_slot(GLenum slot)
+        {
+            state::current().bind_texture_unit(slot, GL_TEXTURE_2D, 0);
+        }
+
+        #ifdef _USE_STB_IMAGE_LOADER_
+            namespace loader
+            {
+                /** @brief Helps in loading images. It supports most image formats. */
+                class image_loader
+                {
+                private:
+                    image_data _data;
+
+                public:
+                    image_loader() = default;
+                    image_loader(const char* path) { _data.path = path; }
+
+                    /**
+                     * @brief Sets the path to the image to load.
+                     * @param path The path to set.
+                    */
+                    void set_path(const char* path) { _data.path = path; }
+
+                    /** @brief Loads the data from the specified image. */
+                    void load_file() 
+                    { 
+                        _data.data = stbi_load(_data.path, &_data.width, &_data.height, &_data.color_channels, 0); 
+                        if(!_data.data) fprintf(stderr, "Error loading image at \"%s\"\n", _data.path);
+                    }
+
+                    /** @brief Returns the data retrieved from the specified image. */
+                    ptr_t<ubyte_t> get_data() const { return _data.data; }
+
+                    /** @brief Returns the path to the specified image. */
+                    const char* get_path() const { return _data.path; }
+
+                    /** @brief Returns the width of the image. */
+                    int get_width() const { return _data.width; }
+                    /** @brief Return the height of the image. */
+                    int get_height() const { return _data.height; }
+                    /** @brief Returns the number of color channels in the image.*/
+                    int get_channels() const { return _data.color_channels; }
+
+                    /** @brief Returns the image data. It will only return the proper data after the image has been loaded. */
+                    const image_data& get_image_data() const { return _data; }
+
+                    /**
+                     * @brief The destructor, it will be called when any instance of this class goes out of scope. Or
+                     * it can be called manually to destroy or free the resources hogged by this class for storing
+                     * the data of the image.
+                    */
+                    ~image_loader() noexcept { stbi_image_free(_data.data); }
+                };
+
+                /**
+                 * @brief Gets an image loader for the specified image.
+                 * @param path The path to the image. 
+                 * @returns The pointer to the loader which has been heap allocated.
+                */
+                std::unique_ptr<image_loader> get_image_loader(const char* path)
+                {
+                    return std::unique_ptr<image_loader>(new image_loader(path));
+                }
+
+                /**
+                 * @brief Loads the image data using the specified image loader.
+                 * @param loader A reference to the image loader to use for loading the image data. 
+                */
+                void load_image(image_loader& loader)
+                {
+                    loader.load_file();
+                }
+
+                /**
+                 * @brief Gets the image data from the specified image loader. It is assumed that the loader has 
+                 * already loaded the image.
+                 * @param loader A const reference to the image loader. (Nothing will be modified)
+                 * @returns The pointer to the image data which has been heap allocated.
+                */
+                std::unique_ptr<image_data> get_image_data_from_loader(const image_loader& loader)
+                {
+                    return std::unique_ptr<image_data>(
+                        new image_data {
+                            loader.get_path(),
+                            loader.get_width(),
+                            loader.get_height(),
+                            loader.get_channels(),
+                            loader.get_data()
+                        }
+                    );
+                }
+            }
+        #endif
+        
+    } // namespace texture
+
+    
+
+    _GLFW_END_
+
 #endif
\ No newline at end of file
@@ -0,0 +1,406 @@
+/**
+ * This header contains the texture arrays and the texture atlas. Every texture_object is a separate GL_TEXTURE_2D,
+ * hence two bodies with different textures can never be drawn by the same (multi-)draw call. (see: render_queue.hpp)
+ * Instead, the images are packed into the layers of a single GL_TEXTURE_2D_ARRAY and every instance carries where
+ * its image is; the layer and the part of the layer. (see: atlas_entry)
+ *
+ * The atlas packs the images into shelves (rows of images that are as high as their highest image) from the top of a
+ * layer to its bottom, and then moves on to the next layer. Every image is surrounded by a gutter of its own edge
+ * texels, so that the coarser mipmap levels don't bleed the neighbouring images into it. The wrap mode of the array
+ * can't repeat a single image, a shader that needs to should wrap the coordinates itself. ex;
+ *  vec3 uv = vec3(entry.offset + fract(in_uv) * entry.scale, entry.layer);
+ *
+ * Compressed images (see: texture_compressed.hpp) can't be packed next to each other (the GPU can't generate their
+ * mipmaps), each of them takes a whole layer and must have the size and the format of the layers.
+ *
+ * Where ARB_bindless_texture is supported, bindless_texture_table is the alternative; textures of any size and format
+ * are made resident and their handles are written into a storage buffer, the shader indexes it per instance. ex;
+ *  #extension GL_ARB_bindless_texture : require
+ *  layout(std430, binding = 0) readonly buffer textures { sampler2D handles[]; };
+ *  ... texture(handles[in_texture_index], in_uv) ...
+*/
+
+#include "./glfw.hpp"
+#include "./profiler.hpp"
+#include "./state_cache.hpp"
+#include "./error.hpp"
+#include "./texture.hpp"
+#include "./texture_compressed.hpp"
+#include "./vbo.hpp"
+
+#ifndef _GLFW_TEXTURE_ARRAY_DEFINITION_HPP_
+    #define _GLFW_TEXTURE_ARRAY_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cstdint>
+    #include <cstddef>
+    #include <cstring>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace texture
+    {
+        /** @brief A GL_TEXTURE_2D_ARRAY, every layer has the same size and format. */
+        class texture_array_object
+        {
+        public:
+            GLuint texture_id = 0;
+
+            void find_free_id() { glGenTextures(1, &texture_id); }
+
+            void bind() { state::current().bind_texture(GL_TEXTURE_2D_ARRAY, texture_id); }
+            static void unbind() { state::current().bind_texture(GL_TEXTURE_2D_ARRAY, 0); }
+
+            static void set_mapping_for_x_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, value); }
+            static void set_mapping_for_y_axis(GLint value) { glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, value); }
+
+            static void set_min_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, value); }
+            static void set_mag_filter(GLint value) { glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, value); }
+
+            /**
+             * @brief Allocates immutable storage for every layer. Requires OpenGL 4.2.
+             * @param levels The number of mipmap levels. (see: texture_object::mipmap_levels)
+             * @param internal_format The format of every layer. Must be a sized (or a compressed) format. ex; GL_RGBA8
+             * @param width The width of every layer.
+             * @param height The height of every layer.
+             * @param layers The number of layers.
+            */
+            void create_storage(GLsizei levels, GLenum internal_format, int width, int height, int layers)
+            {
+                GLFW_PROFILE_GPU_SCOPE("texture_array_object::create_storage");
+                GLFW_CHECK_GL(glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internal_format, width, height, layers));
+            }
+
+            /**
+             * @brief Uploads data into a part of a layer.
+             * @param level The mipmap level.
+             * @param x The x-coordinate of the part.
+             * @param y The y-coordinate of the part.
+             * @param layer The layer.
+             * @param w The width of the part.
+             * @param h The height of the part.
+             * @param format The format of the data. ex; GL_RGBA
+             * @param pixels The data.
+            */
+            static void update(GLint level, int x, int y, int layer, int w, int h, GLenum format, const void* pixels)
+            {
+                GLFW_CHECK_GL(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, w, h, 1, format, GL_UNSIGNED_BYTE, pixels));
+            }
+
+            /** @brief Uploads block compressed data into a part of a layer. (see: texture_object::update_compressed) */
+            static void update_compressed(GLint level, int x, int y, int layer, int w, int h, GLenum internal_format, size_t size, const void* data)
+            {
+                GLFW_CHECK_GL(glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, x, y, layer, w, h, 1, internal_format, static_cast<GLsizei>(size), data));
+            }
+
+            static void generate_mipmaps() { glGenerateMipmap(GL_TEXTURE_2D_ARRAY); }
+
+            ~texture_array_object() noexcept
+            {
+                if(!texture_id) return;
+                glDeleteTextures(1, &texture_id);
+                state::current().forget_texture(texture_id);
+            }
+        };
+
+        /**
+         * @brief Where an image is in a texture atlas. It is meant to be copied into the per-instance data; the layer
+         * as an integer attribute (see: vertex_array_object::create_integer_attribute) and the offset and the scale
+         * as a vec4.
+        */
+        struct atlas_entry
+        {
+            /** @brief The offset of the image in its layer, in texture coordinates. [0,1] */
+            float offset[2];
+            /** @brief The size of the image in its layer, in texture coordinates. [0,1] */
+            float scale[2];
+            /** @brief The layer of the array. */
+            uint32_t layer;
+        };
+
+        /** @brief Packs images into the layers of a texture array. (see: the top of this file) */
+        class texture_atlas
+        {
+        private:
+            texture_array_object _array;
+            GLenum _internal_format = GL_RGBA8;
+            int _width = 0;
+            int _height = 0;
+            int _layers = 0;
+            GLsizei _levels = 1;
+            int _gutter = 4;
+
+            /** @brief The shelf that is being filled. Every layer before _layer is full. */
+            int _layer = 0;
+            int _shelf_y = 0;
+            int _shelf_height = 0;
+            int _cursor_x = 0;
+
+            bool _mipmaps_dirty = false;
+            std::vector<ubyte_t> _scratch;
+
+            /**
+             * @brief Finds a place for a rectangle of the size (including its gutter).
+             * @returns false if it doesn't fit into what is left of the layers.
+            */
+            bool allocate(int w, int h, int& x, int& y, int& layer)
+            {
+                if(w > _width || h > _height) return false;
+
+                while(_layer < _layers)
+                {
+                    // The next shelf, when the image doesn't fit to the right of the current one.
+                    if(_cursor_x + w > _width)
+                    {
+                        _shelf_y += _shelf_height;
+                        _shelf_height = 0;
+                        _cursor_x = 0;
+                    }
+                    if(_shelf_y + h <= _height)
+                    {
+                        x = _cursor_x;
+                        y = _shelf_y;
+                        layer = _layer;
+                        _cursor_x += w;
+                        _shelf_height = std::max(_shelf_height, h);
+                        return true;
+                    }
+
+                    _layer++;
+                    _shelf_y = _shelf_height = _cursor_x = 0;
+                }
+                return false;
+            }
+
+            static GLenum format_for(int channels) noexcept(true)
+            {
+                switch(channels)
+                {
+                case 1:  return GL_RED;
+                case 2:  return GL_RG;
+                case 3:  return GL_RGB;
+                default: return GL_RGBA;
+                }
+            }
+
+        public:
+            texture_atlas() = default;
+            texture_atlas(const texture_atlas&) = delete;
+            texture_atlas& operator=(const texture_atlas&) = delete;
+
+            /**
+             * @brief Creates the texture array. The context must be current. The array is bound afterwards.
+             * @param width The width of every layer.
+             * @param height The height of every layer.
+             * @param layers The number of layers. They are allocated up front, the storage is immutable.
+             * @param internal_format? The format of every layer. A compressed format only allows add_compressed.
+             * @param mipmaps? Whether or not to allocate (and generate, see: finish) a full mipmap chain.
+             * @param gutter? The number of texels around every image. More texels keep more of the mipmap levels clean.
+            */
+            void create(int width, int height, int layers, GLenum internal_format=GL_RGBA8, bool mipmaps=true, int gutter=4)
+            {
+                _width = width;
+                _height = height;
+                _layers = layers;
+                _internal_format = internal_format;
+                _levels = mipmaps ? texture_object::mipmap_levels(width, height) : 1;
+                _gutter = std::max(gutter, 0);
+                _layer = _shelf_y = _shelf_height = _cursor_x = 0;
+                _mipmaps_dirty = false;
+
+                if(!_array.texture_id) _array.find_free_id();
+                _array.bind();
+                _array.create_storage(_levels, internal_format, width, height, layers);
+                texture_array_object::set_min_filter(mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                texture_array_object::set_mag_filter(GL_LINEAR);
+                texture_array_object::set_mapping_for_x_axis(GL_CLAMP_TO_EDGE);
+                texture_array_object::set_mapping_for_y_axis(GL_CLAMP_TO_EDGE);
+            }
+
+            /**
+             * @brief Packs the image into the atlas. The array must be bound. (It is, after create)
+             * @param pixels The pixels, 8 bits per channel, rows from the top. ex; what stb decoded.
+             * @param width The width of the image.
+             * @param height The height of the image.
+             * @param channels The number of channels. [1<=channels<=4]
+             * @param entry Where the image was packed, only written if it was.
+             * @returns false if the image doesn't fit into the layers that are left.
+            */
+            bool add(const ubyte_t* pixels, int width, int height, int channels, atlas_entry& entry)
+            {
+                GLFW_PROFILE_SCOPE("texture_atlas::add");
+                int g = _gutter, padded_width = width + 2 * g, padded_height = height + 2 * g;
+                int x, y, layer;
+                if(!allocate(padded_width, padded_height, x, y, layer)) return false;
+
+                // The image and its gutter, which repeats the edge texels of the image outwards.
+                size_t pixel = static_cast<size_t>(channels);
+                _scratch.resize(static_cast<size_t>(padded_width) * padded_height * pixel);
+                for(int row = 0; row < padded_height; row++)
+                {
+                    const ubyte_t* source = pixels + static_cast<size_t>(std::clamp(row - g, 0, height - 1)) * width * pixel;
+                    ubyte_t* destination = _scratch.data() + static_cast<size_t>(row) * padded_width * pixel;
+                    for(int column = 0; column < g; column++) std::memcpy(destination + column * pixel, source, pixel);
+                    std::memcpy(destination + g * pixel, source, width * pixel);
+                    for(int column = g + width; column < padded_width; column++)
+                        std::memcpy(destination + column * pixel, source + (width - 1) * pixel, pixel);
+                }
+
+                GLint previous_alignment = 4;
+                glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                texture_array_object::update(0, x, y, layer, padded_width, padded_height, format_for(channels), _scratch.data());
+                glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+                _mipmaps_dirty = _levels > 1;
+
+                entry = atlas_entry {
+                    { float(x + g) / _width, float(y + g) / _height },
+                    { float(width) / _width, float(height) / _height },
+                    static_cast<uint32_t>(layer)
+                };
+                return true;
+            }
+
+            #ifdef _USE_STB_IMAGE_LOADER_
+                /** @brief Decodes the image with stb and packs it into the atlas. (see: add) */
+                bool add_file(const char* path, atlas_entry& entry)
+                {
+                    int width = 0, height = 0, channels = 0;
+                    ubyte_t* pixels = stbi_load(path, &width, &height, &channels, 0);
+                    if(!pixels)
+                    {
+                        fprintf(stderr, "Error loading image at \"%s\"\n", path);
+                        return false;
+                    }
+                    bool added = add(pixels, width, height, channels, entry);
+                    stbi_image_free(pixels);
+                    return added;
+                }
+            #endif
+
+            /**
+             * @brief Uploads a compressed image into a layer of its own, with the levels of its file. The array must be bound.
+             * @param image The image. It must have the size and the format of the layers.
+             * @param entry The whole layer, only written if the image was added.
+             * @returns false if the image doesn't match the layers, or if no layer is left.
+            */
+            bool add_compressed(const compressed::compressed_image& image, atlas_entry& entry)
+            {
+                GLFW_PROFILE_SCOPE("texture_atlas::add_compressed");
+                if(image.width() != _width || image.height() != _height || image.format().internal_format != _internal_format) return false;
+
+                // A layer that has nothing in it yet.
+                if(_shelf_y || _shelf_height || _cursor_x) _layer++;
+                if(_layer >= _layers) return false;
+
+                size_t levels = std::min(image.level_count(), static_cast<size_t>(_levels));
+                for(size_t i = 0; i < levels; i++)
+                {
+                    const compressed::compressed_level& level = image.level(i);
+                    texture_array_object::update_compressed(static_cast<GLint>(i), 0, 0, _layer, level.width, level.height,
+                        _internal_format, level.size, level.data);
+                }
+
+                entry = atlas_entry { { 0.0f, 0.0f }, { 1.0f, 1.0f }, static_cast<uint32_t>(_layer) };
+                _layer++;
+                _shelf_y = _shelf_height = _cursor_x = 0;
+                return true;
+            }
+
+            /** @brief Generates the mipmaps of the images that were added since the last call. The array must be bound. */
+            void finish()
+            {
+                if(!_mipmaps_dirty) return;
+                GLFW_PROFILE_GPU_SCOPE("texture_atlas::finish");
+                texture_array_object::generate_mipmaps();
+                _mipmaps_dirty = false;
+            }
+
+            /** @brief Returns the array, to be bound to a unit when drawing. ex; draw_packet::texture */
+            texture_array_object& array() noexcept(true) { return _array; }
+            GLuint get_id() const noexcept(true) { return _array.texture_id; }
+
+            int width() const noexcept(true) { return _width; }
+            int height() const noexcept(true) { return _height; }
+            int layer_count() const noexcept(true) { return _layers; }
+            /** @brief Returns the number of layers that something has been packed into. */
+            int used_layers() const noexcept(true) { return std::min(_layer + ((_shelf_y || _shelf_height || _cursor_x) ? 1 : 0), _layers); }
+        };
+
+        /**
+         * @brief The handles of bindless textures (ARB_bindless_texture) in a storage buffer. A texture is made resident
+         * when it is added, and non-resident when the table is cleared or destroyed. A resident texture can't be
+         * changed (its storage, its parameters) and must not be deleted before it has been made non-resident.
+        */
+        class bindless_texture_table
+        {
+        private:
+            std::vector<GLuint64> _handles;
+            buffer_object _buffer;
+            size_t _capacity = 0;
+            bool _dirty = false;
+
+        public:
+            bindless_texture_table()
+            {
+                _buffer.set_type(GL_SHADER_STORAGE_BUFFER);
+                _buffer.find_free_id();
+            }
+            bindless_texture_table(const bindless_texture_table&) = delete;
+            bindless_texture_table& operator=(const bindless_texture_table&) = delete;
+
+            /** @brief Whether or not the driver supports bindless textures. The context must be current. */
+            static bool is_supported() { return GLAD_GL_ARB_bindless_texture != 0; }
+
+            /**
+             * @brief Makes the texture resident and adds its handle (with its own sampler state) to the table.
+             * @param texture The id of the texture. Its storage and parameters must be final.
+             * @returns The index of the handle, which is what the instances refer to the texture with.
+            */
+            uint32_t add(GLuint texture)
+            {
+                GLuint64 handle = glGetTextureHandleARB(texture);
+                glMakeTextureHandleResidentARB(handle);
+                _handles.push_back(handle);
+                _dirty = true;
+                return static_cast<uint32_t>(_handles.size() - 1);
+            }
+
+            /** @brief Makes every texture non-resident and empties the table. */
+            void clear()
+            {
+                for(GLuint64 handle : _handles) glMakeTextureHandleNonResidentARB(handle);
+                _handles.clear();
+                _dirty = true;
+            }
+
+            /**
+             * @brief Writes the handles that were added since the last call into the buffer (if any) and binds it.
+             * @param binding The binding point of the storage block. (see: shader_program::bind_storage_block)
+            */
+            void bind_base(GLuint binding)
+            {
+                if(_dirty && !_handles.empty())
+                {
+                    _buffer.bind();
+                    if(_handles.size() > _capacity)
+                    {
+                        _capacity = std::max(_handles.size(), _capacity * 2);
+                        _buffer.create<GLuint64>(nullptr, _capacity, GL_DYNAMIC_DRAW);
+                    }
+                    _buffer.update<GLuint64>(_handles.data(), _handles.size());
+                }
+                _dirty = false;
+                _buffer.bind_base(binding);
+            }
+
+            size_t size() const noexcept(true) { return _handles.size(); }
+
+            ~bindless_texture_table() noexcept(true) { clear(); }
+        };
+    }; // namespace texture
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
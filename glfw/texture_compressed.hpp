@@ -0,0 +1,384 @@
+/**
+ * This header contains the compressed texture containers. A KTX2 or DDS file already holds the texture in a block
+ * compressed format that the GPU samples from directly (BC1-7, ETC2/EAC or ASTC) together with its mipmap chain,
+ * hence it is neither decoded on the CPU nor are its mipmaps generated. It also takes 4 to 8 times less memory on
+ * the GPU than the same texture in RGBA8.
+ *
+ * The file is memory-mapped (see: mapped_file.hpp) and only its header is read, the levels are uploaded straight from
+ * the mapping. Only 2D textures are supported, i.e. no cube maps, no arrays and no 3D textures. KTX2 files must not be
+ * supercompressed (Basis Universal, zstd), the data of every level must already be in the format of the GPU.
+ *
+ * Every other file (ex; png, jpg) is still decoded by stb. (see: is_compressed_container) The texture streamer and the
+ * loader context choose between the two by themselves. (see: texture_streaming.hpp, loader_context.hpp)
+ *
+ * Usage;
+ *  texture::compressed::compressed_image image;
+ *  if(image.open("./albedo.ktx2") && image.is_supported())
+ *  {
+ *      texture.bind();
+ *      texture::compressed::create(texture, image);
+ *  }
+*/
+
+#include "./glfw.hpp"
+#include "./texture.hpp"
+#include "./mapped_file.hpp"
+
+#ifndef _GLFW_TEXTURE_COMPRESSED_DEFINITION_HPP_
+    #define _GLFW_TEXTURE_COMPRESSED_DEFINITION_HPP_
+
+    #include <cstdint>
+    #include <cstddef>
+    #include <cstdio>
+    #include <cstring>
+    #include <cctype>
+    #include <algorithm>
+
+    _GLFW_START_
+
+    namespace texture
+    {
+    namespace compressed
+    {
+        /** @brief A block compressed format. Every block holds block_width*block_height texels in block_bytes bytes. */
+        struct compressed_format
+        {
+            /** @brief The internal format that the texture is created with. ex; GL_COMPRESSED_RGBA_BPTC_UNORM */
+            GLenum internal_format;
+            uint8_t block_width;
+            uint8_t block_height;
+            uint8_t block_bytes;
+        };
+
+        /** @brief A mipmap level of a compressed image. The data points into the mapped file. */
+        struct compressed_level
+        {
+            const unsigned char* data;
+            size_t size;
+            int width;
+            int height;
+        };
+
+        /** @brief The maximum number of levels. (A 32768x32768 texture) */
+        constexpr size_t max_levels = 16;
+
+        namespace detail
+        {
+            // The extension enums aren't in every loader, their values are fixed by the registry.
+            constexpr GLenum rgb_s3tc_dxt1              = 0x83F0;
+            constexpr GLenum rgba_s3tc_dxt1             = 0x83F1;
+            constexpr GLenum rgba_s3tc_dxt3             = 0x83F2;
+            constexpr GLenum rgba_s3tc_dxt5             = 0x83F3;
+            constexpr GLenum srgb_s3tc_dxt1             = 0x8C4C;
+            constexpr GLenum srgb_alpha_s3tc_dxt1       = 0x8C4D;
+            constexpr GLenum srgb_alpha_s3tc_dxt3       = 0x8C4E;
+            constexpr GLenum srgb_alpha_s3tc_dxt5       = 0x8C4F;
+            constexpr GLenum red_rgtc1                  = 0x8DBB;
+            constexpr GLenum signed_red_rgtc1           = 0x8DBC;
+            constexpr GLenum rg_rgtc2                   = 0x8DBD;
+            constexpr GLenum signed_rg_rgtc2            = 0x8DBE;
+            constexpr GLenum rgba_bptc_unorm            = 0x8E8C;
+            constexpr GLenum srgb_alpha_bptc_unorm      = 0x8E8D;
+            constexpr GLenum rgb_bptc_signed_float      = 0x8E8E;
+            constexpr GLenum rgb_bptc_unsigned_float    = 0x8E8F;
+            constexpr GLenum r11_eac                    = 0x9270;
+            constexpr GLenum signed_r11_eac             = 0x9271;
+            constexpr GLenum rg11_eac                   = 0x9272;
+            constexpr GLenum signed_rg11_eac            = 0x9273;
+            constexpr GLenum rgb8_etc2                  = 0x9274;
+            constexpr GLenum srgb8_etc2                 = 0x9275;
+            constexpr GLenum rgb8_alpha1_etc2           = 0x9276;
+            constexpr GLenum srgb8_alpha1_etc2          = 0x9277;
+            constexpr GLenum rgba8_etc2_eac             = 0x9278;
+            constexpr GLenum srgb8_alpha8_etc2_eac      = 0x9279;
+            /** @brief GL_COMPRESSED_RGBA_ASTC_4x4_KHR, the other block sizes follow it in the order of astc_blocks. */
+            constexpr GLenum rgba_astc_4x4              = 0x93B0;
+            /** @brief GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR */
+            constexpr GLenum srgb8_alpha8_astc_4x4      = 0x93D0;
+
+            /** @brief The block sizes of ASTC, in the order of both the GL enums and the Vulkan formats. */
+            constexpr uint8_t astc_blocks[14][2] =
+            {
+                {4,4}, {5,4}, {5,5}, {6,5}, {6,6}, {8,5}, {8,6}, {8,8}, {10,5}, {10,6}, {10,8}, {10,10}, {12,10}, {12,12}
+            };
+
+            /** @brief Converts a VkFormat (KTX2) into a compressed format. @returns false if it isn't a supported one. */
+            inline bool from_vk_format(uint32_t format, compressed_format& out)
+            {
+                // VK_FORMAT_BC1_RGB_UNORM_BLOCK (131) to VK_FORMAT_EAC_R11G11_SNORM_BLOCK (156), every UNORM is followed by its SRGB (or SNORM).
+                static const GLenum table[] =
+                {
+                    rgb_s3tc_dxt1, srgb_s3tc_dxt1, rgba_s3tc_dxt1, srgb_alpha_s3tc_dxt1, rgba_s3tc_dxt3, srgb_alpha_s3tc_dxt3,
+                    rgba_s3tc_dxt5, srgb_alpha_s3tc_dxt5, red_rgtc1, signed_red_rgtc1, rg_rgtc2, signed_rg_rgtc2,
+                    rgb_bptc_unsigned_float, rgb_bptc_signed_float, rgba_bptc_unorm, srgb_alpha_bptc_unorm,
+                    rgb8_etc2, srgb8_etc2, rgb8_alpha1_etc2, srgb8_alpha1_etc2, rgba8_etc2_eac, srgb8_alpha8_etc2_eac,
+                    r11_eac, signed_r11_eac, rg11_eac, signed_rg11_eac
+                };
+                // The 8 byte formats. (BC1, BC4, ETC2 RGB, ETC2 RGB A1 and R11)
+                static const bool half_block[] =
+                {
+                    true, true, true, true, false, false, false, false, true, true, false, false, false, false, false, false,
+                    true, true, true, true, false, false, true, true, false, false
+                };
+
+                if(format >= 131 && format <= 156)
+                {
+                    out = compressed_format { table[format - 131], 4, 4, uint8_t(half_block[format - 131] ? 8 : 16) };
+                    return true;
+                }
+                // VK_FORMAT_ASTC_4x4_UNORM_BLOCK (157) to VK_FORMAT_ASTC_12x12_SRGB_BLOCK (184), also UNORM then SRGB.
+                if(format >= 157 && format <= 184)
+                {
+                    uint32_t block = (format - 157) / 2;
+                    GLenum base = (format - 157) % 2 ? srgb8_alpha8_astc_4x4 : rgba_astc_4x4;
+                    out = compressed_format { base + block, astc_blocks[block][0], astc_blocks[block][1], 16 };
+                    return true;
+                }
+                return false;
+            }
+
+            /** @brief Converts a DXGI_FORMAT (DDS with a DX10 header) into a compressed format. */
+            inline bool from_dxgi_format(uint32_t format, compressed_format& out)
+            {
+                switch(format)
+                {
+                case 71: out = { rgba_s3tc_dxt1, 4, 4, 8 };                 return true; // BC1_UNORM
+                case 72: out = { srgb_alpha_s3tc_dxt1, 4, 4, 8 };           return true; // BC1_UNORM_SRGB
+                case 74: out = { rgba_s3tc_dxt3, 4, 4, 16 };                return true; // BC2_UNORM
+                case 75: out = { srgb_alpha_s3tc_dxt3, 4, 4, 16 };          return true; // BC2_UNORM_SRGB
+                case 77: out = { rgba_s3tc_dxt5, 4, 4, 16 };                return true; // BC3_UNORM
+                case 78: out = { srgb_alpha_s3tc_dxt5, 4, 4, 16 };          return true; // BC3_UNORM_SRGB
+                case 80: out = { red_rgtc1, 4, 4, 8 };                      return true; // BC4_UNORM
+                case 81: out = { signed_red_rgtc1, 4, 4, 8 };               return true; // BC4_SNORM
+                case 83: out = { rg_rgtc2, 4, 4, 16 };                      return true; // BC5_UNORM
+                case 84: out = { signed_rg_rgtc2, 4, 4, 16 };               return true; // BC5_SNORM
+                case 95: out = { rgb_bptc_unsigned_float, 4, 4, 16 };       return true; // BC6H_UF16
+                case 96: out = { rgb_bptc_signed_float, 4, 4, 16 };         return true; // BC6H_SF16
+                case 98: out = { rgba_bptc_unorm, 4, 4, 16 };               return true; // BC7_UNORM
+                case 99: out = { srgb_alpha_bptc_unorm, 4, 4, 16 };         return true; // BC7_UNORM_SRGB
+                }
+                return false;
+            }
+
+            /** @brief Converts a FourCC (DDS without a DX10 header) into a compressed format. */
+            inline bool from_four_cc(uint32_t four_cc, compressed_format& out)
+            {
+                auto code = [](const char* s) { return uint32_t(s[0]) | uint32_t(s[1]) << 8 | uint32_t(s[2]) << 16 | uint32_t(s[3]) << 24; };
+
+                if(four_cc == code("DXT1")) { out = { rgba_s3tc_dxt1, 4, 4, 8 }; return true; }
+                if(four_cc == code("DXT3")) { out = { rgba_s3tc_dxt3, 4, 4, 16 }; return true; }
+                if(four_cc == code("DXT5")) { out = { rgba_s3tc_dxt5, 4, 4, 16 }; return true; }
+                if(four_cc == code("ATI1") || four_cc == code("BC4U")) { out = { red_rgtc1, 4, 4, 8 }; return true; }
+                if(four_cc == code("BC4S")) { out = { signed_red_rgtc1, 4, 4, 8 }; return true; }
+                if(four_cc == code("ATI2") || four_cc == code("BC5U")) { out = { rg_rgtc2, 4, 4, 16 }; return true; }
+                if(four_cc == code("BC5S")) { out = { signed_rg_rgtc2, 4, 4, 16 }; return true; }
+                return false;
+            }
+
+            inline uint32_t read_u32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+            inline uint64_t read_u64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+        }; // namespace detail
+
+        /**
+         * @brief Whether or not the file is a compressed container, judging by its extension. (".ktx2" or ".dds", in
+         * any case) Every other file is left to stb.
+        */
+        inline bool is_compressed_container(const char* path)
+        {
+            const char* dot = std::strrchr(path, '.');
+            if(!dot) return false;
+
+            char extension[6] = {};
+            for(size_t i = 0; i < 5 && dot[i + 1]; i++) extension[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(dot[i + 1])));
+            return !std::strcmp(extension, "ktx2") || !std::strcmp(extension, "dds");
+        }
+
+        /** @brief A mapped KTX2 or DDS file. (see: the top of this file) */
+        class compressed_image
+        {
+        private:
+            mapped_file _file;
+            compressed_format _format = {};
+            int _width = 0;
+            int _height = 0;
+            compressed_level _levels[max_levels] = {};
+            size_t _level_count = 0;
+
+            size_t level_size(int width, int height) const noexcept(true)
+            {
+                size_t blocks_x = (static_cast<size_t>(width) + _format.block_width - 1) / _format.block_width;
+                size_t blocks_y = (static_cast<size_t>(height) + _format.block_height - 1) / _format.block_height;
+                return blocks_x * blocks_y * _format.block_bytes;
+            }
+
+            /** @brief Fills in the sizes of the levels. @returns false if there are more levels than the image can have. */
+            bool size_levels(size_t count)
+            {
+                if(_width <= 0 || _height <= 0 || !count || count > max_levels ||
+                    count > static_cast<size_t>(texture_object::mipmap_levels(_width, _height))) return false;
+
+                _level_count = count;
+                for(size_t i = 0; i < count; i++)
+                {
+                    compressed_level& level = _levels[i];
+                    level.width = std::max(_width >> i, 1);
+                    level.height = std::max(_height >> i, 1);
+                    level.size = level_size(level.width, level.height);
+                }
+                return true;
+            }
+
+            bool parse_ktx2()
+            {
+                static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+                const unsigned char* p = _file.data();
+                // The identifier, the header (9 u32), the index (4 u32 and 2 u64) and at least one level (3 u64).
+                if(_file.size() < 80 + 24 || std::memcmp(p, identifier, 12)) return false;
+
+                uint32_t vk_format = detail::read_u32(p + 12);
+                uint32_t width = detail::read_u32(p + 20), height = detail::read_u32(p + 24), depth = detail::read_u32(p + 28);
+                uint32_t layers = detail::read_u32(p + 32), faces = detail::read_u32(p + 36), levels = detail::read_u32(p + 40);
+                uint32_t supercompression = detail::read_u32(p + 44);
+
+                if(depth > 1 || layers > 1 || faces != 1 || supercompression != 0) return false;
+                if(!detail::from_vk_format(vk_format, _format)) return false;
+
+                _width = static_cast<int>(width);
+                _height = static_cast<int>(height);
+                // 0 levels means that the mipmaps should be generated, which isn't possible for compressed formats.
+                if(!size_levels(std::max(levels, 1u)) || _file.size() < 80 + 24 * _level_count) return false;
+
+                for(size_t i = 0; i < _level_count; i++)
+                {
+                    uint64_t offset = detail::read_u64(p + 80 + 24 * i), length = detail::read_u64(p + 80 + 24 * i + 8);
+                    if(length != _levels[i].size || offset > _file.size() || length > _file.size() - offset) return false;
+                    _levels[i].data = p + offset;
+                }
+                return true;
+            }
+
+            bool parse_dds()
+            {
+                const unsigned char* p = _file.data();
+                if(_file.size() < 128 || std::memcmp(p, "DDS ", 4) || detail::read_u32(p + 4) != 124) return false;
+
+                constexpr uint32_t mipmap_count_flag = 0x20000, four_cc_flag = 0x4, cubemap_flag = 0x200, volume_flag = 0x200000;
+                uint32_t flags = detail::read_u32(p + 8);
+                _height = static_cast<int>(detail::read_u32(p + 12));
+                _width = static_cast<int>(detail::read_u32(p + 16));
+                uint32_t levels = flags & mipmap_count_flag ? detail::read_u32(p + 28) : 1;
+                uint32_t pixel_flags = detail::read_u32(p + 80), four_cc = detail::read_u32(p + 84);
+                uint32_t caps2 = detail::read_u32(p + 112);
+
+                if(!(pixel_flags & four_cc_flag) || caps2 & (cubemap_flag | volume_flag)) return false;
+
+                size_t offset = 128;
+                if(four_cc == detail::read_u32(reinterpret_cast<const unsigned char*>("DX10")))
+                {
+                    if(_file.size() < 148) return false;
+                    uint32_t dxgi_format = detail::read_u32(p + 128), dimension = detail::read_u32(p + 132);
+                    uint32_t misc = detail::read_u32(p + 136), array_size = detail::read_u32(p + 140);
+                    // D3D10_RESOURCE_DIMENSION_TEXTURE2D, not a cube map, a single layer.
+                    if(dimension != 3 || misc & 0x4 || array_size > 1) return false;
+                    if(!detail::from_dxgi_format(dxgi_format, _format)) return false;
+                    offset = 148;
+                }
+                else if(!detail::from_four_cc(four_cc, _format)) return false;
+
+                if(!size_levels(std::max(levels, 1u))) return false;
+
+                // The levels follow each other, from the largest one.
+                for(size_t i = 0; i < _level_count; i++)
+                {
+                    if(_levels[i].size > _file.size() - offset) return false;
+                    _levels[i].data = p + offset;
+                    offset += _levels[i].size;
+                }
+                return true;
+            }
+
+        public:
+            compressed_image() = default;
+            compressed_image(const compressed_image&) = delete;
+            compressed_image& operator=(const compressed_image&) = delete;
+
+            /**
+             * @brief Maps the file and reads its header. An image that is already open is closed first.
+             * @param path The path to the KTX2 or DDS file.
+             * @returns Whether or not the file is a 2D texture in a supported format.
+            */
+            bool open(const char* path)
+            {
+                close();
+                if(!_file.open(path)) return false;
+
+                if(!parse_ktx2() && !parse_dds())
+                {
+                    fprintf(stderr, "Error loading compressed texture at \"%s\"\n", path);
+                    close();
+                    return false;
+                }
+                return true;
+            }
+
+            /** @brief Unmaps the file. */
+            void close() noexcept(true)
+            {
+                _file.close();
+                _level_count = 0;
+                _width = _height = 0;
+            }
+
+            bool is_open() const noexcept(true) { return _level_count != 0; }
+
+            /**
+             * @brief Whether or not the GPU can sample from the format. (ex; ASTC is rarely supported by desktop GPUs)
+             * Requires a current context, and OpenGL 4.3 for the query.
+            */
+            bool is_supported() const
+            {
+                GLint supported = GL_FALSE;
+                glGetInternalformativ(GL_TEXTURE_2D, _format.internal_format, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+                return supported == GL_TRUE;
+            }
+
+            const compressed_format& format() const noexcept(true) { return _format; }
+            int width() const noexcept(true) { return _width; }
+            int height() const noexcept(true) { return _height; }
+
+            /** @brief Returns the number of levels in the file. Every one of them is uploaded, none are generated. */
+            size_t level_count() const noexcept(true) { return _level_count; }
+            /** @brief Returns the level, 0 being the largest one. */
+            const compressed_level& level(size_t i) const noexcept(true) { return _levels[i]; }
+
+            /** @brief Returns the size(in bytes) of every level together. */
+            size_t total_size() const noexcept(true)
+            {
+                size_t size = 0;
+                for(size_t i = 0; i < _level_count; i++) size += _levels[i].size;
+                return size;
+            }
+        };
+
+        /**
+         * @brief Uploads every level of the image into the texture (glCompressedTexImage2D) and limits the texture to
+         * those levels, so that a chain that stops before 1x1 is still complete. The texture must be bound.
+         * @param texture The texture.
+         * @param image The image. It must be open.
+        */
+        void create(texture_object& texture, const compressed_image& image)
+        {
+            GLFW_PROFILE_GPU_SCOPE("texture::compressed::create");
+            for(size_t i = 0; i < image.level_count(); i++)
+            {
+                const compressed_level& level = image.level(i);
+                texture.create_compressed(static_cast<GLint>(i), image.format().internal_format, level.width, level.height, level.size, level.data);
+            }
+            texture_object::set_max_level(static_cast<GLint>(image.level_count()) - 1);
+        }
+    }; // namespace compressed
+    }; // namespace texture
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,487 @@
+/**
+ * This header contains the texture streamer. It loads textures in the background so that loading a lot of them
+ * doesn't freeze the frame.
+ *
+ * A texture goes through these steps;
+ *  - The image is decoded by stb on the shared thread pool. (see: thread_pool.hpp)
+ *  - Its storage is allocated with glTexStorage2D (immutable) and the pixels are copied into a pixel unpack buffer
+ *    (PBO) and uploaded from there, a few rows at a time so that no more than the upload budget is uploaded per frame.
+ *  - A fence is placed after the last upload. Once the GPU has passed it, the texture is ready to be used.
+ *
+ * KTX2 and DDS files (see: texture_compressed.hpp) skip the decoding; they are only mapped and their header is read on
+ * the thread pool. Their levels are uploaded as they are (a whole level at a time) and no mipmaps are generated.
+ *
+ * Like the image_loader this requires _USE_STB_IMAGE_LOADER_ to be defined.
+*/
+
+#include "./glfw.hpp"
+#include "./texture.hpp"
+#include "./texture_compressed.hpp"
+#include "./thread_pool.hpp"
+
+#ifndef _GLFW_TEXTURE_STREAMING_DEFINITION_HPP_
+    #define _GLFW_TEXTURE_STREAMING_DEFINITION_HPP_
+
+    #include <string>
+    #include <vector>
+    #include <deque>
+    #include <mutex>
+    #include <condition_variable>
+    #include <atomic>
+    #include <cstring>
+
+    _GLFW_START_
+
+    #ifdef _USE_STB_IMAGE_LOADER_
+    namespace texture
+    {
+    namespace streaming
+    {
+        /** @brief Identifies a texture that has been requested from a texture_streamer. */
+        using texture_handle = uint32_t;
+        /** @brief Represents a handle to nothing. */
+        constexpr texture_handle invalid_texture_handle = UINT32_MAX;
+
+        /** @brief The various states a streamed texture can be in. */
+        enum class texture_state : uint8_t
+        {
+            /** @brief The image is being decoded (or mapped, if it is compressed) on the thread pool. */
+            DECODING    = 0,
+            /** @brief The image has been decoded and is waiting to be uploaded. */
+            DECODED     = 1,
+            /** @brief A part of the image has been uploaded. */
+            UPLOADING   = 2,
+            /** @brief The whole image has been uploaded, waiting for the GPU to finish using the staging buffer. */
+            FENCED      = 3,
+            /** @brief The texture can be used for rendering. */
+            READY       = 4,
+            /** @brief The image couldn't be decoded. */
+            FAILED      = 5
+        };
+
+        /** @brief How a streamed texture should be created. */
+        struct stream_options
+        {
+            /** @brief Whether or not to allocate and generate a full mipmap chain. A compressed image always uses the levels of its file. */
+            bool mipmaps = true;
+            GLint min_filter = GL_LINEAR_MIPMAP_LINEAR;
+            GLint mag_filter = GL_LINEAR;
+            GLint wrap = GL_REPEAT;
+        };
+
+        /** @brief Loads textures in the background and uploads them over several frames. */
+        class texture_streamer
+        {
+        private:
+            struct record
+            {
+                std::string path;
+                stream_options options;
+                std::atomic<texture_state> state = texture_state::DECODING;
+
+                int width = 0;
+                int height = 0;
+                int color_channels = 0;
+                ptr_t<ubyte_t> pixels = nullptr;
+
+                GLuint texture_id = 0;
+                int rows_uploaded = 0;
+
+                /** @brief The mapped file, only for KTX2 and DDS images. It is closed once every level has been uploaded. */
+                std::unique_ptr<compressed::compressed_image> compressed;
+                size_t levels_uploaded = 0;
+                size_t bytes_staged = 0;
+
+                GLuint staging = 0;
+                size_t staging_size = 0;
+                GLsync fence = nullptr;
+            };
+
+            struct staging_buffer { GLuint id; size_t size; };
+
+            jobs::thread_pool& _pool;
+
+            /** @brief Only accessed by the thread that owns the context, the workers only get a pointer to their record. */
+            std::vector<std::unique_ptr<record>> _records;
+            std::deque<texture_handle> _upload_queue;
+            std::vector<texture_handle> _fenced;
+            std::vector<staging_buffer> _free_staging;
+
+            std::mutex _lock;
+            std::condition_variable _all_decoded;
+            std::vector<texture_handle> _decoded;
+            size_t _decoding = 0;
+
+            size_t _budget = 4 << 20;
+            size_t _uploaded_last_frame = 0;
+
+            static void formats_for(int channels, GLenum& internal_format, GLenum& format)
+            {
+                switch(channels)
+                {
+                case 1:  internal_format = GL_R8;    format = GL_RED;  break;
+                case 2:  internal_format = GL_RG8;   format = GL_RG;   break;
+                case 3:  internal_format = GL_RGB8;  format = GL_RGB;  break;
+                default: internal_format = GL_RGBA8; format = GL_RGBA; break;
+                }
+            }
+
+            size_t image_size(const record& rec) const
+            {
+                if(rec.compressed) return rec.compressed->total_size();
+                return static_cast<size_t>(rec.width) * rec.height * rec.color_channels;
+            }
+
+            /** @brief Gets a staging buffer that is at least @c size bytes big. It is bound to GL_PIXEL_UNPACK_BUFFER. */
+            staging_buffer acquire_staging(size_t size)
+            {
+                for(size_t i = 0; i < _free_staging.size(); i++)
+                {
+                    if(_free_staging[i].size >= size)
+                    {
+                        staging_buffer buffer = _free_staging[i];
+                        _free_staging.erase(_free_staging.begin() + i);
+                        state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+                        return buffer;
+                    }
+                }
+
+                staging_buffer buffer { 0, size };
+                glGenBuffers(1, &buffer.id);
+                state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+                return buffer;
+            }
+
+            /**
+             * @brief Creates the storage of the texture and its staging buffer.
+             * @returns false (and marks the texture as failed) if the GPU can't sample from the format of a compressed image.
+            */
+            bool begin_upload(record& rec)
+            {
+                GLenum internal_format, format;
+                GLsizei levels;
+                bool mipmapped;
+                if(rec.compressed)
+                {
+                    if(!rec.compressed->is_supported())
+                    {
+                        fprintf(stderr, "Unsupported compressed format in \"%s\"\n", rec.path.c_str());
+                        rec.compressed.reset();
+                        rec.state.store(texture_state::FAILED, std::memory_order_relaxed);
+                        return false;
+                    }
+                    internal_format = rec.compressed->format().internal_format;
+                    levels = static_cast<GLsizei>(rec.compressed->level_count());
+                    mipmapped = levels > 1;
+                }
+                else
+                {
+                    formats_for(rec.color_channels, internal_format, format);
+                    levels = rec.options.mipmaps ? texture_object::mipmap_levels(rec.width, rec.height) : 1;
+                    mipmapped = rec.options.mipmaps;
+                }
+
+                glGenTextures(1, &rec.texture_id);
+                state::current().bind_texture(GL_TEXTURE_2D, rec.texture_id);
+                glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, rec.width, rec.height);
+                texture_object::set_min_filter(mipmapped ? rec.options.min_filter : rec.options.mag_filter);
+                texture_object::set_mag_filter(rec.options.mag_filter);
+                texture_object::set_mapping_for_x_axis(rec.options.wrap);
+                texture_object::set_mapping_for_y_axis(rec.options.wrap);
+
+                staging_buffer buffer = acquire_staging(image_size(rec));
+                rec.staging = buffer.id;
+                rec.staging_size = buffer.size;
+                rec.state.store(texture_state::UPLOADING, std::memory_order_relaxed);
+                return true;
+            }
+
+            /** @brief Places the fence after the last upload of the texture. */
+            void finish_upload(record& rec)
+            {
+                rec.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                rec.state.store(texture_state::FENCED, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Uploads as many rows of the texture as fit into the budget (at least one row).
+             * @returns The number of bytes that were uploaded.
+            */
+            size_t upload_rows(record& rec, size_t budget)
+            {
+                GLenum internal_format, format;
+                formats_for(rec.color_channels, internal_format, format);
+
+                size_t row_size = static_cast<size_t>(rec.width) * rec.color_channels;
+                int rows = static_cast<int>(std::max<size_t>(budget / row_size, 1));
+                rows = std::min(rows, rec.height - rec.rows_uploaded);
+
+                size_t offset = row_size * rec.rows_uploaded;
+                size_t size = row_size * rows;
+
+                state::current().bind_texture(GL_TEXTURE_2D, rec.texture_id);
+                state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, rec.staging);
+
+                // Every range is only written once, hence there is no need to synchronize with the GPU.
+                void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, size,
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                if(mapped)
+                {
+                    std::memcpy(mapped, rec.pixels + offset, size);
+                    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                }
+
+                texture_object::update(0, 0, rec.rows_uploaded, rec.width, rows, format, reinterpret_cast<const void*>(offset));
+                rec.rows_uploaded += rows;
+
+                if(rec.rows_uploaded == rec.height)
+                {
+                    if(rec.options.mipmaps) texture_object::generate_mipmaps();
+                    finish_upload(rec);
+
+                    stbi_image_free(rec.pixels);
+                    rec.pixels = nullptr;
+                }
+                return size;
+            }
+
+            /**
+             * @brief Uploads as many levels of a compressed image as fit into the budget (at least one level). The levels
+             * can't be split into rows as easily as the pixels, a whole level is uploaded at once.
+             * @returns The number of bytes that were uploaded.
+            */
+            size_t upload_levels(record& rec, size_t budget)
+            {
+                const compressed::compressed_image& image = *rec.compressed;
+                state::current().bind_texture(GL_TEXTURE_2D, rec.texture_id);
+                state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, rec.staging);
+
+                size_t uploaded = 0;
+                do
+                {
+                    const compressed::compressed_level& level = image.level(rec.levels_uploaded);
+
+                    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, rec.bytes_staged, level.size,
+                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+                    if(mapped)
+                    {
+                        std::memcpy(mapped, level.data, level.size);
+                        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                    }
+
+                    texture_object::update_compressed(static_cast<GLint>(rec.levels_uploaded), 0, 0, level.width, level.height,
+                        image.format().internal_format, level.size, reinterpret_cast<const void*>(rec.bytes_staged));
+                    rec.bytes_staged += level.size;
+                    rec.levels_uploaded++;
+                    uploaded += level.size;
+                }
+                while(rec.levels_uploaded < image.level_count() && uploaded + image.level(rec.levels_uploaded).size <= budget);
+
+                if(rec.levels_uploaded == image.level_count())
+                {
+                    finish_upload(rec);
+                    rec.compressed.reset();
+                }
+                return uploaded;
+            }
+
+            /** @brief Marks the textures whose fences have been passed as ready and recycles their staging buffers. */
+            void retire_fenced()
+            {
+                for(size_t i = 0; i < _fenced.size();)
+                {
+                    record& rec = *_records[_fenced[i]];
+                    if(glClientWaitSync(rec.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                    {
+                        i++;
+                        continue;
+                    }
+
+                    glDeleteSync(rec.fence);
+                    rec.fence = nullptr;
+                    _free_staging.push_back(staging_buffer { rec.staging, rec.staging_size });
+                    rec.staging = 0;
+                    rec.state.store(texture_state::READY, std::memory_order_relaxed);
+
+                    _fenced[i] = _fenced.back();
+                    _fenced.pop_back();
+                }
+            }
+
+        public:
+            /** @brief Creates the streamer. @param pool? The pool where the images will be decoded. */
+            explicit texture_streamer(jobs::thread_pool& pool = jobs::shared_pool()) : _pool(pool) {}
+
+            texture_streamer(const texture_streamer&) = delete;
+            texture_streamer& operator=(const texture_streamer&) = delete;
+
+            /** @brief Sets the maximum number of bytes that will be uploaded per frame. (4MiB by default) */
+            void set_upload_budget(size_t bytes) noexcept(true) { _budget = bytes ? bytes : 1; }
+            /** @brief Returns the maximum number of bytes that will be uploaded per frame. */
+            size_t get_upload_budget() const noexcept(true) { return _budget; }
+            /** @brief Returns the number of bytes that were uploaded during the last call to update. */
+            size_t uploaded_last_frame() const noexcept(true) { return _uploaded_last_frame; }
+
+            /**
+             * @brief Starts loading the specified image in the background. Should be called from the thread that owns the context.
+             * @param path The path to the image.
+             * @param options? How the texture should be created.
+             * @returns The handle that identifies the texture.
+            */
+            texture_handle load(const char* path, const stream_options& options = {})
+            {
+                texture_handle handle = static_cast<texture_handle>(_records.size());
+                _records.push_back(std::make_unique<record>());
+
+                record* rec = _records.back().get();
+                rec->path = path;
+                rec->options = options;
+
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    _decoding++;
+                }
+                _pool.enqueue([this, rec, handle]
+                {
+                    bool loaded;
+                    if(compressed::is_compressed_container(rec->path.c_str()))
+                    {
+                        rec->compressed = std::make_unique<compressed::compressed_image>();
+                        loaded = rec->compressed->open(rec->path.c_str());
+                        if(loaded)
+                        {
+                            rec->width = rec->compressed->width();
+                            rec->height = rec->compressed->height();
+                        }
+                        else rec->compressed.reset();
+                    }
+                    else
+                    {
+                        rec->pixels = stbi_load(rec->path.c_str(), &rec->width, &rec->height, &rec->color_channels, 0);
+                        if(!rec->pixels) fprintf(stderr, "Error loading image at \"%s\"\n", rec->path.c_str());
+                        loaded = rec->pixels != nullptr;
+                    }
+                    rec->state.store(loaded ? texture_state::DECODED : texture_state::FAILED, std::memory_order_release);
+
+                    std::lock_guard<std::mutex> guard(_lock);
+                    if(loaded) _decoded.push_back(handle);
+                    if(!--_decoding) _all_decoded.notify_all();
+                });
+
+                return handle;
+            }
+
+            /**
+             * @brief Uploads the decoded images, no more than the upload budget, and marks the finished ones as ready.
+             * Should be called once per frame from the thread that owns the context.
+            */
+            void update()
+            {
+                retire_fenced();
+
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    for(texture_handle handle : _decoded) _upload_queue.push_back(handle);
+                    _decoded.clear();
+                }
+
+                _uploaded_last_frame = 0;
+                if(_upload_queue.empty()) return;
+
+                GLint previous_texture = 0, previous_alignment = 4;
+                glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous_texture);
+                glGetIntegerv(GL_UNPACK_ALIGNMENT, &previous_alignment);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+                while(!_upload_queue.empty() && _uploaded_last_frame < _budget)
+                {
+                    record& rec = *_records[_upload_queue.front()];
+                    if(rec.state.load(std::memory_order_acquire) == texture_state::DECODED && !begin_upload(rec))
+                    {
+                        _upload_queue.pop_front();
+                        continue;
+                    }
+
+                    size_t budget = _budget - _uploaded_last_frame;
+                    _uploaded_last_frame += rec.compressed ? upload_levels(rec, budget) : upload_rows(rec, budget);
+
+                    if(rec.state.load(std::memory_order_relaxed) == texture_state::FENCED)
+                    {
+                        _fenced.push_back(_upload_queue.front());
+                        _upload_queue.pop_front();
+                    }
+                }
+
+                state::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                state::current().bind_texture(GL_TEXTURE_2D, static_cast<GLuint>(previous_texture));
+                glPixelStorei(GL_UNPACK_ALIGNMENT, previous_alignment);
+            }
+
+            /** @brief Returns the state of the texture. */
+            texture_state get_state(texture_handle handle) const
+            {
+                return _records[handle]->state.load(std::memory_order_acquire);
+            }
+            /** @brief Whether or not the texture can be used for rendering. */
+            bool is_ready(texture_handle handle) const { return get_state(handle) == texture_state::READY; }
+
+            /** @brief Returns the id of the texture. It is 0 until the texture is ready. */
+            GLuint get_texture_id(texture_handle handle) const
+            {
+                return is_ready(handle) ? _records[handle]->texture_id : 0;
+            }
+            /** @brief Returns the width of the texture. It is only valid after the image has been decoded. */
+            int get_width(texture_handle handle) const { return _records[handle]->width; }
+            /** @brief Returns the height of the texture. It is only valid after the image has been decoded. */
+            int get_height(texture_handle handle) const { return _records[handle]->height; }
+
+            /** @brief Returns the number of textures that aren't ready yet. (Excluding the ones that failed) */
+            size_t pending() const
+            {
+                size_t count = 0;
+                for(const std::unique_ptr<record>& rec : _records)
+                {
+                    texture_state state = rec->state.load(std::memory_order_relaxed);
+                    count += state != texture_state::READY && state != texture_state::FAILED;
+                }
+                return count;
+            }
+
+            /** @brief Waits for the decoding jobs and then deletes all the textures and buffers. The context must still be current. */
+            ~texture_streamer() noexcept(true)
+            {
+                {
+                    std::unique_lock<std::mutex> guard(_lock);
+                    _all_decoded.wait(guard, [this] { return _decoding == 0; });
+                }
+
+                for(std::unique_ptr<record>& rec : _records)
+                {
+                    if(rec->pixels) stbi_image_free(rec->pixels);
+                    if(rec->fence) glDeleteSync(rec->fence);
+                    if(rec->staging) 
+                    {
+                        glDeleteBuffers(1, &rec->staging);
+                        state::current().forget_buffer(rec->staging);
+                    }
+                    if(rec->texture_id) 
+                    {
+                        glDeleteTextures(1, &rec->texture_id);
+                        state::current().forget_texture(rec->texture_id);
+                    }
+                }
+                for(staging_buffer& buffer : _free_staging) 
+                {
+                    glDeleteBuffers(1, &buffer.id);
+                    state::current().forget_buffer(buffer.id);
+                }
+            }
+        };
+    }; // namespace streaming
+    }; // namespace texture
+    #endif
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,365 @@
+/**
+ * This header contains the thread pool that is shared by the whole engine. (Loading files, decoding images, solving
+ * the physics, etc.)
+ *
+ * The jobs that are submitted to the pool must not call any OpenGL functions as the workers don't have a context.
+ * Use glfw::jobs::shared_pool() rather than creating new pools so that the engine doesn't create more threads
+ * than there are cores.
+*/
+
+#include "./glfw.hpp"
+
+#ifndef _GLFW_THREAD_POOL_DEFINITION_HPP_
+    #define _GLFW_THREAD_POOL_DEFINITION_HPP_
+
+    #include <thread>
+    #include <mutex>
+    #include <condition_variable>
+    #include <functional>
+    #include <future>
+    #include <vector>
+    #include <memory>
+    #include <type_traits>
+    #include <algorithm>
+    #include <atomic>
+    #include <exception>
+
+    _GLFW_START_
+
+    namespace jobs
+    {
+        /**
+         * @brief A fixed number of worker threads that execute the jobs submitted to them.
+         *
+         * Every worker has its own queue. A worker takes the newest job from its own queue first (it is the most
+         * likely to still be in its cache) and steals the oldest job from the queues of the other workers when its
+         * own queue is empty. Jobs that are submitted from a worker go into its own queue, jobs that are submitted
+         * from any other thread are spread over the queues.
+         *
+         * Once the queues have grown large enough, neither enqueue (for jobs small enough to be stored inside of the
+         * std::function) nor parallel_for allocate anything.
+        */
+        class thread_pool
+        {
+        public:
+            using job_type = std::function<void()>;
+
+        private:
+            /** @brief A ring buffer of jobs, so that pushing and popping never allocates once it has grown large enough. */
+            struct worker_queue
+            {
+                std::mutex lock;
+                /** @brief Room for the helpers that a burst of parallel_fors leaves behind while the workers are busy. */
+                std::vector<job_type> jobs = std::vector<job_type>(256);
+                size_t head = 0;
+                size_t count = 0;
+
+                void push_back(job_type&& job)
+                {
+                    if(count == jobs.size())
+                    {
+                        std::vector<job_type> larger(std::max<size_t>(jobs.size() * 2, 16));
+                        for(size_t i = 0; i < count; i++) larger[i] = std::move(jobs[(head + i) % jobs.size()]);
+                        jobs.swap(larger);
+                        head = 0;
+                    }
+                    jobs[(head + count++) % jobs.size()] = std::move(job);
+                }
+                void pop_back(job_type& job) { job = std::move(jobs[(head + --count) % jobs.size()]); }
+                void pop_front(job_type& job)
+                {
+                    job = std::move(jobs[head]);
+                    head = (head + 1) % jobs.size();
+                    count--;
+                }
+            };
+
+            /**
+             * @brief What the chunks of a parallel_for share. They are recycled, and the jobs only capture a pointer to
+             * one (and its epoch) so that the std::function of the job doesn't allocate either.
+            */
+            struct parallel_state
+            {
+                std::atomic<size_t> next { 0 };
+                std::atomic<size_t> done { 0 };
+                /**
+                 * @brief The number of parallel_fors that used the state. A helper that only starts once its range has
+                 * finished (ex; all the workers were busy) sees a newer epoch and leaves without touching the state,
+                 * hence the state is put back as soon as its range is done rather than when the last helper has run.
+                */
+                std::atomic<uint64_t> epoch { 0 };
+                /** @brief The helpers that are running chunks of the current epoch. */
+                std::atomic<size_t> entered { 0 };
+                std::mutex lock;
+                std::exception_ptr error;
+
+                size_t begin = 0, end = 0, grain = 0, chunks = 0;
+                void* body = nullptr;
+                void (*invoke)(void* body, size_t chunk_begin, size_t chunk_end) = nullptr;
+                parallel_state* next_free = nullptr;
+            };
+
+            std::vector<std::thread> _workers;
+            std::vector<std::unique_ptr<worker_queue>> _queues;
+
+            /** @brief The number of jobs in all the queues. */
+            std::atomic<size_t> _queued { 0 };
+            /** @brief The number of jobs that have been submitted but haven't finished yet. */
+            std::atomic<size_t> _unfinished { 0 };
+            std::atomic<size_t> _next_queue { 0 };
+
+            std::mutex _state_lock;
+            std::vector<std::unique_ptr<parallel_state>> _states;
+            parallel_state* _free_states = nullptr;
+
+            std::mutex _sleep_lock;
+            std::condition_variable _job_available;
+            std::condition_variable _idle;
+            bool _stopping = false;
+
+            /** @brief The pool that the calling thread is a worker of, and its index in that pool. */
+            static inline thread_local thread_pool* __current_pool = nullptr;
+            static inline thread_local size_t __current_index = 0;
+
+            /** @brief Takes a job from the queue of the worker, or steals one from the other queues. */
+            bool try_pop(size_t index, job_type& job)
+            {
+                size_t count = _queues.size();
+                for(size_t i = 0; i < count; i++)
+                {
+                    worker_queue& queue = *_queues[(index + i) % count];
+                    std::lock_guard<std::mutex> guard(queue.lock);
+                    if(!queue.count) continue;
+
+                    if(!i) queue.pop_back(job);
+                    else queue.pop_front(job);
+                    _queued--;
+                    return true;
+                }
+                return false;
+            }
+
+            void finish_job()
+            {
+                if(--_unfinished == 0)
+                {
+                    std::lock_guard<std::mutex> guard(_sleep_lock);
+                    _idle.notify_all();
+                }
+            }
+
+            parallel_state* acquire_state()
+            {
+                std::lock_guard<std::mutex> guard(_state_lock);
+                if(!_free_states)
+                {
+                    _states.push_back(std::make_unique<parallel_state>());
+                    return _states.back().get();
+                }
+                parallel_state* state = _free_states;
+                _free_states = state->next_free;
+                return state;
+            }
+
+            /** @brief Puts the state back once every chunk has finished. Waits for the helpers that are still inside. */
+            void release_state(parallel_state* state)
+            {
+                // Either a helper sees the new epoch, or this sees that it entered.
+                state->epoch++;
+                while(state->entered.load()) std::this_thread::yield();
+
+                state->error = nullptr;
+                std::lock_guard<std::mutex> guard(_state_lock);
+                state->next_free = _free_states;
+                _free_states = state;
+            }
+
+            /** @brief What a helper of a parallel_for runs, if its range hasn't finished yet. */
+            static void help(parallel_state* state, uint64_t epoch)
+            {
+                state->entered++;
+                if(state->epoch.load() == epoch) run_chunks(state);
+                state->entered--;
+            }
+
+            static void run_chunks(parallel_state* state)
+            {
+                for(;;)
+                {
+                    size_t chunk = state->next++;
+                    if(chunk >= state->chunks) return;
+
+                    size_t chunk_begin = state->begin + chunk * state->grain;
+                    try { state->invoke(state->body, chunk_begin, std::min(chunk_begin + state->grain, state->end)); }
+                    catch(...)
+                    {
+                        std::lock_guard<std::mutex> guard(state->lock);
+                        if(!state->error) state->error = std::current_exception();
+                    }
+                    state->done++;
+                }
+            }
+
+            void worker_func(size_t index)
+            {
+                __current_pool = this;
+                __current_index = index;
+
+                for(;;)
+                {
+                    job_type job;
+                    if(try_pop(index, job))
+                    {
+                        job();
+                        finish_job();
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> guard(_sleep_lock);
+                    _job_available.wait(guard, [this] { return _stopping || _queued.load(); });
+                    if(_stopping && !_queued.load()) return;
+                }
+            }
+
+        public:
+            /**
+             * @brief Creates the pool and starts the workers.
+             * @param threads? The number of workers. By default it is one less than the number of cores, so that the
+             * thread that owns the context has a core for itself.
+            */
+            explicit thread_pool(size_t threads = std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1)
+            {
+                if(!threads) threads = 1;
+                _queues.reserve(threads);
+                for(size_t i = 0; i < threads; i++) _queues.push_back(std::make_unique<worker_queue>());
+
+                _workers.reserve(threads);
+                for(size_t i = 0; i < threads; i++) _workers.emplace_back(&thread_pool::worker_func, this, i);
+            }
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+            /** @brief Returns the number of workers. */
+            size_t size() const noexcept(true) { return _workers.size(); }
+
+            /** @brief Whether or not the calling thread is one of the workers of this pool. */
+            bool is_worker_thread() const noexcept(true) { return __current_pool == this; }
+            /** @brief Returns the index of the calling worker, or size() if the calling thread isn't a worker of this pool. */
+            size_t worker_index() const noexcept(true) { return is_worker_thread() ? __current_index : size(); }
+
+            /** @brief Adds a job to the pool without a way to wait for it. */
+            void enqueue(job_type job)
+            {
+                size_t index = is_worker_thread() ? __current_index : _next_queue++ % _queues.size();
+
+                _unfinished++;
+                {
+                    std::lock_guard<std::mutex> guard(_queues[index]->lock);
+                    _queues[index]->push_back(std::move(job));
+                    _queued++;
+                }
+                {
+                    // Taking the lock makes sure that a worker that is about to sleep sees the job.
+                    std::lock_guard<std::mutex> guard(_sleep_lock);
+                }
+                _job_available.notify_one();
+            }
+
+            /**
+             * @brief Adds a job to the pool.
+             * @param fn The job. Anything that can be called without any parameters.
+             * @returns A future that will contain the result of the job (or the exception that it threw).
+            */
+            template <typename Fn>
+            auto submit(Fn&& fn) -> std::future<std::invoke_result_t<std::decay_t<Fn>>>
+            {
+                using result_type = std::invoke_result_t<std::decay_t<Fn>>;
+
+                // std::function must be copyable, hence the shared_ptr.
+                auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<Fn>(fn));
+                std::future<result_type> result = task->get_future();
+                enqueue([task] { (*task)(); });
+                return result;
+            }
+
+            /**
+             * @brief Splits the range into chunks and runs them on the workers and the calling thread, then waits for
+             * all of them. The calling thread only ever runs chunks of this range, never any other job, and it can be
+             * one of the workers. (ex; a parallel_for inside of a job)
+             * @param begin The first index.
+             * @param end One past the last index.
+             * @param grain The number of indices per chunk. 0 picks it so that there are about 4 chunks per thread.
+             * @param fn Called as void(size_t chunk_begin, size_t chunk_end) for every chunk. If it throws, the first
+             * exception is rethrown once every chunk has finished.
+            */
+            template <typename Fn>
+            void parallel_for(size_t begin, size_t end, size_t grain, Fn&& fn)
+            {
+                if(end <= begin) return;
+                size_t count = end - begin;
+                if(!grain) grain = std::max<size_t>(1, count / (4 * (size() + 1)));
+
+                size_t chunks = (count + grain - 1) / grain;
+                if(chunks == 1)
+                {
+                    fn(begin, end);
+                    return;
+                }
+
+                using body_type = std::remove_reference_t<Fn>;
+
+                // The helpers may only start after every chunk has finished, then they leave without a chunk; they
+                // never touch fn (which lives on this stack) unless they get one. (see: parallel_state::epoch)
+                size_t helpers = std::min(size(), chunks - 1);
+                parallel_state* state = acquire_state();
+                uint64_t epoch = state->epoch.load();
+                state->next = 0;
+                state->done = 0;
+                state->begin = begin;
+                state->end = end;
+                state->grain = grain;
+                state->chunks = chunks;
+                state->body = const_cast<void*>(static_cast<const void*>(&fn));
+                state->invoke = [](void* body, size_t chunk_begin, size_t chunk_end) { (*static_cast<body_type*>(body))(chunk_begin, chunk_end); };
+
+                for(size_t i = 0; i < helpers; i++) enqueue([state, epoch] { help(state, epoch); });
+
+                run_chunks(state);
+                while(state->done.load() < chunks) std::this_thread::yield();
+
+                std::exception_ptr error = state->error;
+                release_state(state);
+                if(error) std::rethrow_exception(error);
+            }
+
+            /** @brief Blocks until every job that has been submitted so far has finished. Must not be called from a worker. */
+            void wait_idle()
+            {
+                std::unique_lock<std::mutex> guard(_sleep_lock);
+                _idle.wait(guard, [this] { return !_unfinished.load(); });
+            }
+
+            /** @brief Finishes the jobs that are left and then stops the workers. */
+            ~thread_pool() noexcept(true)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_sleep_lock);
+                    _stopping = true;
+                }
+                _job_available.notify_all();
+                for(std::thread& worker : _workers) worker.join();
+            }
+        };
+
+        /** @brief Returns the pool that is shared by the whole engine. It is created when it is first used. */
+        thread_pool& shared_pool()
+        {
+            static thread_pool pool;
+            return pool;
+        }
+    }; // namespace jobs
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
@@ -1,50 +1,173 @@
-/**
- * Please try to keep this file independent of any other files in this project.
-*/
-
-#ifndef _GLFW_TIME_DEFINITION_HPP_
-    #define _GLFW_TIME_DEFINITION_HPP_
-
-    #include "glfw.hpp"
-
-    #include "string"
-    #include "thread"
-
-    #include "ctime"
-    #include "algorithm"
-
-    _GLFW_START_
-
-    namespace time
-    {
-        /** @brief The quantity that measures the time taken for the previous frame to finish
-         * rendering. This quantity is measured in (seconds).
-        */
-        long double deltaTime = .0L;
-
-        
-        /** @brief Returns the current time in seconds. */
-        long double now() noexcept(true)
-        {
-            return std::chrono::high_resolution_clock::now().time_since_epoch().count() / std::chrono::nanoseconds::period::den;
-        }
-
-        /**
-         * @brief Halts the execution of the current thread for the specified amount of time.
-         * @param sec The amount of time to sleep in seconds.
-        */
-        void sleep(long double sec) noexcept(true)
-        {   
-            std::this_thread::sleep_for(
-                std::chrono::nanoseconds(
-                    static_cast<uint64_t>(
-                        sec * std::chrono::nanoseconds::period::den
-                    )
-                )
-            );
-        }
-    }
-
-    _GLFW_END_
-
+/**
+ * Please try to keep this file independent of any other files in this project.
+*/
+
+#ifndef _GLFW_TIME_DEFINITION_HPP_
+    #define _GLFW_TIME_DEFINITION_HPP_
+
+    #include "glfw.hpp"
+
+    #include "string"
+    #include "thread"
+
+    #include "ctime"
+    #include "chrono"
+    #include "algorithm"
+    #include "cstdint"
+
+    _GLFW_START_
+
+    namespace time
+    {
+        /** @brief The quantity that measures the time taken for the previous frame to finish
+         * rendering. This quantity is measured in (seconds).
+        */
+        long double deltaTime = .0L;
+
+        
+        /** @brief The clock used for all the measurements. It is monotonic i.e. it never goes back in time. */
+        using clock = std::chrono::steady_clock;
+
+        /** @brief Returns the current time in nanoseconds. The point from where the time is measured is unspecified 
+         * hence, it should only be used for measuring durations. */
+        uint64_t now_ns() noexcept(true)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+        }
+
+        /** @brief Returns the current time in seconds (with nanosecond resolution). The point from where the time is 
+         * measured is unspecified hence, it should only be used for measuring durations. */
+        long double now() noexcept(true)
+        {
+            return static_cast<long double>(now_ns()) / std::chrono::nanoseconds::period::den;
+        }
+
+        /**
+         * @brief Halts the execution of the current thread for the specified amount of time.
+         * @param sec The amount of time to sleep in seconds.
+        */
+        void sleep(long double sec) noexcept(true)
+        {   
+            std::this_thread::sleep_for(
+                std::chrono::nanoseconds(
+                    static_cast<uint64_t>(
+                        sec * std::chrono::nanoseconds::period::den
+                    )
+                )
+            );
+        }
+
+        /** @brief Measures the time that has passed since it was started. */
+        class timer
+        {
+        private:
+            uint64_t _start = now_ns();
+
+        public:
+            /** @brief Starts (or restarts) the timer. The timer is started when it is created. */
+            void start() noexcept(true) { _start = now_ns(); }
+
+            /** @brief Returns the time(in nanoseconds) that has passed since the timer was started. */
+            uint64_t elapsed_ns() const noexcept(true) { return now_ns() - _start; }
+            /** @brief Returns the time(in seconds) that has passed since the timer was started. */
+            long double elapsed() const noexcept(true) 
+            { 
+                return static_cast<long double>(elapsed_ns()) / std::chrono::nanoseconds::period::den; 
+            }
+
+            /** @brief Returns the time(in nanoseconds) that has passed since the timer was started and restarts it. */
+            uint64_t lap_ns() noexcept(true)
+            {
+                uint64_t current = now_ns();
+                uint64_t elapsed = current - _start;
+                _start = current;
+                return elapsed;
+            }
+        };
+
+        /** @brief A summary of the frame times recorded by a frame_time_histogram. All times are in seconds. */
+        struct frame_time_stats
+        {
+            long double min = .0L;
+            long double avg = .0L;
+            long double p50 = .0L;
+            long double p99 = .0L;
+            long double max = .0L;
+            /** @brief The number of frames that the summary was made from. */
+            size_t count = 0;
+        };
+
+        /**
+         * @brief Keeps track of the durations of the last @c N frames. Adding a frame is O(1) so that it can be 
+         * done every frame, the summary (see: stats) is only computed when it is asked for.
+         * @tparam N The number of frames to keep track of.
+        */
+        template <size_t N = 256>
+        class frame_time_histogram
+        {
+        private:
+            uint64_t _samples[N] = {};
+            size_t _next = 0;
+            size_t _count = 0;
+            uint64_t _sum = 0;
+
+            static long double to_seconds(uint64_t ns) 
+            { 
+                return static_cast<long double>(ns) / std::chrono::nanoseconds::period::den; 
+            }
+
+        public:
+            /** @brief Records the duration of a frame. The oldest frame is forgotten once @c N frames have been recorded. */
+            void add_ns(uint64_t frame_time) noexcept(true)
+            {
+                if(_count == N) _sum -= _samples[_next];
+                else _count++;
+
+                _samples[_next] = frame_time;
+                _sum += frame_time;
+                _next = (_next + 1) % N;
+            }
+            /** @brief Records the duration(in seconds) of a frame. */
+            void add(long double frame_time) noexcept(true)
+            {
+                add_ns(static_cast<uint64_t>(frame_time * std::chrono::nanoseconds::period::den));
+            }
+
+            /** @brief Forgets all the frames that have been recorded. */
+            void clear() noexcept(true) { _next = _count = 0; _sum = 0; }
+
+            /** @brief Returns the number of frames that are currently recorded. Range:[0,N] */
+            size_t size() const noexcept(true) { return _count; }
+
+            /** @brief Returns the duration(in seconds) of the most recently recorded frame. */
+            long double last() const noexcept(true) { return _count ? to_seconds(_samples[(_next + N - 1) % N]) : .0L; }
+
+            /** @brief Computes the summary (min/avg/p50/p99/max) of the recorded frames. */
+            frame_time_stats stats() const
+            {
+                frame_time_stats result;
+                if(!_count) return result;
+
+                uint64_t sorted[N];
+                std::copy(_samples, _samples + _count, sorted);
+                std::sort(sorted, sorted + _count);
+
+                auto percentile = [&](size_t p) { return to_seconds(sorted[(_count - 1) * p / 100]); };
+
+                result.min = to_seconds(sorted[0]);
+                result.max = to_seconds(sorted[_count - 1]);
+                result.avg = to_seconds(_sum) / _count;
+                result.p50 = percentile(50);
+                result.p99 = percentile(99);
+                result.count = _count;
+                return result;
+            }
+        };
+
+        /** @brief The frame times recorded by the frame loop. (see: frame_loop.hpp) */
+        frame_time_histogram<> frame_times;
+    }
+
+    _GLFW_END_
+
 #endif
\ No newline at end of file
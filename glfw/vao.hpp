@@ -1,81 +1,179 @@
-#ifndef _GLFW_VERTEX_ARRAY_OBJECT_DEFINITION_HPP_
-    #define _GLFW_VERTEX_ARRAY_OBJECT_DEFINITION_HPP_
-
-    #include "./glfw.hpp"
-
-
-    _GLFW_START_
-
-        class buffer_object; // Opaque definition
-
-        class vertex_array_object
-        {
-        public:
-            /// @brief The id of the array object. It is used for referencing and identifying this specific array object. (It is unique!)
-            GLuint array_id;
-
-            /// @brief Finds an unused and unique id for this buffer object.
-            void find_free_id() { glGenVertexArrays(1, &array_id); }
-
-            /// @brief Binds the array object and makes it the current active one. This also binds all the buffers assigned to this vertex array object.
-            void bind() { glBindVertexArray(array_id); }
-
-            #ifdef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
-                /// @brief Binds the buffer to the vertex array object. This only has to be called once per buffer object.
-                /// @param buffer A reference to the buffer object. (State will be modified)
-                void bind_buffer(buffer_object& buffer)
-                {
-                    buffer.bind();
-                }
-            #endif
-
-            /// @brief Unbinds the array object.
-            static void unbind() { glBindVertexArray(0); }
-            
-            /** 
-             * @brief Creates an attribute pointer that tells opengl what this piece of data does. Attributes 
-             * are disabled by default.
-             * @param index The index of the attribute.
-             * @param count The number of elements in the attribute. [1<=count<=4]
-             * @param type The type of the data in the attribute. ex; float, uint, etc.
-             * @param normalized Whether or not to convert to fixed point values.
-             * @param size The total size(in bytes) of the attribute. (Or in other words the distance between any 
-             * two attributes.)
-             * @param offset The offset of the attribute compared to the data.  
-            */
-            void create_attribute(GLuint index, GLint count, GLenum type, bool normalized, size_t size, const void* offset)
-            {
-                glVertexAttribPointer(index, count, type, normalized, size, offset);
-            }
-
-            /// @brief Enables the specified attribute.
-            /// @param index The same index supplied during a call to "create_attribute".
-            void enable_attribute(GLuint index) { glEnableVertexAttribArray(index); }
-            /// @brief Disables the specified attribute.
-            /// @param index The same index supplied during a call to "create_attribute".
-            void disable_attribute(GLuint index) { glDisableVertexAttribArray(index); }
-
-            /**
-             * @brief Draws the specified type of elements using the vertices(from a bounded buffer object) and
-             * using the order provided by the index buffer object.
-             * @param type The type of figure to draw. ex; point, line, triangle, etc.
-             * @param number_of_elements The number of indices in the array .
-             * @param type_of_indices The type of the data in the indices array. i.e. uint, int, ubyte, etc.
-             * @param offset? If no IBO has been bound to the VAO then the location to where the IBO is present 
-             *  will be required, if otherwise then specify the offset of indices for this render. 
-            */
-            void draw_elements(GLenum type, GLsizei number_of_elements, GLenum type_of_indices, const void* offset=0)
-            {
-                glDrawElements(type, number_of_elements, type_of_indices, offset);
-            }
-
-            /// @brief Deletes the array object after this instance of the class goes out of scope or is deleted. Hence, it is better to heap allocate instances of this class.
-            ~vertex_array_object() noexcept(true) { glDeleteVertexArrays(1, &array_id); }
-        };
-
-        /// @brief Shorthand name for vertex buffer objects.
-        using __vao = vertex_array_object;
-
-    _GLFW_END_
-
+#ifndef _GLFW_VERTEX_ARRAY_OBJECT_DEFINITION_HPP_
+    #define _GLFW_VERTEX_ARRAY_OBJECT_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+    #include "./profiler.hpp"
+    #include "./state_cache.hpp"
+    #include "./error.hpp"
+
+
+    _GLFW_START_
+
+        class buffer_object; // Opaque definition
+
+        /**
+         * @brief The layout of a single command in an indirect draw buffer (GL_DRAW_INDIRECT_BUFFER). It is read 
+         * by the GPU hence, the order and the size of the members must not be changed.
+        */
+        struct draw_elements_indirect_command
+        {
+            /// @brief The number of indices to draw.
+            GLuint count;
+            /// @brief The number of instances to draw.
+            GLuint instance_count;
+            /// @brief The index of first index (not in bytes) in the index buffer.
+            GLuint first_index;
+            /// @brief A constant that is added to every index.
+            GLint base_vertex;
+            /// @brief The instance from where the per-instance attributes start.
+            GLuint base_instance;
+        };
+
+        class vertex_array_object
+        {
+        public:
+            /// @brief The id of the array object. It is used for referencing and identifying this specific array object. (It is unique!)
+            GLuint array_id;
+
+            /// @brief Finds an unused and unique id for this buffer object.
+            void find_free_id() { glGenVertexArrays(1, &array_id); }
+
+            /// @brief Binds the array object and makes it the current active one. This also binds all the buffers assigned to this vertex array object.
+            void bind() { state::current().bind_vertex_array(array_id); }
+
+            #ifdef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
+                /// @brief Binds the buffer to the vertex array object. This only has to be called once per buffer object.
+                /// @param buffer A reference to the buffer object. (State will be modified)
+                void bind_buffer(buffer_object& buffer)
+                {
+                    buffer.bind();
+                }
+            #endif
+
+            /// @brief Unbinds the array object.
+            static void unbind() { state::current().bind_vertex_array(0); }
+            
+            /** 
+             * @brief Creates an attribute pointer that tells opengl what this piece of data does. Attributes 
+             * are disabled by default.
+             * @param index The index of the attribute.
+             * @param count The number of elements in the attribute. [1<=count<=4]
+             * @param type The type of the data in the attribute. ex; float, uint, etc.
+             * @param normalized Whether or not to convert to fixed point values.
+             * @param size The total size(in bytes) of the attribute. (Or in other words the distance between any 
+             * two attributes.)
+             * @param offset The offset of the attribute compared to the data.  
+            */
+            void create_attribute(GLuint index, GLint count, GLenum type, bool normalized, size_t size, const void* offset)
+            {
+                glVertexAttribPointer(index, count, type, normalized, size, offset);
+            }
+
+            /**
+             * @brief Creates an attribute that is read as integers, without being converted to floats. 
+             * (ex; the layer of a texture atlas, see: texture_array.hpp)
+             * @param index The index of the attribute. (layout(location = index) in uint ...)
+             * @param count The number of components. [1,4]
+             * @param type The type of the data in the attribute. ex; GL_UNSIGNED_INT
+             * @param size The total size(in bytes) of the attribute. 
+             * @param offset The offset of the attribute compared to the data.  
+            */
+            void create_integer_attribute(GLuint index, GLint count, GLenum type, size_t size, const void* offset)
+            {
+                glVertexAttribIPointer(index, count, type, size, offset);
+            }
+
+            /// @brief Enables the specified attribute.
+            /// @param index The same index supplied during a call to "create_attribute".
+            void enable_attribute(GLuint index) { glEnableVertexAttribArray(index); }
+            /// @brief Disables the specified attribute.
+            /// @param index The same index supplied during a call to "create_attribute".
+            void disable_attribute(GLuint index) { glDisableVertexAttribArray(index); }
+
+            /// @brief Sets the rate at which the attribute advances while drawing instances.
+            /// @param index The same index supplied during a call to "create_attribute".
+            /// @param divisor 0 advances the attribute every vertex, N advances the attribute every N instances.
+            void set_attribute_divisor(GLuint index, GLuint divisor) { glVertexAttribDivisor(index, divisor); }
+
+            /**
+             * @brief Creates a per-instance 4x4 float matrix attribute (ex; the transform of every body). A matrix 
+             * takes up 4 attribute indices, one per column, [index, index+4). The attributes are enabled and advance 
+             * once per instance. The instance buffer has to be bound before calling this function.
+             * @param index The first index out of the four that will be used.
+             * @param size The distance(in bytes) between the matrices of two instances. 
+             * @param offset The offset of the first matrix in the instance buffer.
+            */
+            void create_instance_transform_attribute(GLuint index, size_t size, const void* offset=0)
+            {
+                for(GLuint column = 0; column < 4; column++)
+                {
+                    create_attribute(index+column, 4, GL_FLOAT, false, size, 
+                        static_cast<const char*>(offset) + sizeof(GLfloat)*4*column);
+                    enable_attribute(index+column);
+                    set_attribute_divisor(index+column, 1);
+                }
+            }
+
+            /**
+             * @brief Draws the specified type of elements using the vertices(from a bounded buffer object) and
+             * using the order provided by the index buffer object.
+             * @param type The type of figure to draw. ex; point, line, triangle, etc.
+             * @param number_of_elements The number of indices in the array .
+             * @param type_of_indices The type of the data in the indices array. i.e. uint, int, ubyte, etc.
+             * @param offset? If no IBO has been bound to the VAO then the location to where the IBO is present 
+             *  will be required, if otherwise then specify the offset of indices for this render. 
+            */
+            void draw_elements(GLenum type, GLsizei number_of_elements, GLenum type_of_indices, const void* offset=0)
+            {
+                GLFW_PROFILE_GPU_SCOPE("vertex_array_object::draw_elements");
+                GLFW_CHECK_GL(glDrawElements(type, number_of_elements, type_of_indices, offset));
+            }
+
+            /**
+             * @brief Draws multiple instances of the same elements in a single draw call. Per-instance data is read 
+             * from the attributes that have a divisor. (see: set_attribute_divisor)
+             * @param type The type of figure to draw. ex; point, line, triangle, etc.
+             * @param number_of_elements The number of indices in the array.
+             * @param type_of_indices The type of the data in the indices array. i.e. uint, int, ubyte, etc.
+             * @param number_of_instances The number of instances to draw.
+             * @param offset? The offset of indices for this render.
+             * @param base_instance? The instance from where the per-instance attributes start. When the instance 
+             *  data lives in a streaming_buffer_object, pass region_offset()/sizeof(instance) here instead of 
+             *  re-creating the attributes every frame.
+            */
+            void draw_elements_instanced(GLenum type, GLsizei number_of_elements, GLenum type_of_indices, GLsizei number_of_instances, const void* offset=0, GLuint base_instance=0)
+            {
+                GLFW_PROFILE_GPU_SCOPE("vertex_array_object::draw_elements_instanced");
+                if(base_instance) GLFW_CHECK_GL(glDrawElementsInstancedBaseInstance(type, number_of_elements, type_of_indices, offset, number_of_instances, base_instance));
+                else GLFW_CHECK_GL(glDrawElementsInstanced(type, number_of_elements, type_of_indices, offset, number_of_instances));
+            }
+
+            /**
+             * @brief Issues multiple draws, whose parameters (draw_elements_indirect_command) are read from the 
+             * buffer bound to GL_DRAW_INDIRECT_BUFFER, in a single call. Requires OpenGL 4.3.
+             * @param type The type of figure to draw. ex; point, line, triangle, etc.
+             * @param type_of_indices The type of the data in the indices array. i.e. uint, int, ubyte, etc.
+             * @param number_of_draws The number of commands to read from the indirect buffer.
+             * @param offset? The offset(in bytes) of the first command in the indirect buffer.
+             * @param stride? The distance(in bytes) between two commands. 0 means that they are tightly packed.
+            */
+            void multi_draw_elements_indirect(GLenum type, GLenum type_of_indices, GLsizei number_of_draws, const void* offset=0, GLsizei stride=0)
+            {
+                GLFW_PROFILE_GPU_SCOPE("vertex_array_object::multi_draw_elements_indirect");
+                GLFW_CHECK_GL(glMultiDrawElementsIndirect(type, type_of_indices, offset, number_of_draws, stride));
+            }
+
+            /// @brief Deletes the array object after this instance of the class goes out of scope or is deleted. Hence, it is better to heap allocate instances of this class.
+            ~vertex_array_object() noexcept(true) 
+            { 
+                glDeleteVertexArrays(1, &array_id); 
+                state::current().forget_vertex_array(array_id);
+            }
+        };
+
+        /// @brief Shorthand name for vertex buffer objects.
+        using __vao = vertex_array_object;
+
+    _GLFW_END_
+
 #endif
\ No newline at end of file
@@ -1,85 +1,304 @@
-/**
- * This file contains the definition and implementation of the buffer_object class.
- * 
- * THis class is used to store data about opengl objects. Such as the vertices of the object,
- * the color of the object, the order in which the vertices have to be interpreted, etc.
- * 
- * This class by default ships with two type definitions for the buffer_object class;
- *  typename __vbo,
- *  typename __ibo
- * 
- * They are just defined as follows;
- *  using __vbo = buffer_object;
- *  using __ibo = buffer_object;
- * 
- * THey are just renames of the buffer_object class. Hence, they themselves aren't significant.
- * 
- * Using the above example, you can also rename the buffer_object class.
- * 
- * The texture.hpp file also ships with the __tbo rename of the buffer_object class.
- * 
- * What these names stand for;
- *  - __vbo : Vertex Buffer Object
- *  - __ibo : Index Buffer Object
- *  - __tbo : Texture Buffer Object
- * 
- * Refer to this link for more information about the different types of buffer objects.
- *  @link https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBufferData.xhtml
-*/
-
-#ifndef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
-    #define _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
-
-    #include "./glfw.hpp"
-
-    
-    _GLFW_START_
-    
-    class buffer_object
-    {
-    public:
-        /// @brief The id of the buffer object. It is used for referencing and identifying this specific buffer object. (It is unique!)
-        GLuint buffer_id;
-        /// @brief The type of the buffer object.
-        GLenum buffer_type;
-
-        /// @brief Returns the id of the buffer object.
-        GLuint get_id() const { return buffer_id; }
-        /// @brief Returns the type of the buffer object.
-        GLenum get_type() const { return buffer_type; }
-
-        /// @brief Sets the type of the buffer object.
-        /// @param target The type to set. ex; vertex buffers, index buffers, etc.
-        void set_type(GLenum target) { buffer_type = target; }
-
-        /// @brief Finds an unused and unique id for this buffer object.
-        void find_free_id() { glGenBuffers(1, &buffer_id); }
-
-        /// @brief Binds this buffer to being the active buffer.
-        void bind() { glBindBuffer(buffer_type, buffer_id); }
-        /// @brief Unbinds this buffer from being the active buffer.
-        void unbind() { glBindBuffer(buffer_type, 0); }
-
-        /// @brief Creates the buffer object.
-        /// @tparam T The type of the data. Should be an arithmetic type!
-        /// @param data The data. If it is null, then a buffer with uninitialized data of the specified size will be created.
-        /// @param size The number of elements in the data.
-        /// @param usage How and How much it will be used.
-        template <typename T>
-        void create(const T* data, size_t size, GLenum usage)
-        { 
-            glBufferData(buffer_type, sizeof(T)*size/*byte-sized*/, data, usage); 
-        }
-
-        /// @brief Deletes the buffer after this instance of the class goes out of scope or is deleted. Hence, it is better to heap allocate instances of this class.
-        ~buffer_object() noexcept { glDeleteBuffers(1, &buffer_id); }
-    };
-
-    /// @brief Shorthand name for Vertex Buffer Objects.
-    using __vbo = buffer_object;
-    /// @brief Shorthand name for Index Buffer Objects.
-    using __ibo = buffer_object;
-
-    _GLFW_END_
-
+/**
+ * This file contains the definition and implementation of the buffer_object class.
+ * 
+ * THis class is used to store data about opengl objects. Such as the vertices of the object,
+ * the color of the object, the order in which the vertices have to be interpreted, etc.
+ * 
+ * This class by default ships with two type definitions for the buffer_object class;
+ *  typename __vbo,
+ *  typename __ibo
+ * 
+ * They are just defined as follows;
+ *  using __vbo = buffer_object;
+ *  using __ibo = buffer_object;
+ * 
+ * THey are just renames of the buffer_object class. Hence, they themselves aren't significant.
+ * 
+ * Using the above example, you can also rename the buffer_object class.
+ * 
+ * The texture.hpp file also ships with the __tbo rename of the buffer_object class.
+ * 
+ * What these names stand for;
+ *  - __vbo : Vertex Buffer Object
+ *  - __ibo : Index Buffer Object
+ *  - __tbo : Texture Buffer Object
+ *  - __sbo : Streaming Buffer Object
+ *  - __ssbo : Shader Storage Buffer Object
+ * 
+ * The streaming_buffer_object class is a buffer_object whose storage is persistently mapped and split
+ * into a ring of regions. It is meant for data that changes every frame (ex; the transforms of the 
+ * bodies in the simulation) as it can be written to directly without reallocating the buffer.
+ * 
+ * Any buffer_object can also be bound to an indexed binding point (see: bind_base) so that compute shaders can
+ * read and write it as a shader storage buffer. The same buffer can then be drawn from as a vertex buffer without
+ * the data ever going back to the CPU.
+ * 
+ * Refer to this link for more information about the different types of buffer objects.
+ *  @link https://registry.khronos.org/OpenGL-Refpages/gl4/html/glBufferData.xhtml
+*/
+
+#ifndef _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
+    #define _GLFW_VERTEX_BUFFER_OBJECT_DEFINITION_HPP_
+
+    #include "./glfw.hpp"
+    #include "./state_cache.hpp"
+    #include "./error.hpp"
+
+    #include <cstdio>
+    #include <cstring>
+    #include <type_traits>
+    
+    _GLFW_START_
+    
+    class buffer_object
+    {
+    public:
+        /// @brief The id of the buffer object. It is used for referencing and identifying this specific buffer object. (It is unique!)
+        GLuint buffer_id;
+        /// @brief The type of the buffer object.
+        GLenum buffer_type;
+
+        /// @brief Returns the id of the buffer object.
+        GLuint get_id() const { return buffer_id; }
+        /// @brief Returns the type of the buffer object.
+        GLenum get_type() const { return buffer_type; }
+
+        /// @brief Sets the type of the buffer object.
+        /// @param target The type to set. ex; vertex buffers, index buffers, etc.
+        void set_type(GLenum target) { buffer_type = target; }
+
+        /// @brief Finds an unused and unique id for this buffer object.
+        void find_free_id() { glGenBuffers(1, &buffer_id); }
+
+        /// @brief Binds this buffer to being the active buffer.
+        void bind() { state::current().bind_buffer(buffer_type, buffer_id); }
+        /// @brief Unbinds this buffer from being the active buffer.
+        void unbind() { state::current().bind_buffer(buffer_type, 0); }
+
+        /// @brief Creates the buffer object.
+        /// @tparam T The type of the data. Should be an arithmetic type!
+        /// @param data The data. If it is null, then a buffer with uninitialized data of the specified size will be created.
+        /// @param size The number of elements in the data.
+        /// @param usage How and How much it will be used.
+        template <typename T>
+        void create(const T* data, size_t size, GLenum usage)
+        { 
+            GLFW_CHECK_GL(glBufferData(buffer_type, sizeof(T)*size/*byte-sized*/, data, usage)); 
+        }
+
+        /// @brief Updates a part of the buffer object without reallocating it. The buffer must have been created before.
+        /// @tparam T The type of the data. Should be an arithmetic type!
+        /// @param data The new data.
+        /// @param size The number of elements in the data.
+        /// @param offset? The number of elements to skip from the start of the buffer.
+        template <typename T>
+        void update(const T* data, size_t size, size_t offset=0)
+        {
+            GLFW_CHECK_GL(glBufferSubData(buffer_type, sizeof(T)*offset, sizeof(T)*size, data));
+        }
+
+        /**
+         * @brief Binds the whole buffer to an indexed binding point, without changing its type. 
+         * (see: shader_program::bind_storage_block)
+         * @param binding The binding point.
+         * @param target? The indexed target. GL_SHADER_STORAGE_BUFFER requires OpenGL 4.3.
+        */
+        void bind_base(GLuint binding, GLenum target=GL_SHADER_STORAGE_BUFFER) const 
+        { 
+            state::current().bind_buffer_base(target, binding, buffer_id);
+        }
+
+        /**
+         * @brief Binds a part of the buffer to an indexed binding point, without changing its type.
+         * @param binding The binding point.
+         * @param offset The offset(in bytes) of the part. Should be a multiple of GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT.
+         * @param size The size(in bytes) of the part.
+         * @param target? The indexed target.
+        */
+        void bind_range(GLuint binding, size_t offset, size_t size, GLenum target=GL_SHADER_STORAGE_BUFFER) const
+        {
+            state::current().bind_buffer_range(target, binding, buffer_id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+        }
+
+        /// @brief Deletes the buffer after this instance of the class goes out of scope or is deleted. Hence, it is better to heap allocate instances of this class.
+        ~buffer_object() noexcept 
+        { 
+            glDeleteBuffers(1, &buffer_id); 
+            state::current().forget_buffer(buffer_id);
+        }
+    };
+
+    /**
+     * @brief A buffer object that is meant to be rewritten every frame. Its storage is immutable (glBufferStorage), 
+     * persistently mapped and split into @c region_count regions. The CPU writes into one region while the GPU 
+     * is still reading from the others, a fence is placed after the region has been used so that it wont be 
+     * overwritten before the GPU has finished with it.
+     * 
+     * Usage (every frame);
+     *  T* ptr = buffer.map_region<T>();   // Waits if the GPU is still using this region.
+     *  ... write to ptr ...
+     *  ... draw using buffer.region_offset() as the offset ...
+     *  buffer.fence_region();             // Must be called after the draw calls that use the region.
+     * 
+     * Requires OpenGL 4.4 or ARB_buffer_storage.
+    */
+    class streaming_buffer_object : public buffer_object
+    {
+    public:
+        /// @brief The number of regions in the ring. i.e. Triple buffering.
+        static constexpr size_t region_count = 3;
+
+    private:
+        GLubyte* _mapped = nullptr;
+        size_t _region_size = 0;
+        size_t _region = 0;
+        GLsync _fences[region_count] = {};
+
+        /// @brief Waits until the GPU has finished using the specified region.
+        void wait_for_region(size_t region)
+        {
+            if(!_fences[region]) return;
+
+            GLbitfield flags = 0;
+            GLuint64 timeout = 0;
+            for(;;)
+            {
+                GLenum result = glClientWaitSync(_fences[region], flags, timeout);
+                if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) break;
+
+                // The first wait only polls, after that flush the commands so that the fence will actually be signaled.
+                flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+                timeout = 1000000; // 1ms (in nanoseconds)
+            }
+            glDeleteSync(_fences[region]);
+            _fences[region] = nullptr;
+        }
+
+    public:
+        static constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        /// @brief Creates the storage of the buffer object and maps it. The buffer must be bound before calling this function.
+        /// @tparam T The type of the data.
+        /// @param size The number of elements in a single region.
+        /// @param alignment? The alignment(in bytes) of every region. Should be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT if the buffer is used as a uniform buffer.
+        /// @returns Whether or not the buffer could be mapped. If it couldn't, the buffer has no regions and must not be written to. (see: is_mapped)
+        template <typename T>
+        bool create(size_t size, size_t alignment=256)
+        {
+            _region_size = (sizeof(T)*size + alignment-1) / alignment * alignment;
+            _region = 0;
+
+            GLFW_CHECK_GL(glBufferStorage(buffer_type, _region_size*region_count, nullptr, map_flags));
+            _mapped = static_cast<GLubyte*>(glMapBufferRange(buffer_type, 0, _region_size*region_count, map_flags));
+            if(!_mapped)
+            {
+                fprintf(stderr, "Error mapping a streaming buffer of %zu bytes\n", _region_size*region_count);
+                _region_size = 0;
+                return false;
+            }
+            return true;
+        }
+
+        /// @brief Whether or not the storage of the buffer was created and mapped. (see: create)
+        bool is_mapped() const noexcept(true) { return _mapped != nullptr; }
+
+        /// @brief Returns a pointer to the region that can be written to this frame. Waits if the GPU is still reading from it.
+        /// @tparam T The type of the data.
+        template <typename T>
+        T* map_region()
+        {
+            wait_for_region(_region);
+            return reinterpret_cast<T*>(_mapped + _region*_region_size);
+        }
+
+        /// @brief Copies the data into the current region. It waits if the GPU is still reading from it.
+        /// @tparam T The type of the data.
+        /// @param data The data.
+        /// @param size The number of elements in the data. Should fit inside a single region.
+        template <typename T>
+        void write(const T* data, size_t size)
+        {
+            std::memcpy(map_region<T>(), data, sizeof(T)*size);
+        }
+
+        /// @brief Places a fence after the commands that use the current region and moves on to the next region.
+        void fence_region()
+        {
+            if(_fences[_region]) glDeleteSync(_fences[_region]);
+            _fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            _region = (_region + 1) % region_count;
+        }
+
+        /// @brief Returns the offset(in bytes) of the current region from the start of the buffer.
+        size_t region_offset() const { return _region*_region_size; }
+        /// @brief Returns the size(in bytes) of a single region.
+        size_t region_size() const { return _region_size; }
+        /// @brief Returns the index of the current region. Range:[0,region_count)
+        size_t region_index() const { return _region; }
+
+        /// @brief Deletes the fences. The buffer will be unmapped and deleted by buffer_object.
+        ~streaming_buffer_object() noexcept
+        {
+            for(GLsync& fence : _fences) if(fence) glDeleteSync(fence);
+        }
+    };
+
+    /**
+     * @brief A uniform buffer that mirrors a struct. Every frame the whole struct is written into the persistently mapped
+     * buffer at once, instead of setting each uniform with a separate glUniform* call.
+     * 
+     * The struct must follow the std140 layout of the uniform block in the shader. i.e. vec3 and vec4 members are aligned
+     * to 16 bytes, array elements are padded to 16 bytes, etc. The easiest way is to only use vec4s, mat4s and scalars
+     * packed in groups of 4. Refer to the rules in; @link https://registry.khronos.org/OpenGL/specs/gl/glspec46.core.pdf#page=168
+     * 
+     * Usage (every frame);
+     *  ubo.write(params); // or ubo.map()->member = ...;
+     *  ubo.bind_base(binding);
+     *  ... draw ...
+     *  ubo.fence_region();
+     * 
+     * @tparam T The struct.
+    */
+    template <typename T>
+    class uniform_buffer_object : public streaming_buffer_object
+    {
+        static_assert(sizeof(T) % 16 == 0, "A std140 uniform block is always padded to a multiple of 16 bytes.");
+        static_assert(std::is_trivially_copyable_v<T>, "The struct is copied into the buffer as it is.");
+
+    public:
+        uniform_buffer_object() { set_type(GL_UNIFORM_BUFFER); }
+
+        /// @brief Creates the storage of the buffer. The buffer must be bound before calling this function.
+        /// @returns Whether or not the buffer could be mapped. (see: streaming_buffer_object::create)
+        bool create()
+        {
+            GLint alignment = 256;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            return streaming_buffer_object::create<T>(1, static_cast<size_t>(alignment));
+        }
+
+        /// @brief Returns the struct that will be read by the GPU this frame. Waits if the GPU is still reading from it.
+        T* map() { return map_region<T>(); }
+
+        /// @brief Copies the struct into the buffer.
+        void write(const T& data) { streaming_buffer_object::write<T>(&data, 1); }
+
+        /// @brief Binds the current region of the buffer to the uniform block binding point. (see: shader_program::bind_uniform_block)
+        void bind_base(GLuint binding) const
+        {
+            state::current().bind_buffer_range(GL_UNIFORM_BUFFER, binding, buffer_id, static_cast<GLintptr>(region_offset()), sizeof(T));
+        }
+    };
+
+    /// @brief Shorthand name for Vertex Buffer Objects.
+    using __vbo = buffer_object;
+    /// @brief Shorthand name for Index Buffer Objects.
+    using __ibo = buffer_object;
+    /// @brief Shorthand name for Streaming Buffer Objects.
+    using __sbo = streaming_buffer_object;
+    /// @brief Shorthand name for Shader Storage Buffer Objects.
+    using __ssbo = buffer_object;
+
+    _GLFW_END_
+
 #endif
\ No newline at end of file
@@ -0,0 +1,215 @@
+/**
+ * This header contains the window group; several windows (ex; the main view, a debug view and a telemetry view of the
+ * same simulation) that share a single set of resources. The group creates an invisible window first, every other
+ * window is created sharing its objects. Hence a buffer, a texture or a program is uploaded once (on the resource
+ * context, or by a loader context that shares it, see: loader_context.hpp) and is used by every window.
+ *
+ * Every window has its own render thread (see: command_buffer.hpp), so every window swaps on its own thread with its
+ * own swap interval. The windows whose late frames are dropped (see: add_view) never make the loop wait, if their
+ * render thread is still busy with an older frame they skip the frame instead. A debug window that takes twice as
+ * long as the main view is drawn at half the rate, rather than halving the rate of the main view.
+ *
+ * Every window is recorded in the same frame of the loop with the same interpolation factor, i.e. they all show the
+ * same state of the simulation. (see: fixed_step_loop::frame(render::window_group&))
+ *
+ * Only the objects that hold data are shared. Vertex arrays and framebuffers are not, every window must create its
+ * own; on its context, before the group is started (or by recording a call into its frames afterwards). As the draw
+ * packets refer to a vertex array, a window only replays the packets recorded for it.
+ *
+ * Usage;
+ *  render::window_group group;
+ *  group.create(pool);                              // The resource context is made current.
+ *  glfw::init_glad();
+ *  gl_window* main_view = group.add_view(1280, 720, "Main", 1);
+ *  gl_window* debug_view = group.add_view(640, 480, "Debug", 0, true);
+ *  ... upload the shared objects on the resource context ...
+ *  ... create the vertex arrays on the context of every window ...
+ *  group.start();                                   // The contexts of the windows move to their render threads.
+ *  loop.run(group);
+ *  group.stop();
+*/
+
+#include "./glfw.hpp"
+#include "./glwindow.hpp"
+#include "./profiler.hpp"
+#include "./state_cache.hpp"
+#include "./thread_pool.hpp"
+#include "./command_buffer.hpp"
+
+#ifndef _GLFW_WINDOW_GROUP_DEFINITION_HPP_
+    #define _GLFW_WINDOW_GROUP_DEFINITION_HPP_
+
+    #include <vector>
+    #include <memory>
+    #include <cstdint>
+    #include <cstdio>
+
+    _GLFW_START_
+
+    namespace render
+    {
+        /** @brief Windows that share their resources and render on their own threads. (see: the top of this file) */
+        class window_group
+        {
+        private:
+            struct view
+            {
+                std::unique_ptr<gl_window> window;
+                /** @brief Declared after the window, it must be stopped before the window is destroyed. */
+                std::unique_ptr<render_thread> renderer;
+                bool drop_late_frames = false;
+                uint64_t dropped_frames = 0;
+                /** @brief Whether or not the frame that is being recorded is going to be submitted. */
+                bool recording = false;
+            };
+
+            /** @brief The invisible window whose context owns the shared objects. */
+            gl_window _resources;
+            std::vector<view> _views;
+            jobs::thread_pool* _pool = nullptr;
+            size_t _queue_capacity = 1024;
+            bool _started = false;
+
+        public:
+            window_group() = default;
+            window_group(const window_group&) = delete;
+            window_group& operator=(const window_group&) = delete;
+
+            /**
+             * @brief Creates the resource context and makes it current. glfw::init must have been called, glfw::init_glad
+             * should be called after this.
+             * @param pool The pool whose workers will record the commands of every window.
+             * @param queue_capacity? The number of packets that fit without growing the render queue of a window.
+             * @returns false if the context couldn't be created.
+            */
+            bool create(jobs::thread_pool& pool, size_t queue_capacity=1024)
+            {
+                _pool = &pool;
+                _queue_capacity = queue_capacity;
+                if(!_resources.create_headless())
+                {
+                    fprintf(stderr, "Error creating the resource context of a window group\n");
+                    return false;
+                }
+                _resources.make_context_current();
+                return true;
+            }
+
+            /**
+             * @brief Creates a window that shares the objects of the resource context. Must be called before start, on
+             * the main thread. The hints that have been set are used. (see: gl_window::set_hint)
+             * @param width The width of the window.
+             * @param height The height of the window.
+             * @param title The title of the window.
+             * @param swap_interval? The number of screen updates that a swap of this window waits for. 0 turns vsync off.
+             * @param drop_late_frames? Whether the loop skips this window when it is behind (true), or waits for it (false).
+             * The main view should wait, otherwise it would be the one that gets skipped.
+             * @param monitor? The monitor for fullscreen, NULL for windowed mode.
+             * @returns The window, nullptr if it couldn't be created. It belongs to the group. The first window of the
+             * group is the main view; the loop stops once it is closed.
+            */
+            gl_window* add_view(int width, int height, const char* title, int swap_interval=1, bool drop_late_frames=false, GLFWmonitor* monitor=NULL)
+            {
+                if(_started) return nullptr;
+
+                view v;
+                v.window = std::make_unique<gl_window>();
+                v.window->create(width, height, title, monitor, _resources.context);
+                if(!v.window->context)
+                {
+                    fprintf(stderr, "Error creating the window \"%s\"\n", title);
+                    return nullptr;
+                }
+                v.renderer = std::make_unique<render_thread>(*v.window, *_pool, _queue_capacity);
+                v.renderer->set_swap_interval(swap_interval);
+                v.drop_late_frames = drop_late_frames;
+
+                _views.push_back(std::move(v));
+                return _views.back().window.get();
+            }
+
+            /**
+             * @brief Moves the context of every window over to its render thread. The resource context is made current
+             * on the calling thread again. Waits for the uploads so far, the windows might use them right away.
+            */
+            void start()
+            {
+                if(_started) return;
+                _resources.make_context_current();
+                glFinish();
+
+                for(view& v : _views)
+                {
+                    v.window->make_context_current();
+                    v.renderer->start();
+                }
+                _resources.make_context_current();
+                _started = true;
+            }
+
+            /** @brief Replays the frames that have been submitted and stops every render thread. */
+            void stop()
+            {
+                if(!_started) return;
+                for(view& v : _views) v.renderer->stop();
+                _started = false;
+            }
+
+            bool started() const noexcept(true) { return _started; }
+
+            /**
+             * @brief Begins the frame of every window. The windows that drop their late frames and are still busy are
+             * skipped. (see: is_recording)
+            */
+            void begin_frame()
+            {
+                GLFW_PROFILE_SCOPE("window_group::begin_frame");
+                for(view& v : _views)
+                {
+                    if(!v.drop_late_frames)
+                    {
+                        v.renderer->begin_frame();
+                        v.recording = true;
+                    }
+                    else if(!(v.recording = v.renderer->try_begin_frame() != nullptr)) v.dropped_frames++;
+                }
+            }
+
+            /** @brief Submits the frame of every window that is recording one. */
+            void submit()
+            {
+                for(view& v : _views)
+                {
+                    if(v.recording) v.renderer->submit();
+                    v.recording = false;
+                }
+            }
+
+            /** @brief Waits until every window has replayed every frame that has been submitted. */
+            void wait_idle()
+            {
+                for(view& v : _views) v.renderer->wait_idle();
+            }
+
+            /** @brief Whether or not the window is recording this frame. Only valid between begin_frame and submit. */
+            bool is_recording(size_t index) const { return _views[index].recording; }
+            /** @brief Returns the number of frames that the window skipped as it was behind. */
+            uint64_t dropped_frames(size_t index) const { return _views[index].dropped_frames; }
+
+            size_t view_count() const noexcept(true) { return _views.size(); }
+            gl_window& window(size_t index) { return *_views[index].window; }
+            render_thread& renderer(size_t index) { return *_views[index].renderer; }
+            /** @brief Returns the invisible window whose context owns the shared objects. (ex; to share it with a loader context) */
+            gl_window& resources() noexcept(true) { return _resources; }
+
+            /** @brief Whether or not the main view (the first window) has recieved a close event. */
+            bool should_close() { return _views.empty() || _views[0].window->event_listener.should_close(); }
+
+            /** @brief Stops the render threads, then the windows are destroyed. */
+            ~window_group() noexcept(true) { stop(); }
+        };
+    }; // namespace render
+
+    _GLFW_END_
+
+#endif
\ No newline at end of file
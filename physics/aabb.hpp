@@ -0,0 +1,114 @@
+/**
+ * This header contains the axis-aligned bounding boxes and how they are computed for the bodies.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+
+#ifndef _PHYSICS_AABB_DEFINITION_HPP_
+    #define _PHYSICS_AABB_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cmath>
+
+    _PHYSICS_START_
+
+    /** @brief An axis-aligned bounding box. */
+    struct aabb
+    {
+        glm::vec3 min = glm::vec3(0.0f);
+        glm::vec3 max = glm::vec3(0.0f);
+
+        /** @brief Whether or not the two boxes overlap. Touching boxes are considered to overlap. */
+        bool overlaps(const aabb& other) const noexcept(true)
+        {
+            return min.x <= other.max.x && max.x >= other.min.x
+                && min.y <= other.max.y && max.y >= other.min.y
+                && min.z <= other.max.z && max.z >= other.min.z;
+        }
+
+        /** @brief Whether or not the other box is completely inside of this box. */
+        bool contains(const aabb& other) const noexcept(true)
+        {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+                && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+        }
+
+        glm::vec3 center() const noexcept(true) { return (min + max) * 0.5f; }
+        glm::vec3 size() const noexcept(true) { return max - min; }
+
+        /** @brief Half of the surface area. This is what the surface area heuristic compares. */
+        float half_area() const noexcept(true)
+        {
+            glm::vec3 d = max - min;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        }
+
+        /** @brief Returns the box that contains both boxes. */
+        static aabb merge(const aabb& a, const aabb& b) noexcept(true)
+        {
+            aabb result;
+            result.min = glm::vec3(std::fmin(a.min.x, b.min.x), std::fmin(a.min.y, b.min.y), std::fmin(a.min.z, b.min.z));
+            result.max = glm::vec3(std::fmax(a.max.x, b.max.x), std::fmax(a.max.y, b.max.y), std::fmax(a.max.z, b.max.z));
+            return result;
+        }
+
+        /** @brief Returns the box grown by @c margin in every direction. */
+        aabb expanded(float margin) const noexcept(true)
+        {
+            aabb result;
+            result.min = min - glm::vec3(margin);
+            result.max = max + glm::vec3(margin);
+            return result;
+        }
+    };
+
+    /** @brief Computes the world space bounding box of the body at the index. */
+    aabb compute_bounds(const body_store& bodies, size_t i)
+    {
+        glm::vec3 center = bodies.position.get(i);
+        const shape& s = bodies.shapes[i];
+
+        glm::vec3 extent;
+        if(s.type == shape_type::SPHERE) extent = glm::vec3(s.radius);
+        else
+        {
+            // The extent of a rotated box along an axis is the sum of its half extents projected onto that axis. i.e. |R| * h
+            glm::mat3 r = glm::mat3_cast(bodies.orientation.get(i));
+            if(s.type == shape_type::BOX || s.type == shape_type::CONVEX)
+            {
+                // A hull is bounded by the box around its points.
+                glm::vec3 h = s.local_half_extents();
+                extent = glm::vec3(
+                    std::fabs(r[0][0]) * h.x + std::fabs(r[1][0]) * h.y + std::fabs(r[2][0]) * h.z,
+                    std::fabs(r[0][1]) * h.x + std::fabs(r[1][1]) * h.y + std::fabs(r[2][1]) * h.z,
+                    std::fabs(r[0][2]) * h.x + std::fabs(r[1][2]) * h.y + std::fabs(r[2][2]) * h.z);
+            }
+            else
+            {
+                // A capsule is the segment along the local y-axis grown by the radius.
+                float h = s.half_extents.y;
+                extent = glm::vec3(std::fabs(r[1][0]) * h, std::fabs(r[1][1]) * h, std::fabs(r[1][2]) * h) + glm::vec3(s.radius);
+            }
+        }
+
+        aabb box;
+        box.min = center - extent;
+        box.max = center + extent;
+        return box;
+    }
+
+    /**
+     * @brief Computes the world space bounding box of every body, in the order of their indices.
+     * @param bodies A reference to the bodies.
+     * @param bounds Where to write the boxes. It is resized to bodies.size().
+    */
+    void compute_bounds(const body_store& bodies, std::vector<aabb>& bounds)
+    {
+        bounds.resize(bodies.size());
+        for(size_t i = 0; i < bodies.size(); i++) bounds[i] = compute_bounds(bodies, i);
+    }
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,591 @@
+/**
+ * This header contains the dynamic bounding volume tree. It is a binary tree of axis-aligned boxes whose leaves are
+ * the boxes of the bodies (the proxies) and whose every other node contains the boxes of its two children.
+ *
+ * The nodes are stored in a flat pool and refer to each other with int32 indices, nodes that are freed are reused.
+ * The box of a leaf is fattened by a margin (and by the displacement of the body, when it is known) so that a body
+ * which moves only a little doesn't have to be re-inserted every step.
+ *
+ * A leaf is inserted next to the sibling that increases the surface area of the tree the least (the surface area
+ * heuristic), afterwards the ancestors are rotated whenever swapping two of their grandchildren reduces the area.
+ * For trees that rarely change (ex; the static geometry of a level) rebuild() builds the whole tree from scratch
+ * with a binned SAH, which gives faster queries than any sequence of insertions.
+ *
+ * None of the queries allocate. (Unless the tree is deeper than query_stack_capacity, which it never should be)
+*/
+
+#include "./physics.hpp"
+#include "./aabb.hpp"
+
+#ifndef _PHYSICS_AABB_TREE_DEFINITION_HPP_
+    #define _PHYSICS_AABB_TREE_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cmath>
+    #include <limits>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /** @brief The index of a node in the pool of a tree. */
+    using node_index = int32_t;
+    /** @brief Represents the index of no node. */
+    constexpr node_index null_node = -1;
+
+    /** @brief The number of nodes that the queries can keep on their stack before they have to allocate. */
+    constexpr size_t query_stack_capacity = 256;
+
+    /** @brief The stack of nodes that a query still has to visit. */
+    class node_stack
+    {
+    private:
+        node_index _inline[query_stack_capacity];
+        std::vector<node_index> _overflow;
+        size_t _size = 0;
+
+    public:
+        void push(node_index index)
+        {
+            if(_size < query_stack_capacity) _inline[_size] = index;
+            else _overflow.push_back(index);
+            _size++;
+        }
+        node_index pop()
+        {
+            _size--;
+            if(_size < query_stack_capacity) return _inline[_size];
+
+            node_index index = _overflow.back();
+            _overflow.pop_back();
+            return index;
+        }
+        bool empty() const noexcept(true) { return !_size; }
+    };
+
+    /** @brief A dynamic bounding volume tree. (see: the top of this file) */
+    class aabb_tree
+    {
+    public:
+        struct node
+        {
+            /** @brief The fattened box for a leaf, the box that contains both children for any other node. */
+            aabb box;
+            /** @brief The parent of the node, or the next free node if the node is free. */
+            node_index parent = null_node;
+            node_index left = null_node;
+            node_index right = null_node;
+            /** @brief 0 for a leaf, -1 for a free node. */
+            int32_t height = -1;
+            /** @brief What the leaf refers to. (ex; the handle of a body) */
+            uint32_t user_data = 0;
+
+            bool is_leaf() const noexcept(true) { return left == null_node; }
+        };
+
+    private:
+        std::vector<node> _nodes;
+        node_index _root = null_node;
+        node_index _free = null_node;
+        size_t _proxy_count = 0;
+        float _margin;
+
+        /** @brief Only used by rebuild. */
+        std::vector<node_index> _build_leaves;
+
+        node_index allocate_node()
+        {
+            if(_free == null_node)
+            {
+                _nodes.push_back(node());
+                _nodes.back().height = 0;
+                return static_cast<node_index>(_nodes.size() - 1);
+            }
+
+            node_index index = _free;
+            _free = _nodes[index].parent;
+            _nodes[index] = node();
+            _nodes[index].height = 0;
+            return index;
+        }
+
+        void free_node(node_index index)
+        {
+            _nodes[index].parent = _free;
+            _nodes[index].height = -1;
+            _free = index;
+        }
+
+        /** @brief Recomputes the box and the height of the node from its children. */
+        void refit(node_index index)
+        {
+            node& n = _nodes[index];
+            n.box = aabb::merge(_nodes[n.left].box, _nodes[n.right].box);
+            n.height = 1 + std::max(_nodes[n.left].height, _nodes[n.right].height);
+        }
+
+        /**
+         * @brief Swaps a child of the node with a grandchild (from the other side) if that reduces the area of the
+         * child that changes. The box of the node itself stays the same.
+        */
+        void rotate(node_index a)
+        {
+            node_index b = _nodes[a].left, c = _nodes[a].right;
+            bool b_leaf = _nodes[b].is_leaf(), c_leaf = _nodes[c].is_leaf();
+            if(b_leaf && c_leaf) return;
+
+            // 0 = none, 1 = B <-> F, 2 = B <-> G, 3 = C <-> D, 4 = C <-> E
+            int best = 0;
+            float best_gain = 0.0f;
+
+            if(!c_leaf)
+            {
+                node_index f = _nodes[c].left, g = _nodes[c].right;
+                float area = _nodes[c].box.half_area();
+                float gain_f = area - aabb::merge(_nodes[b].box, _nodes[g].box).half_area();
+                float gain_g = area - aabb::merge(_nodes[b].box, _nodes[f].box).half_area();
+                if(gain_f > best_gain) { best = 1; best_gain = gain_f; }
+                if(gain_g > best_gain) { best = 2; best_gain = gain_g; }
+            }
+            if(!b_leaf)
+            {
+                node_index d = _nodes[b].left, e = _nodes[b].right;
+                float area = _nodes[b].box.half_area();
+                float gain_d = area - aabb::merge(_nodes[c].box, _nodes[e].box).half_area();
+                float gain_e = area - aabb::merge(_nodes[c].box, _nodes[d].box).half_area();
+                if(gain_d > best_gain) { best = 3; best_gain = gain_d; }
+                if(gain_e > best_gain) { best = 4; best_gain = gain_e; }
+            }
+
+            // The child of A (child) is swapped with a child (grandchild) of the other child of A (other).
+            node_index child, other, grandchild;
+            switch(best)
+            {
+            case 1: child = b; other = c; grandchild = _nodes[c].left;  break;
+            case 2: child = b; other = c; grandchild = _nodes[c].right; break;
+            case 3: child = c; other = b; grandchild = _nodes[b].left;  break;
+            case 4: child = c; other = b; grandchild = _nodes[b].right; break;
+            default: return;
+            }
+
+            if(_nodes[a].left == child) _nodes[a].left = grandchild;
+            else _nodes[a].right = grandchild;
+            _nodes[grandchild].parent = a;
+
+            if(_nodes[other].left == grandchild) _nodes[other].left = child;
+            else _nodes[other].right = child;
+            _nodes[child].parent = other;
+
+            refit(other);
+            _nodes[a].height = 1 + std::max(_nodes[_nodes[a].left].height, _nodes[_nodes[a].right].height);
+        }
+
+        /** @brief Refits and rotates every node from the index up to the root. */
+        void refit_upwards(node_index index)
+        {
+            while(index != null_node)
+            {
+                refit(index);
+                rotate(index);
+                index = _nodes[index].parent;
+            }
+        }
+
+        void insert_leaf(node_index leaf)
+        {
+            if(_root == null_node)
+            {
+                _root = leaf;
+                _nodes[leaf].parent = null_node;
+                return;
+            }
+
+            // ============================= FIND THE BEST SIBLING =============================
+            const aabb box = _nodes[leaf].box;
+            node_index index = _root;
+            while(!_nodes[index].is_leaf())
+            {
+                const node& n = _nodes[index];
+                float area = n.box.half_area();
+                float combined = aabb::merge(n.box, box).half_area();
+
+                // The cost of making a new parent for this node and the leaf.
+                float cost = 2.0f * combined;
+                // Every ancestor (including this node) grows by this much if the leaf goes further down.
+                float inheritance = 2.0f * (combined - area);
+
+                auto descend_cost = [&](node_index child_index)
+                {
+                    const node& child = _nodes[child_index];
+                    float merged = aabb::merge(child.box, box).half_area();
+                    return (child.is_leaf() ? merged : merged - child.box.half_area()) + inheritance;
+                };
+                float cost_left = descend_cost(n.left);
+                float cost_right = descend_cost(n.right);
+
+                if(cost < cost_left && cost < cost_right) break;
+                index = cost_left < cost_right ? n.left : n.right;
+            }
+            node_index sibling = index;
+
+            // ============================= CREATE THE NEW PARENT =============================
+            node_index old_parent = _nodes[sibling].parent;
+            node_index new_parent = allocate_node();
+            _nodes[new_parent].parent = old_parent;
+            _nodes[new_parent].left = sibling;
+            _nodes[new_parent].right = leaf;
+            _nodes[sibling].parent = new_parent;
+            _nodes[leaf].parent = new_parent;
+
+            if(old_parent == null_node) _root = new_parent;
+            else if(_nodes[old_parent].left == sibling) _nodes[old_parent].left = new_parent;
+            else _nodes[old_parent].right = new_parent;
+
+            refit_upwards(new_parent);
+        }
+
+        void remove_leaf(node_index leaf)
+        {
+            if(leaf == _root)
+            {
+                _root = null_node;
+                return;
+            }
+
+            node_index parent = _nodes[leaf].parent;
+            node_index grandparent = _nodes[parent].parent;
+            node_index sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+            if(grandparent == null_node)
+            {
+                _root = sibling;
+                _nodes[sibling].parent = null_node;
+                free_node(parent);
+                return;
+            }
+
+            if(_nodes[grandparent].left == parent) _nodes[grandparent].left = sibling;
+            else _nodes[grandparent].right = sibling;
+            _nodes[sibling].parent = grandparent;
+            free_node(parent);
+
+            refit_upwards(grandparent);
+        }
+
+        /** @brief Builds a subtree over _build_leaves[begin, end) and returns its root. */
+        node_index build(size_t begin, size_t end)
+        {
+            if(end - begin == 1) return _build_leaves[begin];
+
+            // ============================= BIN THE CENTERS =============================
+            constexpr size_t bin_count = 12;
+
+            aabb centers;
+            centers.min = centers.max = _nodes[_build_leaves[begin]].box.center();
+            for(size_t i = begin; i < end; i++)
+            {
+                glm::vec3 c = _nodes[_build_leaves[i]].box.center();
+                centers = aabb::merge(centers, aabb { c, c });
+            }
+            glm::vec3 extent = centers.size();
+            int axis = extent.y > extent.x ? 1 : 0;
+            if(extent.z > extent[axis]) axis = 2;
+
+            size_t split = begin + (end - begin) / 2;
+            if(extent[axis] > 0.0f)
+            {
+                aabb bin_boxes[bin_count];
+                size_t bin_counts[bin_count] = {};
+                float scale = bin_count / extent[axis];
+
+                auto bin_of = [&](node_index leaf)
+                {
+                    float offset = (_nodes[leaf].box.center()[axis] - centers.min[axis]) * scale;
+                    return std::min(static_cast<size_t>(offset), bin_count - 1);
+                };
+
+                for(size_t i = begin; i < end; i++)
+                {
+                    size_t bin = bin_of(_build_leaves[i]);
+                    const aabb& box = _nodes[_build_leaves[i]].box;
+                    bin_boxes[bin] = bin_counts[bin] ? aabb::merge(bin_boxes[bin], box) : box;
+                    bin_counts[bin]++;
+                }
+
+                // ============================= PICK THE CHEAPEST SPLIT =============================
+                // The cost of a split is the area of each side multiplied by the number of leaves on that side.
+                float right_costs[bin_count] = {};
+                aabb right_box;
+                size_t right_count = 0;
+                for(size_t i = bin_count - 1; i > 0; i--)
+                {
+                    if(bin_counts[i]) right_box = right_count ? aabb::merge(right_box, bin_boxes[i]) : bin_boxes[i];
+                    right_count += bin_counts[i];
+                    right_costs[i] = right_count ? right_box.half_area() * right_count : 0.0f;
+                }
+
+                float best_cost = std::numeric_limits<float>::max();
+                size_t best_bin = 0;
+                aabb left_box;
+                size_t left_count = 0;
+                for(size_t i = 0; i < bin_count - 1; i++)
+                {
+                    if(bin_counts[i]) left_box = left_count ? aabb::merge(left_box, bin_boxes[i]) : bin_boxes[i];
+                    left_count += bin_counts[i];
+                    if(!left_count || left_count == end - begin) continue;
+
+                    float cost = left_box.half_area() * left_count + right_costs[i + 1];
+                    if(cost < best_cost) { best_cost = cost; best_bin = i; }
+                }
+
+                if(best_cost < std::numeric_limits<float>::max())
+                {
+                    auto middle = std::partition(_build_leaves.begin() + begin, _build_leaves.begin() + end,
+                        [&](node_index leaf) { return bin_of(leaf) <= best_bin; });
+                    split = static_cast<size_t>(middle - _build_leaves.begin());
+                }
+            }
+
+            node_index left = build(begin, split);
+            node_index right = build(split, end);
+
+            node_index parent = allocate_node();
+            _nodes[parent].left = left;
+            _nodes[parent].right = right;
+            _nodes[left].parent = parent;
+            _nodes[right].parent = parent;
+            refit(parent);
+            return parent;
+        }
+
+        /** @brief The distance from the point to the box, 0 if it is inside. */
+        static float distance_to(const aabb& box, const glm::vec3& point) noexcept(true)
+        {
+            float dx = std::fmax(std::fmax(box.min.x - point.x, point.x - box.max.x), 0.0f);
+            float dy = std::fmax(std::fmax(box.min.y - point.y, point.y - box.max.y), 0.0f);
+            float dz = std::fmax(std::fmax(box.min.z - point.z, point.z - box.max.z), 0.0f);
+            return std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+
+    public:
+        /** @param margin How much the boxes of the leaves are fattened by. */
+        explicit aabb_tree(float margin = 0.1f) : _margin(margin) {}
+
+        /**
+         * @brief Inserts a box into the tree.
+         * @param box The (tight) box, it is fattened by the margin.
+         * @param user_data What the leaf refers to.
+         * @returns The id of the proxy. It stays the same until the proxy is destroyed.
+        */
+        node_index create_proxy(const aabb& box, uint32_t user_data)
+        {
+            node_index leaf = allocate_node();
+            _nodes[leaf].box = box.expanded(_margin);
+            _nodes[leaf].user_data = user_data;
+            insert_leaf(leaf);
+            _proxy_count++;
+            return leaf;
+        }
+
+        void destroy_proxy(node_index proxy)
+        {
+            remove_leaf(proxy);
+            free_node(proxy);
+            _proxy_count--;
+        }
+
+        /**
+         * @brief Updates the box of the proxy. Nothing happens as long as the fattened box still contains the box.
+         * @param proxy The id of the proxy.
+         * @param box The new (tight) box.
+         * @param displacement? How far the body is expected to move until the next update, the box is extended in
+         * that direction.
+         * @returns Whether or not the proxy was re-inserted.
+        */
+        bool move_proxy(node_index proxy, const aabb& box, const glm::vec3& displacement = glm::vec3(0.0f))
+        {
+            if(_nodes[proxy].box.contains(box)) return false;
+
+            remove_leaf(proxy);
+
+            aabb fat = box.expanded(_margin);
+            for(int axis = 0; axis < 3; axis++)
+            {
+                if(displacement[axis] < 0.0f) fat.min[axis] += displacement[axis];
+                else fat.max[axis] += displacement[axis];
+            }
+            _nodes[proxy].box = fat;
+
+            insert_leaf(proxy);
+            return true;
+        }
+
+        /** @brief Rebuilds every node above the leaves with a binned SAH. The ids of the proxies stay the same. */
+        void rebuild()
+        {
+            _build_leaves.clear();
+            for(size_t i = 0; i < _nodes.size(); i++)
+            {
+                node& n = _nodes[i];
+                if(n.height < 0) continue;
+                if(n.is_leaf()) _build_leaves.push_back(static_cast<node_index>(i));
+                else free_node(static_cast<node_index>(i));
+            }
+
+            _root = _build_leaves.empty() ? null_node : build(0, _build_leaves.size());
+            if(_root != null_node) _nodes[_root].parent = null_node;
+        }
+
+        /** @brief Removes every proxy. */
+        void clear()
+        {
+            _nodes.clear();
+            _root = _free = null_node;
+            _proxy_count = 0;
+        }
+
+        /**
+         * @brief Calls the function for every proxy whose fattened box overlaps the box.
+         * @param fn Called as bool(node_index proxy, uint32_t user_data), returning false stops the query.
+        */
+        template <typename Fn>
+        void query(const aabb& box, Fn&& fn) const
+        {
+            if(_root == null_node) return;
+
+            node_stack stack;
+            stack.push(_root);
+            while(!stack.empty())
+            {
+                const node& n = _nodes[stack.pop()];
+                if(!n.box.overlaps(box)) continue;
+
+                if(n.is_leaf())
+                {
+                    if(!fn(static_cast<node_index>(&n - _nodes.data()), n.user_data)) return;
+                }
+                else
+                {
+                    stack.push(n.left);
+                    stack.push(n.right);
+                }
+            }
+        }
+
+        /**
+         * @brief Calls the function for every proxy whose fattened box is hit by the ray.
+         * @param origin Where the ray starts.
+         * @param direction The direction of the ray, it doesn't have to be normalized. Distances are measured in
+         * multiples of its length.
+         * @param max_distance How far the ray goes.
+         * @param fn Called as float(node_index proxy, uint32_t user_data, float max_distance), the ray is clipped to
+         * the returned distance. Return max_distance to ignore the proxy, 0 stops the query.
+        */
+        template <typename Fn>
+        void raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, Fn&& fn) const
+        {
+            if(_root == null_node) return;
+
+            glm::vec3 inverse(
+                direction.x != 0.0f ? 1.0f / direction.x : std::numeric_limits<float>::infinity(),
+                direction.y != 0.0f ? 1.0f / direction.y : std::numeric_limits<float>::infinity(),
+                direction.z != 0.0f ? 1.0f / direction.z : std::numeric_limits<float>::infinity());
+
+            auto hits = [&](const aabb& box)
+            {
+                float t_min = 0.0f, t_max = max_distance;
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    if(direction[axis] == 0.0f)
+                    {
+                        if(origin[axis] < box.min[axis] || origin[axis] > box.max[axis]) return false;
+                        continue;
+                    }
+                    float t0 = (box.min[axis] - origin[axis]) * inverse[axis];
+                    float t1 = (box.max[axis] - origin[axis]) * inverse[axis];
+                    if(t0 > t1) std::swap(t0, t1);
+                    t_min = std::fmax(t_min, t0);
+                    t_max = std::fmin(t_max, t1);
+                    if(t_min > t_max) return false;
+                }
+                return true;
+            };
+
+            node_stack stack;
+            stack.push(_root);
+            while(!stack.empty())
+            {
+                const node& n = _nodes[stack.pop()];
+                if(!hits(n.box)) continue;
+
+                if(n.is_leaf())
+                {
+                    max_distance = fn(static_cast<node_index>(&n - _nodes.data()), n.user_data, max_distance);
+                    if(max_distance <= 0.0f) return;
+                }
+                else
+                {
+                    stack.push(n.left);
+                    stack.push(n.right);
+                }
+            }
+        }
+
+        /**
+         * @brief Finds the proxy that is the nearest to the point.
+         * @param point The point.
+         * @param max_distance Proxies that are further away than this are ignored.
+         * @param fn Called as float(node_index proxy, uint32_t user_data), must return the exact distance from the
+         * point to whatever the proxy refers to. It is only called for proxies whose box is closer than the nearest
+         * one so far.
+         * @param distance? Set to the distance of the nearest proxy.
+         * @returns The nearest proxy, or null_node if there is none within max_distance.
+        */
+        template <typename Fn>
+        node_index nearest(const glm::vec3& point, float max_distance, Fn&& fn, float* distance = nullptr) const
+        {
+            node_index best = null_node;
+            float best_distance = max_distance;
+            if(_root != null_node)
+            {
+                node_stack stack;
+                stack.push(_root);
+                while(!stack.empty())
+                {
+                    node_index index = stack.pop();
+                    const node& n = _nodes[index];
+                    if(distance_to(n.box, point) >= best_distance) continue;
+
+                    if(n.is_leaf())
+                    {
+                        float d = fn(index, n.user_data);
+                        if(d < best_distance) { best_distance = d; best = index; }
+                        continue;
+                    }
+
+                    // The closer child is pushed last so that it is visited first, which prunes more of the other.
+                    float left = distance_to(_nodes[n.left].box, point), right = distance_to(_nodes[n.right].box, point);
+                    if(left < right) { stack.push(n.right); stack.push(n.left); }
+                    else { stack.push(n.left); stack.push(n.right); }
+                }
+            }
+            if(distance) *distance = best_distance;
+            return best;
+        }
+
+        /** @brief Returns the fattened box of the proxy. */
+        const aabb& get_fat_aabb(node_index proxy) const { return _nodes[proxy].box; }
+        uint32_t get_user_data(node_index proxy) const { return _nodes[proxy].user_data; }
+
+        /** @brief Returns the height of the tree. 0 for a single leaf or an empty tree. */
+        int32_t height() const noexcept(true) { return _root == null_node ? 0 : _nodes[_root].height; }
+        size_t proxy_count() const noexcept(true) { return _proxy_count; }
+        node_index root() const noexcept(true) { return _root; }
+        const std::vector<node>& nodes() const noexcept(true) { return _nodes; }
+
+        void set_margin(float margin) noexcept(true) { _margin = margin; }
+        float get_margin() const noexcept(true) { return _margin; }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
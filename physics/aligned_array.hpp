@@ -0,0 +1,141 @@
+/**
+ * This header contains the array that the structure-of-arrays storages of the physics engine are built from.
+ *
+ * Unlike std::vector its storage is aligned to simd_alignment (64 bytes) and its capacity is rounded up to a multiple
+ * of the elements that fit into 64 bytes (16 floats), the elements past the size (the padding) are always zero.
+ * Hence, the SIMD kernels can always process whole registers, the last one simply contains some padding. The capacity
+ * at least doubles when the array grows, so appending is amortized constant time like std::vector.
+*/
+
+#include "./physics.hpp"
+
+#ifndef _PHYSICS_ALIGNED_ARRAY_DEFINITION_HPP_
+    #define _PHYSICS_ALIGNED_ARRAY_DEFINITION_HPP_
+
+    #include <new>
+    #include <cstring>
+    #include <utility>
+    #include <type_traits>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /**
+     * @brief A growable array whose storage is aligned to simd_alignment.
+     * @tparam T The type of the elements. Must be trivially copyable as the elements are moved around with memcpy.
+    */
+    template <typename T>
+    class aligned_array
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "The elements are moved around with memcpy.");
+
+    private:
+        T* _data = nullptr;
+        size_t _size = 0;
+        size_t _capacity = 0;
+
+        /// @brief The number of elements that fit into simd_alignment bytes.
+        static constexpr size_t elements_per_line = simd_alignment / sizeof(T) ? simd_alignment / sizeof(T) : 1;
+
+    public:
+        aligned_array() = default;
+        explicit aligned_array(size_t size) { resize(size); }
+
+        aligned_array(const aligned_array& other) { *this = other; }
+        aligned_array(aligned_array&& other) noexcept(true) { swap(other); }
+
+        aligned_array& operator=(const aligned_array& other)
+        {
+            if(this == &other) return *this;
+            clear();
+            reserve(other._size);
+            if(other._size) std::memcpy(_data, other._data, sizeof(T) * other._size);
+            _size = other._size;
+            return *this;
+        }
+        aligned_array& operator=(aligned_array&& other) noexcept(true)
+        {
+            swap(other);
+            return *this;
+        }
+
+        void swap(aligned_array& other) noexcept(true)
+        {
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_capacity, other._capacity);
+        }
+
+        /// @brief Makes sure that at least @c capacity elements fit without reallocating.
+        void reserve(size_t capacity)
+        {
+            if(capacity <= _capacity) return;
+
+            capacity = (capacity + elements_per_line - 1) / elements_per_line * elements_per_line;
+            T* data = static_cast<T*>(::operator new(sizeof(T) * capacity, std::align_val_t(simd_alignment)));
+            std::memset(static_cast<void*>(data), 0, sizeof(T) * capacity);
+            if(_size) std::memcpy(static_cast<void*>(data), _data, sizeof(T) * _size);
+
+            if(_data) ::operator delete(_data, std::align_val_t(simd_alignment));
+            _data = data;
+            _capacity = capacity;
+        }
+
+        /// @brief Changes the number of elements. New elements are set to @c value, the removed ones are zeroed so that the padding stays zero.
+        void resize(size_t size, const T& value = T())
+        {
+            if(size > _capacity) reserve(std::max(size, _capacity * 2));
+            if(size < _size) std::memset(static_cast<void*>(_data + size), 0, sizeof(T) * (_size - size));
+            for(size_t i = _size; i < size; i++) _data[i] = value;
+            _size = size;
+        }
+
+        void push_back(const T& value)
+        {
+            if(_size == _capacity) reserve(std::max<size_t>(_capacity * 2, elements_per_line));
+            _data[_size++] = value;
+        }
+        /// @brief Removes the last element. It is zeroed so that the padding stays zero.
+        void pop_back() { _data[--_size] = T(); }
+
+        /// @brief Removes the element by moving the last element into its place. It does not preserve the order.
+        void swap_remove(size_t index)
+        {
+            _data[index] = _data[_size - 1];
+            pop_back();
+        }
+
+        /// @brief Removes all the elements without freeing the storage. They are zeroed so that the padding stays zero.
+        void clear() noexcept(true)
+        {
+            if(_size) std::memset(static_cast<void*>(_data), 0, sizeof(T) * _size);
+            _size = 0;
+        }
+
+        /// @brief Sets every element, including the padding, to zero.
+        void zero() noexcept(true) { if(_capacity) std::memset(static_cast<void*>(_data), 0, sizeof(T) * _capacity); }
+
+        T& operator[](size_t index) { return _data[index]; }
+        const T& operator[](size_t index) const { return _data[index]; }
+
+        T* data() noexcept(true) { return _data; }
+        const T* data() const noexcept(true) { return _data; }
+
+        T* begin() noexcept(true) { return _data; }
+        T* end() noexcept(true) { return _data + _size; }
+        const T* begin() const noexcept(true) { return _data; }
+        const T* end() const noexcept(true) { return _data + _size; }
+
+        size_t size() const noexcept(true) { return _size; }
+        size_t capacity() const noexcept(true) { return _capacity; }
+        bool empty() const noexcept(true) { return !_size; }
+
+        ~aligned_array() noexcept(true)
+        {
+            if(_data) ::operator delete(_data, std::align_val_t(simd_alignment));
+        }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,480 @@
+/**
+ * This header contains the storage of the rigid bodies.
+ *
+ * The state of the bodies is stored as a structure of arrays. i.e. all the x-coordinates of the positions are next
+ * to each other, then all the y-coordinates, etc. This is what lets the kernels (see: integrate.hpp) process
+ * simd::width bodies per instruction. The bodies are densely packed, removing a body moves the last body into its
+ * place, hence a body must be referred to by its handle and not by its index.
+ *
+ * Static bodies are bodies with an inverse mass of 0. They are never moved by the simulation. Neither are the
+ * sleeping bodies, until they are woken up. (see: sleep.hpp)
+*/
+
+#include "./physics.hpp"
+#include "./aligned_array.hpp"
+#include "./snapshot.hpp"
+
+#ifndef _PHYSICS_BODY_STORE_DEFINITION_HPP_
+    #define _PHYSICS_BODY_STORE_DEFINITION_HPP_
+
+    #include <vector>
+    #include <algorithm>
+    #include <cstdio>
+    #include <cstring>
+    #include <cstddef>
+    #include <cstdint>
+
+    _PHYSICS_START_
+
+    /** @brief The different kinds of shapes. */
+    enum class shape_type : uint8_t
+    {
+        SPHERE  = 0,
+        BOX     = 1,
+        /** @brief A cylinder with hemispherical caps, along the local y-axis. */
+        CAPSULE = 2,
+        /** @brief The convex hull of a set of points. (see: convex_hull) */
+        CONVEX  = 3
+    };
+
+    /**
+     * @brief The points of a convex shape, in the local space of the body. The shape is the convex hull of the
+     * points, hence the points inside of it don't have to be removed. Neither the hull nor its points are copied into
+     * the bodies, they must outlive every body that uses them. (ex; the points of a mapped mesh file, see: mesh_asset.hpp)
+     * A body refers to a hull by its id in a hull_registry.
+    */
+    struct convex_hull
+    {
+        const glm::vec3* points = nullptr;
+        size_t point_count = 0;
+
+        convex_hull() = default;
+        convex_hull(const glm::vec3* points, size_t count) : points(points), point_count(count) {}
+        explicit convex_hull(const std::vector<glm::vec3>& points) : points(points.data()), point_count(points.size()) {}
+        /** @brief The hull would refer to the points of a temporary. */
+        convex_hull(std::vector<glm::vec3>&&) = delete;
+
+        const glm::vec3* begin() const noexcept(true) { return points; }
+        const glm::vec3* end() const noexcept(true) { return points + point_count; }
+
+        /** @brief Returns the half extents of the box around the origin (the center of the body) that holds every point. */
+        glm::vec3 half_extents() const
+        {
+            glm::vec3 extents(0.0f);
+            for(const glm::vec3& p : *this) extents = glm::max(extents, glm::abs(p));
+            return extents;
+        }
+    };
+
+    /** @brief The id of no hull. */
+    constexpr uint32_t no_hull = UINT32_MAX;
+
+    /**
+     * @brief The hulls that the bodies of a world can use, by id. A snapshot (see: snapshot.hpp) stores the id of the
+     * hull of a body rather than its address, the address isn't the same in another process (or after the hull was
+     * loaded again). Hence, for a snapshot to be restored, the same hulls must have been registered under the same
+     * ids first. ex; the index of the mesh in its mesh file, or the order in which they are added by a level.
+    */
+    class hull_registry
+    {
+    private:
+        std::vector<const convex_hull*> _hulls;
+
+    public:
+        /** @brief Registers the hull under the next free id. @returns The id. */
+        uint32_t add(const convex_hull& hull)
+        {
+            _hulls.push_back(&hull);
+            return static_cast<uint32_t>(_hulls.size() - 1);
+        }
+        /** @brief Registers the hull under the id, replacing the hull that had it. The hull must outlive its registration. */
+        void set(uint32_t id, const convex_hull& hull)
+        {
+            if(id >= _hulls.size()) _hulls.resize(static_cast<size_t>(id) + 1, nullptr);
+            _hulls[id] = &hull;
+        }
+        /** @brief The bodies that use the hull must have been destroyed first. */
+        void remove(uint32_t id) { if(id < _hulls.size()) _hulls[id] = nullptr; }
+
+        /** @returns The hull that has the id, nullptr if there is none. */
+        const convex_hull* find(uint32_t id) const noexcept(true) { return id < _hulls.size() ? _hulls[id] : nullptr; }
+        size_t size() const noexcept(true) { return _hulls.size(); }
+    };
+
+    /** @brief The collision shape of a body, in the local space of the body. */
+    struct shape
+    {
+        shape_type type = shape_type::SPHERE;
+        /** @brief The radius of a sphere or a capsule. */
+        float radius = 0.5f;
+        /** @brief Half of the size of a box along each axis. For a capsule only y is used, it is the distance from
+         * the center to the center of a cap. For a convex hull it is the box around its points. */
+        glm::vec3 half_extents = glm::vec3(0.5f);
+        /** @brief The id of the hull in the hull_registry of the world, no_hull for any other shape. This is what a snapshot stores. */
+        uint32_t hull_id = no_hull;
+        /** @brief The points of a convex hull, nullptr for any other shape. For a hull the radius rounds its corners. */
+        const convex_hull* hull = nullptr;
+
+        static shape sphere(float radius) { shape s; s.type = shape_type::SPHERE; s.radius = radius; return s; }
+        static shape box(const glm::vec3& half_extents)
+        {
+            shape s; s.type = shape_type::BOX; s.half_extents = half_extents; s.radius = 0.0f; return s;
+        }
+        static shape capsule(float radius, float half_height)
+        {
+            shape s; s.type = shape_type::CAPSULE; s.radius = radius; s.half_extents = glm::vec3(0.0f, half_height, 0.0f); return s;
+        }
+        /**
+         * @param hulls The hulls of the world. (see: world::hulls)
+         * @param id The id of the hull, it must have been registered.
+         * @param radius? Rounds the corners of the hull.
+        */
+        static shape convex(const hull_registry& hulls, uint32_t id, float radius = 0.0f)
+        {
+            shape s; s.type = shape_type::CONVEX; s.hull_id = id; s.hull = hulls.find(id); s.radius = radius;
+            s.half_extents = s.hull ? s.hull->half_extents() : glm::vec3(0.0f);
+            return s;
+        }
+
+        /** @brief Returns the half extents of the bounding box of the shape in its local space. */
+        glm::vec3 local_half_extents() const
+        {
+            switch(type)
+            {
+            case shape_type::SPHERE:  return glm::vec3(radius);
+            case shape_type::BOX:     return half_extents;
+            case shape_type::CAPSULE: return glm::vec3(radius, half_extents.y + radius, radius);
+            case shape_type::CONVEX:  return half_extents + glm::vec3(radius);
+            }
+            return glm::vec3(radius);
+        }
+
+        /** @brief Returns the diagonal of the inertia tensor of the shape for the specified mass. */
+        glm::vec3 inertia(float mass) const
+        {
+            switch(type)
+            {
+            case shape_type::SPHERE:
+                return glm::vec3(0.4f * mass * radius * radius);
+            case shape_type::BOX:
+            case shape_type::CONVEX:
+            {
+                // A hull is approximated by the box around its points.
+                glm::vec3 size = local_half_extents() * 2.0f;
+                glm::vec3 sq = size * size;
+                return glm::vec3(sq.y + sq.z, sq.x + sq.z, sq.x + sq.y) * (mass / 12.0f);
+            }
+            case shape_type::CAPSULE:
+            {
+                // The cylinder and the two hemispheres, split by the volume of each part.
+                float r = radius, h = half_extents.y * 2.0f;
+                float cylinder_volume = 3.14159265f * r * r * h;
+                float sphere_volume = 4.0f / 3.0f * 3.14159265f * r * r * r;
+                float cylinder_mass = mass * cylinder_volume / (cylinder_volume + sphere_volume);
+                float sphere_mass = mass - cylinder_mass;
+
+                float axial = cylinder_mass * r * r * 0.5f + sphere_mass * r * r * 0.4f;
+                float side = cylinder_mass * (3.0f * r * r + h * h) / 12.0f
+                    + sphere_mass * (0.4f * r * r + 0.375f * r * h + 0.25f * h * h);
+                return glm::vec3(side, axial, side);
+            }
+            }
+            return glm::vec3(0.0f);
+        }
+    };
+
+    /** @brief How the surface of a body reacts in a contact. */
+    struct material
+    {
+        float friction = 0.5f;
+        /** @brief 0 means a contact absorbs all the energy, 1 means it preserves it. */
+        float restitution = 0.0f;
+    };
+
+    /** @brief Everything that is needed to create a body. */
+    struct body_desc
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 linear_velocity = glm::vec3(0.0f);
+        glm::vec3 angular_velocity = glm::vec3(0.0f);
+
+        /** @brief The mass of the body. A mass of 0 makes it a static body. */
+        float mass = 1.0f;
+        float linear_damping = 0.01f;
+        float angular_damping = 0.05f;
+
+        physics::shape shape;
+        physics::material material;
+    };
+
+    /** @brief An array of 3D vectors stored as three arrays (one per component). */
+    struct vec3_soa
+    {
+        aligned_array<float> x, y, z;
+
+        glm::vec3 get(size_t i) const { return glm::vec3(x[i], y[i], z[i]); }
+        void set(size_t i, const glm::vec3& v) { x[i] = v.x; y[i] = v.y; z[i] = v.z; }
+
+        void push_back(const glm::vec3& v) { x.push_back(v.x); y.push_back(v.y); z.push_back(v.z); }
+        void swap_remove(size_t i) { x.swap_remove(i); y.swap_remove(i); z.swap_remove(i); }
+        void reserve(size_t n) { x.reserve(n); y.reserve(n); z.reserve(n); }
+        void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); }
+        void zero() { x.zero(); y.zero(); z.zero(); }
+    };
+
+    /** @brief An array of quaternions stored as four arrays (one per component). */
+    struct quat_soa
+    {
+        aligned_array<float> x, y, z, w;
+
+        glm::quat get(size_t i) const { return glm::quat(w[i], x[i], y[i], z[i]); }
+        void set(size_t i, const glm::quat& q) { x[i] = q.x; y[i] = q.y; z[i] = q.z; w[i] = q.w; }
+
+        void push_back(const glm::quat& q) { x.push_back(q.x); y.push_back(q.y); z.push_back(q.z); w.push_back(q.w); }
+        void swap_remove(size_t i) { x.swap_remove(i); y.swap_remove(i); z.swap_remove(i); w.swap_remove(i); }
+        void reserve(size_t n) { x.reserve(n); y.reserve(n); z.reserve(n); w.reserve(n); }
+        void resize(size_t n) { x.resize(n); y.resize(n); z.resize(n); w.resize(n); }
+    };
+
+    /** @brief The storage of all the bodies of a world. */
+    class body_store
+    {
+    public:
+        // ============================= HOT (read by the kernels) =============================
+        vec3_soa position;
+        quat_soa orientation;
+        vec3_soa linear_velocity;
+        vec3_soa angular_velocity;
+
+        /** @brief The forces and torques accumulated since the last step. They are cleared after every step. */
+        vec3_soa force;
+        vec3_soa torque;
+
+        /** @brief 0 for static bodies. */
+        aligned_array<float> inverse_mass;
+        /** @brief The diagonal of the inverse inertia tensor in the local space of the body. */
+        vec3_soa inverse_inertia;
+        aligned_array<float> linear_damping;
+        aligned_array<float> angular_damping;
+
+        /** @brief The state at the start of the last step, for interpolating while rendering. */
+        vec3_soa previous_position;
+        quat_soa previous_orientation;
+
+        /** @brief 1 for the bodies that are awake, 0 for the ones that are sleeping. (see: sleep.hpp) */
+        aligned_array<float> awake;
+
+        // ============================= COLD =============================
+        std::vector<physics::shape> shapes;
+        std::vector<physics::material> materials;
+        /** @brief The handle of the body at every index. */
+        std::vector<body_handle> handles;
+        /** @brief How long (in seconds) the body has been moving slower than the sleep thresholds. */
+        std::vector<float> sleep_time;
+        /** @brief The sleeping island that the body is a part of, or UINT32_MAX if it is awake. */
+        std::vector<uint32_t> sleep_island;
+
+    private:
+        /** @brief The index of every handle, or UINT32_MAX if the handle is free. */
+        std::vector<uint32_t> _indices;
+        std::vector<body_handle> _free_handles;
+
+    public:
+        /** @brief Returns the number of bodies. */
+        size_t size() const noexcept(true) { return handles.size(); }
+        /** @brief Returns the number of bodies rounded up to a whole number of SIMD registers. The kernels process this many. */
+        size_t padded_size() const noexcept(true) { return (size() + 15) / 16 * 16; }
+
+        /** @brief Whether or not the handle refers to a body that exists. */
+        bool contains(body_handle handle) const noexcept(true)
+        {
+            return handle < _indices.size() && _indices[handle] != UINT32_MAX;
+        }
+        /** @brief Returns the current index of the body. It changes when other bodies are removed. */
+        size_t index_of(body_handle handle) const noexcept(true) { return _indices[handle]; }
+
+        /** @brief Makes sure that @c count bodies fit without reallocating. */
+        void reserve(size_t count)
+        {
+            position.reserve(count); orientation.reserve(count);
+            linear_velocity.reserve(count); angular_velocity.reserve(count);
+            force.reserve(count); torque.reserve(count);
+            inverse_mass.reserve(count); inverse_inertia.reserve(count);
+            linear_damping.reserve(count); angular_damping.reserve(count);
+            previous_position.reserve(count); previous_orientation.reserve(count);
+            awake.reserve(count);
+            shapes.reserve(count); materials.reserve(count); handles.reserve(count);
+            sleep_time.reserve(count); sleep_island.reserve(count);
+        }
+
+        /** @brief Adds a body and returns its handle. */
+        body_handle add(const body_desc& desc)
+        {
+            body_handle handle;
+            if(!_free_handles.empty())
+            {
+                handle = _free_handles.back();
+                _free_handles.pop_back();
+            }
+            else
+            {
+                handle = static_cast<body_handle>(_indices.size());
+                _indices.push_back(UINT32_MAX);
+            }
+            _indices[handle] = static_cast<uint32_t>(size());
+
+            glm::quat orientation_normalized = glm::normalize(desc.orientation);
+            bool is_static = desc.mass <= 0.0f;
+
+            position.push_back(desc.position);
+            orientation.push_back(orientation_normalized);
+            linear_velocity.push_back(is_static ? glm::vec3(0.0f) : desc.linear_velocity);
+            angular_velocity.push_back(is_static ? glm::vec3(0.0f) : desc.angular_velocity);
+            force.push_back(glm::vec3(0.0f));
+            torque.push_back(glm::vec3(0.0f));
+
+            inverse_mass.push_back(is_static ? 0.0f : 1.0f / desc.mass);
+            glm::vec3 inertia = desc.shape.inertia(desc.mass);
+            inverse_inertia.push_back(is_static ? glm::vec3(0.0f) : glm::vec3(
+                inertia.x > 0.0f ? 1.0f / inertia.x : 0.0f,
+                inertia.y > 0.0f ? 1.0f / inertia.y : 0.0f,
+                inertia.z > 0.0f ? 1.0f / inertia.z : 0.0f));
+            linear_damping.push_back(desc.linear_damping);
+            angular_damping.push_back(desc.angular_damping);
+
+            previous_position.push_back(desc.position);
+            previous_orientation.push_back(orientation_normalized);
+            awake.push_back(1.0f);
+
+            shapes.push_back(desc.shape);
+            materials.push_back(desc.material);
+            handles.push_back(handle);
+            sleep_time.push_back(0.0f);
+            sleep_island.push_back(UINT32_MAX);
+            return handle;
+        }
+
+        /** @brief Removes the body. The last body is moved into its place. */
+        void remove(body_handle handle)
+        {
+            size_t index = index_of(handle);
+            size_t last = size() - 1;
+
+            position.swap_remove(index); orientation.swap_remove(index);
+            linear_velocity.swap_remove(index); angular_velocity.swap_remove(index);
+            force.swap_remove(index); torque.swap_remove(index);
+            inverse_mass.swap_remove(index); inverse_inertia.swap_remove(index);
+            linear_damping.swap_remove(index); angular_damping.swap_remove(index);
+            previous_position.swap_remove(index); previous_orientation.swap_remove(index);
+            awake.swap_remove(index);
+
+            shapes[index] = shapes[last]; shapes.pop_back();
+            materials[index] = materials[last]; materials.pop_back();
+            handles[index] = handles[last]; handles.pop_back();
+            sleep_time[index] = sleep_time[last]; sleep_time.pop_back();
+            sleep_island[index] = sleep_island[last]; sleep_island.pop_back();
+
+            if(index != last) _indices[handles[index]] = static_cast<uint32_t>(index);
+            _indices[handle] = UINT32_MAX;
+            _free_handles.push_back(handle);
+        }
+
+        /** @brief Writes every array (and the handles) into the snapshot. (see: snapshot.hpp) */
+        void save(snapshot_writer& out) const
+        {
+            for(const vec3_soa* v : { &position, &linear_velocity, &angular_velocity, &force, &torque, &inverse_inertia, &previous_position })
+            {
+                out.array(v->x); out.array(v->y); out.array(v->z);
+            }
+            for(const quat_soa* q : { &orientation, &previous_orientation })
+            {
+                out.array(q->x); out.array(q->y); out.array(q->z); out.array(q->w);
+            }
+            out.array(inverse_mass); out.array(linear_damping); out.array(angular_damping); out.array(awake);
+            out.value(static_cast<uint32_t>(shapes.size()));
+            for(const shape& s : shapes)
+            {
+                // Field by field into a zeroed shape, so that its padding is the same bytes in every snapshot. Only
+                // the ids of the hulls are stored, their addresses would differ from one process to the next.
+                shape stored;
+                std::memset(&stored, 0, sizeof(shape));
+                stored.type = s.type;
+                stored.radius = s.radius;
+                stored.half_extents = s.half_extents;
+                stored.hull_id = s.hull_id;
+                out.value(stored);
+            }
+            out.array(materials); out.array(handles); out.array(sleep_time); out.array(sleep_island);
+            out.array(_indices); out.array(_free_handles);
+        }
+
+        /**
+         * @brief Reads the arrays that save wrote.
+         * @param in The snapshot.
+         * @param hulls The hulls that the ids of the convex shapes are resolved with.
+         * @returns false if the snapshot is damaged or a hull isn't registered, the store is left in an unknown state then.
+        */
+        bool load(snapshot_reader& in, const hull_registry& hulls)
+        {
+            for(vec3_soa* v : { &position, &linear_velocity, &angular_velocity, &force, &torque, &inverse_inertia, &previous_position })
+            {
+                in.array(v->x); in.array(v->y); in.array(v->z);
+            }
+            for(quat_soa* q : { &orientation, &previous_orientation })
+            {
+                in.array(q->x); in.array(q->y); in.array(q->z); in.array(q->w);
+            }
+            in.array(inverse_mass); in.array(linear_damping); in.array(angular_damping); in.array(awake);
+            in.array(shapes); in.array(materials); in.array(handles); in.array(sleep_time); in.array(sleep_island);
+            in.array(_indices); in.array(_free_handles);
+            if(in.failed()) return false;
+
+            // Every array must have one element per body.
+            size_t n = handles.size();
+            for(const vec3_soa* v : { &position, &linear_velocity, &angular_velocity, &force, &torque, &inverse_inertia, &previous_position })
+                if(v->x.size() != n || v->y.size() != n || v->z.size() != n) return false;
+            for(const quat_soa* q : { &orientation, &previous_orientation })
+                if(q->x.size() != n || q->y.size() != n || q->z.size() != n || q->w.size() != n) return false;
+            if(inverse_mass.size() != n || linear_damping.size() != n || angular_damping.size() != n || awake.size() != n
+                || shapes.size() != n || materials.size() != n || sleep_time.size() != n || sleep_island.size() != n) return false;
+
+            // Every body has a handle that maps back to it, every other handle is free; the later lookups aren't checked.
+            if(n > _indices.size()) return false;
+            for(size_t i = 0; i < n; i++)
+                if(handles[i] >= _indices.size() || _indices[handles[i]] != i) return false;
+            size_t unused = 0;
+            for(uint32_t index : _indices)
+            {
+                if(index == UINT32_MAX) unused++;
+                else if(index >= n) return false;
+            }
+            if(unused != _free_handles.size()) return false;
+            for(body_handle handle : _free_handles)
+                if(handle >= _indices.size() || _indices[handle] != UINT32_MAX) return false;
+
+            for(shape& s : shapes)
+            {
+                if(static_cast<uint8_t>(s.type) > static_cast<uint8_t>(shape_type::CONVEX)) return false;
+                s.hull = nullptr;
+                if(s.type != shape_type::CONVEX) continue;
+                if(!(s.hull = hulls.find(s.hull_id)))
+                {
+                    fprintf(stderr, "Error restoring snapshot, no hull is registered as %u\n", s.hull_id);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /** @brief Whether or not the body at the index is static. */
+        bool is_static(size_t index) const noexcept(true) { return inverse_mass[index] == 0.0f; }
+        /** @brief Whether or not the body at the index is sleeping. */
+        bool is_sleeping(size_t index) const noexcept(true) { return awake[index] == 0.0f; }
+        /** @brief Whether or not the body at the index is moved by the simulation. i.e. dynamic and awake. */
+        bool is_active(size_t index) const noexcept(true) { return !is_static(index) && !is_sleeping(index); }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,584 @@
+/**
+ * This header contains the broadphases. A broadphase finds the pairs of bodies whose bounding boxes overlap, so that
+ * only those pairs have to be tested by the (much more expensive) narrowphase.
+ *
+ *  SWEEP_AND_PRUNE : Keeps the endpoints of the boxes along one axis sorted, from step to step. As the bodies move only
+ *                    a little per step, the endpoints are nearly sorted and an insertion sort re-sorts them in about
+ *                    O(n). A single sweep over them then finds the pairs. Best when the bodies are spread out.
+ *  UNIFORM_GRID    : Hashes every box into the cells of a uniform grid that it overlaps, only the bodies in the same
+ *                    cell are tested. Best for dense scenes with bodies of similar sizes. Bodies that overlap too many
+ *                    cells (ex; the ground) are tested against every body instead.
+ *  DYNAMIC_TREE    : Keeps the dynamic bodies in a dynamic bounding volume tree and the static bodies in a separate
+ *                    tree that is only rebuilt when they change. (see: aabb_tree.hpp) Best for scenes with many
+ *                    static colliders, and the only one that the world can answer ray and overlap queries with
+ *                    without testing every body.
+ *
+ * Pairs of two static bodies are never reported.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./aabb.hpp"
+#include "./aabb_tree.hpp"
+#include "./culling.hpp"
+
+#ifndef _PHYSICS_BROADPHASE_DEFINITION_HPP_
+    #define _PHYSICS_BROADPHASE_DEFINITION_HPP_
+
+    #include <vector>
+    #include <memory>
+    #include <algorithm>
+    #include <cmath>
+    #include <limits>
+
+    _PHYSICS_START_
+
+    /** @brief Two bodies whose bounding boxes overlap. @c a is always the smaller handle. */
+    struct body_pair
+    {
+        body_handle a;
+        body_handle b;
+
+        bool operator==(const body_pair& other) const noexcept(true) { return a == other.a && b == other.b; }
+        bool operator<(const body_pair& other) const noexcept(true) { return a < other.a || (a == other.a && b < other.b); }
+    };
+
+    /** @brief The different broadphases. (see: the top of this file) */
+    enum class broadphase_type : uint8_t
+    {
+        SWEEP_AND_PRUNE = 0,
+        UNIFORM_GRID    = 1,
+        DYNAMIC_TREE    = 2
+    };
+
+    /** @brief How the broadphase of a world is created. */
+    struct broadphase_settings
+    {
+        broadphase_type type = broadphase_type::SWEEP_AND_PRUNE;
+
+        /** @brief The size of a cell of the uniform grid. 0 picks it on every step from the average size of the bodies. */
+        float grid_cell_size = 0.0f;
+        /** @brief A body that overlaps more cells than this is tested against every body instead. */
+        size_t grid_max_cells_per_body = 64;
+
+        /** @brief How much the boxes in the dynamic tree are fattened by. */
+        float tree_margin = 0.1f;
+        /** @brief The boxes in the dynamic tree are also extended by this many times the displacement of the last step. */
+        float tree_displacement_multiplier = 2.0f;
+    };
+
+    /** @brief What the last call to find_pairs did. */
+    struct broadphase_stats
+    {
+        /** @brief The number of pairs whose boxes were tested against each other. */
+        size_t tests = 0;
+        /** @brief The number of pairs that were found. */
+        size_t pairs = 0;
+    };
+
+    /** @brief The interface that every broadphase implements. */
+    class broadphase
+    {
+    protected:
+        broadphase_stats _stats;
+
+        /** @brief Adds the pair unless both of the bodies are static. */
+        static void add_pair(const body_store& bodies, size_t first, size_t second, std::vector<body_pair>& pairs)
+        {
+            if(bodies.is_static(first) && bodies.is_static(second)) return;
+
+            body_handle a = bodies.handles[first], b = bodies.handles[second];
+            pairs.push_back(a < b ? body_pair { a, b } : body_pair { b, a });
+        }
+
+    public:
+        virtual ~broadphase() = default;
+
+        /** @brief Called after a body is created. */
+        virtual void insert(body_handle handle) = 0;
+        /** @brief Called before a body is destroyed. */
+        virtual void erase(body_handle handle) = 0;
+
+        /**
+         * @brief Finds every pair of bodies whose boxes overlap.
+         * @param bodies A reference to the bodies.
+         * @param bounds The box of every body, in the order of their indices. (see: compute_bounds)
+         * @param pairs Where to write the pairs. It is cleared first.
+        */
+        virtual void find_pairs(const body_store& bodies, const std::vector<aabb>& bounds, std::vector<body_pair>& pairs) = 0;
+
+        virtual broadphase_type type() const noexcept(true) = 0;
+
+        /** @brief Returns what the last call to find_pairs did. */
+        const broadphase_stats& stats() const noexcept(true) { return _stats; }
+    };
+
+    /** @brief The incremental sweep-and-prune broadphase. */
+    class sweep_and_prune : public broadphase
+    {
+    private:
+        /** @brief The minimum or the maximum of a box along the sweep axis. */
+        struct endpoint
+        {
+            float value;
+            /** @brief The handle of the body shifted left by one, the lowest bit is set for a maximum. */
+            uint32_t data;
+
+            body_handle handle() const noexcept(true) { return data >> 1; }
+            bool is_max() const noexcept(true) { return data & 1; }
+
+            /** @brief Minimums come before maximums of the same value, so that touching boxes overlap. */
+            bool operator<(const endpoint& other) const noexcept(true)
+            {
+                return value < other.value || (value == other.value && (data & 1) < (other.data & 1));
+            }
+        };
+
+        std::vector<endpoint> _endpoints;
+        /** @brief The bodies whose minimum has been passed by the sweep but not their maximum yet. */
+        std::vector<body_handle> _active;
+        /** @brief Where every handle is in _active. */
+        std::vector<uint32_t> _active_slots;
+
+        int _axis = 0;
+        size_t _inserted = 0;
+
+        /** @brief Picks the axis along which the centers are spread the most, it leads to the fewest overlaps. */
+        void choose_axis(const std::vector<aabb>& bounds)
+        {
+            if(bounds.empty()) return;
+
+            glm::vec3 sum(0.0f), sum_sq(0.0f);
+            for(const aabb& box : bounds)
+            {
+                glm::vec3 c = box.center();
+                sum = sum + c;
+                sum_sq = sum_sq + c * c;
+            }
+            float n = static_cast<float>(bounds.size());
+            glm::vec3 variance = sum_sq / n - (sum / n) * (sum / n);
+
+            _axis = variance.y > variance.x ? 1 : 0;
+            if(variance.z > variance[_axis]) _axis = 2;
+        }
+
+    public:
+        void insert(body_handle handle) override
+        {
+            // The new endpoints are moved into place by the next sort.
+            _endpoints.push_back(endpoint { std::numeric_limits<float>::max(), handle << 1 });
+            _endpoints.push_back(endpoint { std::numeric_limits<float>::max(), (handle << 1) | 1 });
+            if(handle >= _active_slots.size()) _active_slots.resize(handle + 1);
+            _inserted++;
+        }
+
+        void erase(body_handle handle) override
+        {
+            // Erasing (rather than swapping) keeps the endpoints sorted.
+            _endpoints.erase(std::remove_if(_endpoints.begin(), _endpoints.end(),
+                [handle](const endpoint& e) { return e.handle() == handle; }), _endpoints.end());
+        }
+
+        void find_pairs(const body_store& bodies, const std::vector<aabb>& bounds, std::vector<body_pair>& pairs) override
+        {
+            pairs.clear();
+            _stats = broadphase_stats();
+
+            // Inserting many bodies at once would make the insertion sort quadratic, sort from scratch instead.
+            bool full_sort = _inserted > _endpoints.size() / 8;
+            if(full_sort) choose_axis(bounds);
+            _inserted = 0;
+
+            for(endpoint& e : _endpoints)
+            {
+                const aabb& box = bounds[bodies.index_of(e.handle())];
+                e.value = e.is_max() ? box.max[_axis] : box.min[_axis];
+            }
+
+            if(full_sort) std::sort(_endpoints.begin(), _endpoints.end());
+            else
+            {
+                for(size_t i = 1; i < _endpoints.size(); i++)
+                {
+                    endpoint e = _endpoints[i];
+                    size_t j = i;
+                    for(; j > 0 && e < _endpoints[j - 1]; j--) _endpoints[j] = _endpoints[j - 1];
+                    _endpoints[j] = e;
+                }
+            }
+
+            _active.clear();
+            // At most every body is active at once, it only allocates after bodies were created.
+            _active.reserve(_endpoints.size() / 2);
+            for(const endpoint& e : _endpoints)
+            {
+                body_handle handle = e.handle();
+                if(e.is_max())
+                {
+                    uint32_t slot = _active_slots[handle];
+                    _active_slots[_active.back()] = slot;
+                    _active[slot] = _active.back();
+                    _active.pop_back();
+                    continue;
+                }
+
+                size_t index = bodies.index_of(handle);
+                const aabb& box = bounds[index];
+                for(body_handle other : _active)
+                {
+                    size_t other_index = bodies.index_of(other);
+                    _stats.tests++;
+                    if(box.overlaps(bounds[other_index])) add_pair(bodies, index, other_index, pairs);
+                }
+
+                _active_slots[handle] = static_cast<uint32_t>(_active.size());
+                _active.push_back(handle);
+            }
+
+            _stats.pairs = pairs.size();
+        }
+
+        broadphase_type type() const noexcept(true) override { return broadphase_type::SWEEP_AND_PRUNE; }
+
+        /** @brief Returns the axis that the endpoints are sorted along. 0 = x, 1 = y, 2 = z */
+        int axis() const noexcept(true) { return _axis; }
+    };
+
+    /** @brief The hashed uniform grid broadphase. */
+    class uniform_grid : public broadphase
+    {
+    private:
+        /** @brief A body in a cell. */
+        struct cell_entry
+        {
+            int32_t x, y, z;
+            uint32_t index;
+        };
+
+        broadphase_settings _settings;
+        float _cell_size = 1.0f;
+
+        std::vector<cell_entry> _entries;
+        std::vector<cell_entry> _sorted;
+        std::vector<uint32_t> _bucket_starts;
+        /** @brief The bodies that overlap too many cells. */
+        std::vector<uint32_t> _oversized;
+        std::vector<uint8_t> _is_oversized;
+
+        static uint32_t hash(int32_t x, int32_t y, int32_t z) noexcept(true)
+        {
+            return static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u ^ static_cast<uint32_t>(z) * 83492791u;
+        }
+
+        int32_t cell_of(float value) const noexcept(true) { return static_cast<int32_t>(std::floor(value / _cell_size)); }
+
+    public:
+        explicit uniform_grid(const broadphase_settings& settings) : _settings(settings) {}
+
+        void insert(body_handle) override {}
+        void erase(body_handle) override {}
+
+        void find_pairs(const body_store& bodies, const std::vector<aabb>& bounds, std::vector<body_pair>& pairs) override
+        {
+            pairs.clear();
+            _stats = broadphase_stats();
+            _entries.clear();
+            _oversized.clear();
+            _is_oversized.assign(bounds.size(), 0);
+            if(bounds.empty()) return;
+
+            if(_settings.grid_cell_size > 0.0f) _cell_size = _settings.grid_cell_size;
+            else
+            {
+                // About as large as the average body, so that most of the bodies overlap up to 8 cells.
+                float sum = 0.0f;
+                for(const aabb& box : bounds)
+                {
+                    glm::vec3 size = box.size();
+                    sum += std::fmax(size.x, std::fmax(size.y, size.z));
+                }
+                _cell_size = std::fmax(sum / static_cast<float>(bounds.size()), 1e-3f);
+            }
+
+            // ============================= INSERT =============================
+            for(size_t i = 0; i < bounds.size(); i++)
+            {
+                const aabb& box = bounds[i];
+                int32_t x0 = cell_of(box.min.x), y0 = cell_of(box.min.y), z0 = cell_of(box.min.z);
+                int32_t x1 = cell_of(box.max.x), y1 = cell_of(box.max.y), z1 = cell_of(box.max.z);
+
+                size_t cells = static_cast<size_t>(x1 - x0 + 1) * static_cast<size_t>(y1 - y0 + 1) * static_cast<size_t>(z1 - z0 + 1);
+                if(cells > _settings.grid_max_cells_per_body)
+                {
+                    _oversized.push_back(static_cast<uint32_t>(i));
+                    _is_oversized[i] = 1;
+                    continue;
+                }
+
+                for(int32_t x = x0; x <= x1; x++)
+                for(int32_t y = y0; y <= y1; y++)
+                for(int32_t z = z0; z <= z1; z++)
+                    _entries.push_back(cell_entry { x, y, z, static_cast<uint32_t>(i) });
+            }
+
+            // ============================= BUCKET =============================
+            // A counting sort by the hash of the cell. The buckets may still contain several cells.
+            size_t bucket_count = 1;
+            while(bucket_count < _entries.size() * 2) bucket_count <<= 1;
+            uint32_t mask = static_cast<uint32_t>(bucket_count - 1);
+
+            _bucket_starts.assign(bucket_count + 1, 0);
+            for(const cell_entry& e : _entries) _bucket_starts[(hash(e.x, e.y, e.z) & mask) + 1]++;
+            for(size_t i = 1; i <= bucket_count; i++) _bucket_starts[i] += _bucket_starts[i - 1];
+
+            _sorted.resize(_entries.size());
+            for(const cell_entry& e : _entries) _sorted[_bucket_starts[hash(e.x, e.y, e.z) & mask]++] = e;
+            // Scattering moved every start to the start of the next bucket, shift them back.
+            for(size_t i = bucket_count; i > 0; i--) _bucket_starts[i] = _bucket_starts[i - 1];
+            _bucket_starts[0] = 0;
+
+            // ============================= PAIRS =============================
+            for(size_t bucket = 0; bucket < bucket_count; bucket++)
+            {
+                uint32_t begin = _bucket_starts[bucket], end = _bucket_starts[bucket + 1];
+                for(uint32_t i = begin; i < end; i++)
+                {
+                    const cell_entry& a = _sorted[i];
+                    for(uint32_t j = i + 1; j < end; j++)
+                    {
+                        const cell_entry& b = _sorted[j];
+                        if(a.x != b.x || a.y != b.y || a.z != b.z) continue;
+
+                        const aabb& box_a = bounds[a.index];
+                        const aabb& box_b = bounds[b.index];
+                        _stats.tests++;
+                        if(!box_a.overlaps(box_b)) continue;
+
+                        // Two boxes share every cell that their intersection overlaps, the pair is only reported by
+                        // the cell that contains the minimum corner of the intersection.
+                        if(cell_of(std::fmax(box_a.min.x, box_b.min.x)) != a.x
+                            || cell_of(std::fmax(box_a.min.y, box_b.min.y)) != a.y
+                            || cell_of(std::fmax(box_a.min.z, box_b.min.z)) != a.z) continue;
+
+                        add_pair(bodies, a.index, b.index, pairs);
+                    }
+                }
+            }
+
+            // ============================= OVERSIZED =============================
+            for(uint32_t index : _oversized)
+            {
+                for(uint32_t other = 0; other < bounds.size(); other++)
+                {
+                    // Pairs of two oversized bodies are only tested once.
+                    if(_is_oversized[other] && other <= index) continue;
+
+                    _stats.tests++;
+                    if(bounds[index].overlaps(bounds[other])) add_pair(bodies, index, other, pairs);
+                }
+            }
+
+            _stats.pairs = pairs.size();
+        }
+
+        broadphase_type type() const noexcept(true) override { return broadphase_type::UNIFORM_GRID; }
+
+        /** @brief Returns the size of a cell that was used by the last call to find_pairs. */
+        float cell_size() const noexcept(true) { return _cell_size; }
+    };
+
+    /** @brief The broadphase that is built from two bounding volume trees. */
+    class dynamic_tree_broadphase : public broadphase
+    {
+    private:
+        broadphase_settings _settings;
+        aabb_tree _dynamic;
+        aabb_tree _static;
+        bool _static_dirty = false;
+
+        /** @brief The proxy of every handle, in whichever tree it is in. */
+        std::vector<node_index> _proxies;
+        std::vector<uint8_t> _in_static;
+        /** @brief The bodies that were inserted since the last step. Their boxes aren't known until then. */
+        std::vector<body_handle> _pending;
+
+    public:
+        explicit dynamic_tree_broadphase(const broadphase_settings& settings)
+            : _settings(settings), _dynamic(settings.tree_margin), _static(0.0f) {}
+
+        void insert(body_handle handle) override
+        {
+            if(handle >= _proxies.size())
+            {
+                _proxies.resize(handle + 1, null_node);
+                _in_static.resize(handle + 1, 0);
+            }
+            _pending.push_back(handle);
+        }
+
+        void erase(body_handle handle) override
+        {
+            node_index proxy = _proxies[handle];
+            if(proxy == null_node)
+            {
+                _pending.erase(std::remove(_pending.begin(), _pending.end(), handle), _pending.end());
+                return;
+            }
+
+            if(_in_static[handle])
+            {
+                _static.destroy_proxy(proxy);
+                _static_dirty = true;
+            }
+            else _dynamic.destroy_proxy(proxy);
+            _proxies[handle] = null_node;
+        }
+
+        void find_pairs(const body_store& bodies, const std::vector<aabb>& bounds, std::vector<body_pair>& pairs) override
+        {
+            pairs.clear();
+            _stats = broadphase_stats();
+
+            // ============================= UPDATE THE TREES =============================
+            for(body_handle handle : _pending)
+            {
+                size_t index = bodies.index_of(handle);
+                _in_static[handle] = bodies.is_static(index);
+                if(_in_static[handle])
+                {
+                    _proxies[handle] = _static.create_proxy(bounds[index], handle);
+                    _static_dirty = true;
+                }
+                else _proxies[handle] = _dynamic.create_proxy(bounds[index], handle);
+            }
+            _pending.clear();
+
+            for(size_t i = 0; i < bodies.size(); i++)
+            {
+                body_handle handle = bodies.handles[i];
+                if(_in_static[handle])
+                {
+                    // Static bodies only move when they are teleported.
+                    if(_static.move_proxy(_proxies[handle], bounds[i])) _static_dirty = true;
+                    continue;
+                }
+
+                // The box also covers where the body was at the start of the step, so that a body that is drawn
+                // in between (see: world::cull) is inside of its fattened box. The fattening only looks ahead.
+                glm::vec3 moved = bodies.position.get(i) - bodies.previous_position.get(i);
+                aabb swept = bounds[i];
+                swept.min -= glm::max(moved, glm::vec3(0.0f));
+                swept.max -= glm::min(moved, glm::vec3(0.0f));
+                _dynamic.move_proxy(_proxies[handle], swept, moved * _settings.tree_displacement_multiplier);
+            }
+
+            if(_static_dirty)
+            {
+                _static.rebuild();
+                _static_dirty = false;
+            }
+
+            // ============================= PAIRS =============================
+            for(size_t i = 0; i < bodies.size(); i++)
+            {
+                body_handle handle = bodies.handles[i];
+                if(_in_static[handle]) continue;
+
+                const aabb& box = bounds[i];
+                auto test = [&](node_index, uint32_t other)
+                {
+                    // The fattened boxes overlap, the pair is only reported if the tight boxes do too.
+                    size_t other_index = bodies.index_of(other);
+                    _stats.tests++;
+                    if(box.overlaps(bounds[other_index])) add_pair(bodies, i, other_index, pairs);
+                    return true;
+                };
+
+                // Every pair of dynamic bodies is found twice, only the one from the smaller handle is kept.
+                _dynamic.query(box, [&](node_index proxy, uint32_t other) { return other <= handle ? true : test(proxy, other); });
+                _static.query(box, test);
+            }
+
+            _stats.pairs = pairs.size();
+        }
+
+        broadphase_type type() const noexcept(true) override { return broadphase_type::DYNAMIC_TREE; }
+
+        /**
+         * @brief Calls the function for every body whose (fattened) box overlaps the box.
+         * @param fn Called as bool(body_handle body), returning false stops the query.
+        */
+        template <typename Fn>
+        void query(const aabb& box, Fn&& fn) const
+        {
+            bool stopped = false;
+            _dynamic.query(box, [&](node_index, uint32_t handle) { return !(stopped = !fn(handle)); });
+            if(!stopped) _static.query(box, [&](node_index, uint32_t handle) { return fn(handle); });
+        }
+
+        /**
+         * @brief Casts a ray against the (fattened) boxes of the bodies. (see: aabb_tree::raycast)
+         * @param fn Called as float(body_handle body, float max_distance).
+        */
+        template <typename Fn>
+        void raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, Fn&& fn) const
+        {
+            _dynamic.raycast(origin, direction, max_distance, [&](node_index, uint32_t handle, float distance)
+            {
+                return max_distance = fn(handle, distance);
+            });
+            if(max_distance > 0.0f) _static.raycast(origin, direction, max_distance, [&](node_index, uint32_t handle, float distance)
+            {
+                return fn(handle, distance);
+            });
+        }
+
+        /**
+         * @brief Finds the body that is the nearest to the point. (see: aabb_tree::nearest)
+         * @param fn Called as float(body_handle body), must return the exact distance to the body.
+         * @returns The nearest body, or invalid_body_handle if there is none within max_distance.
+        */
+        template <typename Fn>
+        body_handle nearest(const glm::vec3& point, float max_distance, Fn&& fn) const
+        {
+            float distance = max_distance;
+            auto exact = [&](node_index, uint32_t handle) { return fn(handle); };
+
+            node_index dynamic = _dynamic.nearest(point, max_distance, exact, &distance);
+            node_index fixed = _static.nearest(point, distance, exact);
+
+            if(fixed != null_node) return _static.get_user_data(fixed);
+            if(dynamic != null_node) return _dynamic.get_user_data(dynamic);
+            return invalid_body_handle;
+        }
+
+        /**
+         * @brief Calls the function for every body whose (fattened) box is inside the frustum. (see: cull_tree)
+         * @param fn Called as void(body_handle body).
+        */
+        template <typename Fn>
+        void cull(const frustum& volume, Fn&& fn) const
+        {
+            cull_tree(_dynamic, volume, [&](node_index, uint32_t handle) { fn(handle); });
+            cull_tree(_static, volume, [&](node_index, uint32_t handle) { fn(handle); });
+        }
+
+        const aabb_tree& dynamic_tree() const noexcept(true) { return _dynamic; }
+        const aabb_tree& static_tree() const noexcept(true) { return _static; }
+    };
+
+    /** @brief Creates the broadphase that the settings describe. */
+    std::unique_ptr<broadphase> create_broadphase(const broadphase_settings& settings)
+    {
+        switch(settings.type)
+        {
+        case broadphase_type::UNIFORM_GRID: return std::make_unique<uniform_grid>(settings);
+        case broadphase_type::DYNAMIC_TREE: return std::make_unique<dynamic_tree_broadphase>(settings);
+        case broadphase_type::SWEEP_AND_PRUNE: break;
+        }
+        return std::make_unique<sweep_and_prune>();
+    }
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+/**
+ * This header contains the view frustum and the culling of the bodies against it, so that the bodies that are off
+ * screen are never written into the instance buffer nor drawn.
+ *
+ * A box is tested against all six planes at once, one plane per lane. (see: simd.hpp) The planes are padded to
+ * eight lanes with a plane that every box is in front of, hence it is one instruction per step with AVX2 and two with
+ * SSE or NEON. The bounding volume tree (see: aabb_tree.hpp) is walked from the root; a node that is outside of one
+ * plane is skipped with all of its children and a node that is inside of every plane has all of its leaves reported
+ * without testing them.
+ *
+ * Usage;
+ *  physics::frustum view = physics::frustum::from_matrix(projection * view_matrix);
+ *  size_t visible = world.cull(view, indices.data());
+ *  world.write_instance_transforms(indices.data(), visible, buffer.map_region<instance_transform>(), alpha);
+ *
+ * For the bodies that are behind other bodies, see: glfw/occlusion_culling.hpp
+*/
+
+#include "./physics.hpp"
+#include "./simd.hpp"
+#include "./aabb.hpp"
+#include "./aabb_tree.hpp"
+
+#ifndef _PHYSICS_CULLING_DEFINITION_HPP_
+    #define _PHYSICS_CULLING_DEFINITION_HPP_
+
+    #include <cmath>
+
+    _PHYSICS_START_
+
+    /** @brief Where a box is compared to a volume. */
+    enum class containment : uint8_t
+    {
+        OUTSIDE     = 0,
+        INTERSECTS  = 1,
+        INSIDE      = 2
+    };
+
+    /** @brief The six planes of a view frustum. (see: the top of this file) */
+    class frustum
+    {
+    private:
+        /** @brief The number of lanes that the planes are padded to. A multiple of every simd::width. */
+        static constexpr size_t lanes = 8;
+
+        /** @brief The normals (pointing into the frustum), their absolute values and the distances, one plane per lane. */
+        alignas(simd_alignment) float _nx[lanes];
+        alignas(simd_alignment) float _ny[lanes];
+        alignas(simd_alignment) float _nz[lanes];
+        alignas(simd_alignment) float _ax[lanes];
+        alignas(simd_alignment) float _ay[lanes];
+        alignas(simd_alignment) float _az[lanes];
+        alignas(simd_alignment) float _d[lanes];
+
+    public:
+        /** @brief xyz: The normal, pointing into the frustum. w: The distance. A point p is inside if dot(xyz, p) + w >= 0. */
+        glm::vec4 planes[6];
+
+        frustum() { set_planes(nullptr); }
+
+        /**
+         * @brief Sets the planes. The normals don't have to be normalized, the tests only compare signs.
+         * @param values The six planes, nullptr for a frustum that contains everything.
+        */
+        void set_planes(const glm::vec4* values)
+        {
+            for(size_t i = 0; i < lanes; i++)
+            {
+                // The padding is a plane that every box is far in front of.
+                glm::vec4 p = values && i < 6 ? values[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1e30f);
+                if(i < 6) planes[i] = p;
+                _nx[i] = p.x; _ny[i] = p.y; _nz[i] = p.z; _d[i] = p.w;
+                _ax[i] = std::fabs(p.x); _ay[i] = std::fabs(p.y); _az[i] = std::fabs(p.z);
+            }
+        }
+
+        /**
+         * @brief Extracts the planes of the frustum from a matrix. (Gribb and Hartmann)
+         * @param view_projection The projection matrix times the view matrix. The OpenGL clip space is assumed, i.e. -w <= z <= w.
+        */
+        static frustum from_matrix(const glm::mat4& view_projection)
+        {
+            // The rows of the (column-major) matrix.
+            glm::vec4 row[4];
+            for(int r = 0; r < 4; r++) row[r] = glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+
+            glm::vec4 planes[6] = {
+                row[3] + row[0], row[3] - row[0],   // left, right
+                row[3] + row[1], row[3] - row[1],   // bottom, top
+                row[3] + row[2], row[3] - row[2]    // near, far
+            };
+            for(glm::vec4& p : planes) p /= glm::length(glm::vec3(p));
+
+            frustum result;
+            result.set_planes(planes);
+            return result;
+        }
+
+        /**
+         * @brief Where the box is compared to the frustum. A box that crosses the planes outside of the frustum (near
+         * its corners) is reported as INTERSECTS even though it is outside, which only costs drawing it.
+        */
+        containment classify(const aabb& box) const
+        {
+            glm::vec3 center = box.center(), extent = box.size() * 0.5f;
+            simd::vfloat cx = simd::set1(center.x), cy = simd::set1(center.y), cz = simd::set1(center.z);
+            simd::vfloat ex = simd::set1(extent.x), ey = simd::set1(extent.y), ez = simd::set1(extent.z);
+
+            unsigned outside = 0, crossing = 0;
+            for(size_t i = 0; i < lanes; i += simd::width)
+            {
+                // The signed distance of the center and the radius of the box along the normal.
+                simd::vfloat distance = simd::fmadd(simd::load(_nx + i), cx, simd::fmadd(simd::load(_ny + i), cy,
+                    simd::fmadd(simd::load(_nz + i), cz, simd::load(_d + i))));
+                simd::vfloat radius = simd::fmadd(simd::load(_ax + i), ex, simd::fmadd(simd::load(_ay + i), ey, simd::load(_az + i) * ez));
+
+                outside |= simd::bits(distance < -radius);
+                crossing |= simd::bits(distance < radius);
+            }
+            return outside ? containment::OUTSIDE : crossing ? containment::INTERSECTS : containment::INSIDE;
+        }
+
+        bool intersects(const aabb& box) const { return classify(box) != containment::OUTSIDE; }
+    };
+
+    /**
+     * @brief Calls the function for every proxy of the tree whose fattened box is (at least partly) inside the frustum.
+     * @param fn Called as void(node_index proxy, uint32_t user_data).
+    */
+    template <typename Fn>
+    void cull_tree(const aabb_tree& tree, const frustum& volume, Fn&& fn)
+    {
+        if(tree.root() == null_node) return;
+        const std::vector<aabb_tree::node>& nodes = tree.nodes();
+
+        // The second stack holds the subtrees that are completely inside, their boxes aren't tested anymore.
+        node_stack stack, inside;
+        stack.push(tree.root());
+        while(!stack.empty())
+        {
+            node_index index = stack.pop();
+            const aabb_tree::node& n = nodes[index];
+
+            containment c = volume.classify(n.box);
+            if(c == containment::OUTSIDE) continue;
+            if(n.is_leaf())
+            {
+                fn(index, n.user_data);
+                continue;
+            }
+            if(c == containment::INTERSECTS)
+            {
+                stack.push(n.left);
+                stack.push(n.right);
+                continue;
+            }
+
+            inside.push(index);
+            while(!inside.empty())
+            {
+                node_index i = inside.pop();
+                const aabb_tree::node& m = nodes[i];
+                if(m.is_leaf()) fn(i, m.user_data);
+                else
+                {
+                    inside.push(m.left);
+                    inside.push(m.right);
+                }
+            }
+        }
+    }
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
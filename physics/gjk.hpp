@@ -0,0 +1,436 @@
+/**
+ * This header contains GJK and EPA, the general (and slower) way of finding the contact between two convex shapes.
+ * The narrowphase falls back to them for the pairs that have no specialized kernel. (see: narrowphase.hpp)
+ *
+ * Both work on the Minkowski difference of the shapes, A - B, through the support functions of the shapes alone.
+ * Every shape is split into a core and a radius; a sphere is a point grown by its radius, a capsule a segment, a box
+ * or a hull has a radius of 0 (or the radius that rounds its corners). GJK finds the closest points between the
+ * cores, which is enough as long as the cores don't overlap. EPA finds how deep they overlap when they do.
+ *
+ *  GJK : Gilbert-Johnson-Keerthi, with the closest point on the simplex found by its Voronoi regions.
+ *        (Real-Time Collision Detection, 5.1.5 and 9.5)
+ *  EPA : The expanding polytope algorithm. Grows the simplex that GJK ended with until the face of the polytope
+ *        that is the closest to the origin is on the surface of the difference.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+
+#ifndef _PHYSICS_GJK_DEFINITION_HPP_
+    #define _PHYSICS_GJK_DEFINITION_HPP_
+
+    #include <cmath>
+    #include <limits>
+
+    _PHYSICS_START_
+
+    namespace narrowphase
+    {
+        /** @brief The pose of a shape. */
+        struct transform
+        {
+            glm::vec3 position;
+            glm::quat orientation;
+        };
+
+        /** @brief Returns the radius that the core of the shape is grown by. */
+        inline float core_radius(const shape& s) noexcept(true) { return s.type == shape_type::BOX ? 0.0f : s.radius; }
+
+        /** @brief Returns the point of the core of the shape that is the furthest along the direction, in its local space. */
+        inline glm::vec3 local_support(const shape& s, const glm::vec3& d)
+        {
+            switch(s.type)
+            {
+            case shape_type::SPHERE:
+                return glm::vec3(0.0f);
+            case shape_type::BOX:
+                return glm::vec3(d.x < 0.0f ? -s.half_extents.x : s.half_extents.x,
+                    d.y < 0.0f ? -s.half_extents.y : s.half_extents.y,
+                    d.z < 0.0f ? -s.half_extents.z : s.half_extents.z);
+            case shape_type::CAPSULE:
+                return glm::vec3(0.0f, d.y < 0.0f ? -s.half_extents.y : s.half_extents.y, 0.0f);
+            case shape_type::CONVEX:
+            {
+                glm::vec3 best(0.0f);
+                float best_distance = -std::numeric_limits<float>::max();
+                for(const glm::vec3& p : *s.hull)
+                {
+                    float distance = glm::dot(p, d);
+                    if(distance > best_distance) { best_distance = distance; best = p; }
+                }
+                return best;
+            }
+            }
+            return glm::vec3(0.0f);
+        }
+
+        /** @brief Returns the point of the core of the shape that is the furthest along the direction, in world space. */
+        inline glm::vec3 support(const shape& s, const transform& t, const glm::vec3& d)
+        {
+            return t.position + t.orientation * local_support(s, glm::conjugate(t.orientation) * d);
+        }
+
+        /** @brief A point of the Minkowski difference, and the points of the two shapes that it is made of. */
+        struct simplex_vertex
+        {
+            glm::vec3 a, b;
+            /** @brief a - b */
+            glm::vec3 w;
+        };
+
+        /** @brief Between 1 and 4 points of the difference, and the weights of the point of their hull that is the closest to the origin. */
+        struct simplex
+        {
+            simplex_vertex vertices[4];
+            float weights[4];
+            int count = 0;
+
+            glm::vec3 closest() const
+            {
+                glm::vec3 v(0.0f);
+                for(int i = 0; i < count; i++) v += vertices[i].w * weights[i];
+                return v;
+            }
+        };
+
+        /** @brief What gjk found. */
+        struct gjk_result
+        {
+            /** @brief Whether or not the cores overlap. The points and the distance are only set if they don't. */
+            bool overlap = false;
+            /** @brief The closest points of the cores. */
+            glm::vec3 point_a = glm::vec3(0.0f), point_b = glm::vec3(0.0f);
+            float distance = 0.0f;
+            /** @brief The last simplex, what epa starts from. */
+            narrowphase::simplex simplex;
+        };
+
+        namespace detail
+        {
+            inline simplex_vertex make_vertex(const shape& a, const transform& ta, const shape& b, const transform& tb, const glm::vec3& d)
+            {
+                simplex_vertex v;
+                v.a = support(a, ta, d);
+                v.b = support(b, tb, -d);
+                v.w = v.a - v.b;
+                return v;
+            }
+
+            /** @brief Keeps the listed vertices (in that order) with the weights. */
+            inline void reduce(simplex& s, int count, const int* keep, const float* weights)
+            {
+                simplex_vertex vertices[4];
+                for(int i = 0; i < count; i++) vertices[i] = s.vertices[keep[i]];
+                for(int i = 0; i < count; i++) { s.vertices[i] = vertices[i]; s.weights[i] = weights[i]; }
+                s.count = count;
+            }
+
+            inline void solve_segment(simplex& s)
+            {
+                glm::vec3 a = s.vertices[0].w, ab = s.vertices[1].w - a;
+                float length_sq = glm::dot(ab, ab);
+                float t = length_sq > 1e-12f ? -glm::dot(a, ab) / length_sq : 0.0f;
+
+                if(t <= 0.0f) { int keep[] = { 0 }; float w[] = { 1.0f }; reduce(s, 1, keep, w); }
+                else if(t >= 1.0f) { int keep[] = { 1 }; float w[] = { 1.0f }; reduce(s, 1, keep, w); }
+                else { s.weights[0] = 1.0f - t; s.weights[1] = t; }
+            }
+
+            /** @brief The closest point of the triangle to the origin, by its Voronoi regions. (Real-Time Collision Detection, 5.1.5) */
+            inline void solve_triangle(simplex& s)
+            {
+                glm::vec3 a = s.vertices[0].w, b = s.vertices[1].w, c = s.vertices[2].w;
+                glm::vec3 ab = b - a, ac = c - a;
+
+                float d1 = glm::dot(ab, -a), d2 = glm::dot(ac, -a);
+                if(d1 <= 0.0f && d2 <= 0.0f) { int keep[] = { 0 }; float w[] = { 1.0f }; reduce(s, 1, keep, w); return; }
+
+                float d3 = glm::dot(ab, -b), d4 = glm::dot(ac, -b);
+                if(d3 >= 0.0f && d4 <= d3) { int keep[] = { 1 }; float w[] = { 1.0f }; reduce(s, 1, keep, w); return; }
+
+                float vc = d1 * d4 - d3 * d2;
+                if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+                {
+                    float t = d1 / (d1 - d3);
+                    int keep[] = { 0, 1 }; float w[] = { 1.0f - t, t }; reduce(s, 2, keep, w); return;
+                }
+
+                float d5 = glm::dot(ab, -c), d6 = glm::dot(ac, -c);
+                if(d6 >= 0.0f && d5 <= d6) { int keep[] = { 2 }; float w[] = { 1.0f }; reduce(s, 1, keep, w); return; }
+
+                float vb = d5 * d2 - d1 * d6;
+                if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+                {
+                    float t = d2 / (d2 - d6);
+                    int keep[] = { 0, 2 }; float w[] = { 1.0f - t, t }; reduce(s, 2, keep, w); return;
+                }
+
+                float va = d3 * d6 - d5 * d4;
+                if(va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+                {
+                    float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                    int keep[] = { 1, 2 }; float w[] = { 1.0f - t, t }; reduce(s, 2, keep, w); return;
+                }
+
+                float denominator = 1.0f / (va + vb + vc);
+                float v = vb * denominator, w = vc * denominator;
+                s.weights[0] = 1.0f - v - w; s.weights[1] = v; s.weights[2] = w;
+            }
+
+            /** @returns Whether or not the tetrahedron holds the origin. Otherwise it is reduced to the closest face, edge or vertex. */
+            inline bool solve_tetrahedron(simplex& s)
+            {
+                static constexpr int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+
+                simplex best;
+                float best_distance = std::numeric_limits<float>::max();
+                bool inside = true;
+                for(const int* f : faces)
+                {
+                    glm::vec3 a = s.vertices[f[0]].w;
+                    glm::vec3 n = glm::cross(s.vertices[f[1]].w - a, s.vertices[f[2]].w - a);
+                    float origin_side = glm::dot(-a, n), opposite_side = glm::dot(s.vertices[f[3]].w - a, n);
+                    // A flat tetrahedron holds nothing, every one of its faces is tested.
+                    if(origin_side * opposite_side > 0.0f && std::fabs(opposite_side) > 1e-12f) continue;
+                    inside = false;
+
+                    simplex face;
+                    face.count = 3;
+                    for(int i = 0; i < 3; i++) face.vertices[i] = s.vertices[f[i]];
+                    solve_triangle(face);
+                    glm::vec3 v = face.closest();
+                    if(glm::dot(v, v) < best_distance) { best_distance = glm::dot(v, v); best = face; }
+                }
+                if(inside) return true;
+                s = best;
+                return false;
+            }
+        }; // namespace detail
+
+        /**
+         * @brief Finds the closest points between the cores of two shapes.
+         * @param a The first shape.
+         * @param ta The pose of the first shape.
+         * @param b The second shape.
+         * @param tb The pose of the second shape.
+        */
+        gjk_result gjk(const shape& a, const transform& ta, const shape& b, const transform& tb)
+        {
+            constexpr int max_iterations = 32;
+
+            gjk_result result;
+            simplex& s = result.simplex;
+
+            glm::vec3 d = ta.position - tb.position;
+            if(glm::dot(d, d) < 1e-12f) d = glm::vec3(1.0f, 0.0f, 0.0f);
+            s.vertices[0] = detail::make_vertex(a, ta, b, tb, d);
+            s.weights[0] = 1.0f;
+            s.count = 1;
+            glm::vec3 v = s.vertices[0].w;
+
+            for(int iteration = 0; iteration < max_iterations; iteration++)
+            {
+                float distance_sq = glm::dot(v, v);
+                if(distance_sq < 1e-12f) { result.overlap = true; return result; }
+
+                // No new point is further along -v than v itself, v is the closest point.
+                simplex_vertex vertex = detail::make_vertex(a, ta, b, tb, -v);
+                if(distance_sq - glm::dot(v, vertex.w) <= 1e-6f * distance_sq) break;
+
+                simplex previous = s;
+                s.vertices[s.count++] = vertex;
+                if(s.count == 2) detail::solve_segment(s);
+                else if(s.count == 3) detail::solve_triangle(s);
+                else if(detail::solve_tetrahedron(s)) { result.overlap = true; return result; }
+
+                glm::vec3 next = s.closest();
+                // Numerical trouble; the closest point stopped getting closer.
+                if(glm::dot(next, next) >= distance_sq) { s = previous; break; }
+                v = next;
+            }
+
+            for(int i = 0; i < s.count; i++)
+            {
+                result.point_a += s.vertices[i].a * s.weights[i];
+                result.point_b += s.vertices[i].b * s.weights[i];
+            }
+            result.distance = glm::length(v);
+            return result;
+        }
+
+        /** @brief What epa found. */
+        struct epa_result
+        {
+            /** @brief The direction that b must be moved in to separate the cores, it points from a to b. */
+            glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            /** @brief How far b must be moved. */
+            float depth = 0.0f;
+            /** @brief The deepest points of the cores. */
+            glm::vec3 point_a = glm::vec3(0.0f), point_b = glm::vec3(0.0f);
+        };
+
+        /**
+         * @brief Finds how deep the cores of two shapes overlap.
+         * @param start The simplex that gjk ended with, it must hold the origin.
+         * @param result Set to the penetration.
+         * @returns false if the difference is flat (ex; two crossing segments), the result is left untouched then.
+        */
+        bool epa(const shape& a, const transform& ta, const shape& b, const transform& tb, const simplex& start, epa_result& result)
+        {
+            constexpr int max_vertices = 64;
+            constexpr int max_faces = 128;
+            constexpr int max_edges = 128;
+            constexpr float tolerance = 1e-4f;
+
+            struct face
+            {
+                int v[3];
+                glm::vec3 normal;
+                float distance;
+            };
+
+            simplex_vertex vertices[max_vertices];
+            face faces[max_faces];
+            int edges[max_edges][2];
+            int vertex_count = start.count, face_count = 0;
+            for(int i = 0; i < start.count; i++) vertices[i] = start.vertices[i];
+
+            // ============================= GROW THE SIMPLEX INTO A TETRAHEDRON =============================
+            static const glm::vec3 axes[] = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+            if(vertex_count == 1)
+            {
+                for(const glm::vec3& axis : axes)
+                {
+                    simplex_vertex v = detail::make_vertex(a, ta, b, tb, axis);
+                    glm::vec3 d = v.w - vertices[0].w;
+                    if(glm::dot(d, d) > 1e-8f) { vertices[vertex_count++] = v; break; }
+                }
+                if(vertex_count == 1) return false;
+            }
+            if(vertex_count == 2)
+            {
+                glm::vec3 line = vertices[1].w - vertices[0].w;
+                glm::vec3 axis = std::fabs(line.x) < std::fabs(line.y) ? (std::fabs(line.x) < std::fabs(line.z) ? axes[0] : axes[4])
+                    : (std::fabs(line.y) < std::fabs(line.z) ? axes[2] : axes[4]);
+                glm::vec3 side = glm::cross(line, axis);
+                glm::vec3 directions[] = { side, -side, glm::cross(line, side), -glm::cross(line, side) };
+                for(const glm::vec3& direction : directions)
+                {
+                    simplex_vertex v = detail::make_vertex(a, ta, b, tb, direction);
+                    glm::vec3 c = glm::cross(v.w - vertices[0].w, line);
+                    if(glm::dot(c, c) > 1e-8f * glm::dot(line, line)) { vertices[vertex_count++] = v; break; }
+                }
+                if(vertex_count == 2) return false;
+            }
+            if(vertex_count == 3)
+            {
+                glm::vec3 n = glm::cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w);
+                float area = glm::length(n);
+                if(area < 1e-8f) return false;
+                for(float sign : { 1.0f, -1.0f })
+                {
+                    simplex_vertex v = detail::make_vertex(a, ta, b, tb, n * sign);
+                    if(std::fabs(glm::dot(v.w - vertices[0].w, n)) > 1e-6f * area) { vertices[vertex_count++] = v; break; }
+                }
+                if(vertex_count == 3) return false;
+            }
+
+            // The faces are wound so that their normals point away from the fourth vertex.
+            if(glm::dot(glm::cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w), vertices[3].w - vertices[0].w) > 0.0f)
+                std::swap(vertices[1], vertices[2]);
+
+            auto add_face = [&](int i0, int i1, int i2)
+            {
+                if(face_count == max_faces) return false;
+                face& f = faces[face_count++];
+                f.v[0] = i0; f.v[1] = i1; f.v[2] = i2;
+                glm::vec3 n = glm::cross(vertices[i1].w - vertices[i0].w, vertices[i2].w - vertices[i0].w);
+                float length = glm::length(n);
+                if(length < 1e-12f)
+                {
+                    // A sliver, it is kept to close the polytope but never chosen as the closest face.
+                    f.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                    f.distance = std::numeric_limits<float>::max();
+                    return true;
+                }
+                f.normal = n / length;
+                f.distance = glm::dot(f.normal, vertices[i0].w);
+                return true;
+            };
+            add_face(0, 1, 2); add_face(0, 3, 1); add_face(0, 2, 3); add_face(1, 3, 2);
+
+            // ============================= EXPAND =============================
+            int closest = 0;
+            for(;;)
+            {
+                closest = 0;
+                for(int i = 1; i < face_count; i++) if(faces[i].distance < faces[closest].distance) closest = i;
+                const face& nearest = faces[closest];
+                if(nearest.distance == std::numeric_limits<float>::max()) return false;
+
+                simplex_vertex v = detail::make_vertex(a, ta, b, tb, nearest.normal);
+                // The face is (close enough to) the surface of the difference.
+                if(glm::dot(v.w, nearest.normal) - nearest.distance < tolerance || vertex_count == max_vertices) break;
+
+                // Remove every face that the new point sees, the edges that are left open make up the horizon.
+                int edge_count = 0;
+                bool overflow = false;
+                for(int i = 0; i < face_count; )
+                {
+                    const face& f = faces[i];
+                    if(glm::dot(f.normal, v.w - vertices[f.v[0]].w) <= 0.0f) { i++; continue; }
+
+                    for(int e = 0; e < 3; e++)
+                    {
+                        int from = f.v[e], to = f.v[(e + 1) % 3];
+                        // An edge that is shared with another removed face was seen in the other direction.
+                        int shared = -1;
+                        for(int k = 0; k < edge_count; k++) if(edges[k][0] == to && edges[k][1] == from) { shared = k; break; }
+                        if(shared >= 0)
+                        {
+                            edges[shared][0] = edges[edge_count - 1][0];
+                            edges[shared][1] = edges[edge_count - 1][1];
+                            edge_count--;
+                        }
+                        else if(edge_count < max_edges) { edges[edge_count][0] = from; edges[edge_count][1] = to; edge_count++; }
+                        else overflow = true;
+                    }
+                    faces[i] = faces[--face_count];
+                }
+                if(overflow || !edge_count) return false;
+
+                int index = vertex_count++;
+                vertices[index] = v;
+                for(int k = 0; k < edge_count; k++) if(!add_face(edges[k][0], edges[k][1], index)) return false;
+            }
+
+            // ============================= THE CONTACT =============================
+            const face& f = faces[closest];
+            glm::vec3 p = f.normal * f.distance;
+            glm::vec3 w0 = vertices[f.v[0]].w, w1 = vertices[f.v[1]].w, w2 = vertices[f.v[2]].w;
+
+            // The barycentric coordinates of the projection of the origin onto the face.
+            glm::vec3 e0 = w1 - w0, e1 = w2 - w0, e2 = p - w0;
+            float d00 = glm::dot(e0, e0), d01 = glm::dot(e0, e1), d11 = glm::dot(e1, e1);
+            float d20 = glm::dot(e2, e0), d21 = glm::dot(e2, e1);
+            float denominator = d00 * d11 - d01 * d01;
+            float u = 1.0f / 3.0f, v = 1.0f / 3.0f;
+            if(std::fabs(denominator) > 1e-12f)
+            {
+                u = (d11 * d20 - d01 * d21) / denominator;
+                v = (d00 * d21 - d01 * d20) / denominator;
+            }
+            float w = 1.0f - u - v;
+
+            result.normal = f.normal;
+            result.depth = f.distance;
+            result.point_a = vertices[f.v[0]].a * w + vertices[f.v[1]].a * u + vertices[f.v[2]].a * v;
+            result.point_b = vertices[f.v[0]].b * w + vertices[f.v[1]].b * u + vertices[f.v[2]].b * v;
+            return true;
+        }
+    }; // namespace narrowphase
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,174 @@
+/**
+ * This header contains the integration kernels. They advance the state of the bodies using semi-implicit (symplectic)
+ * Euler; the velocities are updated first and the positions are then updated with the new velocities.
+ *
+ * Every kernel processes a range of bodies [begin, end) in steps of simd::width, @c begin must be a multiple of 16
+ * and @c end must not be larger than body_store::padded_size(). The padding bodies have an inverse mass of 0, hence
+ * they never move.
+ *
+ * The sleeping bodies are treated like static ones; gravity isn't applied to them (their velocities are zero) and the
+ * registers that only hold static or sleeping bodies are skipped altogether.
+*/
+
+#include "./physics.hpp"
+#include "./simd.hpp"
+#include "./body_store.hpp"
+
+#ifndef _PHYSICS_INTEGRATE_DEFINITION_HPP_
+    #define _PHYSICS_INTEGRATE_DEFINITION_HPP_
+
+    _PHYSICS_START_
+
+    namespace kernels
+    {
+        using simd::vfloat;
+
+        /** @brief Rotates the vector (vx,vy,vz) by the quaternion (qx,qy,qz,qw) for simd::width bodies at once. */
+        inline void rotate(vfloat qx, vfloat qy, vfloat qz, vfloat qw, vfloat& vx, vfloat& vy, vfloat& vz)
+        {
+            // t = 2 * cross(q.xyz, v)
+            vfloat two = simd::set1(2.0f);
+            vfloat tx = two * (qy * vz - qz * vy);
+            vfloat ty = two * (qz * vx - qx * vz);
+            vfloat tz = two * (qx * vy - qy * vx);
+            // v' = v + q.w * t + cross(q.xyz, t)
+            vfloat rx = simd::fmadd(qw, tx, vx) + (qy * tz - qz * ty);
+            vfloat ry = simd::fmadd(qw, ty, vy) + (qz * tx - qx * tz);
+            vfloat rz = simd::fmadd(qw, tz, vz) + (qx * ty - qy * tx);
+            vx = rx; vy = ry; vz = rz;
+        }
+
+        /**
+         * @brief Applies gravity, the accumulated forces and torques and the damping to the velocities. The forces
+         * and the torques are cleared afterwards.
+         * @param bodies A reference to the bodies.
+         * @param gravity The acceleration that is applied to every dynamic body.
+         * @param dt The size of the step in seconds.
+         * @param begin The index of the first body.
+         * @param end One past the index of the last body.
+        */
+        void integrate_velocities(body_store& bodies, const glm::vec3& gravity, float dt, size_t begin, size_t end)
+        {
+            const vfloat zero = simd::set1(0.0f);
+            const vfloat one = simd::set1(1.0f);
+            const vfloat vdt = simd::set1(dt);
+            const vfloat gx = simd::set1(gravity.x * dt), gy = simd::set1(gravity.y * dt), gz = simd::set1(gravity.z * dt);
+
+            for(size_t i = begin; i < end; i += simd::width)
+            {
+                vfloat inverse_mass = simd::load(bodies.inverse_mass.data() + i);
+                simd::vmask dynamic = (inverse_mass > zero) & (simd::load(bodies.awake.data() + i) > zero);
+                if(!simd::bits(dynamic)) continue;
+
+                // ============================= LINEAR =============================
+                vfloat scale = inverse_mass * vdt;
+                vfloat linear_damping = one / simd::fmadd(vdt, simd::load(bodies.linear_damping.data() + i), one);
+
+                vfloat vx = simd::load(bodies.linear_velocity.x.data() + i);
+                vfloat vy = simd::load(bodies.linear_velocity.y.data() + i);
+                vfloat vz = simd::load(bodies.linear_velocity.z.data() + i);
+
+                vx = simd::fmadd(simd::load(bodies.force.x.data() + i), scale, vx + simd::select(dynamic, gx, zero)) * linear_damping;
+                vy = simd::fmadd(simd::load(bodies.force.y.data() + i), scale, vy + simd::select(dynamic, gy, zero)) * linear_damping;
+                vz = simd::fmadd(simd::load(bodies.force.z.data() + i), scale, vz + simd::select(dynamic, gz, zero)) * linear_damping;
+
+                simd::store(bodies.linear_velocity.x.data() + i, vx);
+                simd::store(bodies.linear_velocity.y.data() + i, vy);
+                simd::store(bodies.linear_velocity.z.data() + i, vz);
+
+                // ============================= ANGULAR =============================
+                vfloat qx = simd::load(bodies.orientation.x.data() + i);
+                vfloat qy = simd::load(bodies.orientation.y.data() + i);
+                vfloat qz = simd::load(bodies.orientation.z.data() + i);
+                vfloat qw = simd::load(bodies.orientation.w.data() + i);
+
+                // World space inverse inertia: R * diag(I^-1) * R^T. The torque is rotated into the local space,
+                // scaled and rotated back.
+                vfloat ax = simd::load(bodies.torque.x.data() + i);
+                vfloat ay = simd::load(bodies.torque.y.data() + i);
+                vfloat az = simd::load(bodies.torque.z.data() + i);
+                rotate(-qx, -qy, -qz, qw, ax, ay, az);
+                ax = ax * simd::load(bodies.inverse_inertia.x.data() + i) * vdt;
+                ay = ay * simd::load(bodies.inverse_inertia.y.data() + i) * vdt;
+                az = az * simd::load(bodies.inverse_inertia.z.data() + i) * vdt;
+                rotate(qx, qy, qz, qw, ax, ay, az);
+
+                vfloat angular_damping = one / simd::fmadd(vdt, simd::load(bodies.angular_damping.data() + i), one);
+                simd::store(bodies.angular_velocity.x.data() + i, (simd::load(bodies.angular_velocity.x.data() + i) + ax) * angular_damping);
+                simd::store(bodies.angular_velocity.y.data() + i, (simd::load(bodies.angular_velocity.y.data() + i) + ay) * angular_damping);
+                simd::store(bodies.angular_velocity.z.data() + i, (simd::load(bodies.angular_velocity.z.data() + i) + az) * angular_damping);
+
+                simd::store(bodies.force.x.data() + i, zero);
+                simd::store(bodies.force.y.data() + i, zero);
+                simd::store(bodies.force.z.data() + i, zero);
+                simd::store(bodies.torque.x.data() + i, zero);
+                simd::store(bodies.torque.y.data() + i, zero);
+                simd::store(bodies.torque.z.data() + i, zero);
+            }
+        }
+
+        /**
+         * @brief Moves the bodies using their (already integrated) velocities. The state before the move is saved in
+         * previous_position and previous_orientation.
+         * @param bodies A reference to the bodies.
+         * @param dt The size of the step in seconds.
+         * @param begin The index of the first body.
+         * @param end One past the index of the last body.
+        */
+        void integrate_positions(body_store& bodies, float dt, size_t begin, size_t end)
+        {
+            const vfloat vdt = simd::set1(dt);
+            const vfloat half_dt = simd::set1(0.5f * dt);
+            const vfloat one = simd::set1(1.0f);
+            const vfloat zero = simd::set1(0.0f);
+
+            for(size_t i = begin; i < end; i += simd::width)
+            {
+                // Nothing in the register moves, hence even the previous state is already the same as the current one.
+                simd::vmask dynamic = (simd::load(bodies.inverse_mass.data() + i) > zero) & (simd::load(bodies.awake.data() + i) > zero);
+                if(!simd::bits(dynamic)) continue;
+
+                vfloat px = simd::load(bodies.position.x.data() + i);
+                vfloat py = simd::load(bodies.position.y.data() + i);
+                vfloat pz = simd::load(bodies.position.z.data() + i);
+                simd::store(bodies.previous_position.x.data() + i, px);
+                simd::store(bodies.previous_position.y.data() + i, py);
+                simd::store(bodies.previous_position.z.data() + i, pz);
+
+                simd::store(bodies.position.x.data() + i, simd::fmadd(simd::load(bodies.linear_velocity.x.data() + i), vdt, px));
+                simd::store(bodies.position.y.data() + i, simd::fmadd(simd::load(bodies.linear_velocity.y.data() + i), vdt, py));
+                simd::store(bodies.position.z.data() + i, simd::fmadd(simd::load(bodies.linear_velocity.z.data() + i), vdt, pz));
+
+                vfloat qx = simd::load(bodies.orientation.x.data() + i);
+                vfloat qy = simd::load(bodies.orientation.y.data() + i);
+                vfloat qz = simd::load(bodies.orientation.z.data() + i);
+                vfloat qw = simd::load(bodies.orientation.w.data() + i);
+                simd::store(bodies.previous_orientation.x.data() + i, qx);
+                simd::store(bodies.previous_orientation.y.data() + i, qy);
+                simd::store(bodies.previous_orientation.z.data() + i, qz);
+                simd::store(bodies.previous_orientation.w.data() + i, qw);
+
+                vfloat wx = simd::load(bodies.angular_velocity.x.data() + i);
+                vfloat wy = simd::load(bodies.angular_velocity.y.data() + i);
+                vfloat wz = simd::load(bodies.angular_velocity.z.data() + i);
+
+                // q += 0.5 * dt * (w, 0) * q
+                vfloat nx = simd::fmadd(half_dt, wx * qw + wy * qz - wz * qy, qx);
+                vfloat ny = simd::fmadd(half_dt, wy * qw + wz * qx - wx * qz, qy);
+                vfloat nz = simd::fmadd(half_dt, wz * qw + wx * qy - wy * qx, qz);
+                vfloat nw = qw - half_dt * (wx * qx + wy * qy + wz * qz);
+
+                // The epsilon keeps the (all zero) padding quaternions from turning into NaNs. The bodies that don't move
+                // keep their orientations bit for bit, renormalizing could still change the last bit.
+                vfloat inverse_length = one / simd::sqrt(nx * nx + ny * ny + nz * nz + nw * nw + simd::set1(1e-30f));
+                simd::store(bodies.orientation.x.data() + i, simd::select(dynamic, nx * inverse_length, qx));
+                simd::store(bodies.orientation.y.data() + i, simd::select(dynamic, ny * inverse_length, qy));
+                simd::store(bodies.orientation.z.data() + i, simd::select(dynamic, nz * inverse_length, qz));
+                simd::store(bodies.orientation.w.data() + i, simd::select(dynamic, nw * inverse_length, qw));
+            }
+        }
+    }; // namespace kernels
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+/**
+ * This header contains the island builder. An island is a group of dynamic bodies that are connected to each other
+ * by constraints (contacts or joints), directly or through other bodies of the island. Static bodies never join an
+ * island, they don't move hence they can't carry an impulse from one body to another. Neither do the sleeping bodies,
+ * the bodies that touch them are woken up before the islands are built. (see: sleep.hpp)
+ *
+ * The islands are independent of each other, hence they can be solved in parallel without any synchronization.
+ * The islands, and the order of the bodies and the constraints in each island, only depend on the order of the
+ * bodies and the constraints. Not on the number of threads.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+
+#ifndef _PHYSICS_ISLANDS_DEFINITION_HPP_
+    #define _PHYSICS_ISLANDS_DEFINITION_HPP_
+
+    #include <vector>
+
+    _PHYSICS_START_
+
+    /** @brief The two bodies (indices) that a constraint connects. */
+    struct constraint_edge
+    {
+        uint32_t a;
+        uint32_t b;
+    };
+
+    /** @brief A range of bodies and a range of constraints in island_builder::bodies() and island_builder::constraints(). */
+    struct island
+    {
+        uint32_t body_begin;
+        uint32_t body_count;
+        uint32_t constraint_begin;
+        uint32_t constraint_count;
+    };
+
+    /** @brief Builds the islands with a union-find. The storage is reused from build to build. */
+    class island_builder
+    {
+    private:
+        static constexpr uint32_t none = UINT32_MAX;
+
+        std::vector<uint32_t> _parent;
+        std::vector<uint32_t> _island_of_root;
+
+        std::vector<island> _islands;
+        std::vector<uint32_t> _bodies;
+        std::vector<uint32_t> _constraints;
+        std::vector<uint32_t> _constraint_islands;
+        std::vector<uint32_t> _offsets;
+
+        uint32_t find(uint32_t index)
+        {
+            uint32_t root = index;
+            while(_parent[root] != root) root = _parent[root];
+            // Path compression.
+            while(_parent[index] != root)
+            {
+                uint32_t next = _parent[index];
+                _parent[index] = root;
+                index = next;
+            }
+            return root;
+        }
+
+        void unite(uint32_t a, uint32_t b)
+        {
+            a = find(a);
+            b = find(b);
+            if(a == b) return;
+            // The smaller index becomes the root so that the result doesn't depend on the order of the edges.
+            if(a < b) _parent[b] = a;
+            else _parent[a] = b;
+        }
+
+    public:
+        /**
+         * @brief Builds the islands.
+         * @param bodies A reference to the bodies.
+         * @param edges The bodies that every constraint connects. An index of bodies.size() or more is treated as
+         * a static body.
+        */
+        void build(const body_store& bodies, const std::vector<constraint_edge>& edges)
+        {
+            size_t count = bodies.size();
+            auto is_dynamic = [&](uint32_t index) { return index < count && bodies.is_active(index); };
+
+            _parent.resize(count);
+            for(size_t i = 0; i < count; i++) _parent[i] = static_cast<uint32_t>(i);
+
+            for(const constraint_edge& edge : edges)
+            {
+                if(is_dynamic(edge.a) && is_dynamic(edge.b)) unite(edge.a, edge.b);
+            }
+
+            // ============================= NUMBER THE ISLANDS =============================
+            _islands.clear();
+            _island_of_root.assign(count, none);
+            for(size_t i = 0; i < count; i++)
+            {
+                if(!is_dynamic(static_cast<uint32_t>(i))) continue;
+
+                uint32_t root = find(static_cast<uint32_t>(i));
+                if(_island_of_root[root] == none)
+                {
+                    _island_of_root[root] = static_cast<uint32_t>(_islands.size());
+                    _islands.push_back(island { 0, 0, 0, 0 });
+                }
+                _islands[_island_of_root[root]].body_count++;
+            }
+
+            // ============================= GROUP THE BODIES =============================
+            // A counting sort, which keeps the bodies of every island in the order of their indices.
+            _offsets.resize(_islands.size());
+            uint32_t offset = 0;
+            for(size_t i = 0; i < _islands.size(); i++)
+            {
+                _islands[i].body_begin = _offsets[i] = offset;
+                offset += _islands[i].body_count;
+            }
+            _bodies.resize(offset);
+            for(size_t i = 0; i < count; i++)
+            {
+                if(!is_dynamic(static_cast<uint32_t>(i))) continue;
+                _bodies[_offsets[_island_of_root[find(static_cast<uint32_t>(i))]]++] = static_cast<uint32_t>(i);
+            }
+
+            // ============================= GROUP THE CONSTRAINTS =============================
+            _constraint_islands.resize(edges.size());
+            for(size_t i = 0; i < edges.size(); i++)
+            {
+                const constraint_edge& edge = edges[i];
+                uint32_t body = is_dynamic(edge.a) ? edge.a : edge.b;
+                uint32_t island_index = is_dynamic(body) ? _island_of_root[find(body)] : none;
+
+                _constraint_islands[i] = island_index;
+                if(island_index != none) _islands[island_index].constraint_count++;
+            }
+
+            offset = 0;
+            for(size_t i = 0; i < _islands.size(); i++)
+            {
+                _islands[i].constraint_begin = _offsets[i] = offset;
+                offset += _islands[i].constraint_count;
+            }
+            _constraints.resize(offset);
+            for(size_t i = 0; i < edges.size(); i++)
+            {
+                if(_constraint_islands[i] != none) _constraints[_offsets[_constraint_islands[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        /** @brief Makes sure that islands of @p body_count bodies and @p constraint_count constraints are built without allocating. */
+        void reserve(size_t body_count, size_t constraint_count)
+        {
+            _parent.reserve(body_count);
+            _island_of_root.reserve(body_count);
+            _islands.reserve(body_count);
+            _bodies.reserve(body_count);
+            _offsets.reserve(body_count);
+            _constraints.reserve(constraint_count);
+            _constraint_islands.reserve(constraint_count);
+        }
+
+        const std::vector<island>& islands() const noexcept(true) { return _islands; }
+        /** @brief The indices of the bodies, grouped by island. */
+        const std::vector<uint32_t>& bodies() const noexcept(true) { return _bodies; }
+        /** @brief The indices of the constraints, grouped by island. Constraints between two static bodies are left out. */
+        const std::vector<uint32_t>& constraints() const noexcept(true) { return _constraints; }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
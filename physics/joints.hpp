@@ -0,0 +1,151 @@
+/**
+ * This header contains the joints. A joint constrains how two bodies can move relative to each other.
+ *
+ *  ball joint : Keeps a point of one body at the same place as a point of the other body, the bodies can still
+ *               rotate freely around it. (ex; a chain, a ragdoll shoulder)
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./snapshot.hpp"
+
+#ifndef _PHYSICS_JOINTS_DEFINITION_HPP_
+    #define _PHYSICS_JOINTS_DEFINITION_HPP_
+
+    #include <vector>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /// @brief Identifies a joint in a world. It stays the same for as long as the joint exists.
+    using joint_handle = uint32_t;
+    /// @brief Represents a handle to no joint.
+    constexpr joint_handle invalid_joint_handle = UINT32_MAX;
+
+    /** @brief Everything that is needed to create a ball joint. */
+    struct ball_joint_desc
+    {
+        body_handle a = invalid_body_handle;
+        /** @brief invalid_body_handle attaches body a to the world. */
+        body_handle b = invalid_body_handle;
+        /** @brief The point that the bodies are joined at, in world space at the time the joint is created. */
+        glm::vec3 anchor = glm::vec3(0.0f);
+    };
+
+    /** @brief A ball joint. */
+    struct ball_joint
+    {
+        body_handle a;
+        body_handle b;
+        /** @brief The anchor in the local space of body a. */
+        glm::vec3 local_anchor_a;
+        /** @brief The anchor in the local space of body b, in world space if b is invalid_body_handle. */
+        glm::vec3 local_anchor_b;
+        /** @brief The impulse that the solver applied in the last step, the next step is warm started with it. */
+        glm::vec3 impulse = glm::vec3(0.0f);
+    };
+
+    /** @brief The storage of all the joints of a world. Like the bodies, they are densely packed. */
+    class joint_store
+    {
+    public:
+        std::vector<ball_joint> joints;
+        /** @brief The handle of the joint at every index. */
+        std::vector<joint_handle> handles;
+
+    private:
+        std::vector<uint32_t> _indices;
+        std::vector<joint_handle> _free_handles;
+
+    public:
+        size_t size() const noexcept(true) { return joints.size(); }
+
+        bool contains(joint_handle handle) const noexcept(true)
+        {
+            return handle < _indices.size() && _indices[handle] != UINT32_MAX;
+        }
+        size_t index_of(joint_handle handle) const noexcept(true) { return _indices[handle]; }
+
+        joint_handle add(const ball_joint& joint)
+        {
+            joint_handle handle;
+            if(!_free_handles.empty())
+            {
+                handle = _free_handles.back();
+                _free_handles.pop_back();
+            }
+            else
+            {
+                handle = static_cast<joint_handle>(_indices.size());
+                _indices.push_back(UINT32_MAX);
+            }
+
+            _indices[handle] = static_cast<uint32_t>(joints.size());
+            joints.push_back(joint);
+            handles.push_back(handle);
+            return handle;
+        }
+
+        /** @brief Removes the joint. The last joint is moved into its place. */
+        void remove(joint_handle handle)
+        {
+            size_t index = index_of(handle);
+            size_t last = joints.size() - 1;
+
+            joints[index] = joints[last]; joints.pop_back();
+            handles[index] = handles[last]; handles.pop_back();
+
+            if(index != last) _indices[handles[index]] = static_cast<uint32_t>(index);
+            _indices[handle] = UINT32_MAX;
+            _free_handles.push_back(handle);
+        }
+
+        /** @brief Writes the joints (and the handles) into the snapshot. (see: snapshot.hpp) */
+        void save(snapshot_writer& out) const
+        {
+            out.array(joints); out.array(handles); out.array(_indices); out.array(_free_handles);
+        }
+
+        /**
+         * @brief Reads the joints that save wrote.
+         * @param in The snapshot.
+         * @param bodies The bodies that were read from the snapshot, every joint must be attached to them.
+         * @returns false if the snapshot is damaged.
+        */
+        bool load(snapshot_reader& in, const body_store& bodies)
+        {
+            in.array(joints); in.array(handles); in.array(_indices); in.array(_free_handles);
+            if(in.failed() || joints.size() != handles.size() || joints.size() > _indices.size()) return false;
+
+            // The same as the handles of the bodies. (see: body_store::load)
+            for(size_t i = 0; i < handles.size(); i++)
+                if(handles[i] >= _indices.size() || _indices[handles[i]] != i) return false;
+            size_t unused = 0;
+            for(uint32_t index : _indices)
+            {
+                if(index == UINT32_MAX) unused++;
+                else if(index >= joints.size()) return false;
+            }
+            if(unused != _free_handles.size()) return false;
+            for(joint_handle handle : _free_handles)
+                if(handle >= _indices.size() || _indices[handle] != UINT32_MAX) return false;
+
+            // The solver looks the bodies up without checking. (see: constraint_solver::prepare)
+            for(const ball_joint& joint : joints)
+                if(!bodies.contains(joint.a) || (joint.b != invalid_body_handle && !bodies.contains(joint.b))) return false;
+            return true;
+        }
+
+        /** @brief Removes every joint that is attached to the body. */
+        void remove_attached(body_handle body)
+        {
+            for(size_t i = joints.size(); i > 0; i--)
+            {
+                if(joints[i - 1].a == body || joints[i - 1].b == body) remove(handles[i - 1]);
+            }
+        }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
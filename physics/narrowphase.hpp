@@ -0,0 +1,921 @@
+/**
+ * This header contains the narrowphase. It finds the contact points between the shapes of the pairs that the
+ * broadphase reported.
+ *
+ * Every pair of shape types has an entry in a dispatch table. The common pairs have specialized kernels;
+ * sphere-sphere, sphere-box, sphere-capsule, box-box (SAT with face clipping), box-capsule and capsule-capsule.
+ * Every pair with a convex hull falls back to GJK/EPA (see: gjk.hpp), which only finds the deepest point per step.
+ *
+ * The sphere-sphere and sphere-box pairs can be collided in batches instead; a pair_batch gathers them into a
+ * structure of arrays and runs their kernels simd::width pairs at a time. (see: simd.hpp) The world only batches the
+ * sphere-box pairs, the sphere-sphere kernel is too cheap to make up for moving a pair into the lanes and back.
+ *
+ * The manifolds persist from step to step (see: contact_cache); the points of the last step that are found again
+ * carry their impulses over, which is what the solver warm starts from. For the kernels that only find a single
+ * point, the points of the last step that are still touching are kept as well, so that a resting hull gets a
+ * full manifold after a few steps.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./snapshot.hpp"
+#include "./gjk.hpp"
+#include "./simd.hpp"
+
+#ifndef _PHYSICS_NARROWPHASE_DEFINITION_HPP_
+    #define _PHYSICS_NARROWPHASE_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cmath>
+    #include <algorithm>
+    #include <limits>
+
+    _PHYSICS_START_
+
+    /** @brief The maximum number of points in a manifold. */
+    constexpr size_t max_manifold_points = 4;
+
+    /** @brief A single point where two shapes touch. */
+    struct contact_point
+    {
+        /** @brief The point in world space, halfway between the two surfaces. */
+        glm::vec3 position = glm::vec3(0.0f);
+        /** @brief How far the shapes overlap along the normal. Negative if they are (just) apart. */
+        float depth = 0.0f;
+        /** @brief The point on the surface of each body, in the local space of that body. */
+        glm::vec3 local_a = glm::vec3(0.0f), local_b = glm::vec3(0.0f);
+        /** @brief The impulses that the solver applied at the point in the last step. */
+        float normal_impulse = 0.0f;
+        float tangent_impulse[2] = { 0.0f, 0.0f };
+    };
+
+    /** @brief The contact points between two bodies that share a normal. */
+    struct contact_manifold
+    {
+        body_handle a = invalid_body_handle;
+        body_handle b = invalid_body_handle;
+        /** @brief The normal of the contact, pointing from a to b. */
+        glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        contact_point points[max_manifold_points];
+        uint32_t count = 0;
+    };
+
+    /**
+     * @brief The manifolds of the last step, sorted by their bodies so that the manifold of a pair can be found with
+     * a binary search. The storage is reused from step to step.
+    */
+    class contact_cache
+    {
+    private:
+        std::vector<contact_manifold> _manifolds;
+
+        static bool less(const contact_manifold& x, const contact_manifold& y) noexcept(true)
+        {
+            return x.a < y.a || (x.a == y.a && x.b < y.b);
+        }
+
+    public:
+        /** @brief Replaces the cache with the manifolds that have points. */
+        void update(const std::vector<contact_manifold>& manifolds)
+        {
+            _manifolds.clear();
+            for(const contact_manifold& manifold : manifolds) if(manifold.count) _manifolds.push_back(manifold);
+            std::sort(_manifolds.begin(), _manifolds.end(), less);
+        }
+
+        /** @brief Returns the manifold of the pair from the last step, nullptr if they didn't touch. */
+        const contact_manifold* find(body_handle a, body_handle b) const
+        {
+            contact_manifold key;
+            key.a = a; key.b = b;
+            auto it = std::lower_bound(_manifolds.begin(), _manifolds.end(), key, less);
+            return it != _manifolds.end() && it->a == a && it->b == b ? &*it : nullptr;
+        }
+
+        /** @brief Removes the manifolds of the body, so that a body that reuses its handle doesn't inherit them. */
+        void erase(body_handle body)
+        {
+            _manifolds.erase(std::remove_if(_manifolds.begin(), _manifolds.end(),
+                [body](const contact_manifold& m) { return m.a == body || m.b == body; }), _manifolds.end());
+        }
+
+        size_t size() const noexcept(true) { return _manifolds.size(); }
+        void clear() { _manifolds.clear(); }
+        /** @brief Makes sure that the manifolds of @p count pairs fit without reallocating. */
+        void reserve(size_t count) { _manifolds.reserve(count); }
+
+        /** @brief Writes the manifolds (and their impulses) into the snapshot. (see: snapshot.hpp) */
+        void save(snapshot_writer& out) const { out.array(_manifolds); }
+        /** @brief Reads the manifolds that save wrote. @returns false if the snapshot is damaged. */
+        bool load(snapshot_reader& in)
+        {
+            if(!in.array(_manifolds) || !std::is_sorted(_manifolds.begin(), _manifolds.end(), less)) return false;
+            // The points of the manifolds are carried over without checking their count. (see: narrowphase::persist)
+            for(const contact_manifold& manifold : _manifolds)
+                if(manifold.count == 0 || manifold.count > max_manifold_points) return false;
+            return true;
+        }
+    };
+
+    namespace narrowphase
+    {
+        /** @brief How far (in meters) a point may drift from where it was in the last step and still be the same point. */
+        constexpr float persistent_threshold = 0.02f;
+        /**
+         * @brief How far (in meters) apart the points of a face contact may be and still be reported, with a negative
+         * depth. Otherwise a resting box would lose a corner every time it rocks a little.
+        */
+        constexpr float speculative_distance = 0.01f;
+
+        /** @brief Returns the closest point to @c p on the segment from @c a to @c b. */
+        inline glm::vec3 closest_on_segment(const glm::vec3& a, const glm::vec3& b, const glm::vec3& p)
+        {
+            glm::vec3 ab = b - a;
+            float length_sq = glm::dot(ab, ab);
+            if(length_sq <= 1e-12f) return a;
+            float t = std::fmin(std::fmax(glm::dot(p - a, ab) / length_sq, 0.0f), 1.0f);
+            return a + ab * t;
+        }
+
+        /** @brief Finds the closest points between the segments p1-q1 and p2-q2. (Real-Time Collision Detection, 5.1.9) */
+        inline void closest_between_segments(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2,
+            glm::vec3& c1, glm::vec3& c2)
+        {
+            glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+            float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+            float s = 0.0f, t = 0.0f;
+
+            constexpr float epsilon = 1e-12f;
+            if(a <= epsilon && e <= epsilon) { c1 = p1; c2 = p2; return; }
+            if(a <= epsilon) t = std::fmin(std::fmax(f / e, 0.0f), 1.0f);
+            else
+            {
+                float c = glm::dot(d1, r);
+                if(e <= epsilon) s = std::fmin(std::fmax(-c / a, 0.0f), 1.0f);
+                else
+                {
+                    float b = glm::dot(d1, d2);
+                    float denominator = a * e - b * b;
+                    s = denominator > epsilon ? std::fmin(std::fmax((b * f - c * e) / denominator, 0.0f), 1.0f) : 0.0f;
+                    t = (b * s + f) / e;
+                    if(t < 0.0f) { t = 0.0f; s = std::fmin(std::fmax(-c / a, 0.0f), 1.0f); }
+                    else if(t > 1.0f) { t = 1.0f; s = std::fmin(std::fmax((b - c) / a, 0.0f), 1.0f); }
+                }
+            }
+            c1 = p1 + d1 * s;
+            c2 = p2 + d2 * t;
+        }
+
+        /** @brief Returns the two end points of the segment of a capsule in world space. */
+        inline void capsule_segment(const shape& s, const transform& t, glm::vec3& p, glm::vec3& q)
+        {
+            glm::vec3 axis = t.orientation * glm::vec3(0.0f, s.half_extents.y, 0.0f);
+            p = t.position - axis;
+            q = t.position + axis;
+        }
+
+        /** @brief Generates the contact between two spheres (or between the closest points of two segments grown by a radius). */
+        inline bool collide_points(const glm::vec3& a, float radius_a, const glm::vec3& b, float radius_b, contact_manifold& manifold)
+        {
+            glm::vec3 d = b - a;
+            float distance_sq = glm::dot(d, d);
+            float radii = radius_a + radius_b;
+            if(distance_sq > radii * radii) return false;
+
+            float distance = std::sqrt(distance_sq);
+            manifold.normal = distance > 1e-6f ? d / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+
+            float depth = radii - distance;
+            manifold.points[0].position = a + manifold.normal * (radius_a - depth * 0.5f);
+            manifold.points[0].depth = depth;
+            manifold.count = 1;
+            return true;
+        }
+
+        bool sphere_sphere(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            return collide_points(ta.position, a.radius, tb.position, b.radius, manifold);
+        }
+
+        bool sphere_box(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            // In the local space of the box.
+            glm::vec3 p = glm::conjugate(tb.orientation) * (ta.position - tb.position);
+            const glm::vec3& h = b.half_extents;
+            glm::vec3 closest(
+                std::fmin(std::fmax(p.x, -h.x), h.x),
+                std::fmin(std::fmax(p.y, -h.y), h.y),
+                std::fmin(std::fmax(p.z, -h.z), h.z));
+
+            glm::vec3 d = p - closest;
+            float distance_sq = glm::dot(d, d);
+            glm::vec3 normal; // From the box towards the sphere.
+            float depth;
+
+            if(distance_sq > 1e-12f)
+            {
+                if(distance_sq > a.radius * a.radius) return false;
+                float distance = std::sqrt(distance_sq);
+                normal = d / distance;
+                depth = a.radius - distance;
+            }
+            else
+            {
+                // The center is inside of the box, push it out through the closest face.
+                int axis = 0;
+                float best = h.x - std::fabs(p.x);
+                for(int i = 1; i < 3; i++)
+                {
+                    float distance = h[i] - std::fabs(p[i]);
+                    if(distance < best) { best = distance; axis = i; }
+                }
+                normal = glm::vec3(0.0f);
+                normal[axis] = p[axis] < 0.0f ? -1.0f : 1.0f;
+                closest[axis] = h[axis] * normal[axis];
+                depth = best + a.radius;
+            }
+
+            manifold.normal = -(tb.orientation * normal);
+            manifold.points[0].position = tb.orientation * closest + tb.position + manifold.normal * (depth * 0.5f);
+            manifold.points[0].depth = depth;
+            manifold.count = 1;
+            return true;
+        }
+
+        bool sphere_capsule(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            glm::vec3 p, q;
+            capsule_segment(b, tb, p, q);
+            return collide_points(ta.position, a.radius, closest_on_segment(p, q, ta.position), b.radius, manifold);
+        }
+
+        bool capsule_capsule(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            glm::vec3 p1, q1, p2, q2, c1, c2;
+            capsule_segment(a, ta, p1, q1);
+            capsule_segment(b, tb, p2, q2);
+            closest_between_segments(p1, q1, p2, q2, c1, c2);
+            return collide_points(c1, a.radius, c2, b.radius, manifold);
+        }
+
+        /** @brief Reduces the points to at most max_manifold_points, keeping the deepest one and the widest spread. */
+        inline void reduce_points(contact_point* points, uint32_t& count, const glm::vec3& normal)
+        {
+            if(count <= max_manifold_points) return;
+
+            // The deepest point, the point the furthest from it, then the point that makes the largest triangle and
+            // the one that makes the largest triangle on the other side of the first two.
+            uint32_t chosen[4] = {};
+            chosen[0] = 0;
+            for(uint32_t i = 1; i < count; i++) if(points[i].depth > points[chosen[0]].depth) chosen[0] = i;
+
+            float best = -1.0f;
+            for(uint32_t i = 0; i < count; i++)
+            {
+                glm::vec3 d = points[i].position - points[chosen[0]].position;
+                if(glm::dot(d, d) > best) { best = glm::dot(d, d); chosen[1] = i; }
+            }
+
+            glm::vec3 edge = points[chosen[1]].position - points[chosen[0]].position;
+            auto area = [&](uint32_t i) { return glm::dot(glm::cross(edge, points[i].position - points[chosen[0]].position), normal); };
+            float most = 0.0f, least = 0.0f;
+            chosen[2] = chosen[3] = chosen[0];
+            for(uint32_t i = 0; i < count; i++)
+            {
+                float a = area(i);
+                if(a > most) { most = a; chosen[2] = i; }
+                if(a < least) { least = a; chosen[3] = i; }
+            }
+
+            contact_point kept[4];
+            uint32_t kept_count = 0;
+            for(uint32_t i = 0; i < 4; i++)
+            {
+                if(std::find(chosen, chosen + i, chosen[i]) == chosen + i) kept[kept_count++] = points[chosen[i]];
+            }
+            for(uint32_t k = 0; k < kept_count; k++) points[k] = kept[k];
+            count = kept_count;
+        }
+
+        bool box_box(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            glm::mat3 ra = glm::mat3_cast(ta.orientation), rb = glm::mat3_cast(tb.orientation);
+            const glm::vec3& ha = a.half_extents;
+            const glm::vec3& hb = b.half_extents;
+            glm::vec3 d = tb.position - ta.position;
+
+            // ============================= SEPARATING AXES =============================
+            // The 3 face normals of each box and the 9 cross products of their edges. The separation along an axis is
+            // negative if the projections of the boxes overlap.
+            auto separation = [&](const glm::vec3& axis)
+            {
+                float pa = ha.x * std::fabs(glm::dot(ra[0], axis)) + ha.y * std::fabs(glm::dot(ra[1], axis)) + ha.z * std::fabs(glm::dot(ra[2], axis));
+                float pb = hb.x * std::fabs(glm::dot(rb[0], axis)) + hb.y * std::fabs(glm::dot(rb[1], axis)) + hb.z * std::fabs(glm::dot(rb[2], axis));
+                return std::fabs(glm::dot(d, axis)) - pa - pb;
+            };
+
+            float face_a = -std::numeric_limits<float>::max(), face_b = face_a, edge = face_a;
+            int axis_a = 0, axis_b = 0, edge_a = 0, edge_b = 0;
+            for(int i = 0; i < 3; i++)
+            {
+                float s = separation(ra[i]);
+                if(s > speculative_distance) return false;
+                if(s > face_a) { face_a = s; axis_a = i; }
+            }
+            for(int i = 0; i < 3; i++)
+            {
+                float s = separation(rb[i]);
+                if(s > speculative_distance) return false;
+                if(s > face_b) { face_b = s; axis_b = i; }
+            }
+            glm::vec3 edge_axis(0.0f);
+            for(int i = 0; i < 3; i++) for(int j = 0; j < 3; j++)
+            {
+                glm::vec3 axis = glm::cross(ra[i], rb[j]);
+                float length = glm::length(axis);
+                // Parallel edges, the face axes already cover them.
+                if(length < 1e-5f) continue;
+                axis /= length;
+                float s = separation(axis);
+                if(s > speculative_distance) return false;
+                if(s > edge) { edge = s; edge_a = i; edge_b = j; edge_axis = axis; }
+            }
+
+            // The faces are preferred, they give a full manifold. The tolerances keep the choice from flipping
+            // between two nearly equal axes from step to step.
+            bool reference_is_a = !(face_b > 0.98f * face_a + 0.001f);
+            float face = reference_is_a ? face_a : face_b;
+
+            manifold.count = 0;
+            // Apart along an edge axis, edge contacts aren't speculative.
+            if(edge > 0.0f) return false;
+            if(edge > 0.95f * face + 0.01f)
+            {
+                // ============================= EDGE-EDGE =============================
+                glm::vec3 n = glm::dot(edge_axis, d) < 0.0f ? -edge_axis : edge_axis;
+
+                glm::vec3 ca = ta.position, cb = tb.position;
+                for(int k = 0; k < 3; k++)
+                {
+                    if(k != edge_a) ca += ra[k] * (glm::dot(ra[k], n) < 0.0f ? -ha[k] : ha[k]);
+                    if(k != edge_b) cb += rb[k] * (glm::dot(rb[k], n) > 0.0f ? -hb[k] : hb[k]);
+                }
+                glm::vec3 pa, pb;
+                closest_between_segments(ca - ra[edge_a] * ha[edge_a], ca + ra[edge_a] * ha[edge_a],
+                    cb - rb[edge_b] * hb[edge_b], cb + rb[edge_b] * hb[edge_b], pa, pb);
+
+                manifold.normal = n;
+                manifold.points[0].position = (pa + pb) * 0.5f;
+                manifold.points[0].depth = -edge;
+                manifold.count = 1;
+                return true;
+            }
+
+            // ============================= FACE =============================
+            const glm::mat3& r_ref = reference_is_a ? ra : rb;
+            const glm::mat3& r_inc = reference_is_a ? rb : ra;
+            const glm::vec3& h_ref = reference_is_a ? ha : hb;
+            const glm::vec3& h_inc = reference_is_a ? hb : ha;
+            const glm::vec3& c_ref = reference_is_a ? ta.position : tb.position;
+            const glm::vec3& c_inc = reference_is_a ? tb.position : ta.position;
+            int axis = reference_is_a ? axis_a : axis_b;
+
+            // The normal points from the reference box towards the incident box.
+            glm::vec3 n = r_ref[axis];
+            if(glm::dot(n, c_inc - c_ref) < 0.0f) n = -n;
+
+            // The face of the incident box that faces the reference face the most.
+            int incident = 0;
+            float most = -1.0f;
+            for(int k = 0; k < 3; k++)
+            {
+                float alignment = std::fabs(glm::dot(r_inc[k], n));
+                if(alignment > most) { most = alignment; incident = k; }
+            }
+            glm::vec3 face_center = c_inc + r_inc[incident] * (glm::dot(r_inc[incident], n) > 0.0f ? -h_inc[incident] : h_inc[incident]);
+            int u = (incident + 1) % 3, v = (incident + 2) % 3;
+            glm::vec3 eu = r_inc[u] * h_inc[u], ev = r_inc[v] * h_inc[v];
+
+            // Clip the incident face against the side planes of the reference face. (Sutherland-Hodgman)
+            glm::vec3 polygon[8] = { face_center + eu + ev, face_center - eu + ev, face_center - eu - ev, face_center + eu - ev };
+            glm::vec3 clipped[8];
+            int polygon_count = 4;
+            for(int side = 0; side < 4 && polygon_count; side++)
+            {
+                int k = (axis + 1 + side / 2) % 3;
+                glm::vec3 plane = side % 2 ? -r_ref[k] : r_ref[k];
+                float offset = glm::dot(plane, c_ref) + h_ref[k];
+
+                int clipped_count = 0;
+                for(int i = 0; i < polygon_count; i++)
+                {
+                    const glm::vec3& p = polygon[i];
+                    const glm::vec3& q = polygon[(i + 1) % polygon_count];
+                    float dp = glm::dot(plane, p) - offset, dq = glm::dot(plane, q) - offset;
+                    if(dp <= 0.0f && clipped_count < 8) clipped[clipped_count++] = p;
+                    // A point on the plane is already kept, only a proper crossing adds one.
+                    if(((dp < 0.0f && dq > 0.0f) || (dp > 0.0f && dq < 0.0f)) && clipped_count < 8) clipped[clipped_count++] = p + (q - p) * (dp / (dp - dq));
+                }
+                polygon_count = clipped_count;
+                std::copy(clipped, clipped + clipped_count, polygon);
+            }
+
+            // Keep the points that are below (or just above) the reference face, moved halfway towards it.
+            contact_point points[8];
+            uint32_t count = 0;
+            float face_offset = glm::dot(n, c_ref) + h_ref[axis];
+            for(int i = 0; i < polygon_count; i++)
+            {
+                float distance = glm::dot(n, polygon[i]) - face_offset;
+                if(distance > speculative_distance) continue;
+                points[count].position = polygon[i] - n * (distance * 0.5f);
+                points[count].depth = -distance;
+                count++;
+            }
+            if(!count) return false;
+
+            manifold.normal = reference_is_a ? n : -n;
+            reduce_points(points, count, n);
+            std::copy(points, points + count, manifold.points);
+            manifold.count = count;
+            return true;
+        }
+
+        /**
+         * @brief Generates the contact of the cores of two shapes with GJK, or with EPA if the cores overlap.
+         * Only finds a single point. (see: the top of this file)
+        */
+        bool convex_convex(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            float radius_a = core_radius(a), radius_b = core_radius(b);
+            gjk_result closest = gjk(a, ta, b, tb);
+            if(!closest.overlap)
+            {
+                if(closest.distance > radius_a + radius_b) return false;
+                // Touching cores have no meaningful direction between their closest points, EPA finds it instead.
+                if(closest.distance > 1e-4f) return collide_points(closest.point_a, radius_a, closest.point_b, radius_b, manifold);
+            }
+
+            epa_result penetration;
+            if(!epa(a, ta, b, tb, closest.simplex, penetration))
+            {
+                // A flat difference, push the shapes apart along the line between their centers.
+                glm::vec3 d = tb.position - ta.position;
+                penetration.normal = glm::dot(d, d) > 1e-12f ? glm::normalize(d) : glm::vec3(0.0f, 1.0f, 0.0f);
+                penetration.point_a = closest.point_a;
+                penetration.point_b = closest.point_b;
+                penetration.depth = 0.0f;
+            }
+
+            glm::vec3 surface_a = penetration.point_a + penetration.normal * radius_a;
+            glm::vec3 surface_b = penetration.point_b - penetration.normal * radius_b;
+            manifold.normal = penetration.normal;
+            manifold.points[0].position = (surface_a + surface_b) * 0.5f;
+            manifold.points[0].depth = penetration.depth + radius_a + radius_b;
+            manifold.count = 1;
+            return true;
+        }
+
+        bool box_capsule(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            gjk_result closest = gjk(a, ta, b, tb);
+            // The segment goes through the box, it is pushed out by the deepest point alone.
+            if(closest.overlap || closest.distance <= 1e-4f) return convex_convex(a, ta, b, tb, manifold);
+            if(closest.distance > b.radius + speculative_distance) return false;
+
+            glm::vec3 n = (closest.point_b - closest.point_a) / closest.distance;
+            glm::quat inverse = glm::conjugate(ta.orientation);
+            glm::vec3 local_n = inverse * n;
+
+            // A capsule that lies on a face touches it along a segment. The segment (in the local space of the box)
+            // is clipped to the face and each end of what is left becomes a point.
+            int axis = 0;
+            for(int k = 1; k < 3; k++) if(std::fabs(local_n[k]) > std::fabs(local_n[axis])) axis = k;
+            if(std::fabs(local_n[axis]) > 0.99f)
+            {
+                float sign = local_n[axis] < 0.0f ? -1.0f : 1.0f;
+                glm::vec3 p, q;
+                capsule_segment(b, tb, p, q);
+                p = inverse * (p - ta.position);
+                q = inverse * (q - ta.position);
+
+                float t0 = 0.0f, t1 = 1.0f;
+                glm::vec3 dir = q - p;
+                for(int k = 0; k < 3 && t0 <= t1; k++)
+                {
+                    if(k == axis) continue;
+                    float h = a.half_extents[k];
+                    if(std::fabs(dir[k]) < 1e-8f)
+                    {
+                        if(p[k] < -h || p[k] > h) t1 = -1.0f;
+                        continue;
+                    }
+                    float s0 = (-h - p[k]) / dir[k], s1 = (h - p[k]) / dir[k];
+                    if(s0 > s1) std::swap(s0, s1);
+                    t0 = std::fmax(t0, s0);
+                    t1 = std::fmin(t1, s1);
+                }
+
+                if(t0 <= t1)
+                {
+                    glm::vec3 local_face_normal(0.0f);
+                    local_face_normal[axis] = sign;
+                    glm::vec3 face_normal = ta.orientation * local_face_normal;
+                    uint32_t count = 0;
+                    for(float t : { t0, t1 })
+                    {
+                        if(count && t1 - t0 < 1e-4f) break;
+                        glm::vec3 c = p + dir * t;
+                        float distance = c[axis] * sign - a.half_extents[axis];
+                        float depth = b.radius - distance;
+                        if(depth < -speculative_distance) continue;
+                        manifold.points[count].position = ta.position + ta.orientation * c - face_normal * ((distance + b.radius) * 0.5f);
+                        manifold.points[count].depth = depth;
+                        count++;
+                    }
+                    if(count)
+                    {
+                        manifold.normal = face_normal;
+                        manifold.count = count;
+                        return true;
+                    }
+                }
+            }
+            return collide_points(closest.point_a, 0.0f, closest.point_b, b.radius, manifold);
+        }
+
+        /** @brief The signature of every kernel. */
+        using collide_function = bool(*)(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold);
+
+        /** @brief An entry of the dispatch table. */
+        struct kernel
+        {
+            collide_function collide;
+            /** @brief Whether or not the kernel finds a single point per step, which the manifold accumulates. */
+            bool accumulates;
+        };
+
+        /** @brief The kernel of every pair of shape types. Only the entries with a <= b are used. */
+        constexpr size_t shape_type_count = 4;
+        static const kernel dispatch[shape_type_count][shape_type_count] =
+        {
+            /* SPHERE  */ { { sphere_sphere, false }, { sphere_box, false }, { sphere_capsule, false }, { convex_convex, true } },
+            /* BOX     */ { { nullptr, false },       { box_box, false },    { box_capsule, false },    { convex_convex, true } },
+            /* CAPSULE */ { { nullptr, false },       { nullptr, false },    { capsule_capsule, false }, { convex_convex, true } },
+            /* CONVEX  */ { { nullptr, false },       { nullptr, false },    { nullptr, false },        { convex_convex, true } },
+        };
+
+        /** @brief Returns the kernel of the pair. */
+        inline const kernel& kernel_of(shape_type a, shape_type b)
+        {
+            return a <= b ? dispatch[static_cast<size_t>(a)][static_cast<size_t>(b)] : dispatch[static_cast<size_t>(b)][static_cast<size_t>(a)];
+        }
+
+        /**
+         * @brief Finds the contact points between two shapes.
+         * @param manifold Set to the contact, its bodies are left untouched.
+         * @returns Whether or not the shapes touch.
+        */
+        bool collide(const shape& a, const transform& ta, const shape& b, const transform& tb, contact_manifold& manifold)
+        {
+            // Every pair is handled with the lower type first, the normal is flipped afterwards if they were swapped.
+            if(b.type < a.type)
+            {
+                if(!collide(b, tb, a, ta, manifold)) return false;
+                manifold.normal = -manifold.normal;
+                return true;
+            }
+            return kernel_of(a.type, b.type).collide(a, ta, b, tb, manifold);
+        }
+
+        /**
+         * @brief Carries the impulses of the last step over to the contact points that a kernel found.
+         * @param previous The manifold of the pair in the last step, or nullptr if there was none. (see: contact_cache)
+         * @param manifold The contact that the kernel found, its bodies are left untouched.
+         * @param touching What the kernel returned.
+         * @returns Whether or not the shapes touch.
+        */
+        bool persist(const shape& a, const transform& ta, const shape& b, const transform& tb,
+            const contact_manifold* previous, contact_manifold& manifold, bool touching)
+        {
+            if(!touching) manifold.count = 0;
+
+            const glm::vec3& n = manifold.normal;
+            glm::quat inverse_a = glm::conjugate(ta.orientation), inverse_b = glm::conjugate(tb.orientation);
+            for(uint32_t i = 0; i < manifold.count; i++)
+            {
+                contact_point& p = manifold.points[i];
+                p.local_a = inverse_a * (p.position + n * (p.depth * 0.5f) - ta.position);
+                p.local_b = inverse_b * (p.position - n * (p.depth * 0.5f) - tb.position);
+                p.normal_impulse = p.tangent_impulse[0] = p.tangent_impulse[1] = 0.0f;
+            }
+
+            // A normal that turned too much means the bodies touch somewhere else, nothing is carried over.
+            if(!previous || !touching || glm::dot(previous->normal, n) < 0.95f) return touching;
+
+            constexpr float threshold_sq = persistent_threshold * persistent_threshold;
+            bool matched[max_manifold_points] = {};
+            for(uint32_t i = 0; i < manifold.count; i++)
+            {
+                contact_point& p = manifold.points[i];
+                float best = threshold_sq;
+                int found = -1;
+                for(uint32_t k = 0; k < previous->count; k++)
+                {
+                    glm::vec3 d = previous->points[k].local_a - p.local_a;
+                    if(!matched[k] && glm::dot(d, d) < best) { best = glm::dot(d, d); found = static_cast<int>(k); }
+                }
+                if(found < 0) continue;
+
+                const contact_point& old = previous->points[found];
+                matched[found] = true;
+                p.normal_impulse = old.normal_impulse;
+                p.tangent_impulse[0] = old.tangent_impulse[0];
+                p.tangent_impulse[1] = old.tangent_impulse[1];
+            }
+            if(!kernel_of(a.type, b.type).accumulates) return true;
+
+            // ============================= ACCUMULATE =============================
+            // The old points that weren't found again are kept if the bodies still touch there.
+            contact_point points[2 * max_manifold_points];
+            uint32_t count = manifold.count;
+            std::copy(manifold.points, manifold.points + count, points);
+            for(uint32_t k = 0; k < previous->count; k++)
+            {
+                if(matched[k]) continue;
+                contact_point p = previous->points[k];
+                glm::vec3 wa = ta.position + ta.orientation * p.local_a, wb = tb.position + tb.orientation * p.local_b;
+                glm::vec3 d = wa - wb;
+                float depth = glm::dot(d, n);
+                glm::vec3 drift = d - n * depth;
+                if(depth < -persistent_threshold * 0.5f || glm::dot(drift, drift) > threshold_sq) continue;
+
+                p.position = (wa + wb) * 0.5f;
+                p.depth = depth;
+                points[count++] = p;
+            }
+            reduce_points(points, count, n);
+            std::copy(points, points + count, manifold.points);
+            manifold.count = count;
+            return true;
+        }
+
+        /**
+         * @brief Finds the contact points between two shapes and carries the impulses of the last step over.
+         * @param previous The manifold of the pair in the last step, or nullptr if there was none. (see: contact_cache)
+         * @param manifold Set to the contact, its bodies are left untouched.
+         * @returns Whether or not the shapes touch.
+        */
+        bool collide_persistent(const shape& a, const transform& ta, const shape& b, const transform& tb,
+            const contact_manifold* previous, contact_manifold& manifold)
+        {
+            manifold.count = 0;
+            bool touching = collide(a, ta, b, tb, manifold);
+            return persist(a, ta, b, tb, previous, manifold, touching);
+        }
+
+        // ============================= BATCHES =============================
+
+        /** @brief Rotates the vectors by the quaternions, a lane at a time. The same as glm's quat * vec3. */
+        inline void rotate(simd::vfloat qx, simd::vfloat qy, simd::vfloat qz, simd::vfloat qw,
+            simd::vfloat& x, simd::vfloat& y, simd::vfloat& z)
+        {
+            using namespace simd;
+            // uv = cross(q.xyz, v), uuv = cross(q.xyz, uv), v + (uv * w + uuv) * 2
+            vfloat ux = qy * z - y * qz, uy = qz * x - z * qx, uz = qx * y - x * qy;
+            vfloat uux = qy * uz - uy * qz, uuy = qz * ux - uz * qx, uuz = qx * uy - ux * qy;
+            vfloat two = set1(2.0f);
+            x = x + (ux * qw + uux) * two;
+            y = y + (uy * qw + uuy) * two;
+            z = z + (uz * qw + uuz) * two;
+        }
+
+        /**
+         * @brief Up to @c capacity sphere-sphere and sphere-box pairs, as a structure of arrays. Their contacts are
+         * found simd::width pairs at a time (see: run), the same way as their kernels in the dispatch table do. The
+         * sphere is always the first shape of a lane, the normal of a pair that was pushed the other way around is
+         * flipped back by result. A batch is small enough to live on the stack and to stay in the L1 cache, it is
+         * flushed whenever it is full rather than grown.
+         *
+         * Usage;
+         *  pair_batch batch;
+         *  for every pair i: if(!batch.push(i, a, ta, b, tb)) collide_persistent(...);
+         *                    else if(batch.full()) flush;
+         *  flush: batch.run(); for every k < batch.size(): persist(..., batch.result(k, manifold_of(batch.pair(k)))); batch.clear();
+        */
+        class pair_batch
+        {
+        public:
+            /** @brief The number of pairs that fit into a batch. A multiple of every simd::width. */
+            static constexpr size_t capacity = 64;
+
+        private:
+            /** @brief The columns of a kind of pair, one element per lane. */
+            struct lanes
+            {
+                enum column : size_t
+                {
+                    // The sphere, then the other sphere (position, radius) or the box (position, orientation, half extents).
+                    SX, SY, SZ, SR, BX, BY, BZ, BR, QX, QY, QZ, QW, HX, HY, HZ,
+                    // The normal from the sphere towards the other shape, the point, its depth and 1 if they touch.
+                    NX, NY, NZ, PX, PY, PZ, DEPTH, HIT,
+                    COLUMN_COUNT
+                };
+                alignas(simd_alignment) float columns[COLUMN_COUNT][capacity];
+                uint32_t pairs[capacity];
+                bool swapped[capacity];
+                size_t count = 0;
+
+                void set(size_t column, size_t lane, float value) { columns[column][lane] = value; }
+                simd::vfloat load(size_t column, size_t lane) const { return simd::load(columns[column] + lane); }
+                void store(size_t column, size_t lane, simd::vfloat value) { simd::store(columns[column] + lane, value); }
+
+                /** @brief Fills the inputs of the lanes after the last pair, so that the last register only holds finite numbers. */
+                void pad()
+                {
+                    for(size_t i = count; i < simd::padded(count); i++)
+                        for(size_t c = 0; c < NX; c++) columns[c][i] = c == QW ? 1.0f : 0.0f;
+                }
+
+                /** @brief Adds a lane and writes its sphere. @returns The lane. */
+                uint32_t push(uint32_t pair, bool is_swapped, const shape& sphere, const transform& ts)
+                {
+                    uint32_t i = static_cast<uint32_t>(count++);
+                    pairs[i] = pair;
+                    swapped[i] = is_swapped;
+                    set(SX, i, ts.position.x); set(SY, i, ts.position.y); set(SZ, i, ts.position.z);
+                    set(SR, i, sphere.radius);
+                    return i;
+                }
+            };
+
+            lanes _spheres;
+            lanes _boxes;
+            /** @brief The lane of every pair in the order that they were pushed, the lanes of the boxes follow the spheres. */
+            uint32_t _order[capacity];
+            size_t _size = 0;
+
+            /** @brief The same as sphere_sphere. */
+            static void sphere_sphere_lanes(lanes& l)
+            {
+                using namespace simd;
+                const vfloat zero = set1(0.0f), one = set1(1.0f), half = set1(0.5f), epsilon = set1(1e-6f);
+                for(size_t i = 0; i < l.count; i += width)
+                {
+                    vfloat ax = l.load(lanes::SX, i), ay = l.load(lanes::SY, i), az = l.load(lanes::SZ, i), ra = l.load(lanes::SR, i);
+                    vfloat dx = l.load(lanes::BX, i) - ax, dy = l.load(lanes::BY, i) - ay, dz = l.load(lanes::BZ, i) - az;
+                    vfloat radii = ra + l.load(lanes::BR, i);
+                    vfloat distance_sq = dx * dx + dy * dy + dz * dz;
+                    vfloat distance = sqrt(distance_sq);
+
+                    vmask apart = distance > epsilon;
+                    vfloat safe = select(apart, distance, one);
+                    vfloat nx = select(apart, dx / safe, zero), ny = select(apart, dy / safe, one), nz = select(apart, dz / safe, zero);
+                    vfloat depth = radii - distance;
+                    vfloat offset = ra - depth * half;
+
+                    l.store(lanes::NX, i, nx); l.store(lanes::NY, i, ny); l.store(lanes::NZ, i, nz);
+                    l.store(lanes::PX, i, ax + nx * offset); l.store(lanes::PY, i, ay + ny * offset); l.store(lanes::PZ, i, az + nz * offset);
+                    l.store(lanes::DEPTH, i, depth);
+                    l.store(lanes::HIT, i, select(distance_sq <= radii * radii, one, zero));
+                }
+            }
+
+            /** @brief The same as sphere_box. */
+            static void sphere_box_lanes(lanes& l)
+            {
+                using namespace simd;
+                const vfloat zero = set1(0.0f), one = set1(1.0f), half = set1(0.5f), epsilon = set1(1e-12f);
+                for(size_t i = 0; i < l.count; i += width)
+                {
+                    vfloat r = l.load(lanes::SR, i);
+                    vfloat bx = l.load(lanes::BX, i), by = l.load(lanes::BY, i), bz = l.load(lanes::BZ, i);
+                    vfloat qx = l.load(lanes::QX, i), qy = l.load(lanes::QY, i), qz = l.load(lanes::QZ, i), qw = l.load(lanes::QW, i);
+                    vfloat hx = l.load(lanes::HX, i), hy = l.load(lanes::HY, i), hz = l.load(lanes::HZ, i);
+
+                    // In the local space of the box.
+                    vfloat px = l.load(lanes::SX, i) - bx, py = l.load(lanes::SY, i) - by, pz = l.load(lanes::SZ, i) - bz;
+                    rotate(-qx, -qy, -qz, qw, px, py, pz);
+                    vfloat cx = min(max(px, -hx), hx), cy = min(max(py, -hy), hy), cz = min(max(pz, -hz), hz);
+                    vfloat dx = px - cx, dy = py - cy, dz = pz - cz;
+                    vfloat distance_sq = dx * dx + dy * dy + dz * dz;
+
+                    // Outside of the box, the normal points from the closest point towards the center.
+                    vmask outside = distance_sq > epsilon;
+                    vfloat distance = sqrt(distance_sq);
+                    vfloat safe = select(outside, distance, one);
+
+                    // Inside of the box, out through the closest face. The lower axis wins a tie.
+                    vfloat ex = hx - abs(px), ey = hy - abs(py), ez = hz - abs(pz);
+                    vmask on_y = ey < ex;
+                    vfloat best = select(on_y, ey, ex);
+                    vmask on_z = ez < best, not_z = ez >= best;
+                    best = select(on_z, ez, best);
+                    vmask on_x = (ey >= ex) & not_z;
+                    on_y = on_y & not_z;
+                    vfloat sx = select(px < zero, -one, one), sy = select(py < zero, -one, one), sz = select(pz < zero, -one, one);
+
+                    vfloat nx = select(outside, dx / safe, select(on_x, sx, zero));
+                    vfloat ny = select(outside, dy / safe, select(on_y, sy, zero));
+                    vfloat nz = select(outside, dz / safe, select(on_z, sz, zero));
+                    cx = select(outside, cx, select(on_x, hx * sx, cx));
+                    cy = select(outside, cy, select(on_y, hy * sy, cy));
+                    cz = select(outside, cz, select(on_z, hz * sz, cz));
+                    vfloat depth = select(outside, r - distance, best + r);
+
+                    // Back into world space, the normal of the manifold points from the sphere towards the box.
+                    rotate(qx, qy, qz, qw, nx, ny, nz);
+                    rotate(qx, qy, qz, qw, cx, cy, cz);
+                    nx = -nx; ny = -ny; nz = -nz;
+                    vfloat offset = depth * half;
+
+                    l.store(lanes::NX, i, nx); l.store(lanes::NY, i, ny); l.store(lanes::NZ, i, nz);
+                    l.store(lanes::PX, i, cx + bx + nx * offset); l.store(lanes::PY, i, cy + by + ny * offset); l.store(lanes::PZ, i, cz + bz + nz * offset);
+                    l.store(lanes::DEPTH, i, depth);
+                    l.store(lanes::HIT, i, select(outside & (distance_sq > r * r), zero, one));
+                }
+            }
+
+        public:
+            pair_batch() = default;
+            pair_batch(const pair_batch&) = delete;
+            pair_batch& operator=(const pair_batch&) = delete;
+
+            /**
+             * @brief Adds the pair to the lanes of its kind. The batch must not be full.
+             * @param pair The index of the pair, it is handed back by pair().
+             * @returns false if the pair has no batched kernel, it has to be collided on its own. (see: collide_persistent)
+            */
+            bool push(uint32_t pair, const shape& a, const transform& ta, const shape& b, const transform& tb)
+            {
+                if(a.type == shape_type::SPHERE && b.type == shape_type::SPHERE)
+                {
+                    uint32_t i = _spheres.push(pair, false, a, ta);
+                    _order[_size++] = i;
+                    _spheres.set(lanes::BX, i, tb.position.x); _spheres.set(lanes::BY, i, tb.position.y); _spheres.set(lanes::BZ, i, tb.position.z);
+                    _spheres.set(lanes::BR, i, b.radius);
+                    return true;
+                }
+
+                bool swapped = a.type == shape_type::BOX && b.type == shape_type::SPHERE;
+                if(!swapped && !(a.type == shape_type::SPHERE && b.type == shape_type::BOX)) return false;
+
+                const shape& box = swapped ? a : b;
+                const transform& tbox = swapped ? ta : tb;
+                uint32_t i = _boxes.push(pair, swapped, swapped ? b : a, swapped ? tb : ta);
+                _order[_size++] = static_cast<uint32_t>(capacity) + i;
+                _boxes.set(lanes::BX, i, tbox.position.x); _boxes.set(lanes::BY, i, tbox.position.y); _boxes.set(lanes::BZ, i, tbox.position.z);
+                _boxes.set(lanes::QX, i, tbox.orientation.x); _boxes.set(lanes::QY, i, tbox.orientation.y);
+                _boxes.set(lanes::QZ, i, tbox.orientation.z); _boxes.set(lanes::QW, i, tbox.orientation.w);
+                _boxes.set(lanes::HX, i, box.half_extents.x); _boxes.set(lanes::HY, i, box.half_extents.y); _boxes.set(lanes::HZ, i, box.half_extents.z);
+                return true;
+            }
+
+            /** @brief Finds the contacts of every pair that was pushed. */
+            void run()
+            {
+                _spheres.pad();
+                _boxes.pad();
+                sphere_sphere_lanes(_spheres);
+                sphere_box_lanes(_boxes);
+            }
+
+            /** @brief Forgets every pair, so that the batch can be filled again. */
+            void clear() noexcept(true) { _spheres.count = _boxes.count = _size = 0; }
+
+            /** @brief Returns the number of pairs that were pushed. */
+            size_t size() const noexcept(true) { return _size; }
+            bool full() const noexcept(true) { return _size == capacity; }
+            /** @brief Returns the index that the k-th pushed pair was pushed with. [0<=k<size] */
+            uint32_t pair(size_t k) const
+            {
+                uint32_t lane = _order[k];
+                return lane < capacity ? _spheres.pairs[lane] : _boxes.pairs[lane - capacity];
+            }
+
+            /**
+             * @brief Writes the contact of the k-th pushed pair into its manifold, as its kernel in the dispatch table
+             * would. Only valid after run.
+             * @returns Whether or not the shapes touch. (see: persist)
+            */
+            bool result(size_t k, contact_manifold& manifold) const
+            {
+                uint32_t lane = _order[k];
+                const lanes& l = lane < capacity ? _spheres : _boxes;
+                size_t i = lane < capacity ? lane : lane - capacity;
+                manifold.count = 0;
+                if(l.columns[lanes::HIT][i] == 0.0f) return false;
+
+                glm::vec3 normal(l.columns[lanes::NX][i], l.columns[lanes::NY][i], l.columns[lanes::NZ][i]);
+                manifold.normal = l.swapped[i] ? -normal : normal;
+                manifold.points[0].position = glm::vec3(l.columns[lanes::PX][i], l.columns[lanes::PY][i], l.columns[lanes::PZ][i]);
+                manifold.points[0].depth = l.columns[lanes::DEPTH][i];
+                manifold.count = 1;
+                return true;
+            }
+        };
+    }; // namespace narrowphase
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
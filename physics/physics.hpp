@@ -0,0 +1,33 @@
+/**
+ * The default header that every file of the physics engine will have to include.
+ *
+ * The physics engine doesn't need a window or a context. It only uses the math types (glm) and the CPU side of the
+ * glfw headers (time, profiler scopes, thread pool). Hence, it can also run headless; glm is included directly rather
+ * than through glfw/math.hpp, so that it even builds without OpenGL. (see: _GLFW_WITHOUT_OPENGL_ in glfw/glfw.hpp)
+*/
+
+#ifndef _PHYSICS_DEFINITION_HPP_
+    #define _PHYSICS_DEFINITION_HPP_
+
+    #include <glm/glm.hpp>
+    #include <glm/gtc/quaternion.hpp>
+
+    #include <cstdint>
+    #include <cstddef>
+
+    /// @brief The namespace that will contain the physics engine. i.e. the bodies, the world and how they are simulated.
+    namespace physics
+    {
+        /// @brief Identifies a body in a world. It stays the same for as long as the body exists.
+        using body_handle = uint32_t;
+        /// @brief Represents a handle to nothing.
+        constexpr body_handle invalid_body_handle = UINT32_MAX;
+
+        /// @brief The alignment(in bytes) of every structure-of-arrays array. (One cache line, and the size of an AVX-512 register)
+        constexpr size_t simd_alignment = 64;
+    };
+
+    #define _PHYSICS_START_ namespace physics {
+    #define _PHYSICS_END_ };
+
+#endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+/**
+ * This header contains the exact ray and point queries against a single shape. The broadphase (or the tree) only
+ * knows about the bounding boxes, these are what the world uses to find the actual hit.
+ *
+ * Convex hulls are queried as the box around their points.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+
+#ifndef _PHYSICS_QUERIES_DEFINITION_HPP_
+    #define _PHYSICS_QUERIES_DEFINITION_HPP_
+
+    #include <cmath>
+    #include <limits>
+
+    _PHYSICS_START_
+
+    /** @brief Where a ray hit a body. */
+    struct ray_hit
+    {
+        body_handle body = invalid_body_handle;
+        /** @brief The distance along the (normalized) ray. */
+        float distance = 0.0f;
+        glm::vec3 point = glm::vec3(0.0f);
+        /** @brief The normal of the surface at the point. It points out of the body. */
+        glm::vec3 normal = glm::vec3(0.0f);
+    };
+
+    namespace queries
+    {
+        /** @brief Rotates the vector by the inverse of the quaternion. */
+        inline glm::vec3 inverse_rotate(const glm::quat& q, const glm::vec3& v) { return glm::conjugate(q) * v; }
+
+        /**
+         * @brief Intersects a ray with a sphere at the origin.
+         * @returns The distance to the hit, or a negative value if it misses. 0 if the ray starts inside.
+        */
+        inline float ray_sphere(const glm::vec3& origin, const glm::vec3& direction, float radius)
+        {
+            float b = glm::dot(origin, direction);
+            float c = glm::dot(origin, origin) - radius * radius;
+            if(c <= 0.0f) return 0.0f;
+            if(b > 0.0f) return -1.0f;
+
+            float discriminant = b * b - c;
+            if(discriminant < 0.0f) return -1.0f;
+            return -b - std::sqrt(discriminant);
+        }
+
+        /**
+         * @brief Intersects a ray with a shape.
+         * @param s The shape.
+         * @param position The position of the body.
+         * @param orientation The orientation of the body.
+         * @param origin Where the ray starts.
+         * @param direction The normalized direction of the ray.
+         * @param max_distance How far the ray goes.
+         * @param hit Set to the hit, the body is left untouched.
+         * @returns Whether or not the ray hit the shape within max_distance.
+        */
+        bool raycast_shape(const shape& s, const glm::vec3& position, const glm::quat& orientation,
+            const glm::vec3& origin, const glm::vec3& direction, float max_distance, ray_hit& hit)
+        {
+            // Everything is done in the local space of the shape.
+            glm::vec3 o = inverse_rotate(orientation, origin - position);
+            glm::vec3 d = inverse_rotate(orientation, direction);
+
+            float t = -1.0f;
+            glm::vec3 normal(0.0f);
+
+            switch(s.type)
+            {
+            case shape_type::SPHERE:
+            {
+                t = ray_sphere(o, d, s.radius);
+                if(t >= 0.0f) normal = o + d * t;
+                break;
+            }
+            case shape_type::BOX:
+            case shape_type::CONVEX:
+            {
+                glm::vec3 extents = s.local_half_extents();
+                float t_min = 0.0f, t_max = max_distance;
+                int hit_axis = -1;
+                float hit_sign = 0.0f;
+                for(int axis = 0; axis < 3; axis++)
+                {
+                    float h = extents[axis];
+                    if(std::fabs(d[axis]) < 1e-8f)
+                    {
+                        if(o[axis] < -h || o[axis] > h) return false;
+                        continue;
+                    }
+                    float inverse = 1.0f / d[axis];
+                    float t0 = (-h - o[axis]) * inverse, t1 = (h - o[axis]) * inverse;
+                    float sign = -1.0f;
+                    if(t0 > t1) { std::swap(t0, t1); sign = 1.0f; }
+                    if(t0 > t_min) { t_min = t0; hit_axis = axis; hit_sign = sign; }
+                    t_max = std::fmin(t_max, t1);
+                    if(t_min > t_max) return false;
+                }
+                t = t_min;
+                if(hit_axis >= 0) normal[hit_axis] = hit_sign;
+                break;
+            }
+            case shape_type::CAPSULE:
+            {
+                float h = s.half_extents.y, r = s.radius;
+
+                // The side of the cylinder, ignoring the y-axis.
+                float a = d.x * d.x + d.z * d.z;
+                float b = o.x * d.x + o.z * d.z;
+                float c = o.x * o.x + o.z * o.z - r * r;
+                if(c <= 0.0f && std::fabs(o.y) <= h) { t = 0.0f; break; }
+
+                if(a > 1e-8f)
+                {
+                    float discriminant = b * b - a * c;
+                    if(discriminant >= 0.0f)
+                    {
+                        float side = (-b - std::sqrt(discriminant)) / a;
+                        float y = o.y + d.y * side;
+                        if(side >= 0.0f && std::fabs(y) <= h)
+                        {
+                            t = side;
+                            normal = glm::vec3(o.x + d.x * side, 0.0f, o.z + d.z * side);
+                        }
+                    }
+                }
+
+                // The caps.
+                for(float cap : { -h, h })
+                {
+                    glm::vec3 local = o - glm::vec3(0.0f, cap, 0.0f);
+                    float cap_t = ray_sphere(local, d, r);
+                    if(cap_t >= 0.0f && (t < 0.0f || cap_t < t))
+                    {
+                        t = cap_t;
+                        normal = local + d * cap_t;
+                    }
+                }
+                break;
+            }
+            }
+
+            if(t < 0.0f || t > max_distance) return false;
+
+            hit.distance = t;
+            hit.point = origin + direction * t;
+            // A ray that starts inside has no meaningful normal, it points back along the ray.
+            hit.normal = t == 0.0f || glm::dot(normal, normal) == 0.0f ? -direction : orientation * glm::normalize(normal);
+            return true;
+        }
+
+        /**
+         * @brief Returns the distance from the point to the surface of the shape, 0 if the point is inside.
+         * @param s The shape.
+         * @param position The position of the body.
+         * @param orientation The orientation of the body.
+         * @param point The point.
+        */
+        float distance_to_shape(const shape& s, const glm::vec3& position, const glm::quat& orientation, const glm::vec3& point)
+        {
+            glm::vec3 p = inverse_rotate(orientation, point - position);
+            switch(s.type)
+            {
+            case shape_type::SPHERE:
+                return std::fmax(glm::length(p) - s.radius, 0.0f);
+            case shape_type::BOX:
+            case shape_type::CONVEX:
+            {
+                glm::vec3 extents = s.local_half_extents();
+                glm::vec3 q(
+                    std::fmax(std::fabs(p.x) - extents.x, 0.0f),
+                    std::fmax(std::fabs(p.y) - extents.y, 0.0f),
+                    std::fmax(std::fabs(p.z) - extents.z, 0.0f));
+                return glm::length(q);
+            }
+            case shape_type::CAPSULE:
+            {
+                float y = std::fmax(std::fmin(p.y, s.half_extents.y), -s.half_extents.y);
+                return std::fmax(glm::length(p - glm::vec3(0.0f, y, 0.0f)) - s.radius, 0.0f);
+            }
+            }
+            return std::numeric_limits<float>::max();
+        }
+    }; // namespace queries
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,366 @@
+/**
+ * This header contains the replays; a file of the snapshots (see: snapshot.hpp) of a world after every step. The
+ * recorder only copies the state of the world on the simulation thread, a writer thread encodes it and appends it to
+ * the file. Hence recording costs about a memcpy of the stores per step.
+ *
+ * Every keyframe_interval-th frame is a whole snapshot (a keyframe), the frames in between are deltas to the frame
+ * before them. (see: encode_delta) To jump to any frame, the reader decodes the keyframe before it and then the
+ * deltas up to it, the world is never stepped. Playing the frames in order only decodes a delta per frame.
+ *
+ * The file is a header followed by the frames, every frame is a record header followed by its data. There is no
+ * index at the end, the reader finds the frames by skipping from header to header; a recording that was cut short
+ * (ex; by a crash, which is what a replay is often for) can be read up to its last whole frame.
+ *
+ * Usage;
+ *  physics::replay_recorder recorder;
+ *  recorder.open("session.replay");
+ *  ... every step ...
+ *  world.step(dt);
+ *  recorder.record(world);
+ *  ...
+ *  physics::replay_reader reader;
+ *  reader.open("session.replay");
+ *  reader.restore(reader.find_step(1200), world);
+*/
+
+#include "./physics.hpp"
+#include "./snapshot.hpp"
+#include "./world.hpp"
+#include "../glfw/mapped_file.hpp"
+#include "../glfw/profiler.hpp"
+
+#ifndef _PHYSICS_REPLAY_DEFINITION_HPP_
+    #define _PHYSICS_REPLAY_DEFINITION_HPP_
+
+    #include <vector>
+    #include <thread>
+    #include <mutex>
+    #include <condition_variable>
+    #include <algorithm>
+    #include <cstdio>
+    #include <cstring>
+    #include <cstdint>
+    #include <cstddef>
+
+    _PHYSICS_START_
+
+    /** @brief The first 4 bytes of a replay. "PHRP" */
+    constexpr uint32_t replay_magic = 0x50524850;
+    constexpr uint32_t replay_version = 1;
+
+    /** @brief The header of a replay file. */
+    struct replay_header
+    {
+        uint32_t magic = replay_magic;
+        uint32_t version = replay_version;
+        uint32_t keyframe_interval = 0;
+        uint32_t reserved = 0;
+    };
+
+    /** @brief What the data of a frame is. */
+    enum class replay_frame_type : uint32_t
+    {
+        /** @brief A whole snapshot. */
+        KEYFRAME    = 0,
+        /** @brief A delta to the snapshot of the frame before it. */
+        DELTA       = 1
+    };
+
+    /** @brief The header of a single frame, it is followed by @c size bytes of data. */
+    struct replay_record
+    {
+        replay_frame_type type;
+        uint32_t reserved;
+        /** @brief The step_count of the world when the frame was recorded. */
+        uint64_t step;
+        uint64_t size;
+    };
+    static_assert(sizeof(replay_record) == 24, "The record header is written into the file as it is.");
+
+    /** @brief Records the snapshots of a world into a replay file. (see: the top of this file) */
+    class replay_recorder
+    {
+    public:
+        /** @brief The number of snapshots that can wait for the writer thread before record blocks. */
+        static constexpr size_t slot_count = 4;
+
+    private:
+        struct slot
+        {
+            std::vector<uint8_t> snapshot;
+            uint64_t step = 0;
+            bool submitted = false;
+        };
+
+        std::FILE* _file = nullptr;
+        size_t _keyframe_interval = 60;
+        slot _slots[slot_count];
+        size_t _recording = 0;
+        size_t _writing = 0;
+        size_t _recorded_frames = 0;
+
+        /** @brief Only touched by the writer thread. */
+        std::vector<uint8_t> _previous;
+        std::vector<uint8_t> _delta;
+        size_t _written_frames = 0;
+        uint64_t _written_bytes = 0;
+        bool _write_failed = false;
+
+        std::thread _thread;
+        std::mutex _lock;
+        std::condition_variable _changed;
+        bool _running = false;
+
+        void thread_func()
+        {
+            for(;;)
+            {
+                slot& current = _slots[_writing];
+                {
+                    std::unique_lock<std::mutex> guard(_lock);
+                    _changed.wait(guard, [&] { return current.submitted || !_running; });
+                    if(!current.submitted) break;
+                }
+
+                {
+                    GLFW_PROFILE_SCOPE("replay_recorder::write");
+                    bool keyframe = _previous.empty() || _written_frames % _keyframe_interval == 0;
+                    if(!keyframe) encode_delta(_previous, current.snapshot, _delta);
+                    const std::vector<uint8_t>& data = keyframe ? current.snapshot : _delta;
+
+                    replay_record record { keyframe ? replay_frame_type::KEYFRAME : replay_frame_type::DELTA, 0, current.step, data.size() };
+                    if(!_write_failed && (std::fwrite(&record, sizeof(record), 1, _file) != 1
+                        || (data.size() && std::fwrite(data.data(), data.size(), 1, _file) != 1)))
+                    {
+                        _write_failed = true;
+                        fprintf(stderr, "Error writing replay\n");
+                    }
+                    _written_bytes += sizeof(record) + data.size();
+                    _written_frames++;
+                    // The snapshot is the base of the next delta, the slot takes over the storage of the old base.
+                    _previous.swap(current.snapshot);
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(_lock);
+                    current.submitted = false;
+                }
+                _changed.notify_all();
+                _writing = (_writing + 1) % slot_count;
+            }
+        }
+
+    public:
+        replay_recorder() = default;
+        replay_recorder(const replay_recorder&) = delete;
+        replay_recorder& operator=(const replay_recorder&) = delete;
+
+        /**
+         * @brief Creates the file (an existing one is overwritten) and starts the writer thread.
+         * @param path The path to the file.
+         * @param keyframe_interval? The number of frames from one keyframe to the next. Fewer makes the file larger
+         * and jumping to a frame faster.
+         * @returns Whether or not the file could be created.
+        */
+        bool open(const char* path, size_t keyframe_interval=60)
+        {
+            close();
+            _file = std::fopen(path, "wb");
+            if(!_file)
+            {
+                fprintf(stderr, "Error creating replay at \"%s\"\n", path);
+                return false;
+            }
+
+            _keyframe_interval = std::max<size_t>(keyframe_interval, 1);
+            replay_header header;
+            header.keyframe_interval = static_cast<uint32_t>(_keyframe_interval);
+            std::fwrite(&header, sizeof(header), 1, _file);
+
+            _previous.clear();
+            _recording = _writing = 0;
+            _recorded_frames = _written_frames = 0;
+            _written_bytes = sizeof(header);
+            _write_failed = false;
+            _running = true;
+            _thread = std::thread(&replay_recorder::thread_func, this);
+            return true;
+        }
+
+        /**
+         * @brief Takes a snapshot of the world and hands it to the writer thread. Should be called after every step.
+         * Waits if the writer thread is slot_count frames behind. Once the slots have grown to the size of a snapshot,
+         * this doesn't allocate.
+        */
+        void record(const world& w)
+        {
+            GLFW_PROFILE_SCOPE("replay_recorder::record");
+            if(!_file) return;
+
+            slot& current = _slots[_recording];
+            {
+                std::unique_lock<std::mutex> guard(_lock);
+                _changed.wait(guard, [&] { return !current.submitted; });
+            }
+            w.save_snapshot(current.snapshot);
+            current.step = w.step_count();
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                current.submitted = true;
+            }
+            _changed.notify_all();
+            _recording = (_recording + 1) % slot_count;
+            _recorded_frames++;
+        }
+
+        /** @brief Writes the frames that are still waiting, stops the writer thread and closes the file. */
+        void close()
+        {
+            if(!_file) return;
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _running = false;
+            }
+            _changed.notify_all();
+            if(_thread.joinable()) _thread.join();
+
+            std::fclose(_file);
+            _file = nullptr;
+        }
+
+        bool is_open() const noexcept(true) { return _file != nullptr; }
+        /** @brief Returns the number of frames that have been recorded, some of them may not have been written yet. */
+        size_t recorded_frames() const noexcept(true) { return _recorded_frames; }
+        /** @brief Returns the size(in bytes) of the file. Only up to date after close. */
+        uint64_t written_bytes() const noexcept(true) { return _written_bytes; }
+
+        ~replay_recorder() noexcept(true) { close(); }
+    };
+
+    /** @brief Reads the frames of a replay file back. (see: the top of this file) */
+    class replay_reader
+    {
+    private:
+        struct frame
+        {
+            replay_frame_type type;
+            uint64_t step;
+            /** @brief The offset of the data in the file. */
+            size_t offset;
+            size_t size;
+        };
+
+        glfw::mapped_file _file;
+        replay_header _header;
+        std::vector<frame> _frames;
+
+        /** @brief The snapshot of the frame that was decoded last. */
+        std::vector<uint8_t> _current;
+        std::vector<uint8_t> _next;
+        size_t _current_frame = SIZE_MAX;
+
+        bool decode(size_t index)
+        {
+            const frame& f = _frames[index];
+            const uint8_t* data = _file.data() + f.offset;
+            if(f.type == replay_frame_type::KEYFRAME)
+            {
+                _current.assign(data, data + f.size);
+                _current_frame = index;
+                return true;
+            }
+            if(_current_frame != index - 1 || !apply_delta(_current, data, f.size, _next)) return false;
+            _current.swap(_next);
+            _current_frame = index;
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Maps the file and finds its frames.
+         * @param path The path to the file.
+         * @returns Whether or not the file is a replay. A replay that was cut short is read up to its last whole frame.
+        */
+        bool open(const char* path)
+        {
+            close();
+            if(!_file.open(path)) return false;
+
+            const uint8_t* data = _file.data();
+            size_t size = _file.size(), offset = sizeof(replay_header);
+            if(size < offset) return close(), fprintf(stderr, "Error loading replay at \"%s\"\n", path), false;
+            std::memcpy(&_header, data, sizeof(_header));
+            if(_header.magic != replay_magic || _header.version != replay_version)
+                return close(), fprintf(stderr, "Error loading replay at \"%s\"\n", path), false;
+
+            while(size - offset >= sizeof(replay_record))
+            {
+                replay_record record;
+                std::memcpy(&record, data + offset, sizeof(record));
+                offset += sizeof(record);
+                if(record.size > size - offset) break;
+
+                // A delta can't be decoded without the frames before it, the first frame has to be a keyframe.
+                if(_frames.empty() && record.type != replay_frame_type::KEYFRAME) break;
+                _frames.push_back(frame { record.type, record.step, offset, static_cast<size_t>(record.size) });
+                offset += static_cast<size_t>(record.size);
+            }
+            return true;
+        }
+
+        void close()
+        {
+            _file.close();
+            _frames.clear();
+            _current.clear();
+            _current_frame = SIZE_MAX;
+        }
+
+        /**
+         * @brief Decodes the snapshot of the frame. (see: snapshot) Starts from the frame that was decoded last if it
+         * comes before the frame, from the keyframe before the frame otherwise.
+         * @param index The frame. [0,frame_count)
+         * @returns false if the frame doesn't exist or is damaged.
+        */
+        bool seek(size_t index)
+        {
+            GLFW_PROFILE_SCOPE("replay_reader::seek");
+            if(index >= _frames.size()) return false;
+
+            size_t keyframe = index;
+            while(_frames[keyframe].type != replay_frame_type::KEYFRAME) keyframe--;
+            size_t first = _current_frame != SIZE_MAX && _current_frame >= keyframe && _current_frame <= index ? _current_frame + 1 : keyframe;
+
+            for(size_t i = first; i <= index; i++)
+            {
+                if(!decode(i))
+                {
+                    _current_frame = SIZE_MAX;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /** @brief Restores the world to the frame. (see: world::load_snapshot) */
+        bool restore(size_t index, world& w) { return seek(index) && w.load_snapshot(_current); }
+
+        /** @brief Returns the first frame that was recorded at or after the step, frame_count() if there is none. */
+        size_t find_step(uint64_t step) const
+        {
+            auto it = std::lower_bound(_frames.begin(), _frames.end(), step, [](const frame& f, uint64_t s) { return f.step < s; });
+            return static_cast<size_t>(it - _frames.begin());
+        }
+
+        /** @brief Returns the snapshot of the frame that was decoded last. (see: seek) */
+        const std::vector<uint8_t>& snapshot() const noexcept(true) { return _current; }
+
+        size_t frame_count() const noexcept(true) { return _frames.size(); }
+        uint64_t step_of(size_t index) const { return _frames[index].step; }
+        bool is_keyframe(size_t index) const { return _frames[index].type == replay_frame_type::KEYFRAME; }
+        uint32_t keyframe_interval() const noexcept(true) { return _header.keyframe_interval; }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
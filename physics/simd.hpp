@@ -0,0 +1,210 @@
+/**
+ * This header contains a thin wrapper around the SIMD registers of the target, so that the kernels of the physics
+ * engine can be written once and processes @c simd::width bodies per instruction.
+ *
+ *  - AVX2 (+FMA)  : 8 floats, when compiled with -mavx2 -mfma (or /arch:AVX2). The compilation scripts pass them,
+ *                   drop them for a CPU without AVX2. (The SSE4.1 path is used then)
+ *  - SSE4.1       : 4 floats, the default on x86-64 (SSE2 is enough, SSE4.1 is used for blending when available)
+ *  - NEON         : 4 floats, on ARM
+ *  - Scalar       : 1 float, everywhere else. Define _PHYSICS_NO_SIMD_ to force it.
+ *
+ * Loads and stores are aligned, hence every pointer must be aligned to simd_alignment and every array must be padded
+ * to a multiple of @c simd::width. (see: aligned_array.hpp)
+*/
+
+#include "./physics.hpp"
+
+#ifndef _PHYSICS_SIMD_DEFINITION_HPP_
+    #define _PHYSICS_SIMD_DEFINITION_HPP_
+
+    #include <cmath>
+
+    #if !defined(_PHYSICS_NO_SIMD_) && defined(__AVX2__)
+        #include <immintrin.h>
+        #define _PHYSICS_SIMD_AVX2_
+    #elif !defined(_PHYSICS_NO_SIMD_) && (defined(__SSE2__) || defined(_M_X64))
+        #include <emmintrin.h>
+        #ifdef __SSE4_1__
+            #include <smmintrin.h>
+        #endif
+        #define _PHYSICS_SIMD_SSE_
+    #elif !defined(_PHYSICS_NO_SIMD_) && defined(__ARM_NEON)
+        #include <arm_neon.h>
+        #define _PHYSICS_SIMD_NEON_
+    #else
+        #define _PHYSICS_SIMD_SCALAR_
+    #endif
+
+    _PHYSICS_START_
+
+    namespace simd
+    {
+    #if defined(_PHYSICS_SIMD_AVX2_)
+        /// @brief The number of floats in a register.
+        constexpr size_t width = 8;
+        /// @brief The name of the instruction set that is used.
+        constexpr const char* instruction_set = "AVX2";
+
+        struct vfloat { __m256 v; };
+        struct vmask  { __m256 v; };
+
+        inline vfloat load(const float* p)          { return { _mm256_load_ps(p) }; }
+        inline void   store(float* p, vfloat a)     { _mm256_store_ps(p, a.v); }
+        inline vfloat set1(float s)                 { return { _mm256_set1_ps(s) }; }
+
+        inline vfloat operator+(vfloat a, vfloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+        inline vfloat operator-(vfloat a, vfloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+        inline vfloat operator*(vfloat a, vfloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+        inline vfloat operator/(vfloat a, vfloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+        /// @brief a*b + c
+        #ifdef __FMA__
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+        #else
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v) }; }
+        #endif
+        inline vfloat min(vfloat a, vfloat b)       { return { _mm256_min_ps(a.v, b.v) }; }
+        inline vfloat max(vfloat a, vfloat b)       { return { _mm256_max_ps(a.v, b.v) }; }
+        inline vfloat sqrt(vfloat a)                { return { _mm256_sqrt_ps(a.v) }; }
+        inline vfloat abs(vfloat a)                 { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+
+        inline vmask operator<(vfloat a, vfloat b)  { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+        inline vmask operator>(vfloat a, vfloat b)  { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+        inline vmask operator<=(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+        inline vmask operator>=(vfloat a, vfloat b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+        inline vmask operator&(vmask a, vmask b)    { return { _mm256_and_ps(a.v, b.v) }; }
+        inline vmask operator|(vmask a, vmask b)    { return { _mm256_or_ps(a.v, b.v) }; }
+        /// @brief Picks @c a where the mask is set and @c b everywhere else.
+        inline vfloat select(vmask m, vfloat a, vfloat b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+        /// @brief Returns a bit per lane. Bit i is set if lane i of the mask is set.
+        inline unsigned bits(vmask m)               { return static_cast<unsigned>(_mm256_movemask_ps(m.v)); }
+
+    #elif defined(_PHYSICS_SIMD_SSE_)
+        constexpr size_t width = 4;
+        constexpr const char* instruction_set = "SSE";
+
+        struct vfloat { __m128 v; };
+        struct vmask  { __m128 v; };
+
+        inline vfloat load(const float* p)          { return { _mm_load_ps(p) }; }
+        inline void   store(float* p, vfloat a)     { _mm_store_ps(p, a.v); }
+        inline vfloat set1(float s)                 { return { _mm_set1_ps(s) }; }
+
+        inline vfloat operator+(vfloat a, vfloat b) { return { _mm_add_ps(a.v, b.v) }; }
+        inline vfloat operator-(vfloat a, vfloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+        inline vfloat operator*(vfloat a, vfloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+        inline vfloat operator/(vfloat a, vfloat b) { return { _mm_div_ps(a.v, b.v) }; }
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+        inline vfloat min(vfloat a, vfloat b)       { return { _mm_min_ps(a.v, b.v) }; }
+        inline vfloat max(vfloat a, vfloat b)       { return { _mm_max_ps(a.v, b.v) }; }
+        inline vfloat sqrt(vfloat a)                { return { _mm_sqrt_ps(a.v) }; }
+        inline vfloat abs(vfloat a)                 { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+        inline vmask operator<(vfloat a, vfloat b)  { return { _mm_cmplt_ps(a.v, b.v) }; }
+        inline vmask operator>(vfloat a, vfloat b)  { return { _mm_cmpgt_ps(a.v, b.v) }; }
+        inline vmask operator<=(vfloat a, vfloat b) { return { _mm_cmple_ps(a.v, b.v) }; }
+        inline vmask operator>=(vfloat a, vfloat b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+        inline vmask operator&(vmask a, vmask b)    { return { _mm_and_ps(a.v, b.v) }; }
+        inline vmask operator|(vmask a, vmask b)    { return { _mm_or_ps(a.v, b.v) }; }
+        #ifdef __SSE4_1__
+        inline vfloat select(vmask m, vfloat a, vfloat b) { return { _mm_blendv_ps(b.v, a.v, m.v) }; }
+        #else
+        inline vfloat select(vmask m, vfloat a, vfloat b) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+        #endif
+        inline unsigned bits(vmask m)               { return static_cast<unsigned>(_mm_movemask_ps(m.v)); }
+
+    #elif defined(_PHYSICS_SIMD_NEON_)
+        constexpr size_t width = 4;
+        constexpr const char* instruction_set = "NEON";
+
+        struct vfloat { float32x4_t v; };
+        struct vmask  { uint32x4_t v; };
+
+        inline vfloat load(const float* p)          { return { vld1q_f32(p) }; }
+        inline void   store(float* p, vfloat a)     { vst1q_f32(p, a.v); }
+        inline vfloat set1(float s)                 { return { vdupq_n_f32(s) }; }
+
+        inline vfloat operator+(vfloat a, vfloat b) { return { vaddq_f32(a.v, b.v) }; }
+        inline vfloat operator-(vfloat a, vfloat b) { return { vsubq_f32(a.v, b.v) }; }
+        inline vfloat operator*(vfloat a, vfloat b) { return { vmulq_f32(a.v, b.v) }; }
+        #if defined(__aarch64__)
+        inline vfloat operator/(vfloat a, vfloat b) { return { vdivq_f32(a.v, b.v) }; }
+        inline vfloat sqrt(vfloat a)                { return { vsqrtq_f32(a.v) }; }
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { vfmaq_f32(c.v, a.v, b.v) }; }
+        #else
+        inline vfloat operator/(vfloat a, vfloat b)
+        {
+            // Two Newton-Raphson steps on the estimate are enough for full float precision.
+            float32x4_t r = vrecpeq_f32(b.v);
+            r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+            r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+            return { vmulq_f32(a.v, r) };
+        }
+        inline vfloat sqrt(vfloat a)
+        {
+            float32x4_t r = vrsqrteq_f32(a.v);
+            r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a.v, r), r), r);
+            r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(a.v, r), r), r);
+            // sqrt(0) would otherwise be 0*inf.
+            uint32x4_t zero = vceqq_f32(a.v, vdupq_n_f32(0.0f));
+            return { vbslq_f32(zero, a.v, vmulq_f32(a.v, r)) };
+        }
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { vmlaq_f32(c.v, a.v, b.v) }; }
+        #endif
+        inline vfloat min(vfloat a, vfloat b)       { return { vminq_f32(a.v, b.v) }; }
+        inline vfloat max(vfloat a, vfloat b)       { return { vmaxq_f32(a.v, b.v) }; }
+        inline vfloat abs(vfloat a)                 { return { vabsq_f32(a.v) }; }
+
+        inline vmask operator<(vfloat a, vfloat b)  { return { vcltq_f32(a.v, b.v) }; }
+        inline vmask operator>(vfloat a, vfloat b)  { return { vcgtq_f32(a.v, b.v) }; }
+        inline vmask operator<=(vfloat a, vfloat b) { return { vcleq_f32(a.v, b.v) }; }
+        inline vmask operator>=(vfloat a, vfloat b) { return { vcgeq_f32(a.v, b.v) }; }
+        inline vmask operator&(vmask a, vmask b)    { return { vandq_u32(a.v, b.v) }; }
+        inline vmask operator|(vmask a, vmask b)    { return { vorrq_u32(a.v, b.v) }; }
+        inline vfloat select(vmask m, vfloat a, vfloat b) { return { vbslq_f32(m.v, a.v, b.v) }; }
+        inline unsigned bits(vmask m)
+        {
+            const uint32_t lanes[4] = { 1, 2, 4, 8 };
+            uint32x4_t masked = vandq_u32(m.v, vld1q_u32(lanes));
+            return vgetq_lane_u32(masked, 0) | vgetq_lane_u32(masked, 1) | vgetq_lane_u32(masked, 2) | vgetq_lane_u32(masked, 3);
+        }
+
+    #else
+        constexpr size_t width = 1;
+        constexpr const char* instruction_set = "scalar";
+
+        struct vfloat { float v; };
+        struct vmask  { bool v; };
+
+        inline vfloat load(const float* p)          { return { *p }; }
+        inline void   store(float* p, vfloat a)     { *p = a.v; }
+        inline vfloat set1(float s)                 { return { s }; }
+
+        inline vfloat operator+(vfloat a, vfloat b) { return { a.v + b.v }; }
+        inline vfloat operator-(vfloat a, vfloat b) { return { a.v - b.v }; }
+        inline vfloat operator*(vfloat a, vfloat b) { return { a.v * b.v }; }
+        inline vfloat operator/(vfloat a, vfloat b) { return { a.v / b.v }; }
+        inline vfloat fmadd(vfloat a, vfloat b, vfloat c) { return { a.v * b.v + c.v }; }
+        inline vfloat min(vfloat a, vfloat b)       { return { a.v < b.v ? a.v : b.v }; }
+        inline vfloat max(vfloat a, vfloat b)       { return { a.v > b.v ? a.v : b.v }; }
+        inline vfloat sqrt(vfloat a)                { return { std::sqrt(a.v) }; }
+        inline vfloat abs(vfloat a)                 { return { std::fabs(a.v) }; }
+
+        inline vmask operator<(vfloat a, vfloat b)  { return { a.v < b.v }; }
+        inline vmask operator>(vfloat a, vfloat b)  { return { a.v > b.v }; }
+        inline vmask operator<=(vfloat a, vfloat b) { return { a.v <= b.v }; }
+        inline vmask operator>=(vfloat a, vfloat b) { return { a.v >= b.v }; }
+        inline vmask operator&(vmask a, vmask b)    { return { a.v && b.v }; }
+        inline vmask operator|(vmask a, vmask b)    { return { a.v || b.v }; }
+        inline vfloat select(vmask m, vfloat a, vfloat b) { return { m.v ? a.v : b.v }; }
+        inline unsigned bits(vmask m)               { return m.v ? 1u : 0u; }
+    #endif
+
+        inline vfloat operator-(vfloat a) { return set1(0.0f) - a; }
+
+        /// @brief Rounds @c count up to a multiple of the register width.
+        constexpr size_t padded(size_t count) { return (count + width - 1) / width * width; }
+    }; // namespace simd
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,261 @@
+/**
+ * This header contains the sleep tracker. A body that has been (almost) at rest for a while is put to sleep, which
+ * takes it out of the integration, the narrowphase and the solver until something wakes it up again.
+ *
+ * Bodies are put to sleep an island at a time (see: islands.hpp); an island only falls asleep when every one of its
+ * bodies has been slower than the thresholds for time_to_sleep seconds. Otherwise a body at the bottom of a stack
+ * could fall asleep while the bodies above it are still pushing on it. The sleeping islands are remembered, so that
+ * waking one body wakes up every body that it was resting with.
+ *
+ * A sleeping island is woken up when;
+ *  - an awake body touches (or is joined to) one of its bodies.
+ *  - one of its bodies is changed through the world. (ex; world::apply_impulse, world::set_position)
+ *  - one of its bodies, or a body that touches them, is destroyed.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./snapshot.hpp"
+#include "./islands.hpp"
+
+#ifndef _PHYSICS_SLEEP_DEFINITION_HPP_
+    #define _PHYSICS_SLEEP_DEFINITION_HPP_
+
+    #include <vector>
+    #include <limits>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /** @brief When the bodies are put to sleep. */
+    struct sleep_settings
+    {
+        bool enabled = true;
+        /** @brief The speed (in m/s) that a body must stay below to fall asleep. */
+        float linear_threshold = 0.05f;
+        /** @brief The angular speed (in rad/s) that a body must stay below to fall asleep. */
+        float angular_threshold = 0.05f;
+        /** @brief How long (in seconds) every body of an island must stay below the thresholds. */
+        float time_to_sleep = 0.5f;
+    };
+
+    /** @brief Puts the islands that came to rest to sleep and wakes them up again. */
+    class sleep_tracker
+    {
+    private:
+        static constexpr uint32_t none = UINT32_MAX;
+
+        /** @brief Where the bodies of a sleeping island are in _members. An empty island is free to be reused. */
+        struct member_range
+        {
+            uint32_t begin = 0;
+            uint32_t count = 0;
+        };
+
+        sleep_settings _settings;
+        /**
+         * @brief The bodies of every sleeping island, one island after the other, and the island of every entry (none
+         * once the island was woken up). A body is in one sleeping island at most, hence once there is space for every
+         * body (see: reserve) the storage is only compacted, never grown.
+        */
+        std::vector<body_handle> _members;
+        std::vector<uint32_t> _member_islands;
+        std::vector<member_range> _islands;
+        std::vector<uint32_t> _free_islands;
+        size_t _sleeping_bodies = 0;
+
+        /** @brief Moves the entries of the sleeping islands to the front, over the ones of the islands that woke up. */
+        void compact()
+        {
+            size_t write = 0;
+            for(size_t k = 0; k < _members.size(); k++)
+            {
+                uint32_t id = _member_islands[k];
+                if(id == none) continue;
+                // The entries of an island are next to each other, the first one is where it starts.
+                if(k == _islands[id].begin) _islands[id].begin = static_cast<uint32_t>(write);
+                _members[write] = _members[k];
+                _member_islands[write] = id;
+                write++;
+            }
+            _members.resize(write);
+            _member_islands.resize(write);
+        }
+
+        /** @brief Returns the id of a free island, placed at the end of the members. */
+        uint32_t add_island(uint32_t count)
+        {
+            if(_members.size() + count > _members.capacity()) compact();
+
+            uint32_t id;
+            if(!_free_islands.empty())
+            {
+                id = _free_islands.back();
+                _free_islands.pop_back();
+            }
+            else
+            {
+                id = static_cast<uint32_t>(_islands.size());
+                _islands.emplace_back();
+            }
+            _islands[id] = member_range { static_cast<uint32_t>(_members.size()), count };
+            return id;
+        }
+
+        void sleep_island(body_store& bodies, const island_builder& islands, const island& group)
+        {
+            uint32_t id = add_island(group.body_count);
+            for(uint32_t k = 0; k < group.body_count; k++)
+            {
+                uint32_t i = islands.bodies()[group.body_begin + k];
+                bodies.awake[i] = 0.0f;
+                bodies.sleep_island[i] = id;
+                bodies.linear_velocity.set(i, glm::vec3(0.0f));
+                bodies.angular_velocity.set(i, glm::vec3(0.0f));
+                // So that the body isn't interpolated between its last two states while it sleeps.
+                bodies.previous_position.set(i, bodies.position.get(i));
+                bodies.previous_orientation.set(i, bodies.orientation.get(i));
+                _members.push_back(bodies.handles[i]);
+                _member_islands.push_back(id);
+            }
+            _sleeping_bodies += group.body_count;
+        }
+
+    public:
+        explicit sleep_tracker(const sleep_settings& settings = {}) : _settings(settings) {}
+
+        const sleep_settings& settings() const noexcept(true) { return _settings; }
+        /** @brief Changes the settings. Disabling sleeping doesn't wake up the sleeping bodies. (see: wake_all) */
+        void set_settings(const sleep_settings& settings) noexcept(true) { _settings = settings; }
+
+        /** @brief Makes sure that up to @p body_count bodies are put to sleep (and woken up) without allocating. */
+        void reserve(size_t body_count)
+        {
+            _members.reserve(body_count);
+            _member_islands.reserve(body_count);
+            _islands.reserve(body_count);
+            _free_islands.reserve(body_count);
+        }
+
+        /** @brief Returns the number of sleeping bodies. */
+        size_t sleeping_bodies() const noexcept(true) { return _sleeping_bodies; }
+        /** @brief Returns the number of sleeping islands. */
+        size_t sleeping_islands() const noexcept(true) { return _islands.size() - _free_islands.size(); }
+
+        /**
+         * @brief Wakes up the body at the index and every body of its island. Does nothing if the body is awake.
+         * The sleep timers of the bodies are reset, hence they stay awake for at least time_to_sleep seconds.
+        */
+        void wake(body_store& bodies, size_t index)
+        {
+            uint32_t id = bodies.sleep_island[index];
+            if(id == none) return;
+
+            member_range& range = _islands[id];
+            for(uint32_t k = range.begin; k < range.begin + range.count; k++)
+            {
+                body_handle handle = _members[k];
+                _member_islands[k] = none;
+                // The bodies that were destroyed while they slept are skipped.
+                if(!bodies.contains(handle)) continue;
+                size_t i = bodies.index_of(handle);
+                if(bodies.sleep_island[i] != id) continue;
+
+                bodies.awake[i] = 1.0f;
+                bodies.sleep_time[i] = 0.0f;
+                bodies.sleep_island[i] = none;
+                _sleeping_bodies--;
+            }
+            range = member_range {};
+            _free_islands.push_back(id);
+        }
+
+        /** @brief Writes the sleeping islands into the snapshot. (see: snapshot.hpp) The settings are not a part of it. */
+        void save(snapshot_writer& out) const
+        {
+            out.value(static_cast<uint64_t>(_sleeping_bodies));
+            out.value(static_cast<uint32_t>(_islands.size()));
+            for(const member_range& range : _islands) out.array(_members.data() + range.begin, range.count);
+            out.array(_free_islands);
+        }
+
+        /**
+         * @brief Reads the sleeping islands that save wrote.
+         * @param in The snapshot.
+         * @param bodies The bodies that were read from the snapshot, their islands must be the ones that are read.
+         * @returns false if the snapshot is damaged.
+        */
+        bool load(snapshot_reader& in, const body_store& bodies)
+        {
+            uint64_t sleeping = 0;
+            uint32_t count = 0;
+            if(!in.value(sleeping) || !in.value(count)) return false;
+            _members.clear();
+            _member_islands.clear();
+            // Grown one island at a time, a damaged count runs out of bytes instead of allocating it up front.
+            _islands.clear();
+            std::vector<body_handle> members;
+            for(uint32_t id = 0; id < count; id++)
+            {
+                if(!in.array(members)) return false;
+                _islands.push_back(member_range { static_cast<uint32_t>(_members.size()), static_cast<uint32_t>(members.size()) });
+                _members.insert(_members.end(), members.begin(), members.end());
+                _member_islands.insert(_member_islands.end(), members.size(), id);
+            }
+            if(!in.array(_free_islands)) return false;
+            for(uint32_t id : _free_islands)
+                if(id >= _islands.size() || _islands[id].count) return false;
+
+            // wake looks the islands of the bodies up without checking.
+            size_t asleep = 0;
+            for(uint32_t id : bodies.sleep_island)
+            {
+                if(id == none) continue;
+                if(id >= _islands.size()) return false;
+                asleep++;
+            }
+            if(asleep != sleeping) return false;
+            _sleeping_bodies = static_cast<size_t>(sleeping);
+            return true;
+        }
+
+        /** @brief Wakes up every sleeping body. */
+        void wake_all(body_store& bodies)
+        {
+            for(size_t i = 0; i < bodies.size(); i++) wake(bodies, i);
+        }
+
+        /**
+         * @brief Advances the sleep timers of the awake bodies and puts the islands that came to rest to sleep.
+         * Must be called after the islands have been built and the velocities have been solved for the step.
+         * @param bodies A reference to the bodies.
+         * @param islands The islands of the step. (see: constraint_solver::islands)
+         * @param dt The size of the step in seconds.
+        */
+        void update(body_store& bodies, const island_builder& islands, float dt)
+        {
+            if(!_settings.enabled) return;
+
+            float linear_sq = _settings.linear_threshold * _settings.linear_threshold;
+            float angular_sq = _settings.angular_threshold * _settings.angular_threshold;
+
+            for(const island& group : islands.islands())
+            {
+                float island_time = std::numeric_limits<float>::max();
+                for(uint32_t k = 0; k < group.body_count; k++)
+                {
+                    uint32_t i = islands.bodies()[group.body_begin + k];
+                    glm::vec3 v = bodies.linear_velocity.get(i), w = bodies.angular_velocity.get(i);
+
+                    float& time = bodies.sleep_time[i];
+                    time = glm::dot(v, v) > linear_sq || glm::dot(w, w) > angular_sq ? 0.0f : time + dt;
+                    island_time = std::min(island_time, time);
+                }
+                if(group.body_count && island_time >= _settings.time_to_sleep) sleep_island(bodies, islands, group);
+            }
+        }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,256 @@
+/**
+ * This header contains the snapshots; the whole state of a world as a binary blob (see: world::save_snapshot) that
+ * the world can be restored to later on. ex; to roll back to the last state that every peer agreed on, or to
+ * reproduce a bug from the step before it happened. A restored world steps exactly like the world that the snapshot
+ * was taken of.
+ *
+ * A blob is the arrays of the stores one after the other, as they are laid out in memory; every array is its length
+ * followed by its elements. Hence a snapshot is taken with a few memcpy, and is only meant to be restored by the same
+ * build on the same platform. The convex hulls are not copied, a shape is stored with the id of its hull (see:
+ * hull_registry) and is resolved again when the snapshot is restored; by another process too, once the same hulls are
+ * registered under the same ids.
+ *
+ * Two snapshots of the same world are mostly the same bytes at the same offsets (static and sleeping bodies don't
+ * change at all), encode_delta stores only the words that differ. (see: the top of replay.hpp)
+*/
+
+#include "./physics.hpp"
+#include "./aligned_array.hpp"
+
+#ifndef _PHYSICS_SNAPSHOT_DEFINITION_HPP_
+    #define _PHYSICS_SNAPSHOT_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cstdint>
+    #include <cstddef>
+    #include <cstring>
+    #include <type_traits>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /** @brief The first 4 bytes of a snapshot. "PHSS" */
+    constexpr uint32_t snapshot_magic = 0x53534850;
+    /** @brief Snapshots of another version are rejected, the layout of the stores may have changed. */
+    constexpr uint32_t snapshot_version = 3;
+
+    /** @brief Appends values and arrays to a blob. The storage of the blob is kept, writing into it again doesn't allocate. */
+    class snapshot_writer
+    {
+    private:
+        std::vector<uint8_t>& _bytes;
+
+    public:
+        /** @param bytes The blob. It is cleared. */
+        explicit snapshot_writer(std::vector<uint8_t>& bytes) : _bytes(bytes) { _bytes.clear(); }
+
+        void write(const void* data, size_t size)
+        {
+            size_t offset = _bytes.size();
+            _bytes.resize(offset + size);
+            if(size) std::memcpy(_bytes.data() + offset, data, size);
+        }
+
+        template <typename T>
+        void value(const T& v)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written as bytes.");
+            write(&v, sizeof(T));
+        }
+
+        /** @brief Writes the number of elements (as an uint32) and then the elements. */
+        template <typename T>
+        void array(const T* data, size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written as bytes.");
+            value(static_cast<uint32_t>(count));
+            write(data, sizeof(T) * count);
+        }
+        template <typename T>
+        void array(const std::vector<T>& v) { array(v.data(), v.size()); }
+        template <typename T>
+        void array(const aligned_array<T>& v) { array(v.data(), v.size()); }
+
+        size_t size() const noexcept(true) { return _bytes.size(); }
+        /** @brief Returns what has been written so far. Only valid until the next write. */
+        uint8_t* data() noexcept(true) { return _bytes.data(); }
+    };
+
+    /** @brief Reads the values and the arrays of a blob back, in the order that they were written. Every read is bounds checked. */
+    class snapshot_reader
+    {
+    private:
+        const uint8_t* _data;
+        size_t _size;
+        size_t _offset = 0;
+        bool _failed = false;
+
+    public:
+        snapshot_reader(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+        explicit snapshot_reader(const std::vector<uint8_t>& bytes) : _data(bytes.data()), _size(bytes.size()) {}
+
+        /** @returns false (and every read after it fails) if the blob ends before @p size bytes. */
+        bool read(void* data, size_t size)
+        {
+            if(_failed || size > _size - _offset) return !(_failed = true);
+            if(size) std::memcpy(data, _data + _offset, size);
+            _offset += size;
+            return true;
+        }
+
+        template <typename T>
+        bool value(T& v) { return read(&v, sizeof(T)); }
+
+        template <typename T>
+        bool array(std::vector<T>& v)
+        {
+            uint32_t count = 0;
+            if(!value(count) || sizeof(T) * count > _size - _offset) return !(_failed = true);
+            v.resize(count);
+            return read(v.data(), sizeof(T) * count);
+        }
+
+        /** @brief The padding after the elements is zeroed, the kernels process it. (see: body_store::padded_size) */
+        template <typename T>
+        bool array(aligned_array<T>& v)
+        {
+            uint32_t count = 0;
+            if(!value(count) || sizeof(T) * count > _size - _offset) return !(_failed = true);
+            v.resize(count);
+            return read(v.data(), sizeof(T) * count);
+        }
+
+        bool failed() const noexcept(true) { return _failed; }
+        /** @brief Whether or not every byte of the blob has been read. */
+        bool at_end() const noexcept(true) { return _offset == _size; }
+    };
+
+    namespace detail
+    {
+        inline void write_varint(std::vector<uint8_t>& out, uint64_t value)
+        {
+            while(value >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        inline bool read_varint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+        {
+            value = 0;
+            for(int shift = 0; p != end && shift < 64; shift += 7)
+            {
+                uint8_t byte = *p++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if(!(byte & 0x80)) return true;
+            }
+            return false;
+        }
+
+        /** @brief Returns the word of the blob at the index, the words past its end are 0. */
+        inline uint32_t word_at(const uint8_t* data, size_t size, size_t index) noexcept(true)
+        {
+            uint32_t word = 0;
+            size_t offset = index * 4;
+            if(offset < size) std::memcpy(&word, data + offset, std::min<size_t>(4, size - offset));
+            return word;
+        }
+    }; // namespace detail
+
+    /**
+     * @brief Encodes a blob as the difference to another one. The blobs are compared as 32-bit words; the words that
+     * are the same are skipped, the others are stored XOR-ed with the word of the base. The delta is the size of the
+     * target followed by runs of varint(unchanged words), varint(changed words), changed words...
+     * @param base The blob that the delta is applied to. (ex; the snapshot of the last step)
+     * @param target The blob that is encoded.
+     * @param delta Where to write the delta. It is cleared first, its storage is reused.
+    */
+    void encode_delta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target, std::vector<uint8_t>& delta)
+    {
+        delta.clear();
+        detail::write_varint(delta, target.size());
+
+        const uint8_t* b = base.data();
+        const uint8_t* t = target.data();
+        size_t words = (target.size() + 3) / 4;
+        // The words that both blobs have in full are compared in place, the ones after them go through word_at.
+        size_t full = std::min(base.size(), target.size()) / 4;
+        auto word = [&](const uint8_t* data, size_t size, size_t index) {
+            uint32_t w;
+            if(index < full) std::memcpy(&w, data + index * 4, 4);
+            else w = detail::word_at(data, size, index);
+            return w;
+        };
+        // At most a varint pair per changed word, reserved so that the changed words are appended without checks.
+        delta.reserve(delta.size() + target.size() + target.size() / 2 + 16);
+
+        size_t i = 0;
+        while(i < words)
+        {
+            size_t run = i;
+            // Unchanged words, 8 bytes at a time while both blobs have them.
+            while(run + 2 <= full && std::memcmp(b + run * 4, t + run * 4, 8) == 0) run += 2;
+            while(run < words && word(b, base.size(), run) == word(t, target.size(), run)) run++;
+            size_t changed = run;
+            while(changed < words && word(b, base.size(), changed) != word(t, target.size(), changed)) changed++;
+
+            detail::write_varint(delta, run - i);
+            detail::write_varint(delta, changed - run);
+            size_t offset = delta.size();
+            delta.resize(offset + (changed - run) * 4);
+            uint8_t* out = delta.data() + offset;
+            for(size_t k = run; k < changed; k++, out += 4)
+            {
+                uint32_t x = word(b, base.size(), k) ^ word(t, target.size(), k);
+                std::memcpy(out, &x, 4);
+            }
+            i = changed;
+        }
+    }
+
+    /**
+     * @brief Rebuilds a blob from its base and a delta. (see: encode_delta)
+     * @param base The blob that the delta was encoded against.
+     * @param delta The delta.
+     * @param size The size(in bytes) of the delta.
+     * @param target Where to write the blob. Must not be the base.
+     * @returns false if the delta is damaged.
+    */
+    bool apply_delta(const std::vector<uint8_t>& base, const uint8_t* delta, size_t size, std::vector<uint8_t>& target)
+    {
+        const uint8_t* p = delta;
+        const uint8_t* end = delta + size;
+        uint64_t target_size = 0;
+        if(!detail::read_varint(p, end, target_size)) return false;
+
+        size_t words = (target_size + 3) / 4;
+        // A whole number of words, trimmed afterwards.
+        target.resize(words * 4);
+        std::memset(target.data(), 0, target.size());
+        std::memcpy(target.data(), base.data(), std::min(base.size(), target.size()));
+
+        size_t i = 0;
+        while(i < words)
+        {
+            uint64_t unchanged = 0, changed = 0;
+            if(!detail::read_varint(p, end, unchanged) || !detail::read_varint(p, end, changed)) return false;
+            if(unchanged > words - i || changed > words - i - unchanged || changed * 4 > static_cast<uint64_t>(end - p)) return false;
+            i += unchanged;
+            for(uint64_t k = 0; k < changed; k++, i++, p += 4)
+            {
+                uint32_t word, x;
+                std::memcpy(&word, target.data() + i * 4, 4);
+                std::memcpy(&x, p, 4);
+                word ^= x;
+                std::memcpy(target.data() + i * 4, &word, 4);
+            }
+        }
+        target.resize(target_size);
+        return p == end;
+    }
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,622 @@
+/**
+ * This header contains the constraint solver. It solves the contacts and the joints with sequential impulses, i.e.
+ * it iterates over the constraints and applies to each the impulse that makes its bodies satisfy it, correcting the
+ * velocities that the earlier constraints left behind.
+ *
+ * The contacts and the joints are warm started; the impulses that the points of a manifold (see: contact_cache)
+ * and the joints ended the last step with are applied before the first iteration, so a resting stack or a hanging
+ * chain starts close to its solution instead of from nothing.
+ *
+ * Sequential impulses are sequential by nature: two constraints that share a body can't be solved at the same time.
+ * The solver runs them in parallel in two ways, neither of which needs any atomics:
+ *  - Small islands (see: islands.hpp) are solved whole, one island per job. Islands share no bodies.
+ *  - The constraints of large islands are colored, so that no two constraints of the same color share a dynamic
+ *    body. Every iteration then solves the colors one after another, each color in parallel.
+ * Static bodies are shared freely, as they are never written to.
+ *
+ * The order in which the constraints are solved only depends on the order of the constraints, hence the results are
+ * the same for any number of threads. (They are bit for bit identical to solving them on a single thread)
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./narrowphase.hpp"
+#include "./joints.hpp"
+#include "./islands.hpp"
+#include "../glfw/thread_pool.hpp"
+#include "../glfw/memory.hpp"
+
+#ifndef _PHYSICS_SOLVER_DEFINITION_HPP_
+    #define _PHYSICS_SOLVER_DEFINITION_HPP_
+
+    #include <vector>
+    #include <cmath>
+    #include <algorithm>
+
+    _PHYSICS_START_
+
+    /** @brief How the constraints are solved. */
+    struct solver_settings
+    {
+        uint32_t velocity_iterations = 8;
+        /** @brief The fraction of the penetration that is corrected per step. */
+        float baumgarte = 0.2f;
+        /** @brief How far the bodies may overlap without being pushed apart, this keeps resting contacts stable. */
+        float penetration_slop = 0.005f;
+        /** @brief The largest velocity that the penetration is corrected with. */
+        float max_correction_velocity = 4.0f;
+        /** @brief Contacts that approach slower than this (in m/s) don't bounce. */
+        float restitution_threshold = 1.0f;
+        /** @brief Whether or not the contacts and the joints start from the impulses of the last step. */
+        bool warm_starting = true;
+        /**
+         * @brief The part of its last impulse that a joint starts from. The impulse also holds the correction of the
+         * drift (see: baumgarte), at full strength it is applied twice and long chains (40 links and more) blow up.
+        */
+        float joint_warm_starting = 0.7f;
+
+        /** @brief Islands with at least this many constraints are colored rather than solved by a single job. */
+        size_t large_island_constraints = 128;
+        /** @brief The number of constraints of a color that a job solves at once. */
+        size_t batch_grain = 64;
+        /** @brief false solves everything on the calling thread. */
+        bool multithreaded = true;
+    };
+
+    /** @brief What the last step of the solver did. */
+    struct solver_stats
+    {
+        size_t islands = 0;
+        size_t large_islands = 0;
+        size_t colors = 0;
+        /** @brief The constraints of large islands that didn't fit into any color and were solved on a single thread. */
+        size_t uncolored = 0;
+        size_t contacts = 0;
+        size_t joints = 0;
+    };
+
+    /** @brief The state of a body that the solver works on. */
+    struct solver_body
+    {
+        glm::vec3 linear_velocity = glm::vec3(0.0f);
+        glm::vec3 angular_velocity = glm::vec3(0.0f);
+        /** @brief The inverse inertia tensor in world space. */
+        glm::mat3 inverse_inertia = glm::mat3(0.0f);
+        float inverse_mass = 0.0f;
+    };
+
+    struct contact_constraint_point
+    {
+        /** @brief The contact point relative to the centers of the bodies. */
+        glm::vec3 r_a, r_b;
+        float normal_mass;
+        float tangent_mass[2];
+        /** @brief The velocity that the bodies should separate with. (penetration correction, restitution) */
+        float velocity_bias;
+        /** @brief The accumulated impulses. */
+        float normal_impulse;
+        float tangent_impulse[2];
+    };
+
+    struct contact_constraint
+    {
+        uint32_t a, b;
+        /** @brief The index of the manifold that the constraint was made from. */
+        uint32_t manifold;
+        glm::vec3 normal;
+        glm::vec3 tangents[2];
+        float friction;
+        float restitution;
+        uint32_t count;
+        contact_constraint_point points[max_manifold_points];
+    };
+
+    struct ball_joint_constraint
+    {
+        /** @brief The index of the joint that the constraint was made from. */
+        uint32_t joint;
+        uint32_t a, b;
+        glm::vec3 r_a, r_b;
+        /** @brief The inverse of the effective mass matrix. */
+        glm::mat3 mass;
+        glm::vec3 bias;
+        glm::vec3 impulse;
+    };
+
+    /** @brief Solves the contacts and the joints of a world. (see: the top of this file) */
+    class constraint_solver
+    {
+    private:
+        static constexpr uint32_t max_colors = 64;
+
+        solver_settings _settings;
+        solver_stats _stats;
+
+        /** @brief One per body plus a static body at the end, which is what joints attached to the world use. */
+        std::vector<solver_body> _bodies;
+        std::vector<contact_constraint> _contacts;
+        std::vector<ball_joint_constraint> _joints;
+        /** @brief The bodies of every constraint, the contacts first and then the joints. */
+        std::vector<constraint_edge> _edges;
+
+        island_builder _islands;
+        std::vector<uint32_t> _small_islands;
+        std::vector<uint32_t> _large_islands;
+
+        /** @brief The constraints of the large islands, grouped by color. */
+        std::vector<uint32_t> _colored;
+        std::vector<uint32_t> _color_offsets;
+        std::vector<uint32_t> _uncolored;
+
+        /** @brief Returns the matrix that computes the cross product with the vector. i.e. skew(v) * x = cross(v, x) */
+        static glm::mat3 skew(const glm::vec3& v)
+        {
+            return glm::mat3(glm::vec3(0.0f, v.z, -v.y), glm::vec3(-v.z, 0.0f, v.x), glm::vec3(v.y, -v.x, 0.0f));
+        }
+
+        /** @brief Returns the inverse of the effective mass of the two bodies at the points along the direction. */
+        static float effective_mass(const solver_body& a, const solver_body& b, const glm::vec3& r_a, const glm::vec3& r_b, const glm::vec3& direction)
+        {
+            glm::vec3 ra_n = glm::cross(r_a, direction), rb_n = glm::cross(r_b, direction);
+            float k = a.inverse_mass + b.inverse_mass
+                + glm::dot(ra_n, a.inverse_inertia * ra_n) + glm::dot(rb_n, b.inverse_inertia * rb_n);
+            return k > 0.0f ? 1.0f / k : 0.0f;
+        }
+
+        void solve_contact(contact_constraint& c)
+        {
+            solver_body& a = _bodies[c.a];
+            solver_body& b = _bodies[c.b];
+            glm::vec3 va = a.linear_velocity, wa = a.angular_velocity;
+            glm::vec3 vb = b.linear_velocity, wb = b.angular_velocity;
+
+            auto apply = [&](const contact_constraint_point& p, const glm::vec3& impulse)
+            {
+                va = va - impulse * a.inverse_mass;
+                wa = wa - a.inverse_inertia * glm::cross(p.r_a, impulse);
+                vb = vb + impulse * b.inverse_mass;
+                wb = wb + b.inverse_inertia * glm::cross(p.r_b, impulse);
+            };
+
+            for(uint32_t i = 0; i < c.count; i++)
+            {
+                contact_constraint_point& p = c.points[i];
+
+                // ============================= FRICTION =============================
+                float max_friction = c.friction * p.normal_impulse;
+                for(int t = 0; t < 2; t++)
+                {
+                    glm::vec3 dv = vb + glm::cross(wb, p.r_b) - va - glm::cross(wa, p.r_a);
+                    float lambda = -p.tangent_mass[t] * glm::dot(dv, c.tangents[t]);
+
+                    float old_impulse = p.tangent_impulse[t];
+                    p.tangent_impulse[t] = std::fmin(std::fmax(old_impulse + lambda, -max_friction), max_friction);
+                    apply(p, c.tangents[t] * (p.tangent_impulse[t] - old_impulse));
+                }
+
+                // ============================= NORMAL =============================
+                glm::vec3 dv = vb + glm::cross(wb, p.r_b) - va - glm::cross(wa, p.r_a);
+                float lambda = -p.normal_mass * (glm::dot(dv, c.normal) - p.velocity_bias);
+
+                float old_impulse = p.normal_impulse;
+                p.normal_impulse = std::fmax(old_impulse + lambda, 0.0f);
+                apply(p, c.normal * (p.normal_impulse - old_impulse));
+            }
+
+            // Static bodies are shared between the constraints of a color, they must never be written to.
+            if(a.inverse_mass > 0.0f) { a.linear_velocity = va; a.angular_velocity = wa; }
+            if(b.inverse_mass > 0.0f) { b.linear_velocity = vb; b.angular_velocity = wb; }
+        }
+
+        /** @brief Applies the impulses that the contact starts from. */
+        void warm_start_contact(contact_constraint& c)
+        {
+            solver_body& a = _bodies[c.a];
+            solver_body& b = _bodies[c.b];
+            for(uint32_t i = 0; i < c.count; i++)
+            {
+                const contact_constraint_point& p = c.points[i];
+                glm::vec3 impulse = c.normal * p.normal_impulse + c.tangents[0] * p.tangent_impulse[0] + c.tangents[1] * p.tangent_impulse[1];
+                if(a.inverse_mass > 0.0f)
+                {
+                    a.linear_velocity = a.linear_velocity - impulse * a.inverse_mass;
+                    a.angular_velocity = a.angular_velocity - a.inverse_inertia * glm::cross(p.r_a, impulse);
+                }
+                if(b.inverse_mass > 0.0f)
+                {
+                    b.linear_velocity = b.linear_velocity + impulse * b.inverse_mass;
+                    b.angular_velocity = b.angular_velocity + b.inverse_inertia * glm::cross(p.r_b, impulse);
+                }
+            }
+        }
+
+        /** @brief Applies the impulse that the joint starts from. */
+        void warm_start_joint(const ball_joint_constraint& j)
+        {
+            solver_body& a = _bodies[j.a];
+            solver_body& b = _bodies[j.b];
+            if(a.inverse_mass > 0.0f)
+            {
+                a.linear_velocity = a.linear_velocity - j.impulse * a.inverse_mass;
+                a.angular_velocity = a.angular_velocity - a.inverse_inertia * glm::cross(j.r_a, j.impulse);
+            }
+            if(b.inverse_mass > 0.0f)
+            {
+                b.linear_velocity = b.linear_velocity + j.impulse * b.inverse_mass;
+                b.angular_velocity = b.angular_velocity + b.inverse_inertia * glm::cross(j.r_b, j.impulse);
+            }
+        }
+
+        void warm_start_constraint(uint32_t index)
+        {
+            if(index < _contacts.size()) warm_start_contact(_contacts[index]);
+            else warm_start_joint(_joints[index - _contacts.size()]);
+        }
+
+        void solve_joint(ball_joint_constraint& j)
+        {
+            solver_body& a = _bodies[j.a];
+            solver_body& b = _bodies[j.b];
+
+            glm::vec3 dv = b.linear_velocity + glm::cross(b.angular_velocity, j.r_b)
+                - a.linear_velocity - glm::cross(a.angular_velocity, j.r_a);
+            glm::vec3 impulse = j.mass * -(dv + j.bias);
+            j.impulse = j.impulse + impulse;
+
+            if(a.inverse_mass > 0.0f)
+            {
+                a.linear_velocity = a.linear_velocity - impulse * a.inverse_mass;
+                a.angular_velocity = a.angular_velocity - a.inverse_inertia * glm::cross(j.r_a, impulse);
+            }
+            if(b.inverse_mass > 0.0f)
+            {
+                b.linear_velocity = b.linear_velocity + impulse * b.inverse_mass;
+                b.angular_velocity = b.angular_velocity + b.inverse_inertia * glm::cross(j.r_b, impulse);
+            }
+        }
+
+        void solve_constraint(uint32_t index)
+        {
+            if(index < _contacts.size()) solve_contact(_contacts[index]);
+            else solve_joint(_joints[index - _contacts.size()]);
+        }
+
+        /** @brief Colors the constraints of the large islands. The masks and the colors only live in the scratch arena. */
+        void color(const std::vector<uint32_t>& large_islands, glfw::memory::frame_arena& scratch)
+        {
+            uint64_t* color_masks = scratch.allocate_zeroed<uint64_t>(_bodies.size());
+            uint32_t* constraint_colors = scratch.allocate<uint32_t>(_edges.size());
+            _uncolored.clear();
+
+            uint32_t color_count = 0;
+            size_t colored = 0;
+            for(uint32_t island_index : large_islands)
+            {
+                const island& is = _islands.islands()[island_index];
+                for(uint32_t k = 0; k < is.constraint_count; k++)
+                {
+                    uint32_t c = _islands.constraints()[is.constraint_begin + k];
+                    const constraint_edge& edge = _edges[c];
+
+                    // The masks of the static bodies stay 0, any number of constraints of a color may share them.
+                    uint64_t used = color_masks[edge.a] | color_masks[edge.b];
+                    if(!~used)
+                    {
+                        constraint_colors[c] = max_colors;
+                        _uncolored.push_back(c);
+                        continue;
+                    }
+
+                    uint32_t chosen = 0;
+                    while(used & (uint64_t(1) << chosen)) chosen++;
+                    constraint_colors[c] = chosen;
+                    color_count = std::max(color_count, chosen + 1);
+                    colored++;
+
+                    if(_bodies[edge.a].inverse_mass > 0.0f) color_masks[edge.a] |= uint64_t(1) << chosen;
+                    if(_bodies[edge.b].inverse_mass > 0.0f) color_masks[edge.b] |= uint64_t(1) << chosen;
+                }
+            }
+
+            // A counting sort by color, which keeps the order of the constraints within every color.
+            _color_offsets.assign(color_count + 1, 0);
+            for(uint32_t island_index : large_islands)
+            {
+                const island& is = _islands.islands()[island_index];
+                for(uint32_t k = 0; k < is.constraint_count; k++)
+                {
+                    uint32_t c = _islands.constraints()[is.constraint_begin + k];
+                    if(constraint_colors[c] < max_colors) _color_offsets[constraint_colors[c] + 1]++;
+                }
+            }
+            for(uint32_t i = 1; i <= color_count; i++) _color_offsets[i] += _color_offsets[i - 1];
+
+            _colored.resize(colored);
+            uint32_t* color_cursors = scratch.allocate<uint32_t>(_color_offsets.size());
+            std::copy(_color_offsets.begin(), _color_offsets.end(), color_cursors);
+            for(uint32_t island_index : large_islands)
+            {
+                const island& is = _islands.islands()[island_index];
+                for(uint32_t k = 0; k < is.constraint_count; k++)
+                {
+                    uint32_t c = _islands.constraints()[is.constraint_begin + k];
+                    if(constraint_colors[c] < max_colors) _colored[color_cursors[constraint_colors[c]]++] = c;
+                }
+            }
+
+            _stats.colors = color_count;
+            _stats.uncolored = _uncolored.size();
+        }
+
+    public:
+        explicit constraint_solver(const solver_settings& settings = {}) : _settings(settings) {}
+
+        solver_settings& settings() noexcept(true) { return _settings; }
+        const solver_stats& stats() const noexcept(true) { return _stats; }
+
+        /**
+         * @brief Makes sure that the steps with up to @p body_count bodies, @p contact_count contacts and @p joint_count
+         * joints are prepared and solved without allocating.
+         * @param scratch The arena that prepare will be given, reserved for the colors.
+        */
+        void reserve(size_t body_count, size_t contact_count, size_t joint_count, glfw::memory::frame_arena& scratch)
+        {
+            size_t constraint_count = contact_count + joint_count;
+            _bodies.reserve(body_count + 1);
+            _contacts.reserve(contact_count);
+            _joints.reserve(joint_count);
+            _edges.reserve(constraint_count);
+            _islands.reserve(body_count, constraint_count);
+            _small_islands.reserve(body_count);
+            _large_islands.reserve(body_count);
+            _colored.reserve(constraint_count);
+            _color_offsets.reserve(max_colors + 1);
+            _uncolored.reserve(constraint_count);
+            // The masks, the colors and the cursors of color, each aligned.
+            scratch.reserve(sizeof(uint64_t) * (body_count + 1) + sizeof(uint32_t) * (constraint_count + max_colors + 1)
+                + 3 * alignof(std::max_align_t));
+        }
+
+        /**
+         * @brief Builds the constraints for the current state of the bodies.
+         * @param bodies A reference to the bodies. Their velocities must already include the external forces.
+         * @param manifolds The contacts. Manifolds without any points, or between two bodies that don't move, are skipped.
+         * @param joints The joints.
+         * @param dt The size of the step in seconds.
+         * @param scratch The arena that the temporary data is allocated from. It must not be reset before prepare returns.
+        */
+        void prepare(const body_store& bodies, const std::vector<contact_manifold>& manifolds, const joint_store& joints, float dt,
+            glfw::memory::frame_arena& scratch)
+        {
+            _stats = solver_stats();
+            size_t count = bodies.size();
+            uint32_t world_body = static_cast<uint32_t>(count);
+
+            // ============================= BODIES =============================
+            _bodies.resize(count + 1);
+            for(size_t i = 0; i < count; i++)
+            {
+                solver_body& body = _bodies[i];
+                body.linear_velocity = bodies.linear_velocity.get(i);
+                body.angular_velocity = bodies.angular_velocity.get(i);
+                // A sleeping body is as immovable as a static one, until it is woken up.
+                bool active = !bodies.is_sleeping(i);
+                body.inverse_mass = active ? bodies.inverse_mass[i] : 0.0f;
+
+                glm::mat3 r = glm::mat3_cast(bodies.orientation.get(i));
+                glm::vec3 d = active ? bodies.inverse_inertia.get(i) : glm::vec3(0.0f);
+                glm::mat3 diagonal(glm::vec3(d.x, 0.0f, 0.0f), glm::vec3(0.0f, d.y, 0.0f), glm::vec3(0.0f, 0.0f, d.z));
+                body.inverse_inertia = r * diagonal * glm::transpose(r);
+            }
+            _bodies[world_body] = solver_body();
+
+            _contacts.clear();
+            _joints.clear();
+            _edges.clear();
+            float inverse_dt = dt > 0.0f ? 1.0f / dt : 0.0f;
+
+            // ============================= CONTACTS =============================
+            for(size_t m = 0; m < manifolds.size(); m++)
+            {
+                const contact_manifold& manifold = manifolds[m];
+                if(!manifold.count) continue;
+
+                contact_constraint c;
+                c.a = static_cast<uint32_t>(bodies.index_of(manifold.a));
+                c.b = static_cast<uint32_t>(bodies.index_of(manifold.b));
+                // The manifolds of the sleeping bodies are kept so that they can warm start once they wake up.
+                if(!bodies.is_active(c.a) && !bodies.is_active(c.b)) continue;
+                c.manifold = static_cast<uint32_t>(m);
+                c.normal = manifold.normal;
+                c.count = manifold.count;
+
+                // Any two directions that are perpendicular to the normal and to each other.
+                const glm::vec3& n = c.normal;
+                c.tangents[0] = std::fabs(n.x) >= 0.57735f ? glm::normalize(glm::vec3(n.y, -n.x, 0.0f)) : glm::normalize(glm::vec3(0.0f, n.z, -n.y));
+                c.tangents[1] = glm::cross(n, c.tangents[0]);
+
+                const material& ma = bodies.materials[c.a];
+                const material& mb = bodies.materials[c.b];
+                c.friction = std::sqrt(ma.friction * mb.friction);
+                c.restitution = std::fmax(ma.restitution, mb.restitution);
+
+                const solver_body& a = _bodies[c.a];
+                const solver_body& b = _bodies[c.b];
+                glm::vec3 pa = bodies.position.get(c.a), pb = bodies.position.get(c.b);
+                for(uint32_t i = 0; i < c.count; i++)
+                {
+                    contact_constraint_point& p = c.points[i];
+                    const contact_point& point = manifold.points[i];
+                    p.r_a = point.position - pa;
+                    p.r_b = point.position - pb;
+
+                    p.normal_mass = effective_mass(a, b, p.r_a, p.r_b, n);
+                    p.tangent_mass[0] = effective_mass(a, b, p.r_a, p.r_b, c.tangents[0]);
+                    p.tangent_mass[1] = effective_mass(a, b, p.r_a, p.r_b, c.tangents[1]);
+                    bool warm = _settings.warm_starting;
+                    p.normal_impulse = warm ? point.normal_impulse : 0.0f;
+                    p.tangent_impulse[0] = warm ? point.tangent_impulse[0] : 0.0f;
+                    p.tangent_impulse[1] = warm ? point.tangent_impulse[1] : 0.0f;
+
+                    // A point that is (just) apart lets the bodies approach until they touch, but no further.
+                    if(point.depth < 0.0f) p.velocity_bias = point.depth * inverse_dt;
+                    else p.velocity_bias = std::fmin(_settings.baumgarte * inverse_dt * std::fmax(point.depth - _settings.penetration_slop, 0.0f),
+                        _settings.max_correction_velocity);
+
+                    glm::vec3 dv = b.linear_velocity + glm::cross(b.angular_velocity, p.r_b)
+                        - a.linear_velocity - glm::cross(a.angular_velocity, p.r_a);
+                    float approach = glm::dot(dv, n);
+                    if(approach < -_settings.restitution_threshold) p.velocity_bias = std::fmax(p.velocity_bias, -c.restitution * approach);
+                }
+
+                _contacts.push_back(c);
+                _edges.push_back(constraint_edge { c.a, c.b });
+            }
+
+            // ============================= JOINTS =============================
+            for(size_t i = 0; i < joints.size(); i++)
+            {
+                const ball_joint& joint = joints.joints[i];
+                ball_joint_constraint j;
+                j.joint = static_cast<uint32_t>(i);
+                j.a = static_cast<uint32_t>(bodies.index_of(joint.a));
+                j.b = bodies.contains(joint.b) ? static_cast<uint32_t>(bodies.index_of(joint.b)) : world_body;
+
+                const solver_body& a = _bodies[j.a];
+                const solver_body& b = _bodies[j.b];
+                if(a.inverse_mass == 0.0f && b.inverse_mass == 0.0f) continue;
+
+                j.r_a = bodies.orientation.get(j.a) * joint.local_anchor_a;
+                glm::vec3 anchor_a = bodies.position.get(j.a) + j.r_a, anchor_b;
+                if(j.b == world_body)
+                {
+                    j.r_b = glm::vec3(0.0f);
+                    anchor_b = joint.local_anchor_b;
+                }
+                else
+                {
+                    j.r_b = bodies.orientation.get(j.b) * joint.local_anchor_b;
+                    anchor_b = bodies.position.get(j.b) + j.r_b;
+                }
+
+                // K = (1/ma + 1/mb) * I - skew(ra) * Ia^-1 * skew(ra) - skew(rb) * Ib^-1 * skew(rb)
+                glm::mat3 sa = skew(j.r_a), sb = skew(j.r_b);
+                glm::mat3 k = glm::mat3(a.inverse_mass + b.inverse_mass) - sa * a.inverse_inertia * sa - sb * b.inverse_inertia * sb;
+                j.mass = glm::inverse(k);
+                j.bias = (anchor_b - anchor_a) * (_settings.baumgarte * inverse_dt);
+                j.impulse = _settings.warm_starting ? joint.impulse * _settings.joint_warm_starting : glm::vec3(0.0f);
+
+                _joints.push_back(j);
+                _edges.push_back(constraint_edge { j.a, j.b });
+            }
+
+            _stats.contacts = _contacts.size();
+            _stats.joints = _joints.size();
+
+            // ============================= ISLANDS =============================
+            _islands.build(bodies, _edges);
+            _small_islands.clear();
+            _large_islands.clear();
+            for(size_t i = 0; i < _islands.islands().size(); i++)
+            {
+                const island& is = _islands.islands()[i];
+                if(!is.constraint_count) continue;
+                if(is.constraint_count < _settings.large_island_constraints) _small_islands.push_back(static_cast<uint32_t>(i));
+                else _large_islands.push_back(static_cast<uint32_t>(i));
+            }
+            _stats.islands = _islands.islands().size();
+            _stats.large_islands = _large_islands.size();
+            color(_large_islands, scratch);
+        }
+
+        /**
+         * @brief Runs the velocity iterations.
+         * @param pool The pool to solve on, or nullptr to solve on the calling thread.
+        */
+        void solve(glfw::jobs::thread_pool* pool)
+        {
+            auto run = [&](size_t count, size_t grain, auto&& fn)
+            {
+                if(pool && _settings.multithreaded) pool->parallel_for(0, count, grain, fn);
+                else fn(size_t(0), count);
+            };
+
+            // ============================= SMALL ISLANDS =============================
+            run(_small_islands.size(), 0, [&](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; i++)
+                {
+                    const island& is = _islands.islands()[_small_islands[i]];
+                    const uint32_t* constraints = _islands.constraints().data() + is.constraint_begin;
+                    for(uint32_t k = 0; k < is.constraint_count; k++) warm_start_constraint(constraints[k]);
+                    for(uint32_t iteration = 0; iteration < _settings.velocity_iterations; iteration++)
+                    {
+                        for(uint32_t k = 0; k < is.constraint_count; k++) solve_constraint(constraints[k]);
+                    }
+                }
+            });
+
+            // ============================= LARGE ISLANDS =============================
+            // The warm start touches the same bodies as the solve, hence it is colored the same way.
+            for(size_t color = 0; color + 1 < _color_offsets.size(); color++)
+            {
+                const uint32_t* constraints = _colored.data() + _color_offsets[color];
+                run(_color_offsets[color + 1] - _color_offsets[color], _settings.batch_grain, [&](size_t begin, size_t end)
+                {
+                    for(size_t k = begin; k < end; k++) warm_start_constraint(constraints[k]);
+                });
+            }
+            for(uint32_t c : _uncolored) warm_start_constraint(c);
+
+            for(uint32_t iteration = 0; iteration < _settings.velocity_iterations; iteration++)
+            {
+                for(size_t color = 0; color + 1 < _color_offsets.size(); color++)
+                {
+                    const uint32_t* constraints = _colored.data() + _color_offsets[color];
+                    run(_color_offsets[color + 1] - _color_offsets[color], _settings.batch_grain, [&](size_t begin, size_t end)
+                    {
+                        for(size_t k = begin; k < end; k++) solve_constraint(constraints[k]);
+                    });
+                }
+                for(uint32_t c : _uncolored) solve_constraint(c);
+            }
+        }
+
+        /** @brief Writes the solved velocities back into the bodies. */
+        void store(body_store& bodies) const
+        {
+            for(size_t i = 0; i < bodies.size(); i++)
+            {
+                if(!bodies.is_active(i)) continue;
+                bodies.linear_velocity.set(i, _bodies[i].linear_velocity);
+                bodies.angular_velocity.set(i, _bodies[i].angular_velocity);
+            }
+        }
+
+        /**
+         * @brief Writes the accumulated impulses back into the manifolds and the joints that the constraints were made
+         * from, for the next warm start.
+        */
+        void store_impulses(std::vector<contact_manifold>& manifolds, joint_store& joints) const
+        {
+            for(const ball_joint_constraint& j : _joints) joints.joints[j.joint].impulse = j.impulse;
+            for(const contact_constraint& c : _contacts)
+            {
+                contact_manifold& manifold = manifolds[c.manifold];
+                for(uint32_t i = 0; i < c.count; i++)
+                {
+                    manifold.points[i].normal_impulse = c.points[i].normal_impulse;
+                    manifold.points[i].tangent_impulse[0] = c.points[i].tangent_impulse[0];
+                    manifold.points[i].tangent_impulse[1] = c.points[i].tangent_impulse[1];
+                }
+            }
+        }
+
+        /** @brief Returns the islands of the last step. */
+        const island_builder& islands() const noexcept(true) { return _islands; }
+        const std::vector<contact_constraint>& contacts() const noexcept(true) { return _contacts; }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,774 @@
+/**
+ * This header contains the world. It owns the bodies and advances the simulation.
+ *
+ * The world is meant to be driven by a fixed step loop (see: glfw/frame_loop.hpp); call step from the simulation
+ * function and write_instance_transforms (or write_dirty_instance_transforms) from the renderer.
+ *
+ * The bodies that came to rest are put to sleep (see: sleep.hpp). Changing a body through the world wakes it up,
+ * changing it directly through bodies() does not; call wake_body afterwards.
+ *
+ * The whole state of the world can be saved into a snapshot and restored later on. (see: snapshot.hpp, replay.hpp)
+ *
+ * The renderer can skip the bodies that are off screen; cull finds the ones inside the view frustum (see: culling.hpp)
+ * and write_instance_transforms writes only theirs.
+*/
+
+#include "./physics.hpp"
+#include "./body_store.hpp"
+#include "./integrate.hpp"
+#include "./aabb.hpp"
+#include "./broadphase.hpp"
+#include "./culling.hpp"
+#include "./queries.hpp"
+#include "./narrowphase.hpp"
+#include "./joints.hpp"
+#include "./solver.hpp"
+#include "./sleep.hpp"
+#include "./snapshot.hpp"
+#include "../glfw/profiler.hpp"
+#include "../glfw/thread_pool.hpp"
+#include "../glfw/memory.hpp"
+
+#ifndef _PHYSICS_WORLD_DEFINITION_HPP_
+    #define _PHYSICS_WORLD_DEFINITION_HPP_
+
+    _PHYSICS_START_
+
+    /**
+     * @brief The transform of a single body, in the layout that the instanced rendering path reads. i.e. a column-major
+     * 4x4 float matrix (sizeof = 64 bytes) that includes the scale of the shape, so that every body of the same shape
+     * can be drawn with a single unit mesh. (A unit sphere with a radius of 1, a cube from -1 to 1, etc.)
+     * (see: vertex_array_object::create_instance_transform_attribute)
+    */
+    struct alignas(16) instance_transform
+    {
+        float columns[4][4];
+    };
+    static_assert(sizeof(instance_transform) == 64, "The transform must be tightly packed, the GPU reads it as a mat4.");
+
+    /** @brief The settings that a world is created with. */
+    struct world_settings
+    {
+        glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+        /** @brief The number of bodies to reserve space for. */
+        size_t expected_bodies = 0;
+        /**
+         * @brief The number of pairs (see: broadphase::find_pairs) to reserve space for. The manifolds, the contacts
+         * and the constraints of a step are reserved along with them, hence a step only allocates when there are more
+         * bodies, pairs or joints than ever before. (see: world::step_allocations)
+        */
+        size_t expected_pairs = 0;
+        /** @brief Which broadphase finds the pairs of bodies that may be touching. It can't be changed afterwards. */
+        broadphase_settings broadphase;
+        solver_settings solver;
+        physics::sleep_settings sleep;
+        /** @brief The pool that the narrowphase and the solver run on. nullptr uses glfw::jobs::shared_pool(). */
+        glfw::jobs::thread_pool* pool = nullptr;
+    };
+
+    /** @brief Owns the bodies and advances the simulation in steps. */
+    class world
+    {
+    private:
+        world_settings _settings;
+        hull_registry _hulls;
+        body_store _bodies;
+        uint64_t _step_count = 0;
+
+        std::unique_ptr<physics::broadphase> _broadphase;
+        std::vector<aabb> _bounds;
+        std::vector<body_pair> _pairs;
+
+        joint_store _joints;
+        /** @brief One per pair, the pairs whose shapes don't touch have no points. */
+        std::vector<contact_manifold> _manifolds;
+        /** @brief The manifolds of the last step, what the new ones carry their impulses over from. */
+        contact_cache _contact_cache;
+        constraint_solver _solver;
+        sleep_tracker _sleep;
+        /** @brief The step (see: step_count) in which the transform of the body at every index last changed. */
+        std::vector<uint64_t> _transform_changed;
+        glfw::jobs::thread_pool* _pool;
+        /** @brief The scratch memory of a step, one arena per thread. They are reset at the start of every step. */
+        glfw::memory::thread_arenas _arenas;
+        uint64_t _step_allocations = 0;
+
+        /** @brief Whether or not the pairs have to be found again before the next step. */
+        bool _pairs_dirty = false;
+        /** @brief What the storage of a step is reserved for. (see: reserve_step) */
+        size_t _reserved_bodies = 0, _reserved_pairs = 0, _reserved_joints = 0;
+
+        /**
+         * @brief Grows the storage of a step along with the bodies, the pairs and the joints. It follows their capacity
+         * rather than their size, so that it grows as rarely as they do.
+        */
+        void reserve_step(size_t bodies, size_t pairs, size_t joints)
+        {
+            if(bodies <= _reserved_bodies && pairs <= _reserved_pairs && joints <= _reserved_joints) return;
+            _reserved_bodies = std::max(_reserved_bodies, bodies);
+            _reserved_pairs = std::max(_reserved_pairs, pairs);
+            _reserved_joints = std::max(_reserved_joints, joints);
+
+            _pairs.reserve(_reserved_pairs);
+            _manifolds.reserve(_reserved_pairs);
+            _contact_cache.reserve(_reserved_pairs);
+            _solver.reserve(_reserved_bodies, _reserved_pairs, _reserved_joints, _arenas.local());
+            _sleep.reserve(_reserved_bodies);
+        }
+
+        /** @brief Finds the pairs for the current positions of the bodies. */
+        void update_broadphase()
+        {
+            {
+                GLFW_PROFILE_SCOPE("world::broadphase");
+                compute_bounds(_bodies, _bounds);
+                _broadphase->find_pairs(_bodies, _bounds, _pairs);
+                // The order in which the broadphase finds the pairs depends on its history (ex; the shape of the tree),
+                // sorted, the contacts are solved in the same order after a snapshot has been restored.
+                std::sort(_pairs.begin(), _pairs.end(), [](const body_pair& x, const body_pair& y)
+                {
+                    return x.a < y.a || (x.a == y.a && x.b < y.b);
+                });
+            }
+            GLFW_PROFILE_COUNTER("broadphase::tests", _broadphase->stats().tests);
+            GLFW_PROFILE_COUNTER("broadphase::pairs", _broadphase->stats().pairs);
+            _pairs_dirty = false;
+        }
+
+        /** @brief Returns the broadphase if it is a DYNAMIC_TREE, nullptr otherwise. */
+        const dynamic_tree_broadphase* tree() const noexcept(true)
+        {
+            return _broadphase->type() == broadphase_type::DYNAMIC_TREE ? static_cast<const dynamic_tree_broadphase*>(_broadphase.get()) : nullptr;
+        }
+
+        bool raycast_body(size_t index, const glm::vec3& origin, const glm::vec3& direction, float max_distance, ray_hit& hit) const
+        {
+            if(!queries::raycast_shape(_bodies.shapes[index], _bodies.position.get(index), _bodies.orientation.get(index),
+                origin, direction, max_distance, hit)) return false;
+            hit.body = _bodies.handles[index];
+            return true;
+        }
+
+        float distance_to_body(size_t index, const glm::vec3& point) const
+        {
+            return queries::distance_to_shape(_bodies.shapes[index], _bodies.position.get(index), _bodies.orientation.get(index), point);
+        }
+
+        /** @brief Wakes up the body (and its island) because it was changed through the world. */
+        void touch(size_t index, bool transform)
+        {
+            _sleep.wake(_bodies, index);
+            _bodies.sleep_time[index] = 0.0f;
+            if(transform) _transform_changed[index] = _step_count;
+        }
+
+        /** @brief Wakes up the sleeping bodies that an awake body touches or is joined to. */
+        void wake_touched()
+        {
+            if(!_sleep.sleeping_bodies()) return;
+
+            auto wake_pair = [this](body_handle a, body_handle b)
+            {
+                if(!_bodies.contains(a) || !_bodies.contains(b)) return;
+                size_t ia = _bodies.index_of(a), ib = _bodies.index_of(b);
+                if(_bodies.is_sleeping(ia) && _bodies.is_active(ib)) _sleep.wake(_bodies, ia);
+                else if(_bodies.is_sleeping(ib) && _bodies.is_active(ia)) _sleep.wake(_bodies, ib);
+            };
+            for(const contact_manifold& manifold : _manifolds)
+            {
+                if(manifold.count) wake_pair(manifold.a, manifold.b);
+            }
+            for(const ball_joint& joint : _joints.joints) wake_pair(joint.a, joint.b);
+        }
+
+        void write_instance_transform(size_t i, float alpha, instance_transform& transform) const
+        {
+            const body_store& b = _bodies;
+            glm::vec3 position = b.previous_position.get(i) + (b.position.get(i) - b.previous_position.get(i)) * alpha;
+
+            // Normalized linear interpolation, taking the shorter path.
+            glm::quat from = b.previous_orientation.get(i), to = b.orientation.get(i);
+            float sign = glm::dot(from, to) < 0.0f ? -1.0f : 1.0f;
+            glm::quat q = glm::normalize(glm::quat(
+                from.w + (to.w * sign - from.w) * alpha,
+                from.x + (to.x * sign - from.x) * alpha,
+                from.y + (to.y * sign - from.y) * alpha,
+                from.z + (to.z * sign - from.z) * alpha));
+
+            glm::vec3 scale = b.shapes[i].local_half_extents();
+            glm::mat3 rotation = glm::mat3_cast(q);
+
+            float (&m)[4][4] = transform.columns;
+            for(int c = 0; c < 3; c++)
+            {
+                m[c][0] = rotation[c][0] * scale[c];
+                m[c][1] = rotation[c][1] * scale[c];
+                m[c][2] = rotation[c][2] * scale[c];
+                m[c][3] = 0.0f;
+            }
+            m[3][0] = position.x; m[3][1] = position.y; m[3][2] = position.z; m[3][3] = 1.0f;
+        }
+
+    public:
+        explicit world(const world_settings& settings = {}) : _settings(settings),
+            _broadphase(create_broadphase(settings.broadphase)), _solver(settings.solver), _sleep(settings.sleep),
+            _pool(settings.pool ? settings.pool : &glfw::jobs::shared_pool()), _arenas(*_pool)
+        {
+            _bodies.reserve(settings.expected_bodies);
+            _transform_changed.reserve(settings.expected_bodies);
+            reserve_step(settings.expected_bodies, settings.expected_pairs, 0);
+        }
+
+        world(const world&) = delete;
+        world& operator=(const world&) = delete;
+
+        /** @brief Returns the hulls that the convex bodies use. (see: shape::convex) */
+        hull_registry& hulls() noexcept(true) { return _hulls; }
+        const hull_registry& hulls() const noexcept(true) { return _hulls; }
+
+        /** @brief Creates a body and returns its handle. */
+        body_handle create_body(const body_desc& desc)
+        {
+            body_handle handle = _bodies.add(desc);
+            _transform_changed.push_back(_step_count);
+            _broadphase->insert(handle);
+            _pairs_dirty = true;
+            return handle;
+        }
+        /**
+         * @brief Destroys the body and every joint that is attached to it. Its handle can be reused by a body that is
+         * created later. The bodies that were resting on it are woken up.
+        */
+        void destroy_body(body_handle handle)
+        {
+            size_t index = _bodies.index_of(handle);
+            _sleep.wake(_bodies, index);
+            for(const body_pair& pair : _pairs)
+            {
+                body_handle other = pair.a == handle ? pair.b : pair.b == handle ? pair.a : invalid_body_handle;
+                if(_bodies.contains(other)) _sleep.wake(_bodies, _bodies.index_of(other));
+            }
+            for(const ball_joint& joint : _joints.joints)
+            {
+                body_handle other = joint.a == handle ? joint.b : joint.b == handle ? joint.a : invalid_body_handle;
+                if(_bodies.contains(other)) _sleep.wake(_bodies, _bodies.index_of(other));
+            }
+
+            _joints.remove_attached(handle);
+            _broadphase->erase(handle);
+            _contact_cache.erase(handle);
+            _bodies.remove(handle);
+            // The last body was moved into the index, hence the transform at the index has changed.
+            _transform_changed[index] = _step_count;
+            _transform_changed.pop_back();
+            _pairs_dirty = true;
+        }
+
+        /** @brief Returns the storage of the bodies. Any changes made to it are seen by the next step. */
+        body_store& bodies() noexcept(true) { return _bodies; }
+        const body_store& bodies() const noexcept(true) { return _bodies; }
+
+        /** @brief Joins two bodies (or a body and the world) at a point. */
+        joint_handle create_ball_joint(const ball_joint_desc& desc)
+        {
+            size_t a = _bodies.index_of(desc.a);
+            ball_joint joint { desc.a, desc.b, glm::vec3(0.0f), desc.anchor };
+            joint.local_anchor_a = glm::conjugate(_bodies.orientation.get(a)) * (desc.anchor - _bodies.position.get(a));
+            if(_bodies.contains(desc.b))
+            {
+                size_t b = _bodies.index_of(desc.b);
+                joint.local_anchor_b = glm::conjugate(_bodies.orientation.get(b)) * (desc.anchor - _bodies.position.get(b));
+            }
+            else joint.b = invalid_body_handle;
+
+            _sleep.wake(_bodies, a);
+            if(_bodies.contains(joint.b)) _sleep.wake(_bodies, _bodies.index_of(joint.b));
+            return _joints.add(joint);
+        }
+        /** @brief Destroys the joint and wakes up the bodies that it joined. */
+        void destroy_joint(joint_handle handle)
+        {
+            const ball_joint& joint = _joints.joints[_joints.index_of(handle)];
+            if(_bodies.contains(joint.a)) _sleep.wake(_bodies, _bodies.index_of(joint.a));
+            if(_bodies.contains(joint.b)) _sleep.wake(_bodies, _bodies.index_of(joint.b));
+            _joints.remove(handle);
+        }
+        size_t joint_count() const noexcept(true) { return _joints.size(); }
+
+        /**
+         * @brief Writes the whole state of the world (the bodies, the joints, the contacts and the sleeping islands)
+         * into a snapshot. (see: snapshot.hpp) The settings are not a part of it. Once the blob has grown to the size
+         * of a snapshot, this doesn't allocate.
+         * @param bytes Where to write the snapshot. It is cleared first.
+        */
+        void save_snapshot(std::vector<uint8_t>& bytes) const
+        {
+            GLFW_PROFILE_SCOPE("world::save_snapshot");
+            snapshot_writer out(bytes);
+            out.value(snapshot_magic);
+            out.value(snapshot_version);
+            out.value(_step_count);
+            _bodies.save(out);
+            _joints.save(out);
+            _contact_cache.save(out);
+            _sleep.save(out);
+        }
+
+        /**
+         * @brief Restores the world to a snapshot of itself (or of a world with the same settings). The handles are
+         * restored as well, hence the handles from before the snapshot refer to the same bodies again. The broadphase
+         * is rebuilt from scratch on the next step. Every output of write_dirty_instance_transforms must be written
+         * in full afterwards (i.e. its written_at set to 0), once the bodies have moved back. The hulls of the convex
+         * bodies are looked up in hulls() by their ids.
+         * @param data The snapshot. (see: save_snapshot)
+         * @param size The size(in bytes) of the snapshot.
+         * @returns false if the snapshot is damaged, of another version or uses a hull that isn't registered, the world
+         * is left untouched then.
+        */
+        bool load_snapshot(const uint8_t* data, size_t size)
+        {
+            GLFW_PROFILE_SCOPE("world::load_snapshot");
+            snapshot_reader in(data, size);
+            uint32_t magic = 0, version = 0;
+            uint64_t step_count = 0;
+            if(!in.value(magic) || magic != snapshot_magic || !in.value(version) || version != snapshot_version || !in.value(step_count)) return false;
+
+            // Read into new stores first, so that a damaged snapshot doesn't leave the world half restored.
+            body_store bodies;
+            joint_store joints;
+            contact_cache contacts;
+            sleep_tracker sleep(_sleep.settings());
+            if(!bodies.load(in, _hulls) || !joints.load(in, bodies) || !contacts.load(in) || !sleep.load(in, bodies) || !in.at_end()) return false;
+
+            _bodies = std::move(bodies);
+            _joints = std::move(joints);
+            _contact_cache = std::move(contacts);
+            _sleep = std::move(sleep);
+            _step_count = step_count;
+            _transform_changed.assign(_bodies.size(), _step_count);
+
+            _broadphase = create_broadphase(_settings.broadphase);
+            for(body_handle handle : _bodies.handles) _broadphase->insert(handle);
+            _pairs.clear();
+            _manifolds.clear();
+            _pairs_dirty = true;
+            // The stores that were read only have space for what they hold, the next step reserves again.
+            _reserved_bodies = _reserved_pairs = _reserved_joints = 0;
+            return true;
+        }
+        bool load_snapshot(const std::vector<uint8_t>& bytes) { return load_snapshot(bytes.data(), bytes.size()); }
+
+        /** @brief Returns the sleep tracker. (see: sleep_tracker::sleeping_bodies) */
+        const sleep_tracker& sleep() const noexcept(true) { return _sleep; }
+        /** @brief Changes when the bodies are put to sleep. Disabling sleeping wakes up every sleeping body. */
+        void set_sleep_settings(const sleep_settings& settings)
+        {
+            _sleep.set_settings(settings);
+            if(!settings.enabled) _sleep.wake_all(_bodies);
+        }
+        bool is_sleeping(body_handle handle) const { return _bodies.is_sleeping(_bodies.index_of(handle)); }
+        /** @brief Wakes up the body and every body of its island. */
+        void wake_body(body_handle handle) { touch(_bodies.index_of(handle), false); }
+
+        /** @brief Returns the solver. (see: constraint_solver::stats) */
+        const constraint_solver& solver() const noexcept(true) { return _solver; }
+        /** @brief Returns the contacts of the last step, one per pair. (see: pairs) */
+        const std::vector<contact_manifold>& manifolds() const noexcept(true) { return _manifolds; }
+
+        /** @brief Returns the broadphase. (see: broadphase::stats) */
+        const physics::broadphase& broadphase() const noexcept(true) { return *_broadphase; }
+        /** @brief Returns the pairs of bodies whose bounding boxes overlapped at the end of the last step. */
+        const std::vector<body_pair>& pairs() const noexcept(true) { return _pairs; }
+        /** @brief Returns the bounding boxes of the bodies at the end of the last step, in the order of their indices. */
+        const std::vector<aabb>& bounds() const noexcept(true) { return _bounds; }
+
+        /** @brief Returns the number of bodies. */
+        size_t body_count() const noexcept(true) { return _bodies.size(); }
+        /** @brief Returns the number of steps that have been run. */
+        uint64_t step_count() const noexcept(true) { return _step_count; }
+        /**
+         * @brief Returns the number of allocations that the last step made. (see: glfw::memory::allocation_count) It 
+         * drops to 0 after the first few steps; from then on a step only allocates when there are more bodies, pairs or
+         * joints than ever before. (see: world_settings::expected_pairs, bench/simulation_bench.cpp)
+        */
+        uint64_t step_allocations() const noexcept(true) { return _step_allocations; }
+        /** @brief Returns the scratch arenas of the steps. */
+        const glfw::memory::thread_arenas& arenas() const noexcept(true) { return _arenas; }
+
+        void set_gravity(const glm::vec3& gravity) noexcept(true) { _settings.gravity = gravity; }
+        const glm::vec3& get_gravity() const noexcept(true) { return _settings.gravity; }
+
+        glm::vec3 get_position(body_handle handle) const { return _bodies.position.get(_bodies.index_of(handle)); }
+        glm::quat get_orientation(body_handle handle) const { return _bodies.orientation.get(_bodies.index_of(handle)); }
+        glm::vec3 get_linear_velocity(body_handle handle) const { return _bodies.linear_velocity.get(_bodies.index_of(handle)); }
+        glm::vec3 get_angular_velocity(body_handle handle) const { return _bodies.angular_velocity.get(_bodies.index_of(handle)); }
+
+        void set_position(body_handle handle, const glm::vec3& position)
+        {
+            size_t index = _bodies.index_of(handle);
+            _bodies.position.set(index, position);
+            _bodies.previous_position.set(index, position);
+            touch(index, true);
+            _pairs_dirty = true;
+        }
+        void set_orientation(body_handle handle, const glm::quat& orientation)
+        {
+            size_t index = _bodies.index_of(handle);
+            _bodies.orientation.set(index, glm::normalize(orientation));
+            _bodies.previous_orientation.set(index, glm::normalize(orientation));
+            touch(index, true);
+            _pairs_dirty = true;
+        }
+        void set_linear_velocity(body_handle handle, const glm::vec3& velocity)
+        {
+            size_t index = _bodies.index_of(handle);
+            if(_bodies.is_static(index)) return;
+            touch(index, false);
+            _bodies.linear_velocity.set(index, velocity);
+        }
+        void set_angular_velocity(body_handle handle, const glm::vec3& velocity)
+        {
+            size_t index = _bodies.index_of(handle);
+            if(_bodies.is_static(index)) return;
+            touch(index, false);
+            _bodies.angular_velocity.set(index, velocity);
+        }
+
+        /** @brief Applies a force (in newtons) at the center of mass during the next step. */
+        void apply_force(body_handle handle, const glm::vec3& force)
+        {
+            size_t index = _bodies.index_of(handle);
+            touch(index, false);
+            _bodies.force.set(index, _bodies.force.get(index) + force);
+        }
+        /** @brief Applies a torque during the next step. */
+        void apply_torque(body_handle handle, const glm::vec3& torque)
+        {
+            size_t index = _bodies.index_of(handle);
+            touch(index, false);
+            _bodies.torque.set(index, _bodies.torque.get(index) + torque);
+        }
+        /** @brief Changes the velocity of the body immediately. */
+        void apply_impulse(body_handle handle, const glm::vec3& impulse)
+        {
+            size_t index = _bodies.index_of(handle);
+            touch(index, false);
+            _bodies.linear_velocity.set(index, _bodies.linear_velocity.get(index) + impulse * _bodies.inverse_mass[index]);
+        }
+
+        // ============================= QUERIES =============================
+        // With the DYNAMIC_TREE broadphase the queries only visit the bodies whose boxes are near, with any other
+        // broadphase they test every body. The boxes are those at the end of the last step (see: bounds), hence a body
+        // that was created or teleported after the last step isn't found (or is found where it was) until the next step.
+
+        /**
+         * @brief Finds the closest body that the ray hits.
+         * @param origin Where the ray starts.
+         * @param direction The direction of the ray, it is normalized.
+         * @param max_distance How far the ray goes.
+         * @param hit Set to the closest hit.
+         * @returns Whether or not the ray hit anything.
+        */
+        bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, ray_hit& hit) const
+        {
+            glm::vec3 d = glm::normalize(direction);
+            bool found = false;
+
+            if(const dynamic_tree_broadphase* t = tree())
+            {
+                t->raycast(origin, d, max_distance, [&](body_handle handle, float distance)
+                {
+                    if(!_bodies.contains(handle) || !raycast_body(_bodies.index_of(handle), origin, d, distance, hit)) return distance;
+                    found = true;
+                    return hit.distance;
+                });
+                return found;
+            }
+
+            for(size_t i = 0; i < _bodies.size(); i++)
+            {
+                if(raycast_body(i, origin, d, max_distance, hit))
+                {
+                    found = true;
+                    max_distance = hit.distance;
+                }
+            }
+            return found;
+        }
+
+        /**
+         * @brief Calls the function for every body whose bounding box overlaps the box.
+         * @param fn Called as bool(body_handle body), returning false stops the query.
+        */
+        template <typename Fn>
+        void query_aabb(const aabb& box, Fn&& fn) const
+        {
+            if(const dynamic_tree_broadphase* t = tree())
+            {
+                t->query(box, [&](body_handle handle)
+                {
+                    if(!_bodies.contains(handle)) return true;
+                    size_t index = _bodies.index_of(handle);
+                    return index >= _bounds.size() || !_bounds[index].overlaps(box) ? true : fn(handle);
+                });
+                return;
+            }
+
+            for(size_t i = 0; i < _bounds.size() && i < _bodies.size(); i++)
+            {
+                if(_bounds[i].overlaps(box) && !fn(_bodies.handles[i])) return;
+            }
+        }
+
+        /**
+         * @brief Finds the body whose surface is the nearest to the point.
+         * @param point The point.
+         * @param max_distance Bodies that are further away than this are ignored.
+         * @returns The nearest body, or invalid_body_handle if there is none.
+        */
+        body_handle nearest_body(const glm::vec3& point, float max_distance = std::numeric_limits<float>::max()) const
+        {
+            if(const dynamic_tree_broadphase* t = tree())
+            {
+                return t->nearest(point, max_distance, [&](body_handle handle)
+                {
+                    return _bodies.contains(handle) ? distance_to_body(_bodies.index_of(handle), point) : std::numeric_limits<float>::max();
+                });
+            }
+
+            body_handle best = invalid_body_handle;
+            for(size_t i = 0; i < _bodies.size(); i++)
+            {
+                float distance = distance_to_body(i, point);
+                if(distance < max_distance)
+                {
+                    max_distance = distance;
+                    best = _bodies.handles[i];
+                }
+            }
+            return best;
+        }
+
+        /**
+         * @brief Advances the simulation.
+         * @param dt The size of the step in seconds. It should be the same for every step. (see: fixed_step_loop)
+        */
+        void step(float dt)
+        {
+            GLFW_PROFILE_SCOPE("world::step");
+            uint64_t allocations = glfw::memory::allocation_count();
+
+            // The pairs of the last step are already up to date, unless bodies were created, destroyed or teleported since.
+            if(_pairs_dirty) update_broadphase();
+            // Before the arenas are reset, so that the scratch memory that is reserved takes effect in this step.
+            reserve_step(_bodies.handles.capacity(), _pairs.capacity(), _joints.joints.capacity());
+            _arenas.reset();
+
+            size_t count = _bodies.padded_size();
+            {
+                GLFW_PROFILE_SCOPE("world::integrate_velocities");
+                kernels::integrate_velocities(_bodies, _settings.gravity, dt, 0, count);
+            }
+            {
+                GLFW_PROFILE_SCOPE("world::narrowphase");
+                _manifolds.resize(_pairs.size());
+
+                // The sphere-box pairs are batched (see: narrowphase::pair_batch), the rest are collided one at a time. A
+                // sphere-sphere pair is left out, its kernel returns early when the spheres are apart and that is cheaper
+                // than moving it into the lanes and back.
+                auto collide = [this](size_t begin, size_t end)
+                {
+                    // The bodies and the last manifold of every batched pair, in the order that they were pushed.
+                    struct batched_pair
+                    {
+                        size_t a, b;
+                        const contact_manifold* previous;
+                    };
+                    narrowphase::pair_batch batch;
+                    batched_pair batched[narrowphase::pair_batch::capacity];
+                    auto flush = [&]
+                    {
+                        batch.run();
+                        for(size_t k = 0; k < batch.size(); k++)
+                        {
+                            const batched_pair& p = batched[k];
+                            contact_manifold& manifold = _manifolds[batch.pair(k)];
+                            if(!batch.result(k, manifold)) continue;
+                            narrowphase::persist(
+                                _bodies.shapes[p.a], narrowphase::transform { _bodies.position.get(p.a), _bodies.orientation.get(p.a) },
+                                _bodies.shapes[p.b], narrowphase::transform { _bodies.position.get(p.b), _bodies.orientation.get(p.b) },
+                                p.previous, manifold, true);
+                        }
+                        batch.clear();
+                    };
+
+                    for(size_t i = begin; i < end; i++)
+                    {
+                        contact_manifold& manifold = _manifolds[i];
+                        size_t a = _bodies.index_of(_pairs[i].a), b = _bodies.index_of(_pairs[i].b);
+                        manifold.a = _pairs[i].a;
+                        manifold.b = _pairs[i].b;
+                        manifold.count = 0;
+                        const contact_manifold* previous = _contact_cache.find(manifold.a, manifold.b);
+
+                        // Nothing can change between two bodies that are both sleeping or static, the contact is kept as it was.
+                        if(!_bodies.is_active(a) && !_bodies.is_active(b))
+                        {
+                            if(previous) manifold = *previous;
+                            continue;
+                        }
+                        narrowphase::transform ta { _bodies.position.get(a), _bodies.orientation.get(a) };
+                        narrowphase::transform tb { _bodies.position.get(b), _bodies.orientation.get(b) };
+                        const shape& sa = _bodies.shapes[a];
+                        const shape& sb = _bodies.shapes[b];
+                        if(sa.type == sb.type || !batch.push(static_cast<uint32_t>(i), sa, ta, sb, tb))
+                        {
+                            narrowphase::collide_persistent(sa, ta, sb, tb, previous, manifold);
+                            continue;
+                        }
+                        batched[batch.size() - 1] = batched_pair { a, b, previous };
+                        if(batch.full()) flush();
+                    }
+                    flush();
+                };
+                if(_settings.solver.multithreaded) _pool->parallel_for(0, _pairs.size(), 256, collide);
+                else collide(0, _pairs.size());
+            }
+            wake_touched();
+            {
+                GLFW_PROFILE_SCOPE("world::solve");
+                _solver.prepare(_bodies, _manifolds, _joints, dt, _arenas.local());
+                _solver.solve(_pool);
+                _solver.store(_bodies);
+                _solver.store_impulses(_manifolds, _joints);
+                _contact_cache.update(_manifolds);
+            }
+            {
+                GLFW_PROFILE_SCOPE("world::sleep");
+                size_t sleeping = _sleep.sleeping_bodies();
+                _sleep.update(_bodies, _solver.islands(), dt);
+                // The bodies that fell asleep stopped where they were at the end of this step.
+                if(_sleep.sleeping_bodies() != sleeping)
+                {
+                    for(size_t i = 0; i < _bodies.size(); i++) if(_bodies.is_sleeping(i)) _transform_changed[i] = std::max(_transform_changed[i], _step_count);
+                }
+            }
+            GLFW_PROFILE_COUNTER("world::sleeping_bodies", static_cast<double>(_sleep.sleeping_bodies()));
+            GLFW_PROFILE_COUNTER("solver::contacts", _solver.stats().contacts);
+            GLFW_PROFILE_COUNTER("solver::islands", _solver.stats().islands);
+            GLFW_PROFILE_COUNTER("solver::colors", _solver.stats().colors);
+            {
+                GLFW_PROFILE_SCOPE("world::integrate_positions");
+                kernels::integrate_positions(_bodies, dt, 0, count);
+            }
+            update_broadphase();
+            _step_count++;
+
+            _step_allocations = glfw::memory::allocation_count() - allocations;
+            GLFW_PROFILE_COUNTER("memory::step_allocations", static_cast<double>(_step_allocations));
+            GLFW_PROFILE_COUNTER("memory::arena_bytes", static_cast<double>(_arenas.used()));
+        }
+
+        /**
+         * @brief Writes the transform of every body, in the order of their indices. The output can be written directly
+         * into a mapped buffer. ex; world.write_instance_transforms(buffer.map_region<instance_transform>(), alpha)
+         * @param transforms Where to write the transforms. Must have space for body_count() transforms.
+         * @param alpha? The interpolation factor between the previous and the current step. (see: fixed_step_loop::alpha)
+         * @returns The number of transforms that were written.
+        */
+        size_t write_instance_transforms(instance_transform* transforms, float alpha = 1.0f) const
+        {
+            GLFW_PROFILE_SCOPE("world::write_instance_transforms");
+            for(size_t i = 0; i < _bodies.size(); i++) write_instance_transform(i, alpha, transforms[i]);
+            return _bodies.size();
+        }
+
+        /**
+         * @brief Writes the transforms of the bodies at the indices, one after the other. ex; the visible bodies. (see: cull)
+         * @param indices The indices of the bodies.
+         * @param count The number of indices.
+         * @param transforms Where to write the transforms. Must have space for @p count transforms.
+         * @param alpha? The interpolation factor between the previous and the current step. (see: fixed_step_loop::alpha)
+         * @returns The number of transforms that were written.
+        */
+        size_t write_instance_transforms(const uint32_t* indices, size_t count, instance_transform* transforms, float alpha = 1.0f) const
+        {
+            GLFW_PROFILE_SCOPE("world::write_instance_transforms");
+            for(size_t i = 0; i < count; i++) write_instance_transform(indices[i], alpha, transforms[i]);
+            return count;
+        }
+
+        /**
+         * @brief Finds the bodies that are (at least partly) inside the frustum. A body that is drawn between two steps
+         * (see: fixed_step_loop::alpha) is tested with the box that covers both of them. With the DYNAMIC_TREE broadphase
+         * whole subtrees are accepted or rejected at once, otherwise every box is tested.
+         * @param volume The view frustum. (see: frustum::from_matrix)
+         * @param visible Where to write the indices of the bodies, in no particular order. Must have space for body_count() indices.
+         * @returns The number of indices that were written.
+        */
+        size_t cull(const frustum& volume, uint32_t* visible) const
+        {
+            GLFW_PROFILE_SCOPE("world::cull");
+            size_t count = 0;
+
+            if(const dynamic_tree_broadphase* t = tree(); t && !_pairs_dirty)
+            {
+                // The fattened boxes of the tree cover both ends of the last step. (see: dynamic_tree_broadphase::find_pairs)
+                t->cull(volume, [&](body_handle handle)
+                {
+                    if(_bodies.contains(handle)) visible[count++] = static_cast<uint32_t>(_bodies.index_of(handle));
+                });
+            }
+            else
+            {
+                // The bodies were changed (created, moved, etc.) since the last step, the boxes of the step are stale.
+                // They are computed one at a time then, a cull doesn't allocate and any number of them can run at once.
+                for(size_t i = 0; i < _bodies.size(); i++)
+                {
+                    glm::vec3 back = _bodies.previous_position.get(i) - _bodies.position.get(i);
+                    aabb box = _pairs_dirty ? compute_bounds(_bodies, i) : _bounds[i];
+                    box.min += glm::min(back, glm::vec3(0.0f));
+                    box.max += glm::max(back, glm::vec3(0.0f));
+                    if(volume.intersects(box)) visible[count++] = static_cast<uint32_t>(i);
+                }
+            }
+
+            GLFW_PROFILE_COUNTER("world::visible_bodies", static_cast<double>(count));
+            return count;
+        }
+
+        /**
+         * @brief Like write_instance_transforms, but only writes the transforms that may have changed since the
+         * output was last written. i.e. Those of the awake bodies and the bodies that were changed, created or moved
+         * to another index. The sleeping and static bodies keep what was written before, which saves writing most of
+         * the buffer when most of the bodies are at rest.
+         *
+         * Every output must have its own @p written_at, for a streaming_buffer_object that is one per region.
+         * ex; world.write_dirty_instance_transforms(buffer.map_region<instance_transform>(), alpha, written_at[buffer.region_index()])
+         * @param transforms Where to write the transforms. Must have space for body_count() transforms.
+         * @param alpha The interpolation factor between the previous and the current step. (see: fixed_step_loop::alpha)
+         * @param written_at The step_count at which the output was last written, 0 if it never was. It is set to the
+         * current step_count.
+         * @returns The number of transforms that were written.
+        */
+        size_t write_dirty_instance_transforms(instance_transform* transforms, float alpha, uint64_t& written_at) const
+        {
+            GLFW_PROFILE_SCOPE("world::write_dirty_instance_transforms");
+
+            size_t written = 0;
+            for(size_t i = 0; i < _bodies.size(); i++)
+            {
+                if(!_bodies.is_active(i) && _transform_changed[i] < written_at) continue;
+                write_instance_transform(i, alpha, transforms[i]);
+                written++;
+            }
+            written_at = _step_count;
+
+            GLFW_PROFILE_COUNTER("world::written_transforms", static_cast<double>(written));
+            return written;
+        }
+    };
+
+    _PHYSICS_END_
+
+#endif
\ No newline at end of file
@@ -0,0 +1,409 @@
+/**
+ * The offline converter for the mesh asset format. (see: glfw/mesh_asset.hpp) It reads a Wavefront OBJ file and
+ * writes a mesh file that the runtime maps and uses without parsing anything.
+ *
+ * Every object ("o") or group ("g") of the OBJ file becomes a mesh of the file. For every mesh the converter;
+ *  - removes the duplicate vertices and interleaves them as; position (3 floats), normal (GL_INT_2_10_10_10_REV)
+ *    and texture coordinates (2 floats). The normals that are missing are computed from the faces.
+ *  - computes its convex hull; the vertices that are the furthest along one of hull_directions directions. The
+ *    hull of those is slightly smaller than the hull of every vertex, but it never has more than hull_directions
+ *    points, which bounds the cost of a support function. (see: physics/gjk.hpp)
+ *  - builds a bounding volume hierarchy over its triangles (median splits along the longest axis) and sorts its
+ *    triangles so that every leaf refers to a range of them.
+ *
+ * Polygons are split into fans of triangles. Materials and everything else are ignored.
+ *
+ * Usage;
+ *  mesh_converter input.obj output.mesh
+ *
+ * It is built separately from the programs that use the meshes, it only needs glm. (see: tools/compilation-script)
+*/
+
+#include "../glfw/mesh_format.hpp"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+using namespace glfw::assets;
+
+/** @brief The number of directions that the hull of a mesh is sampled in. */
+constexpr size_t hull_directions = 128;
+/** @brief The maximum number of triangles in a leaf of a hierarchy. */
+constexpr uint32_t leaf_triangles = 4;
+
+/** @brief A vertex in the layout of the vertex buffer. */
+struct vertex
+{
+    float position[3];
+    uint32_t normal;
+    float uv[2];
+};
+static_assert(sizeof(vertex) == 24, "The vertices are written as they are.");
+
+/** @brief The position, texture coordinates and normal that a corner of a face refers to. (-1 if it has none) */
+struct corner_key
+{
+    int32_t position, uv, normal;
+
+    bool operator==(const corner_key& other) const noexcept(true)
+    {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct corner_hash
+{
+    size_t operator()(const corner_key& k) const noexcept(true)
+    {
+        uint64_t h = uint64_t(uint32_t(k.position)) * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t(uint32_t(k.uv)) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2));
+        h ^= (uint64_t(uint32_t(k.normal)) + 0x8CB92BA72F3D8DD7ull + (h << 6) + (h >> 2));
+        return static_cast<size_t>(h);
+    }
+};
+
+/** @brief A mesh while it is being converted. */
+struct mesh
+{
+    std::string name;
+    std::vector<vertex> vertices;
+    std::vector<glm::vec3> normals;
+    /** @brief Whether or not the normal of the vertex came from the file. */
+    std::vector<bool> has_normal;
+    std::vector<uint32_t> indices;
+    std::unordered_map<corner_key, uint32_t, corner_hash> unique;
+};
+
+/** @brief Packs a unit vector into a signed normalized 10:10:10:2 integer. */
+uint32_t pack_normal(const glm::vec3& n)
+{
+    auto pack = [](float value) { return static_cast<uint32_t>(static_cast<int32_t>(std::round(glm::clamp(value, -1.0f, 1.0f) * 511.0f)) & 0x3FF); };
+    return pack(n.x) | (pack(n.y) << 10) | (pack(n.z) << 20);
+}
+
+/** @brief Resolves an OBJ index. They start at 1, a negative index counts back from the last element. */
+int32_t resolve(int32_t index, size_t count) { return index < 0 ? static_cast<int32_t>(count) + index : index - 1; }
+
+bool read_obj(const char* path, std::vector<mesh>& meshes)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        fprintf(stderr, "Error loading obj at \"%s\"\n", path);
+        return false;
+    }
+
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec2> uvs;
+    meshes.emplace_back();
+
+    std::string line;
+    size_t line_number = 0;
+    while(std::getline(file, line))
+    {
+        line_number++;
+        std::istringstream in(line);
+        std::string kind;
+        in >> kind;
+
+        if(kind == "v") { glm::vec3 p; in >> p.x >> p.y >> p.z; positions.push_back(p); }
+        else if(kind == "vn") { glm::vec3 n; in >> n.x >> n.y >> n.z; normals.push_back(n); }
+        else if(kind == "vt") { glm::vec2 t; in >> t.x >> t.y; uvs.push_back(t); }
+        else if(kind == "o" || kind == "g")
+        {
+            if(!meshes.back().indices.empty()) meshes.emplace_back();
+            in >> meshes.back().name;
+        }
+        else if(kind == "f")
+        {
+            mesh& m = meshes.back();
+            std::vector<uint32_t> polygon;
+            std::string corner;
+            while(in >> corner)
+            {
+                // v, v/t, v//n or v/t/n
+                int32_t v = 0, t = 0, n = 0;
+                const char* c = corner.c_str();
+                v = std::atoi(c);
+                const char* slash = std::strchr(c, '/');
+                if(slash)
+                {
+                    if(slash[1] != '/') t = std::atoi(slash + 1);
+                    const char* second = std::strchr(slash + 1, '/');
+                    if(second) n = std::atoi(second + 1);
+                }
+
+                int32_t vi = resolve(v, positions.size());
+                int32_t ti = t ? resolve(t, uvs.size()) : -1;
+                int32_t ni = n ? resolve(n, normals.size()) : -1;
+                if(vi < 0 || vi >= int32_t(positions.size()) || ti >= int32_t(uvs.size()) || ni >= int32_t(normals.size()))
+                {
+                    fprintf(stderr, "%s:%zu: index out of range\n", path, line_number);
+                    return false;
+                }
+
+                corner_key key { vi, ti, ni };
+                auto found = m.unique.find(key);
+                if(found == m.unique.end())
+                {
+                    vertex out{};
+                    std::memcpy(out.position, &positions[vi], sizeof(out.position));
+                    if(ti >= 0) { out.uv[0] = uvs[ti].x; out.uv[1] = uvs[ti].y; }
+
+                    found = m.unique.emplace(key, static_cast<uint32_t>(m.vertices.size())).first;
+                    m.vertices.push_back(out);
+                    m.normals.push_back(ni >= 0 ? normals[ni] : glm::vec3(0.0f));
+                    m.has_normal.push_back(ni >= 0);
+                }
+                polygon.push_back(found->second);
+            }
+
+            for(size_t k = 2; k < polygon.size(); k++)
+            {
+                m.indices.push_back(polygon[0]);
+                m.indices.push_back(polygon[k-1]);
+                m.indices.push_back(polygon[k]);
+            }
+        }
+    }
+
+    meshes.erase(std::remove_if(meshes.begin(), meshes.end(), [](const mesh& m) { return m.indices.empty(); }), meshes.end());
+    return true;
+}
+
+/** @brief Computes the missing normals from the (area weighted) normals of the faces and packs every normal. */
+void finish_normals(mesh& m)
+{
+    for(size_t i = 0; i < m.indices.size(); i += 3)
+    {
+        uint32_t a = m.indices[i], b = m.indices[i+1], c = m.indices[i+2];
+        glm::vec3 pa, pb, pc;
+        std::memcpy(&pa, m.vertices[a].position, sizeof(pa));
+        std::memcpy(&pb, m.vertices[b].position, sizeof(pb));
+        std::memcpy(&pc, m.vertices[c].position, sizeof(pc));
+        glm::vec3 face = glm::cross(pb - pa, pc - pa);
+        for(uint32_t v : { a, b, c }) if(!m.has_normal[v]) m.normals[v] += face;
+    }
+
+    for(size_t i = 0; i < m.vertices.size(); i++)
+    {
+        float length = glm::length(m.normals[i]);
+        m.vertices[i].normal = pack_normal(length > 0.0f ? m.normals[i] / length : glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+}
+
+/** @brief Appends the (approximate) hull of the mesh. (see: the top of this file) */
+void build_hull(const mesh& m, std::vector<glm::vec3>& points)
+{
+    std::vector<uint32_t> chosen;
+    for(size_t k = 0; k < hull_directions; k++)
+    {
+        // Spread evenly over the sphere. (A Fibonacci lattice)
+        float y = 1.0f - 2.0f * (k + 0.5f) / hull_directions;
+        float r = std::sqrt(1.0f - y * y), angle = 2.39996323f * k;
+        glm::vec3 d(r * std::cos(angle), y, r * std::sin(angle));
+
+        uint32_t best = 0;
+        float best_distance = -std::numeric_limits<float>::max();
+        for(uint32_t i = 0; i < m.vertices.size(); i++)
+        {
+            const float* p = m.vertices[i].position;
+            float distance = p[0] * d.x + p[1] * d.y + p[2] * d.z;
+            if(distance > best_distance) { best_distance = distance; best = i; }
+        }
+        chosen.push_back(best);
+    }
+
+    std::sort(chosen.begin(), chosen.end());
+    chosen.erase(std::unique(chosen.begin(), chosen.end()), chosen.end());
+
+    size_t first = points.size();
+    for(uint32_t i : chosen)
+    {
+        glm::vec3 p;
+        std::memcpy(&p, m.vertices[i].position, sizeof(p));
+        // Vertices that only differ by their normal or texture coordinates share a position.
+        if(std::find(points.begin() + first, points.end(), p) == points.end()) points.push_back(p);
+    }
+}
+
+/** @brief Builds the hierarchy of the mesh over the triangles [begin, end) of order. Returns the index of the node. */
+uint32_t build_node(const mesh& m, const std::vector<glm::vec3>& centers, std::vector<uint32_t>& order,
+    uint32_t begin, uint32_t end, std::vector<bvh_node>& nodes, size_t first_node)
+{
+    uint32_t index = static_cast<uint32_t>(nodes.size() - first_node);
+    nodes.emplace_back();
+
+    glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+    glm::vec3 center_min = min, center_max = max;
+    for(uint32_t t = begin; t < end; t++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            glm::vec3 p;
+            std::memcpy(&p, m.vertices[m.indices[3 * order[t] + k]].position, sizeof(p));
+            min = glm::min(min, p);
+            max = glm::max(max, p);
+        }
+        center_min = glm::min(center_min, centers[order[t]]);
+        center_max = glm::max(center_max, centers[order[t]]);
+    }
+
+    bvh_node node { min, begin, max, end - begin };
+    glm::vec3 extent = center_max - center_min;
+    // A leaf, or a group of triangles whose centers are all at the same point which can't be split.
+    if(end - begin <= leaf_triangles || std::max(extent.x, std::max(extent.y, extent.z)) <= 0.0f)
+    {
+        nodes[first_node + index] = node;
+        return index;
+    }
+
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+        [&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; });
+
+    build_node(m, centers, order, begin, middle, nodes, first_node);
+    node.first = build_node(m, centers, order, middle, end, nodes, first_node);
+    node.count = 0;
+    nodes[first_node + index] = node;
+    return index;
+}
+
+/** @brief Builds the hierarchy of the mesh and sorts its triangles in the order of the leaves. */
+void build_bvh(mesh& m, std::vector<bvh_node>& nodes)
+{
+    uint32_t triangle_count = static_cast<uint32_t>(m.indices.size() / 3);
+    std::vector<glm::vec3> centers(triangle_count);
+    std::vector<uint32_t> order(triangle_count);
+    for(uint32_t t = 0; t < triangle_count; t++)
+    {
+        glm::vec3 center(0.0f);
+        for(int k = 0; k < 3; k++)
+        {
+            glm::vec3 p;
+            std::memcpy(&p, m.vertices[m.indices[3 * t + k]].position, sizeof(p));
+            center += p;
+        }
+        centers[t] = center / 3.0f;
+        order[t] = t;
+    }
+
+    build_node(m, centers, order, 0, triangle_count, nodes, nodes.size());
+
+    std::vector<uint32_t> sorted(m.indices.size());
+    for(uint32_t t = 0; t < triangle_count; t++)
+        for(int k = 0; k < 3; k++) sorted[3 * t + k] = m.indices[3 * order[t] + k];
+    m.indices.swap(sorted);
+}
+
+/** @brief Appends the bytes of the section to the file, at the next multiple of section_alignment. */
+file_section append(std::vector<unsigned char>& file, const void* data, size_t size)
+{
+    file.resize((file.size() + section_alignment - 1) / section_alignment * section_alignment, 0);
+    file_section section { file.size(), size };
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    file.insert(file.end(), bytes, bytes + size);
+    return section;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc != 3)
+    {
+        fprintf(stderr, "usage: %s input.obj output.mesh\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<mesh> meshes;
+    if(!read_obj(argv[1], meshes)) return 1;
+
+    std::vector<vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<mesh_record> records;
+    std::vector<glm::vec3> hull_points;
+    std::vector<bvh_node> nodes;
+    bool short_indices = true;
+
+    for(mesh& m : meshes)
+    {
+        finish_normals(m);
+
+        mesh_record record{};
+        record.hull_first = static_cast<uint32_t>(hull_points.size());
+        build_hull(m, hull_points);
+        record.hull_count = static_cast<uint32_t>(hull_points.size()) - record.hull_first;
+
+        record.bvh_first = static_cast<uint32_t>(nodes.size());
+        build_bvh(m, nodes);
+        record.bvh_count = static_cast<uint32_t>(nodes.size()) - record.bvh_first;
+        record.bounds_min = nodes[record.bvh_first].min;
+        record.bounds_max = nodes[record.bvh_first].max;
+
+        record.first_index = static_cast<uint32_t>(indices.size());
+        record.index_count = static_cast<uint32_t>(m.indices.size());
+        record.base_vertex = static_cast<int32_t>(vertices.size());
+        record.vertex_count = static_cast<uint32_t>(m.vertices.size());
+        short_indices = short_indices && m.vertices.size() <= 0x10000;
+
+        vertices.insert(vertices.end(), m.vertices.begin(), m.vertices.end());
+        indices.insert(indices.end(), m.indices.begin(), m.indices.end());
+        records.push_back(record);
+
+        printf("%s: %u vertices, %u triangles, %u hull points, %u nodes\n", m.name.empty() ? "(unnamed)" : m.name.c_str(),
+            record.vertex_count, record.index_count / 3, record.hull_count, record.bvh_count);
+    }
+
+    // ============================= HEADER =============================
+    file_header header{};
+    header.magic = mesh_file_magic;
+    header.version = mesh_file_version;
+    header.vertex_stride = sizeof(vertex);
+    header.attribute_count = 3;
+    header.attributes[0] = vertex_attribute { 0, 3, type_float, 0, offsetof(vertex, position) };
+    header.attributes[1] = vertex_attribute { 1, 4, type_int_2_10_10_10_rev, 1, offsetof(vertex, normal) };
+    header.attributes[2] = vertex_attribute { 2, 2, type_float, 0, offsetof(vertex, uv) };
+    header.index_type = short_indices ? type_unsigned_short : type_unsigned_int;
+    header.mesh_count = static_cast<uint32_t>(records.size());
+
+    // ============================= SECTIONS =============================
+    std::vector<unsigned char> file(sizeof(file_header));
+    header.vertices = append(file, vertices.data(), vertices.size() * sizeof(vertex));
+    if(short_indices)
+    {
+        std::vector<uint16_t> narrow(indices.begin(), indices.end());
+        header.indices = append(file, narrow.data(), narrow.size() * sizeof(uint16_t));
+    }
+    else header.indices = append(file, indices.data(), indices.size() * sizeof(uint32_t));
+    header.meshes = append(file, records.data(), records.size() * sizeof(mesh_record));
+    header.hull_points = append(file, hull_points.data(), hull_points.size() * sizeof(glm::vec3));
+    header.bvh_nodes = append(file, nodes.data(), nodes.size() * sizeof(bvh_node));
+    header.file_size = file.size();
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    std::ofstream out(argv[2], std::ios::binary);
+    if(!out.write(reinterpret_cast<const char*>(file.data()), file.size()))
+    {
+        fprintf(stderr, "Error writing mesh asset at \"%s\"\n", argv[2]);
+        return 1;
+    }
+    out.close();
+
+    // The file is validated like the runtime would, so that a broken file is never left behind unnoticed.
+    if(!validate_mesh_file(file.data(), file.size()))
+    {
+        fprintf(stderr, "Error writing mesh asset at \"%s\", the file is invalid\n", argv[2]);
+        return 1;
+    }
+    printf("%s: %zu meshes, %zu bytes\n", argv[2], records.size(), file.size());
+    return 0;
+}
\ No newline at end of file